@@ -0,0 +1,240 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "Base64Helpers.h"
+#include "SIMDHelpers.h"
+
+
+namespace FBase64Helpers
+{
+    // Vectorised decoding follows Mula & Lemire, "Faster Base64 Encoding and Decoding Using AVX2 Instructions":
+    // characters are validated and translated to sextets with nibble table lookups, then sextets are packed with multiply-adds.
+    // Blocks that contain anything but the standard alphabet are left to the scalar decoder.
+
+#if RIL_SIMD_SSE4_1 || RIL_SIMD_NEON
+    // bit sets of the character classes indexed by the low and the high nibble, character is valid if the sets don't intersect
+    alignas(16) static const uint8 LutLo[16] = { 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A };
+    alignas(16) static const uint8 LutHi[16] = { 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10 };
+    // offset from the character to its sextet indexed by the high nibble, '/' is moved to index 1
+    alignas(16) static const uint8 LutRoll[16] = { 0, 16, 19, 4, uint8(-65), uint8(-65), uint8(-71), uint8(-71), 0, 0, 0, 0, 0, 0, 0, 0 };
+#endif
+
+#if RIL_SIMD_AVX2
+    static FORCEINLINE bool DecodeBlockAVX2(const ANSICHAR* Source, uint8* Dest)
+    {
+        const __m256i Input = _mm256_loadu_si256((const __m256i*)Source);
+
+        const __m256i HiNibbles = _mm256_and_si256(_mm256_srli_epi32(Input, 4), _mm256_set1_epi8(0x0F));
+        const __m256i LoNibbles = _mm256_and_si256(Input, _mm256_set1_epi8(0x0F));
+
+        const __m256i Lo = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)LutLo)), LoNibbles);
+        const __m256i Hi = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)LutHi)), HiNibbles);
+        if (!_mm256_testz_si256(Lo, Hi))
+        {
+            return false;
+        }
+
+        const __m256i Eq2F = _mm256_cmpeq_epi8(Input, _mm256_set1_epi8(0x2F));
+        const __m256i Roll = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)LutRoll)), _mm256_add_epi8(Eq2F, HiNibbles));
+        const __m256i Sextets = _mm256_add_epi8(Input, Roll);
+
+        // 4 sextets -> 24 bits in each 32-bit lane
+        const __m256i MergedPairs = _mm256_maddubs_epi16(Sextets, _mm256_set1_epi32(0x01400140));
+        const __m256i Merged = _mm256_madd_epi16(MergedPairs, _mm256_set1_epi32(0x00011000));
+
+        const __m256i Packed = _mm256_shuffle_epi8(Merged, _mm256_setr_epi8(
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        const __m256i Output = _mm256_permutevar8x32_epi32(Packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+
+        // 24 bytes are valid, caller makes sure there is room for all 32
+        _mm256_storeu_si256((__m256i*)Dest, Output);
+        return true;
+    }
+#endif // RIL_SIMD_AVX2
+
+#if RIL_SIMD_SSE4_1
+    static FORCEINLINE bool DecodeBlockSSE(const ANSICHAR* Source, uint8* Dest)
+    {
+        const __m128i Input = _mm_loadu_si128((const __m128i*)Source);
+
+        const __m128i HiNibbles = _mm_and_si128(_mm_srli_epi32(Input, 4), _mm_set1_epi8(0x0F));
+        const __m128i LoNibbles = _mm_and_si128(Input, _mm_set1_epi8(0x0F));
+
+        const __m128i Lo = _mm_shuffle_epi8(_mm_load_si128((const __m128i*)LutLo), LoNibbles);
+        const __m128i Hi = _mm_shuffle_epi8(_mm_load_si128((const __m128i*)LutHi), HiNibbles);
+        if (!_mm_testz_si128(Lo, Hi))
+        {
+            return false;
+        }
+
+        const __m128i Eq2F = _mm_cmpeq_epi8(Input, _mm_set1_epi8(0x2F));
+        const __m128i Roll = _mm_shuffle_epi8(_mm_load_si128((const __m128i*)LutRoll), _mm_add_epi8(Eq2F, HiNibbles));
+        const __m128i Sextets = _mm_add_epi8(Input, Roll);
+
+        const __m128i MergedPairs = _mm_maddubs_epi16(Sextets, _mm_set1_epi32(0x01400140));
+        const __m128i Merged = _mm_madd_epi16(MergedPairs, _mm_set1_epi32(0x00011000));
+
+        const __m128i Output = _mm_shuffle_epi8(Merged, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+
+        // 12 bytes are valid, caller makes sure there is room for all 16
+        _mm_storeu_si128((__m128i*)Dest, Output);
+        return true;
+    }
+#endif // RIL_SIMD_SSE4_1
+
+#if RIL_SIMD_NEON
+    static FORCEINLINE uint8x16_t TranslateNEON(uint8x16_t Input, uint8x16_t& Error)
+    {
+        const uint8x16_t HiNibbles = vshrq_n_u8(Input, 4);
+        const uint8x16_t LoNibbles = vandq_u8(Input, vdupq_n_u8(0x0F));
+
+        const uint8x16_t Lo = vqtbl1q_u8(vld1q_u8(LutLo), LoNibbles);
+        const uint8x16_t Hi = vqtbl1q_u8(vld1q_u8(LutHi), HiNibbles);
+        Error = vorrq_u8(Error, vandq_u8(Lo, Hi));
+
+        const uint8x16_t Eq2F = vceqq_u8(Input, vdupq_n_u8(0x2F));
+        const uint8x16_t Roll = vqtbl1q_u8(vld1q_u8(LutRoll), vaddq_u8(Eq2F, HiNibbles));
+        return vaddq_u8(Input, Roll);
+    }
+
+    static FORCEINLINE bool DecodeBlockNEON(const ANSICHAR* Source, uint8* Dest)
+    {
+        // deinterleaved load puts 1st, 2nd, 3rd and 4th sextets of 16 quads into separate registers
+        const uint8x16x4_t Input = vld4q_u8((const uint8*)Source);
+
+        uint8x16_t Error = vdupq_n_u8(0);
+        const uint8x16_t A = TranslateNEON(Input.val[0], Error);
+        const uint8x16_t B = TranslateNEON(Input.val[1], Error);
+        const uint8x16_t C = TranslateNEON(Input.val[2], Error);
+        const uint8x16_t D = TranslateNEON(Input.val[3], Error);
+
+        if (vmaxvq_u8(Error) != 0)
+        {
+            return false;
+        }
+
+        uint8x16x3_t Output;
+        Output.val[0] = vorrq_u8(vshlq_n_u8(A, 2), vshrq_n_u8(B, 4));
+        Output.val[1] = vorrq_u8(vshlq_n_u8(B, 4), vshrq_n_u8(C, 2));
+        Output.val[2] = vorrq_u8(vshlq_n_u8(C, 6), D);
+
+        vst3q_u8(Dest, Output);
+        return true;
+    }
+#endif // RIL_SIMD_NEON
+
+    static const int8* GetDecodeTable()
+    {
+        static const TStaticArray<int8, 256> DecodeTable = []()
+        {
+            TStaticArray<int8, 256> Table;
+            for (int32 Index = 0; Index < 256; ++Index)
+            {
+                Table[Index] = -1;
+            }
+
+            const ANSICHAR* Alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+            for (int32 Index = 0; Index < 64; ++Index)
+            {
+                Table[(uint8)Alphabet[Index]] = (int8)Index;
+            }
+
+            // URL-safe alphabet
+            Table['-'] = 62;
+            Table['_'] = 63;
+
+            return Table;
+        }();
+
+        return DecodeTable.GetData();
+    }
+
+    int64 GetMaxDecodedSize(int64 SourceLength)
+    {
+        return (SourceLength / 4) * 3 + 3;
+    }
+
+    int64 Decode(const ANSICHAR* Source, int64 SourceLength, uint8* Dest)
+    {
+        // padding
+        for (int32 Padding = 0; Padding < 2 && SourceLength > 0 && Source[SourceLength - 1] == '='; ++Padding)
+        {
+            --SourceLength;
+        }
+
+        if (SourceLength % 4 == 1)
+        {
+            return INDEX_NONE;
+        }
+
+        const ANSICHAR* Current = Source;
+        const ANSICHAR* End = Source + SourceLength;
+        uint8* Output = Dest;
+
+        // vector stores overrun the decoded bytes, blocks are decoded only while the rest of the output has room for them
+#if RIL_SIMD_AVX2
+        while (End - Current >= 48 && DecodeBlockAVX2(Current, Output))
+        {
+            Current += 32;
+            Output += 24;
+        }
+#endif
+#if RIL_SIMD_SSE4_1
+        while (End - Current >= 24 && DecodeBlockSSE(Current, Output))
+        {
+            Current += 16;
+            Output += 12;
+        }
+#elif RIL_SIMD_NEON
+        while (End - Current >= 64 && DecodeBlockNEON(Current, Output))
+        {
+            Current += 64;
+            Output += 48;
+        }
+#endif
+
+        const int8* DecodeTable = GetDecodeTable();
+
+        while (End - Current >= 4)
+        {
+            const int32 A = DecodeTable[(uint8)Current[0]];
+            const int32 B = DecodeTable[(uint8)Current[1]];
+            const int32 C = DecodeTable[(uint8)Current[2]];
+            const int32 D = DecodeTable[(uint8)Current[3]];
+            if ((A | B | C | D) < 0)
+            {
+                return INDEX_NONE;
+            }
+
+            const uint32 Triple = (A << 18) | (B << 12) | (C << 6) | D;
+            Output[0] = (uint8)(Triple >> 16);
+            Output[1] = (uint8)(Triple >> 8);
+            Output[2] = (uint8)Triple;
+
+            Current += 4;
+            Output += 3;
+        }
+
+        // unpadded tail of 2 or 3 characters
+        const int64 Remaining = End - Current;
+        if (Remaining > 0)
+        {
+            const int32 A = DecodeTable[(uint8)Current[0]];
+            const int32 B = DecodeTable[(uint8)Current[1]];
+            const int32 C = (Remaining > 2) ? DecodeTable[(uint8)Current[2]] : 0;
+            if ((A | B | C) < 0)
+            {
+                return INDEX_NONE;
+            }
+
+            const uint32 Triple = (A << 18) | (B << 12) | (C << 6);
+            *Output++ = (uint8)(Triple >> 16);
+            if (Remaining > 2)
+            {
+                *Output++ = (uint8)(Triple >> 8);
+            }
+        }
+
+        return Output - Dest;
+    }
+}
@@ -0,0 +1,18 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+namespace FBase64Helpers
+{
+    /** Upper bound of the decoded size, the decoder may write up to this many bytes */
+    int64 GetMaxDecodedSize(int64 SourceLength);
+
+    /**
+     * Decodes standard or URL-safe base64, padding is optional. Whitespace must be stripped beforehand.
+     * Returns number of the written bytes or INDEX_NONE if the source is not valid base64.
+     */
+    int64 Decode(const ANSICHAR* Source, int64 SourceLength, uint8* Dest);
+}
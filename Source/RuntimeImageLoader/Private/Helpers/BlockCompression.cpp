@@ -0,0 +1,1159 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "BlockCompression.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformTime.h"
+
+
+namespace FBlockCompression
+{
+    // 4x4 pixels, pixel I is at X = I % 4 and Y = I / 4, channels in RGBA order
+    struct FColorBlock
+    {
+        uint8 Pixels[16][4];
+    };
+
+    struct FMipView
+    {
+        const uint8* Data = nullptr;
+        int32 SizeX = 0;
+        int32 SizeY = 0;
+        int32 BytesPerPixel = 0;
+    };
+
+    // 128-bit block written from the least significant bit, as BC6H and BC7 fields are laid out
+    struct FBitWriter
+    {
+        uint64 Bits[2] = { 0, 0 };
+        int32 Position = 0;
+
+        void Write(uint32 Value, int32 NumBits)
+        {
+            for (int32 Bit = 0; Bit < NumBits; ++Bit, ++Position)
+            {
+                Bits[Position >> 6] |= (uint64)((Value >> Bit) & 1) << (Position & 63);
+            }
+        }
+
+        void Store(uint8* Out) const
+        {
+            for (int32 Byte = 0; Byte < 16; ++Byte)
+            {
+                Out[Byte] = (uint8)(Bits[Byte >> 3] >> ((Byte & 7) * 8));
+            }
+        }
+    };
+
+    static const int32 BC7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    static const int32 ETC1Modifiers[8][4] =
+    {
+        { 2, 8, -2, -8 },
+        { 5, 17, -5, -17 },
+        { 9, 29, -9, -29 },
+        { 13, 42, -13, -42 },
+        { 18, 60, -18, -60 },
+        { 24, 80, -24, -80 },
+        { 33, 106, -33, -106 },
+        { 47, 183, -47, -183 }
+    };
+
+    static const int32 EACModifiers[16][8] =
+    {
+        { -3, -6, -9, -15, 2, 5, 8, 14 },
+        { -3, -7, -10, -13, 2, 6, 9, 12 },
+        { -2, -5, -8, -13, 1, 4, 7, 12 },
+        { -2, -4, -6, -13, 1, 3, 5, 12 },
+        { -3, -6, -8, -12, 2, 5, 7, 11 },
+        { -3, -7, -9, -11, 2, 6, 8, 10 },
+        { -4, -7, -8, -11, 3, 6, 7, 10 },
+        { -3, -5, -8, -11, 2, 4, 7, 10 },
+        { -2, -6, -8, -10, 1, 5, 7, 9 },
+        { -2, -5, -8, -10, 1, 4, 7, 9 },
+        { -2, -4, -8, -10, 1, 3, 7, 9 },
+        { -2, -5, -7, -10, 1, 4, 6, 9 },
+        { -3, -4, -7, -10, 2, 3, 6, 9 },
+        { -1, -2, -3, -10, 0, 1, 2, 9 },
+        { -4, -6, -8, -9, 3, 5, 7, 8 },
+        { -3, -5, -7, -9, 2, 4, 6, 8 }
+    };
+
+    static void LoadBlock(const FMipView& Mip, int32 BlockX, int32 BlockY, FColorBlock& OutBlock)
+    {
+        for (int32 I = 0; I < 16; ++I)
+        {
+            const int32 X = FMath::Min(BlockX * 4 + (I & 3), Mip.SizeX - 1);
+            const int32 Y = FMath::Min(BlockY * 4 + (I >> 2), Mip.SizeY - 1);
+            const int64 Index = (int64)Y * Mip.SizeX + X;
+
+            uint8* Pixel = OutBlock.Pixels[I];
+            if (Mip.BytesPerPixel == 1)
+            {
+                // grayscale is replicated to color
+                Pixel[0] = Pixel[1] = Pixel[2] = Mip.Data[Index];
+                Pixel[3] = 255;
+            }
+            else
+            {
+                const uint8* Source = Mip.Data + Index * 4;
+                Pixel[0] = Source[2];
+                Pixel[1] = Source[1];
+                Pixel[2] = Source[0];
+                Pixel[3] = Source[3];
+            }
+        }
+    }
+
+    /**
+     * Unsigned BC6H interpolates the endpoints unquantized to 16 bits and scales the result by 31/64 to the half float bit pattern,
+     * so the pixels are fitted in that unquantized space. Negative values are clamped to 0 and infinities to the largest half.
+     */
+    static void LoadHalfBlock(const FMipView& Mip, int32 BlockX, int32 BlockY, float OutPoints[16][3])
+    {
+        for (int32 I = 0; I < 16; ++I)
+        {
+            const int32 X = FMath::Min(BlockX * 4 + (I & 3), Mip.SizeX - 1);
+            const int32 Y = FMath::Min(BlockY * 4 + (I >> 2), Mip.SizeY - 1);
+            const uint16* Source = reinterpret_cast<const uint16*>(Mip.Data) + ((int64)Y * Mip.SizeX + X) * 4;
+
+            for (int32 C = 0; C < 3; ++C)
+            {
+                const uint16 Half = (Source[C] & 0x8000) ? 0 : FMath::Min<uint16>(Source[C], 0x7BFF);
+                OutPoints[I][C] = Half * 64.0f / 31.0f;
+            }
+        }
+    }
+
+    /** Endpoints of the principal axis of the points, spanning their projections */
+    template<int32 N>
+    static void ComputeEndpoints(const float (&Points)[16][N], float (&OutStart)[N], float (&OutEnd)[N])
+    {
+        float Mean[N] = {};
+        for (int32 I = 0; I < 16; ++I)
+        {
+            for (int32 C = 0; C < N; ++C)
+            {
+                Mean[C] += Points[I][C] * (1.0f / 16.0f);
+            }
+        }
+
+        float Covariance[N][N] = {};
+        for (int32 I = 0; I < 16; ++I)
+        {
+            for (int32 A = 0; A < N; ++A)
+            {
+                for (int32 B = 0; B < N; ++B)
+                {
+                    Covariance[A][B] += (Points[I][A] - Mean[A]) * (Points[I][B] - Mean[B]);
+                }
+            }
+        }
+
+        // power iteration starting from the row of the largest variance
+        int32 LargestRow = 0;
+        for (int32 C = 1; C < N; ++C)
+        {
+            if (Covariance[C][C] > Covariance[LargestRow][LargestRow])
+            {
+                LargestRow = C;
+            }
+        }
+
+        float Axis[N];
+        for (int32 C = 0; C < N; ++C)
+        {
+            Axis[C] = Covariance[LargestRow][C];
+        }
+
+        for (int32 Iteration = 0; Iteration < 8; ++Iteration)
+        {
+            float NextAxis[N] = {};
+            float Largest = 0.0f;
+            for (int32 A = 0; A < N; ++A)
+            {
+                for (int32 B = 0; B < N; ++B)
+                {
+                    NextAxis[A] += Covariance[A][B] * Axis[B];
+                }
+                Largest = FMath::Max(Largest, FMath::Abs(NextAxis[A]));
+            }
+
+            if (Largest < KINDA_SMALL_NUMBER)
+            {
+                break;
+            }
+
+            for (int32 C = 0; C < N; ++C)
+            {
+                Axis[C] = NextAxis[C] / Largest;
+            }
+        }
+
+        float LengthSquared = 0.0f;
+        for (int32 C = 0; C < N; ++C)
+        {
+            LengthSquared += Axis[C] * Axis[C];
+        }
+
+        if (LengthSquared < KINDA_SMALL_NUMBER)
+        {
+            // flat block
+            for (int32 C = 0; C < N; ++C)
+            {
+                OutStart[C] = OutEnd[C] = Mean[C];
+            }
+            return;
+        }
+
+        const float InvLength = FMath::InvSqrt(LengthSquared);
+        for (int32 C = 0; C < N; ++C)
+        {
+            Axis[C] *= InvLength;
+        }
+
+        float MinT = MAX_flt;
+        float MaxT = -MAX_flt;
+        for (int32 I = 0; I < 16; ++I)
+        {
+            float T = 0.0f;
+            for (int32 C = 0; C < N; ++C)
+            {
+                T += (Points[I][C] - Mean[C]) * Axis[C];
+            }
+            MinT = FMath::Min(MinT, T);
+            MaxT = FMath::Max(MaxT, T);
+        }
+
+        for (int32 C = 0; C < N; ++C)
+        {
+            OutStart[C] = Mean[C] + Axis[C] * MinT;
+            OutEnd[C] = Mean[C] + Axis[C] * MaxT;
+        }
+    }
+
+    /** Least squares endpoints of the points interpolated with the weights, weight 0 is the start */
+    template<int32 N>
+    static bool RefitEndpoints(const float (&Points)[16][N], const float (&Weights)[16], float (&OutStart)[N], float (&OutEnd)[N])
+    {
+        float A = 0.0f, B = 0.0f, C = 0.0f;
+        float StartSum[N] = {};
+        float EndSum[N] = {};
+        for (int32 I = 0; I < 16; ++I)
+        {
+            const float T = Weights[I];
+            const float S = 1.0f - T;
+            A += S * S;
+            B += S * T;
+            C += T * T;
+            for (int32 Channel = 0; Channel < N; ++Channel)
+            {
+                StartSum[Channel] += S * Points[I][Channel];
+                EndSum[Channel] += T * Points[I][Channel];
+            }
+        }
+
+        const float Determinant = A * C - B * B;
+        if (FMath::Abs(Determinant) < KINDA_SMALL_NUMBER)
+        {
+            return false;
+        }
+
+        for (int32 Channel = 0; Channel < N; ++Channel)
+        {
+            OutStart[Channel] = (C * StartSum[Channel] - B * EndSum[Channel]) / Determinant;
+            OutEnd[Channel] = (A * EndSum[Channel] - B * StartSum[Channel]) / Determinant;
+        }
+        return true;
+    }
+
+    static uint16 QuantizeRGB565(const float (&Color)[3])
+    {
+        const uint32 R = FMath::Clamp(FMath::RoundToInt(Color[0] * 31.0f / 255.0f), 0, 31);
+        const uint32 G = FMath::Clamp(FMath::RoundToInt(Color[1] * 63.0f / 255.0f), 0, 63);
+        const uint32 B = FMath::Clamp(FMath::RoundToInt(Color[2] * 31.0f / 255.0f), 0, 31);
+        return (uint16)((R << 11) | (G << 5) | B);
+    }
+
+    static void DecodeRGB565(uint16 Color, int32 (&OutColor)[3])
+    {
+        const int32 R = (Color >> 11) & 31;
+        const int32 G = (Color >> 5) & 63;
+        const int32 B = Color & 31;
+        OutColor[0] = (R << 3) | (R >> 2);
+        OutColor[1] = (G << 2) | (G >> 4);
+        OutColor[2] = (B << 3) | (B >> 2);
+    }
+
+    static uint32 SelectBC1Indices(const FColorBlock& Block, uint16 Color0, uint16 Color1, uint64& OutError)
+    {
+        int32 Palette[4][3];
+        DecodeRGB565(Color0, Palette[0]);
+        DecodeRGB565(Color1, Palette[1]);
+        for (int32 C = 0; C < 3; ++C)
+        {
+            Palette[2][C] = (2 * Palette[0][C] + Palette[1][C] + 1) / 3;
+            Palette[3][C] = (Palette[0][C] + 2 * Palette[1][C] + 1) / 3;
+        }
+
+        uint32 Indices = 0;
+        OutError = 0;
+        for (int32 I = 0; I < 16; ++I)
+        {
+            int32 BestIndex = 0;
+            int32 BestError = MAX_int32;
+            for (int32 Index = 0; Index < 4; ++Index)
+            {
+                int32 Error = 0;
+                for (int32 C = 0; C < 3; ++C)
+                {
+                    const int32 Diff = Palette[Index][C] - Block.Pixels[I][C];
+                    Error += Diff * Diff;
+                }
+
+                if (Error < BestError)
+                {
+                    BestError = Error;
+                    BestIndex = Index;
+                }
+            }
+
+            Indices |= (uint32)BestIndex << (I * 2);
+            OutError += BestError;
+        }
+        return Indices;
+    }
+
+    static uint64 EncodeBC1(const FColorBlock& Block, uint8* Out)
+    {
+        float Points[16][3];
+        for (int32 I = 0; I < 16; ++I)
+        {
+            for (int32 C = 0; C < 3; ++C)
+            {
+                Points[I][C] = Block.Pixels[I][C];
+            }
+        }
+
+        float Start[3], End[3];
+        ComputeEndpoints(Points, Start, End);
+
+        uint16 Color0 = QuantizeRGB565(Start);
+        uint16 Color1 = QuantizeRGB565(End);
+        uint64 Error = 0;
+        uint32 Indices = SelectBC1Indices(Block, Color0, Color1, Error);
+
+        // one least squares pass over the chosen indices
+        static const float IndexWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+        float Weights[16];
+        for (int32 I = 0; I < 16; ++I)
+        {
+            Weights[I] = IndexWeights[(Indices >> (I * 2)) & 3];
+        }
+
+        if (Error > 0 && RefitEndpoints(Points, Weights, Start, End))
+        {
+            const uint16 RefitColor0 = QuantizeRGB565(Start);
+            const uint16 RefitColor1 = QuantizeRGB565(End);
+            uint64 RefitError = 0;
+            const uint32 RefitIndices = SelectBC1Indices(Block, RefitColor0, RefitColor1, RefitError);
+            if (RefitError < Error)
+            {
+                Color0 = RefitColor0;
+                Color1 = RefitColor1;
+                Indices = RefitIndices;
+                Error = RefitError;
+            }
+        }
+
+        // four color mode needs Color0 > Color1, equal endpoints decode in three color mode where index 3 is transparent black
+        if (Color0 < Color1)
+        {
+            Swap(Color0, Color1);
+            Indices ^= 0x55555555;
+        }
+        else if (Color0 == Color1)
+        {
+            Indices = 0;
+        }
+
+        Out[0] = (uint8)Color0;
+        Out[1] = (uint8)(Color0 >> 8);
+        Out[2] = (uint8)Color1;
+        Out[3] = (uint8)(Color1 >> 8);
+        for (int32 Byte = 0; Byte < 4; ++Byte)
+        {
+            Out[4 + Byte] = (uint8)(Indices >> (Byte * 8));
+        }
+        return Error;
+    }
+
+    static uint64 EncodeBC4(const uint8 (&Values)[16], uint8* Out)
+    {
+        uint8 Min = 255, Max = 0;
+        for (int32 I = 0; I < 16; ++I)
+        {
+            Min = FMath::Min(Min, Values[I]);
+            Max = FMath::Max(Max, Values[I]);
+        }
+
+        // Max > Min selects the eight value mode, equal endpoints decode every index 0 exactly
+        Out[0] = Max;
+        Out[1] = Min;
+
+        uint64 Indices = 0;
+        uint64 Error = 0;
+        if (Max > Min)
+        {
+            int32 Palette[8];
+            Palette[0] = Max;
+            Palette[1] = Min;
+            for (int32 Index = 2; Index < 8; ++Index)
+            {
+                Palette[Index] = ((8 - Index) * Max + (Index - 1) * Min + 3) / 7;
+            }
+
+            for (int32 I = 0; I < 16; ++I)
+            {
+                int32 BestIndex = 0;
+                int32 BestError = MAX_int32;
+                for (int32 Index = 0; Index < 8; ++Index)
+                {
+                    const int32 Diff = Palette[Index] - Values[I];
+                    if (Diff * Diff < BestError)
+                    {
+                        BestError = Diff * Diff;
+                        BestIndex = Index;
+                    }
+                }
+
+                Indices |= (uint64)BestIndex << (I * 3);
+                Error += BestError;
+            }
+        }
+
+        for (int32 Byte = 0; Byte < 6; ++Byte)
+        {
+            Out[2 + Byte] = (uint8)(Indices >> (Byte * 8));
+        }
+        return Error;
+    }
+
+    /** 7-bit endpoint with the p-bit that lands closer to the color */
+    static void QuantizeBC7Endpoint(const float (&Color)[4], uint8 (&OutQuantized)[4], uint8& OutPBit)
+    {
+        float BestError = MAX_flt;
+        for (uint8 PBit = 0; PBit < 2; ++PBit)
+        {
+            uint8 Quantized[4];
+            float Error = 0.0f;
+            for (int32 C = 0; C < 4; ++C)
+            {
+                Quantized[C] = (uint8)FMath::Clamp(FMath::RoundToInt((Color[C] - PBit) * 0.5f), 0, 127);
+                const float Diff = ((Quantized[C] << 1) | PBit) - Color[C];
+                Error += Diff * Diff;
+            }
+
+            if (Error < BestError)
+            {
+                BestError = Error;
+                OutPBit = PBit;
+                FMemory::Memcpy(OutQuantized, Quantized, sizeof(Quantized));
+            }
+        }
+    }
+
+    static uint64 SelectBC7Indices(const FColorBlock& Block, const uint8 (&Endpoints)[2][4], const uint8 (&PBits)[2], uint8 (&OutIndices)[16])
+    {
+        int32 Palette[16][4];
+        for (int32 C = 0; C < 4; ++C)
+        {
+            const int32 Start = (Endpoints[0][C] << 1) | PBits[0];
+            const int32 End = (Endpoints[1][C] << 1) | PBits[1];
+            for (int32 Index = 0; Index < 16; ++Index)
+            {
+                Palette[Index][C] = ((64 - BC7Weights4[Index]) * Start + BC7Weights4[Index] * End + 32) >> 6;
+            }
+        }
+
+        uint64 Error = 0;
+        for (int32 I = 0; I < 16; ++I)
+        {
+            int32 BestError = MAX_int32;
+            for (int32 Index = 0; Index < 16; ++Index)
+            {
+                int32 PixelError = 0;
+                for (int32 C = 0; C < 4; ++C)
+                {
+                    const int32 Diff = Palette[Index][C] - Block.Pixels[I][C];
+                    PixelError += Diff * Diff;
+                }
+
+                if (PixelError < BestError)
+                {
+                    BestError = PixelError;
+                    OutIndices[I] = (uint8)Index;
+                }
+            }
+            Error += BestError;
+        }
+        return Error;
+    }
+
+    static uint64 EncodeBC7(const FColorBlock& Block, uint8* Out)
+    {
+        float Points[16][4];
+        for (int32 I = 0; I < 16; ++I)
+        {
+            for (int32 C = 0; C < 4; ++C)
+            {
+                Points[I][C] = Block.Pixels[I][C];
+            }
+        }
+
+        float Start[4], End[4];
+        ComputeEndpoints(Points, Start, End);
+
+        uint8 Endpoints[2][4];
+        uint8 PBits[2];
+        QuantizeBC7Endpoint(Start, Endpoints[0], PBits[0]);
+        QuantizeBC7Endpoint(End, Endpoints[1], PBits[1]);
+
+        uint8 Indices[16];
+        uint64 Error = SelectBC7Indices(Block, Endpoints, PBits, Indices);
+
+        float Weights[16];
+        for (int32 I = 0; I < 16; ++I)
+        {
+            Weights[I] = BC7Weights4[Indices[I]] / 64.0f;
+        }
+
+        if (Error > 0 && RefitEndpoints(Points, Weights, Start, End))
+        {
+            uint8 RefitQuantized[2][4];
+            uint8 RefitPBits[2];
+            uint8 RefitIndices[16];
+            QuantizeBC7Endpoint(Start, RefitQuantized[0], RefitPBits[0]);
+            QuantizeBC7Endpoint(End, RefitQuantized[1], RefitPBits[1]);
+
+            const uint64 RefitError = SelectBC7Indices(Block, RefitQuantized, RefitPBits, RefitIndices);
+            if (RefitError < Error)
+            {
+                FMemory::Memcpy(Endpoints, RefitQuantized, sizeof(Endpoints));
+                FMemory::Memcpy(PBits, RefitPBits, sizeof(PBits));
+                FMemory::Memcpy(Indices, RefitIndices, sizeof(Indices));
+                Error = RefitError;
+            }
+        }
+
+        // the most significant bit of the first index is implied 0
+        if (Indices[0] >= 8)
+        {
+            for (int32 C = 0; C < 4; ++C)
+            {
+                Swap(Endpoints[0][C], Endpoints[1][C]);
+            }
+            Swap(PBits[0], PBits[1]);
+            for (int32 I = 0; I < 16; ++I)
+            {
+                Indices[I] = 15 - Indices[I];
+            }
+        }
+
+        FBitWriter Writer;
+        Writer.Write(1 << 6, 7);
+        for (int32 C = 0; C < 4; ++C)
+        {
+            Writer.Write(Endpoints[0][C], 7);
+            Writer.Write(Endpoints[1][C], 7);
+        }
+        Writer.Write(PBits[0], 1);
+        Writer.Write(PBits[1], 1);
+        Writer.Write(Indices[0], 3);
+        for (int32 I = 1; I < 16; ++I)
+        {
+            Writer.Write(Indices[I], 4);
+        }
+        Writer.Store(Out);
+
+        return Error;
+    }
+
+    static int32 UnquantizeBC6H(int32 Value)
+    {
+        if (Value == 0)
+        {
+            return 0;
+        }
+        return (Value == 1023) ? 0xFFFF : ((Value << 16) + 0x8000) >> 10;
+    }
+
+    static float SelectBC6HIndices(const float (&Points)[16][3], const int32 (&Endpoints)[2][3], uint8 (&OutIndices)[16])
+    {
+        float Palette[16][3];
+        for (int32 C = 0; C < 3; ++C)
+        {
+            const int32 Start = UnquantizeBC6H(Endpoints[0][C]);
+            const int32 End = UnquantizeBC6H(Endpoints[1][C]);
+            for (int32 Index = 0; Index < 16; ++Index)
+            {
+                Palette[Index][C] = (float)(((64 - BC7Weights4[Index]) * Start + BC7Weights4[Index] * End + 32) >> 6);
+            }
+        }
+
+        float Error = 0.0f;
+        for (int32 I = 0; I < 16; ++I)
+        {
+            float BestError = MAX_flt;
+            for (int32 Index = 0; Index < 16; ++Index)
+            {
+                float PixelError = 0.0f;
+                for (int32 C = 0; C < 3; ++C)
+                {
+                    const float Diff = Palette[Index][C] - Points[I][C];
+                    PixelError += Diff * Diff;
+                }
+
+                if (PixelError < BestError)
+                {
+                    BestError = PixelError;
+                    OutIndices[I] = (uint8)Index;
+                }
+            }
+            Error += BestError;
+        }
+        return Error;
+    }
+
+    static void QuantizeBC6HEndpoint(const float (&Color)[3], int32 (&OutQuantized)[3])
+    {
+        for (int32 C = 0; C < 3; ++C)
+        {
+            OutQuantized[C] = FMath::Clamp(FMath::RoundToInt((Color[C] - 32.0f) / 64.0f), 0, 1023);
+        }
+    }
+
+    /** Squared error of the decoded block against the source half floats, in float space */
+    static double GetBC6HFloatError(const float (&Points)[16][3], const int32 (&Endpoints)[2][3], const uint8 (&Indices)[16])
+    {
+        double Error = 0.0;
+        for (int32 I = 0; I < 16; ++I)
+        {
+            for (int32 C = 0; C < 3; ++C)
+            {
+                const int32 Start = UnquantizeBC6H(Endpoints[0][C]);
+                const int32 End = UnquantizeBC6H(Endpoints[1][C]);
+                const int32 Interpolated = ((64 - BC7Weights4[Indices[I]]) * Start + BC7Weights4[Indices[I]] * End + 32) >> 6;
+
+                FFloat16 Decoded, Source;
+                Decoded.Encoded = (uint16)((Interpolated * 31) >> 6);
+                Source.Encoded = (uint16)FMath::RoundToInt(Points[I][C] * 31.0f / 64.0f);
+
+                const double Diff = (double)Decoded.GetFloat() - Source.GetFloat();
+                Error += Diff * Diff;
+            }
+        }
+        return Error;
+    }
+
+    static double EncodeBC6H(const float (&Points)[16][3], uint8* Out)
+    {
+        float Start[3], End[3];
+        ComputeEndpoints(Points, Start, End);
+
+        int32 Endpoints[2][3];
+        QuantizeBC6HEndpoint(Start, Endpoints[0]);
+        QuantizeBC6HEndpoint(End, Endpoints[1]);
+
+        uint8 Indices[16];
+        float Error = SelectBC6HIndices(Points, Endpoints, Indices);
+
+        float Weights[16];
+        for (int32 I = 0; I < 16; ++I)
+        {
+            Weights[I] = BC7Weights4[Indices[I]] / 64.0f;
+        }
+
+        if (Error > 0.0f && RefitEndpoints(Points, Weights, Start, End))
+        {
+            int32 RefitQuantized[2][3];
+            uint8 RefitIndices[16];
+            QuantizeBC6HEndpoint(Start, RefitQuantized[0]);
+            QuantizeBC6HEndpoint(End, RefitQuantized[1]);
+
+            if (SelectBC6HIndices(Points, RefitQuantized, RefitIndices) < Error)
+            {
+                FMemory::Memcpy(Endpoints, RefitQuantized, sizeof(Endpoints));
+                FMemory::Memcpy(Indices, RefitIndices, sizeof(Indices));
+            }
+        }
+
+        if (Indices[0] >= 8)
+        {
+            for (int32 C = 0; C < 3; ++C)
+            {
+                Swap(Endpoints[0][C], Endpoints[1][C]);
+            }
+            for (int32 I = 0; I < 16; ++I)
+            {
+                Indices[I] = 15 - Indices[I];
+            }
+        }
+
+        // mode 11: untransformed 10-bit endpoints
+        FBitWriter Writer;
+        Writer.Write(0x03, 5);
+        for (int32 Endpoint = 0; Endpoint < 2; ++Endpoint)
+        {
+            for (int32 C = 0; C < 3; ++C)
+            {
+                Writer.Write(Endpoints[Endpoint][C], 10);
+            }
+        }
+        Writer.Write(Indices[0], 3);
+        for (int32 I = 1; I < 16; ++I)
+        {
+            Writer.Write(Indices[I], 4);
+        }
+        Writer.Store(Out);
+
+        return GetBC6HFloatError(Points, Endpoints, Indices);
+    }
+
+    /** Best modifier table and selectors of the 8 pixels of one ETC subblock around the base color */
+    static uint64 FitETCSubblock(const FColorBlock& Block, const int32 (&Pixels)[8], const int32 (&Base)[3], int32& OutTable, uint8 (&OutSelectors)[16])
+    {
+        uint64 BestError = MAX_uint64;
+        for (int32 Table = 0; Table < 8; ++Table)
+        {
+            uint64 Error = 0;
+            uint8 Selectors[8];
+            for (int32 P = 0; P < 8; ++P)
+            {
+                const uint8* Pixel = Block.Pixels[Pixels[P]];
+
+                int32 BestPixelError = MAX_int32;
+                for (int32 Selector = 0; Selector < 4; ++Selector)
+                {
+                    int32 PixelError = 0;
+                    for (int32 C = 0; C < 3; ++C)
+                    {
+                        const int32 Diff = FMath::Clamp(Base[C] + ETC1Modifiers[Table][Selector], 0, 255) - Pixel[C];
+                        PixelError += Diff * Diff;
+                    }
+
+                    if (PixelError < BestPixelError)
+                    {
+                        BestPixelError = PixelError;
+                        Selectors[P] = (uint8)Selector;
+                    }
+                }
+                Error += BestPixelError;
+            }
+
+            if (Error < BestError)
+            {
+                BestError = Error;
+                OutTable = Table;
+                for (int32 P = 0; P < 8; ++P)
+                {
+                    OutSelectors[Pixels[P]] = Selectors[P];
+                }
+            }
+        }
+        return BestError;
+    }
+
+    /**
+     * Individual and differential modes with both subblock flips, the base colors are the subblock averages.
+     * The differential delta is kept in range, so ETC2 decoders never read the block as one of the T, H or planar modes.
+     */
+    static uint64 EncodeETC2RGB(const FColorBlock& Block, uint8* Out)
+    {
+        uint64 BestError = MAX_uint64;
+
+        for (int32 Flip = 0; Flip < 2; ++Flip)
+        {
+            // without flip the subblocks are the left and right 2x4 halves, with flip the top and bottom 4x2 halves
+            int32 Subblocks[2][8];
+            int32 Counts[2] = { 0, 0 };
+            for (int32 I = 0; I < 16; ++I)
+            {
+                const int32 Subblock = Flip ? ((I >> 2) >= 2) : ((I & 3) >= 2);
+                Subblocks[Subblock][Counts[Subblock]++] = I;
+            }
+
+            float Average[2][3] = {};
+            for (int32 Subblock = 0; Subblock < 2; ++Subblock)
+            {
+                for (int32 P = 0; P < 8; ++P)
+                {
+                    for (int32 C = 0; C < 3; ++C)
+                    {
+                        Average[Subblock][C] += Block.Pixels[Subblocks[Subblock][P]][C] * (1.0f / 8.0f);
+                    }
+                }
+            }
+
+            int32 Colors5[2][3];
+            bool bDifferentialValid = true;
+            for (int32 C = 0; C < 3; ++C)
+            {
+                Colors5[0][C] = FMath::Clamp(FMath::RoundToInt(Average[0][C] * 31.0f / 255.0f), 0, 31);
+                Colors5[1][C] = FMath::Clamp(FMath::RoundToInt(Average[1][C] * 31.0f / 255.0f), 0, 31);
+                const int32 Delta = Colors5[1][C] - Colors5[0][C];
+                bDifferentialValid &= Delta >= -4 && Delta <= 3;
+            }
+
+            for (int32 Differential = 0; Differential < 2; ++Differential)
+            {
+                if (Differential && !bDifferentialValid)
+                {
+                    continue;
+                }
+
+                int32 Quantized[2][3];
+                int32 Base[2][3];
+                for (int32 Subblock = 0; Subblock < 2; ++Subblock)
+                {
+                    for (int32 C = 0; C < 3; ++C)
+                    {
+                        if (Differential)
+                        {
+                            Quantized[Subblock][C] = Colors5[Subblock][C];
+                            Base[Subblock][C] = (Quantized[Subblock][C] << 3) | (Quantized[Subblock][C] >> 2);
+                        }
+                        else
+                        {
+                            Quantized[Subblock][C] = FMath::Clamp(FMath::RoundToInt(Average[Subblock][C] * 15.0f / 255.0f), 0, 15);
+                            Base[Subblock][C] = Quantized[Subblock][C] * 17;
+                        }
+                    }
+                }
+
+                int32 Tables[2];
+                uint8 Selectors[16];
+                const uint64 Error = FitETCSubblock(Block, Subblocks[0], Base[0], Tables[0], Selectors)
+                    + FitETCSubblock(Block, Subblocks[1], Base[1], Tables[1], Selectors);
+                if (Error >= BestError)
+                {
+                    continue;
+                }
+                BestError = Error;
+
+                for (int32 C = 0; C < 3; ++C)
+                {
+                    Out[C] = Differential
+                        ? (uint8)((Quantized[0][C] << 3) | ((Quantized[1][C] - Quantized[0][C]) & 7))
+                        : (uint8)((Quantized[0][C] << 4) | Quantized[1][C]);
+                }
+                Out[3] = (uint8)((Tables[0] << 5) | (Tables[1] << 2) | (Differential << 1) | Flip);
+
+                // selector bits are stored column by column, most significant bits of all pixels first
+                uint32 MostSignificant = 0;
+                uint32 LeastSignificant = 0;
+                for (int32 I = 0; I < 16; ++I)
+                {
+                    const int32 Bit = (I & 3) * 4 + (I >> 2);
+                    MostSignificant |= (uint32)(Selectors[I] >> 1) << Bit;
+                    LeastSignificant |= (uint32)(Selectors[I] & 1) << Bit;
+                }
+                Out[4] = (uint8)(MostSignificant >> 8);
+                Out[5] = (uint8)MostSignificant;
+                Out[6] = (uint8)(LeastSignificant >> 8);
+                Out[7] = (uint8)LeastSignificant;
+            }
+        }
+        return BestError;
+    }
+
+    static uint64 FitEACBlock(const uint8 (&Values)[16], int32 Base, int32 Multiplier, int32 Table, uint64& OutIndices)
+    {
+        uint64 Error = 0;
+        OutIndices = 0;
+        for (int32 I = 0; I < 16; ++I)
+        {
+            int32 BestIndex = 0;
+            int32 BestError = MAX_int32;
+            for (int32 Index = 0; Index < 8; ++Index)
+            {
+                const int32 Diff = FMath::Clamp(Base + EACModifiers[Table][Index] * Multiplier, 0, 255) - Values[I];
+                if (Diff * Diff < BestError)
+                {
+                    BestError = Diff * Diff;
+                    BestIndex = Index;
+                }
+            }
+
+            // 3-bit indices column by column from the most significant bit
+            const int32 Pixel = (I & 3) * 4 + (I >> 2);
+            OutIndices |= (uint64)BestIndex << (45 - Pixel * 3);
+            Error += BestError;
+        }
+        return Error;
+    }
+
+    static uint64 EncodeEACAlpha(const uint8 (&Values)[16], uint8* Out)
+    {
+        uint8 Min = 255, Max = 0;
+        for (int32 I = 0; I < 16; ++I)
+        {
+            Min = FMath::Min(Min, Values[I]);
+            Max = FMath::Max(Max, Values[I]);
+        }
+
+        // flat alpha is the base with the 0 modifier of table 13
+        int32 BestBase = Min, BestMultiplier = 1, BestTable = 13;
+        uint64 BestIndices = 0;
+        uint64 BestError = FitEACBlock(Values, BestBase, BestMultiplier, BestTable, BestIndices);
+
+        for (int32 Table = 0; Table < 16 && BestError > 0; ++Table)
+        {
+            const int32 TableMin = EACModifiers[Table][3];
+            const int32 TableMax = EACModifiers[Table][7];
+            const int32 Multiplier = FMath::Clamp(FMath::RoundToInt((float)(Max - Min) / (TableMax - TableMin)), 1, 15);
+
+            for (int32 CandidateMultiplier = FMath::Max(Multiplier - 1, 1); CandidateMultiplier <= FMath::Min(Multiplier + 1, 15); ++CandidateMultiplier)
+            {
+                const int32 Base = FMath::Clamp(FMath::RoundToInt((Min + Max) * 0.5f - (TableMin + TableMax) * CandidateMultiplier * 0.5f), 0, 255);
+
+                uint64 Indices = 0;
+                const uint64 Error = FitEACBlock(Values, Base, CandidateMultiplier, Table, Indices);
+                if (Error < BestError)
+                {
+                    BestError = Error;
+                    BestBase = Base;
+                    BestMultiplier = CandidateMultiplier;
+                    BestTable = Table;
+                    BestIndices = Indices;
+                }
+            }
+        }
+
+        Out[0] = (uint8)BestBase;
+        Out[1] = (uint8)((BestMultiplier << 4) | BestTable);
+        for (int32 Byte = 0; Byte < 6; ++Byte)
+        {
+            Out[2 + Byte] = (uint8)(BestIndices >> (40 - Byte * 8));
+        }
+        return BestError;
+    }
+
+    static int32 GetBlockBytes(EFormat Format)
+    {
+        return (Format == EFormat::BC1 || Format == EFormat::BC4 || Format == EFormat::ETC2_RGB) ? 8 : 16;
+    }
+
+    static int32 GetNumEncodedChannels(EFormat Format)
+    {
+        switch (Format)
+        {
+            case EFormat::BC4: return 1;
+            case EFormat::BC5: return 2;
+            case EFormat::BC1:
+            case EFormat::BC6H:
+            case EFormat::ETC2_RGB: return 3;
+            default: return 4;
+        }
+    }
+
+    /** Encodes one block and returns its squared error, of 8-bit values or of BC6H floats */
+    static double EncodeBlock(EFormat Format, const FMipView& Mip, int32 BlockX, int32 BlockY, uint8* Out)
+    {
+        if (Format == EFormat::BC6H)
+        {
+            float Points[16][3];
+            LoadHalfBlock(Mip, BlockX, BlockY, Points);
+            return EncodeBC6H(Points, Out);
+        }
+
+        FColorBlock Block;
+        LoadBlock(Mip, BlockX, BlockY, Block);
+
+        auto GetChannel = [&Block](int32 Channel, uint8 (&OutValues)[16])
+        {
+            for (int32 I = 0; I < 16; ++I)
+            {
+                OutValues[I] = Block.Pixels[I][Channel];
+            }
+        };
+
+        uint8 Values[16];
+        switch (Format)
+        {
+            case EFormat::BC1:
+                return (double)EncodeBC1(Block, Out);
+
+            case EFormat::BC3:
+            {
+                GetChannel(3, Values);
+                const uint64 AlphaError = EncodeBC4(Values, Out);
+                return (double)(AlphaError + EncodeBC1(Block, Out + 8));
+            }
+
+            case EFormat::BC4:
+                GetChannel(0, Values);
+                return (double)EncodeBC4(Values, Out);
+
+            case EFormat::BC5:
+            {
+                GetChannel(0, Values);
+                const uint64 RedError = EncodeBC4(Values, Out);
+                GetChannel(1, Values);
+                return (double)(RedError + EncodeBC4(Values, Out + 8));
+            }
+
+            case EFormat::BC7:
+                return (double)EncodeBC7(Block, Out);
+
+            case EFormat::ETC2_RGB:
+                return (double)EncodeETC2RGB(Block, Out);
+
+            case EFormat::ETC2_RGBA:
+            {
+                GetChannel(3, Values);
+                const uint64 AlphaError = EncodeEACAlpha(Values, Out);
+                return (double)(AlphaError + EncodeETC2RGB(Block, Out + 8));
+            }
+
+            default:
+                checkNoEntry();
+                return 0.0;
+        }
+    }
+
+    EPixelFormat GetPixelFormat(EFormat Format)
+    {
+        switch (Format)
+        {
+            case EFormat::BC1:       return PF_DXT1;
+            case EFormat::BC3:       return PF_DXT5;
+            case EFormat::BC4:       return PF_BC4;
+            case EFormat::BC5:       return PF_BC5;
+            case EFormat::BC6H:      return PF_BC6H;
+            case EFormat::BC7:       return PF_BC7;
+            case EFormat::ETC2_RGB:  return PF_ETC2_RGB;
+            case EFormat::ETC2_RGBA: return PF_ETC2_RGBA;
+            default:                 return PF_Unknown;
+        }
+    }
+
+    const TCHAR* GetName(EFormat Format)
+    {
+        switch (Format)
+        {
+            case EFormat::BC1:       return TEXT("BC1");
+            case EFormat::BC3:       return TEXT("BC3");
+            case EFormat::BC4:       return TEXT("BC4");
+            case EFormat::BC5:       return TEXT("BC5");
+            case EFormat::BC6H:      return TEXT("BC6H");
+            case EFormat::BC7:       return TEXT("BC7");
+            case EFormat::ETC2_RGB:  return TEXT("ETC2 RGB");
+            case EFormat::ETC2_RGBA: return TEXT("ETC2 RGBA");
+            default:                 return TEXT("Unknown");
+        }
+    }
+
+    bool CanCompress(const FRuntimeImageData& Image, EFormat Format)
+    {
+        switch (Format)
+        {
+            case EFormat::BC6H: return Image.Format == ERawImageFormat::RGBA16F;
+            case EFormat::BC5:  return Image.Format == ERawImageFormat::BGRA8;
+            default:            return Image.Format == ERawImageFormat::BGRA8 || Image.Format == ERawImageFormat::G8;
+        }
+    }
+
+    /** Brightest color channel of the first mip as BC6H encodes it, the peak signal of its PSNR */
+    static double GetHalfPeak(const FRuntimeImageData& Image)
+    {
+        const uint16* Values = reinterpret_cast<const uint16*>(Image.RawData.GetData());
+        const int64 NumPixels = (int64)Image.SizeX * Image.SizeY;
+
+        uint16 Brightest = 0;
+        for (int64 Pixel = 0; Pixel < NumPixels; ++Pixel)
+        {
+            for (int32 C = 0; C < 3; ++C)
+            {
+                const uint16 Half = Values[Pixel * 4 + C];
+                if (!(Half & 0x8000))
+                {
+                    Brightest = FMath::Max(Brightest, FMath::Min<uint16>(Half, 0x7BFF));
+                }
+            }
+        }
+
+        FFloat16 Peak;
+        Peak.Encoded = Brightest;
+        return (Brightest == 0) ? 1.0 : (double)Peak.GetFloat();
+    }
+
+    void Compress(const FRuntimeImageData& Image, EFormat Format, TArray64<uint8>& OutData, FStats& OutStats)
+    {
+        check(CanCompress(Image, Format));
+
+        const double StartTime = FPlatformTime::Seconds();
+        const int32 BlockBytes = GetBlockBytes(Format);
+        const int32 NumMips = FMath::Max(Image.NumMips, 1);
+
+        int64 CompressedSize = 0;
+        for (int32 Mip = 0; Mip < NumMips; ++Mip)
+        {
+            CompressedSize += (int64)FMath::DivideAndRoundUp(Image.GetMipSizeX(Mip), 4) * FMath::DivideAndRoundUp(Image.GetMipSizeY(Mip), 4) * BlockBytes;
+        }
+        OutData.SetNumUninitialized(CompressedSize);
+
+        double SquaredError = 0.0;
+        double NumValues = 0.0;
+        int64 DestOffset = 0;
+        for (int32 Mip = 0; Mip < NumMips; ++Mip)
+        {
+            FMipView MipView;
+            MipView.Data = Image.RawData.GetData() + Image.GetMipOffset(Mip);
+            MipView.SizeX = Image.GetMipSizeX(Mip);
+            MipView.SizeY = Image.GetMipSizeY(Mip);
+            MipView.BytesPerPixel = ERawImageFormat::GetBytesPerPixel(Image.Format);
+
+            const int32 BlocksX = FMath::DivideAndRoundUp(MipView.SizeX, 4);
+            const int32 BlocksY = FMath::DivideAndRoundUp(MipView.SizeY, 4);
+            uint8* Dest = OutData.GetData() + DestOffset;
+
+            TArray<double> RowErrors;
+            RowErrors.SetNumZeroed(BlocksY);
+
+            ParallelFor(BlocksY, [&](int32 BlockY)
+            {
+                double RowError = 0.0;
+                for (int32 BlockX = 0; BlockX < BlocksX; ++BlockX)
+                {
+                    RowError += EncodeBlock(Format, MipView, BlockX, BlockY, Dest + ((int64)BlockY * BlocksX + BlockX) * BlockBytes);
+                }
+                RowErrors[BlockY] = RowError;
+            });
+
+            if (Mip == 0)
+            {
+                for (double RowError : RowErrors)
+                {
+                    SquaredError += RowError;
+                }
+
+                // edge blocks repeat the edge pixels, which are in the error sum as well
+                NumValues = (double)BlocksX * BlocksY * 16 * GetNumEncodedChannels(Format);
+            }
+
+            DestOffset += (int64)BlocksX * BlocksY * BlockBytes;
+        }
+
+        OutStats.Seconds = FPlatformTime::Seconds() - StartTime;
+
+        if (SquaredError == 0.0)
+        {
+            OutStats.PSNR = 100.0;
+        }
+        else
+        {
+            const double Peak = (Format == EFormat::BC6H) ? GetHalfPeak(Image) : 255.0;
+            OutStats.PSNR = 10.0 * FMath::LogX(10.0, Peak * Peak * NumValues / SquaredError);
+        }
+    }
+}
@@ -0,0 +1,50 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PixelFormat.h"
+#include "RuntimeImageData.h"
+
+
+namespace FBlockCompression
+{
+    enum class EFormat : uint8
+    {
+        BC1,
+        // BC4 alpha and BC1 color
+        BC3,
+        BC4,
+        // two BC4 blocks of the red and green channels
+        BC5,
+        // unsigned, single region mode with 10-bit endpoints
+        BC6H,
+        // mode 6 only, single subset with RGBA endpoints
+        BC7,
+        // ETC1 compatible individual and differential modes
+        ETC2_RGB,
+        // EAC alpha and ETC2 color
+        ETC2_RGBA
+    };
+
+    struct FStats
+    {
+        double Seconds = 0.0;
+
+        // PSNR of the first mip over the encoded channels and whole edge blocks, 100 for lossless blocks.
+        // BC6H error is of the decoded floats with the brightest channel of the image as the peak
+        double PSNR = 0.0;
+    };
+
+    EPixelFormat GetPixelFormat(EFormat Format);
+    const TCHAR* GetName(EFormat Format);
+
+    /** The encoders take BGRA8 or G8 images, BC5 only BGRA8 and BC6H only RGBA16F */
+    bool CanCompress(const FRuntimeImageData& Image, EFormat Format);
+
+    /**
+     * Compresses the image and all of its mips into tightly packed blocks of the format, rows of blocks are encoded on the task graph.
+     * Blocks over the edge of mips smaller than 4 pixels repeat the edge pixels.
+     */
+    void Compress(const FRuntimeImageData& Image, EFormat Format, TArray64<uint8>& OutData, FStats& OutStats);
+}
@@ -0,0 +1,764 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "ImageResampler.h"
+#include "Async/ParallelFor.h"
+#include "Math/VectorRegister.h"
+#include "Runtime/Launch/Resources/Version.h"
+
+
+namespace FImageResampler
+{
+    // VectorRegister is the double precision register in UE5, the kernels stay 4-wide float
+#if ENGINE_MAJOR_VERSION >= 5
+    typedef VectorRegister4Float FFloatRegister;
+#else
+    typedef VectorRegister FFloatRegister;
+#endif
+
+    // precomputed taps of one axis, weights of destination pixel D are at D * MaxTaps
+    struct FAxisWeights
+    {
+        int32 MaxTaps = 0;
+        TArray<int32> FirstTap;
+        TArray<int32> NumTaps;
+        TArray<float> Weights;
+    };
+
+    // modified Bessel function of the first kind, the series converges quickly for the small arguments of the Kaiser window
+    static float BesselI0(float X)
+    {
+        const float HalfX = X * 0.5f;
+        float Sum = 1.0f;
+        float Term = 1.0f;
+        for (int32 K = 1; K < 16; ++K)
+        {
+            Term *= (HalfX / K) * (HalfX / K);
+            Sum += Term;
+        }
+        return Sum;
+    }
+
+    static float EvaluateFilter(EFilter Filter, float X)
+    {
+        X = FMath::Abs(X);
+
+        switch (Filter)
+        {
+            case EFilter::Box:
+            {
+                return X <= 0.5f ? 1.0f : 0.0f;
+            }
+            case EFilter::Bilinear:
+            {
+                return FMath::Max(0.0f, 1.0f - X);
+            }
+            case EFilter::Bicubic:
+            {
+                const float A = -0.5f;
+                if (X < 1.0f)
+                {
+                    return ((A + 2.0f) * X - (A + 3.0f)) * X * X + 1.0f;
+                }
+                if (X < 2.0f)
+                {
+                    return ((A * X - 5.0f * A) * X + 8.0f * A) * X - 4.0f * A;
+                }
+                return 0.0f;
+            }
+            case EFilter::Lanczos3:
+            {
+                if (X < KINDA_SMALL_NUMBER)
+                {
+                    return 1.0f;
+                }
+                if (X < 3.0f)
+                {
+                    const float PiX = PI * X;
+                    return 3.0f * FMath::Sin(PiX) * FMath::Sin(PiX / 3.0f) / (PiX * PiX);
+                }
+                return 0.0f;
+            }
+            case EFilter::Kaiser:
+            {
+                const float Support = 2.0f;
+                const float Alpha = 4.0f;
+                if (X >= Support)
+                {
+                    return 0.0f;
+                }
+                const float Sinc = (X < KINDA_SMALL_NUMBER) ? 1.0f : FMath::Sin(PI * X) / (PI * X);
+                const float T = X / Support;
+                return Sinc * BesselI0(Alpha * FMath::Sqrt(1.0f - T * T)) / BesselI0(Alpha);
+            }
+        }
+        return 0.0f;
+    }
+
+    static float GetFilterSupport(EFilter Filter)
+    {
+        switch (Filter)
+        {
+            case EFilter::Box:      return 0.5f;
+            case EFilter::Bilinear: return 1.0f;
+            case EFilter::Bicubic:  return 2.0f;
+            case EFilter::Lanczos3: return 3.0f;
+            case EFilter::Kaiser:   return 2.0f;
+        }
+        return 1.0f;
+    }
+
+    static void ComputeAxisWeights(int32 SourceSize, int32 DestSize, EFilter Filter, FAxisWeights& OutWeights)
+    {
+        const float Scale = (float)DestSize / SourceSize;
+        // filter is stretched over the source pixels when downscaling
+        const float FilterScale = FMath::Max(1.0f, 1.0f / Scale);
+        const float Support = GetFilterSupport(Filter) * FilterScale;
+
+        OutWeights.MaxTaps = FMath::Min(FMath::CeilToInt(Support * 2.0f) + 3, SourceSize);
+        OutWeights.FirstTap.SetNumUninitialized(DestSize);
+        OutWeights.NumTaps.SetNumUninitialized(DestSize);
+        OutWeights.Weights.SetNumZeroed(DestSize * OutWeights.MaxTaps);
+
+        for (int32 DestIndex = 0; DestIndex < DestSize; ++DestIndex)
+        {
+            const float Center = (DestIndex + 0.5f) / Scale;
+            const int32 Left = FMath::FloorToInt(Center - Support);
+            const int32 Right = FMath::CeilToInt(Center + Support);
+
+            const int32 FirstTap = FMath::Clamp(Left, 0, SourceSize - 1);
+            const int32 LastTap = FMath::Clamp(Right, 0, SourceSize - 1);
+
+            float* Weights = OutWeights.Weights.GetData() + DestIndex * OutWeights.MaxTaps;
+            int32 NumTaps = FMath::Min(LastTap - FirstTap + 1, OutWeights.MaxTaps);
+
+            // taps outside of the image are folded into the edge pixels
+            float TotalWeight = 0.0f;
+            for (int32 Tap = Left; Tap <= Right; ++Tap)
+            {
+                const float Weight = EvaluateFilter(Filter, (Tap + 0.5f - Center) / FilterScale);
+                if (Weight == 0.0f)
+                {
+                    continue;
+                }
+                const int32 TapIndex = FMath::Clamp(FMath::Clamp(Tap, 0, SourceSize - 1) - FirstTap, 0, NumTaps - 1);
+                Weights[TapIndex] += Weight;
+                TotalWeight += Weight;
+            }
+
+            if (FMath::Abs(TotalWeight) < KINDA_SMALL_NUMBER)
+            {
+                // nearest pixel
+                FMemory::Memzero(Weights, OutWeights.MaxTaps * sizeof(float));
+                Weights[FMath::Clamp(FMath::FloorToInt(Center) - FirstTap, 0, NumTaps - 1)] = 1.0f;
+                TotalWeight = 1.0f;
+            }
+
+            // trailing zero taps are skipped
+            while (NumTaps > 1 && Weights[NumTaps - 1] == 0.0f)
+            {
+                --NumTaps;
+            }
+
+            for (int32 TapIndex = 0; TapIndex < NumTaps; ++TapIndex)
+            {
+                Weights[TapIndex] /= TotalWeight;
+            }
+
+            OutWeights.FirstTap[DestIndex] = FirstTap;
+            OutWeights.NumTaps[DestIndex] = NumTaps;
+        }
+    }
+
+    static int32 GetNumChannels(ERawImageFormat::Type Format)
+    {
+        switch (Format)
+        {
+            case ERawImageFormat::G8:
+            case ERawImageFormat::G16:
+            case ERawImageFormat::R16F:
+#if ENGINE_MAJOR_VERSION >= 5
+            case ERawImageFormat::R32F:
+#endif
+                return 1;
+            default:
+                return 4;
+        }
+    }
+
+    bool IsFormatSupported(ERawImageFormat::Type Format)
+    {
+        switch (Format)
+        {
+            case ERawImageFormat::G8:
+            case ERawImageFormat::G16:
+            case ERawImageFormat::BGRA8:
+            case ERawImageFormat::BGRE8:
+            case ERawImageFormat::RGBA16:
+            case ERawImageFormat::RGBA16F:
+            case ERawImageFormat::RGBA32F:
+            case ERawImageFormat::R16F:
+#if ENGINE_MAJOR_VERSION >= 5
+            case ERawImageFormat::R32F:
+#endif
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    bool IsConversionSupported(ERawImageFormat::Type SourceFormat, ERawImageFormat::Type DestFormat)
+    {
+        return IsFormatSupported(SourceFormat) && IsFormatSupported(DestFormat) && GetNumChannels(SourceFormat) <= GetNumChannels(DestFormat);
+    }
+
+    // linear value quantised to 12 bits -> sRGB byte
+    static const uint8* GetLinearToSRGBTable()
+    {
+        static const TStaticArray<uint8, 4096> Table = []()
+        {
+            TStaticArray<uint8, 4096> Result;
+            for (int32 Index = 0; Index < 4096; ++Index)
+            {
+                const float Linear = Index / 4095.0f;
+                const float SRGB = (Linear <= 0.0031308f) ? Linear * 12.92f : 1.055f * FMath::Pow(Linear, 1.0f / 2.4f) - 0.055f;
+                Result[Index] = (uint8)FMath::Clamp(FMath::RoundToInt(SRGB * 255.0f), 0, 255);
+            }
+            return Result;
+        }();
+        return Table.GetData();
+    }
+
+    static FORCEINLINE uint8 QuantizeUNorm8(float Value)
+    {
+        return (uint8)FMath::Clamp(FMath::RoundToInt(Value * 255.0f), 0, 255);
+    }
+
+    static FORCEINLINE uint16 QuantizeUNorm16(float Value)
+    {
+        return (uint16)FMath::Clamp(FMath::RoundToInt(Value * 65535.0f), 0, 65535);
+    }
+
+    /** Values scaled to 0..Max and rounded as FMath::RoundToInt does, the clamp comes first so truncation rounds */
+    static FORCEINLINE void QuantizeVector(const FFloatRegister& Values, const FFloatRegister& Max, int32* OutValues)
+    {
+        const FFloatRegister Scaled = VectorMultiplyAdd(Values, Max, VectorSetFloat1(0.5f));
+        VectorIntStore(VectorFloatToInt(VectorMin(VectorMax(Scaled, VectorZero()), Max)), OutValues);
+    }
+
+    // UE4 takes a mutable pointer
+    static FORCEINLINE FFloatRegister LoadUNorm16x4(const uint16* Values)
+    {
+        return VectorLoadURGBA16N(const_cast<uint16*>(Values));
+    }
+
+    /** Decodes source row to floats, color is in BGRA order and linearised for sRGB images */
+    static void DecodeRow(const FImage& Image, int32 Y, float* OutRow)
+    {
+        const int64 NumValues = (int64)Image.SizeX * GetNumChannels(Image.Format);
+        const uint8* Row = Image.RawData.GetData() + (int64)Y * Image.SizeX * Image.GetBytesPerPixel();
+        const bool bSRGB = Image.GammaSpace != EGammaSpace::Linear;
+        const FFloatRegister InvMax8 = VectorSetFloat1(1.0f / 255.0f);
+
+        // sRGB bytes are table lookups, half floats and RGBE are converted value by value, the rest is converted 4 values at a time
+        switch (Image.Format)
+        {
+            case ERawImageFormat::G8:
+            {
+                int64 Index = 0;
+                if (!bSRGB)
+                {
+                    for (; Index + 4 <= NumValues; Index += 4)
+                    {
+                        VectorStore(VectorMultiply(VectorLoadByte4(Row + Index), InvMax8), OutRow + Index);
+                    }
+                }
+                for (; Index < NumValues; ++Index)
+                {
+                    OutRow[Index] = bSRGB ? FLinearColor::sRGBToLinearTable[Row[Index]] : Row[Index] / 255.0f;
+                }
+                break;
+            }
+            case ERawImageFormat::BGRA8:
+            {
+                if (!bSRGB)
+                {
+                    for (int64 Index = 0; Index < NumValues; Index += 4)
+                    {
+                        VectorStore(VectorMultiply(VectorLoadByte4(Row + Index), InvMax8), OutRow + Index);
+                    }
+                    break;
+                }
+
+                for (int64 Index = 0; Index < NumValues; Index += 4)
+                {
+                    OutRow[Index + 0] = FLinearColor::sRGBToLinearTable[Row[Index + 0]];
+                    OutRow[Index + 1] = FLinearColor::sRGBToLinearTable[Row[Index + 1]];
+                    OutRow[Index + 2] = FLinearColor::sRGBToLinearTable[Row[Index + 2]];
+                    OutRow[Index + 3] = Row[Index + 3] / 255.0f;
+                }
+                break;
+            }
+            case ERawImageFormat::BGRE8:
+            {
+                const FColor* Pixels = reinterpret_cast<const FColor*>(Row);
+                for (int32 X = 0; X < Image.SizeX; ++X)
+                {
+                    const FLinearColor Color = Pixels[X].FromRGBE();
+                    OutRow[X * 4 + 0] = Color.B;
+                    OutRow[X * 4 + 1] = Color.G;
+                    OutRow[X * 4 + 2] = Color.R;
+                    OutRow[X * 4 + 3] = Color.A;
+                }
+                break;
+            }
+            case ERawImageFormat::G16:
+            {
+                const uint16* Values = reinterpret_cast<const uint16*>(Row);
+                int64 Index = 0;
+                for (; Index + 4 <= NumValues; Index += 4)
+                {
+                    VectorStore(LoadUNorm16x4(Values + Index), OutRow + Index);
+                }
+                for (; Index < NumValues; ++Index)
+                {
+                    OutRow[Index] = Values[Index] / 65535.0f;
+                }
+                break;
+            }
+            case ERawImageFormat::RGBA16:
+            {
+                const uint16* Values = reinterpret_cast<const uint16*>(Row);
+                for (int64 Index = 0; Index < NumValues; Index += 4)
+                {
+                    VectorStore(VectorSwizzle(LoadUNorm16x4(Values + Index), 2, 1, 0, 3), OutRow + Index);
+                }
+                break;
+            }
+            case ERawImageFormat::R16F:
+            {
+                const FFloat16* Values = reinterpret_cast<const FFloat16*>(Row);
+                for (int64 Index = 0; Index < NumValues; ++Index)
+                {
+                    OutRow[Index] = Values[Index].GetFloat();
+                }
+                break;
+            }
+            case ERawImageFormat::RGBA16F:
+            {
+                const FFloat16* Values = reinterpret_cast<const FFloat16*>(Row);
+                for (int64 Index = 0; Index < NumValues; Index += 4)
+                {
+                    OutRow[Index + 0] = Values[Index + 2].GetFloat();
+                    OutRow[Index + 1] = Values[Index + 1].GetFloat();
+                    OutRow[Index + 2] = Values[Index + 0].GetFloat();
+                    OutRow[Index + 3] = Values[Index + 3].GetFloat();
+                }
+                break;
+            }
+            case ERawImageFormat::RGBA32F:
+            {
+                const float* Values = reinterpret_cast<const float*>(Row);
+                for (int64 Index = 0; Index < NumValues; Index += 4)
+                {
+                    VectorStore(VectorSwizzle(VectorLoad(Values + Index), 2, 1, 0, 3), OutRow + Index);
+                }
+                break;
+            }
+            default:
+            {
+                // single channel 32-bit float
+                FMemory::Memcpy(OutRow, Row, NumValues * sizeof(float));
+                break;
+            }
+        }
+    }
+
+    /** Color multiplied by alpha, so transparent pixels don't bleed their color into their neighbours */
+    static void PremultiplyRow(float* Row, int32 SizeX)
+    {
+        const FFloatRegister ColorLanes = MakeVectorRegister(1.0f, 1.0f, 1.0f, 0.0f);
+        const FFloatRegister AlphaLane = MakeVectorRegister(0.0f, 0.0f, 0.0f, 1.0f);
+
+        for (int32 X = 0; X < SizeX; ++X)
+        {
+            // alpha, alpha, alpha, 1
+            const FFloatRegister Pixel = VectorLoad(Row + X * 4);
+            const FFloatRegister Multiplier = VectorMultiplyAdd(VectorReplicate(Pixel, 3), ColorLanes, AlphaLane);
+            VectorStore(VectorMultiply(Pixel, Multiplier), Row + X * 4);
+        }
+    }
+
+    /** Divides the color by alpha again, pixels that end up transparent keep their (nearly black) premultiplied color */
+    static void UnpremultiplyRow(float* Row, int32 SizeX)
+    {
+        const FFloatRegister ColorLanes = MakeVectorRegister(1.0f, 1.0f, 1.0f, 0.0f);
+        const FFloatRegister AlphaLane = MakeVectorRegister(0.0f, 0.0f, 0.0f, 1.0f);
+        const FFloatRegister MinAlpha = VectorSetFloat1(KINDA_SMALL_NUMBER);
+
+        for (int32 X = 0; X < SizeX; ++X)
+        {
+            const FFloatRegister Pixel = VectorLoad(Row + X * 4);
+            const FFloatRegister Divisor = VectorMultiplyAdd(VectorReplicate(Pixel, 3), ColorLanes, AlphaLane);
+            VectorStore(VectorSelect(VectorCompareGT(Divisor, MinAlpha), VectorDivide(Pixel, Divisor), Pixel), Row + X * 4);
+        }
+    }
+
+    /** Expands grayscale row to BGRA with opaque alpha */
+    static void ExpandGrayRow(const float* Source, float* Dest, int32 SizeX)
+    {
+        const FFloatRegister ColorLanes = MakeVectorRegister(1.0f, 1.0f, 1.0f, 0.0f);
+        const FFloatRegister AlphaLane = MakeVectorRegister(0.0f, 0.0f, 0.0f, 1.0f);
+
+        for (int32 X = 0; X < SizeX; ++X)
+        {
+            VectorStore(VectorMultiplyAdd(VectorSetFloat1(Source[X]), ColorLanes, AlphaLane), Dest + X * 4);
+        }
+    }
+
+    static void EncodeRow(const float* Row, FImage& Image, int32 Y)
+    {
+        const int64 NumValues = (int64)Image.SizeX * GetNumChannels(Image.Format);
+        uint8* OutRow = Image.RawData.GetData() + (int64)Y * Image.SizeX * Image.GetBytesPerPixel();
+        const bool bSRGB = Image.GammaSpace != EGammaSpace::Linear;
+        const uint8* LinearToSRGB = GetLinearToSRGBTable();
+
+        const FFloatRegister Max8 = VectorSetFloat1(255.0f);
+        const FFloatRegister Max16 = VectorSetFloat1(65535.0f);
+        const FFloatRegister MaxSRGBIndex = VectorSetFloat1(4095.0f);
+        const FFloatRegister Half = VectorSetFloat1(0.5f);
+
+        // clamped before the truncating store, so it rounds as QuantizeUNorm8
+        auto StoreUNorm8x4 = [&Max8, &Half](const FFloatRegister& Values, uint8* Out)
+        {
+            VectorStoreByte4(VectorMin(VectorMax(VectorMultiplyAdd(Values, Max8, Half), VectorZero()), Max8), Out);
+        };
+
+        // sRGB is a table lookup by the 12-bit linear value, the table indices are computed 4 at a time
+        switch (Image.Format)
+        {
+            case ERawImageFormat::G8:
+            {
+                int64 Index = 0;
+                for (; Index + 4 <= NumValues; Index += 4)
+                {
+                    if (bSRGB)
+                    {
+                        int32 Indices[4];
+                        QuantizeVector(VectorLoad(Row + Index), MaxSRGBIndex, Indices);
+                        for (int32 Lane = 0; Lane < 4; ++Lane)
+                        {
+                            OutRow[Index + Lane] = LinearToSRGB[Indices[Lane]];
+                        }
+                    }
+                    else
+                    {
+                        StoreUNorm8x4(VectorLoad(Row + Index), OutRow + Index);
+                    }
+                }
+                for (; Index < NumValues; ++Index)
+                {
+                    OutRow[Index] = bSRGB ? LinearToSRGB[FMath::Clamp(FMath::RoundToInt(Row[Index] * 4095.0f), 0, 4095)] : QuantizeUNorm8(Row[Index]);
+                }
+                break;
+            }
+            case ERawImageFormat::BGRA8:
+            {
+                for (int64 Index = 0; Index < NumValues; Index += 4)
+                {
+                    if (bSRGB)
+                    {
+                        int32 Indices[4];
+                        QuantizeVector(VectorLoad(Row + Index), MaxSRGBIndex, Indices);
+                        OutRow[Index + 0] = LinearToSRGB[Indices[0]];
+                        OutRow[Index + 1] = LinearToSRGB[Indices[1]];
+                        OutRow[Index + 2] = LinearToSRGB[Indices[2]];
+                        OutRow[Index + 3] = QuantizeUNorm8(Row[Index + 3]);
+                    }
+                    else
+                    {
+                        StoreUNorm8x4(VectorLoad(Row + Index), OutRow + Index);
+                    }
+                }
+                break;
+            }
+            case ERawImageFormat::BGRE8:
+            {
+                FColor* Pixels = reinterpret_cast<FColor*>(OutRow);
+                for (int32 X = 0; X < Image.SizeX; ++X)
+                {
+                    // ringing of the sharper filters must not turn into negative radiance
+                    const FLinearColor Color(
+                        FMath::Max(0.0f, Row[X * 4 + 2]),
+                        FMath::Max(0.0f, Row[X * 4 + 1]),
+                        FMath::Max(0.0f, Row[X * 4 + 0]),
+                        Row[X * 4 + 3]);
+                    Pixels[X] = Color.ToRGBE();
+                }
+                break;
+            }
+            case ERawImageFormat::G16:
+            {
+                uint16* Values = reinterpret_cast<uint16*>(OutRow);
+                int64 Index = 0;
+                for (; Index + 4 <= NumValues; Index += 4)
+                {
+                    int32 Quantized[4];
+                    QuantizeVector(VectorLoad(Row + Index), Max16, Quantized);
+                    for (int32 Lane = 0; Lane < 4; ++Lane)
+                    {
+                        Values[Index + Lane] = (uint16)Quantized[Lane];
+                    }
+                }
+                for (; Index < NumValues; ++Index)
+                {
+                    Values[Index] = QuantizeUNorm16(Row[Index]);
+                }
+                break;
+            }
+            case ERawImageFormat::RGBA16:
+            {
+                uint16* Values = reinterpret_cast<uint16*>(OutRow);
+                for (int64 Index = 0; Index < NumValues; Index += 4)
+                {
+                    int32 Quantized[4];
+                    QuantizeVector(VectorSwizzle(VectorLoad(Row + Index), 2, 1, 0, 3), Max16, Quantized);
+                    for (int32 Lane = 0; Lane < 4; ++Lane)
+                    {
+                        Values[Index + Lane] = (uint16)Quantized[Lane];
+                    }
+                }
+                break;
+            }
+            case ERawImageFormat::R16F:
+            {
+                FFloat16* Values = reinterpret_cast<FFloat16*>(OutRow);
+                for (int64 Index = 0; Index < NumValues; ++Index)
+                {
+                    Values[Index].Set(Row[Index]);
+                }
+                break;
+            }
+            case ERawImageFormat::RGBA16F:
+            {
+                FFloat16* Values = reinterpret_cast<FFloat16*>(OutRow);
+                for (int64 Index = 0; Index < NumValues; Index += 4)
+                {
+                    Values[Index + 0].Set(Row[Index + 2]);
+                    Values[Index + 1].Set(Row[Index + 1]);
+                    Values[Index + 2].Set(Row[Index + 0]);
+                    Values[Index + 3].Set(Row[Index + 3]);
+                }
+                break;
+            }
+            case ERawImageFormat::RGBA32F:
+            {
+                float* Values = reinterpret_cast<float*>(OutRow);
+                for (int64 Index = 0; Index < NumValues; Index += 4)
+                {
+                    VectorStore(VectorSwizzle(VectorLoad(Row + Index), 2, 1, 0, 3), Values + Index);
+                }
+                break;
+            }
+            default:
+            {
+                FMemory::Memcpy(OutRow, Row, NumValues * sizeof(float));
+                break;
+            }
+        }
+    }
+
+    static void FilterRowHorizontal(const float* Source, float* Dest, int32 DestSizeX, int32 NumChannels, const FAxisWeights& Weights)
+    {
+        for (int32 X = 0; X < DestSizeX; ++X)
+        {
+            const float* PixelWeights = Weights.Weights.GetData() + X * Weights.MaxTaps;
+            const float* Taps = Source + Weights.FirstTap[X] * NumChannels;
+            const int32 NumTaps = Weights.NumTaps[X];
+
+            if (NumChannels == 4)
+            {
+                FFloatRegister Sum = VectorZero();
+                for (int32 Tap = 0; Tap < NumTaps; ++Tap)
+                {
+                    Sum = VectorMultiplyAdd(VectorLoad(Taps + Tap * 4), VectorSetFloat1(PixelWeights[Tap]), Sum);
+                }
+                VectorStore(Sum, Dest + X * 4);
+            }
+            else
+            {
+                // single channel taps are contiguous, 4 of them are summed at a time
+                FFloatRegister Sums = VectorZero();
+                int32 Tap = 0;
+                for (; Tap + 4 <= NumTaps; Tap += 4)
+                {
+                    Sums = VectorMultiplyAdd(VectorLoad(Taps + Tap), VectorLoad(PixelWeights + Tap), Sums);
+                }
+
+                float Lanes[4];
+                VectorStore(Sums, Lanes);
+                float Sum = (Lanes[0] + Lanes[1]) + (Lanes[2] + Lanes[3]);
+                for (; Tap < NumTaps; ++Tap)
+                {
+                    Sum += Taps[Tap] * PixelWeights[Tap];
+                }
+                Dest[X] = Sum;
+            }
+        }
+    }
+
+    static void AccumulateRow(const float* Source, float Weight, float* Dest, int32 NumValues)
+    {
+        const FFloatRegister VectorWeight = VectorSetFloat1(Weight);
+
+        int32 Index = 0;
+        for (; Index + 4 <= NumValues; Index += 4)
+        {
+            VectorStore(VectorMultiplyAdd(VectorLoad(Source + Index), VectorWeight, VectorLoad(Dest + Index)), Dest + Index);
+        }
+        for (; Index < NumValues; ++Index)
+        {
+            Dest[Index] += Source[Index] * Weight;
+        }
+    }
+
+    void Resize(const FImage& Source, FImage& Dest, EFilter Filter)
+    {
+        QUICK_SCOPE_CYCLE_COUNTER(STAT_FImageResampler_Resize);
+
+        check(IsConversionSupported(Source.Format, Dest.Format));
+
+        // rows are filtered with the source channels and expanded only when they are encoded
+        const int32 NumChannels = GetNumChannels(Source.Format);
+        const bool bExpandGray = NumChannels < GetNumChannels(Dest.Format);
+
+        // RGBE alpha is always 1
+        const bool bPremultiply = NumChannels == 4 && Source.Format != ERawImageFormat::BGRE8;
+
+        FAxisWeights WeightsX;
+        FAxisWeights WeightsY;
+        ComputeAxisWeights(Source.SizeX, Dest.SizeX, Filter, WeightsX);
+        ComputeAxisWeights(Source.SizeY, Dest.SizeY, Filter, WeightsY);
+
+        const int32 SourceRowValues = Source.SizeX * NumChannels;
+        const int32 DestRowValues = Dest.SizeX * NumChannels;
+
+        // destination rows are produced in bands, each band filters horizontally only the source rows it needs.
+        // Band height keeps its horizontally filtered rows within the budget, they are read once per vertical tap
+        const int64 BandBudgetBytes = 1024 * 1024;
+        const int64 FilteredRowBytes = (int64)DestRowValues * sizeof(float);
+        const int64 FilteredRowsInBudget = FMath::Max<int64>(1, BandBudgetBytes / FilteredRowBytes - WeightsY.MaxTaps);
+        const int32 RowsPerBand = (int32)FMath::Clamp<int64>(FilteredRowsInBudget * Dest.SizeY / Source.SizeY, 4, 64);
+        const int32 NumBands = FMath::DivideAndRoundUp(Dest.SizeY, RowsPerBand);
+
+        ParallelFor(NumBands, [&](int32 Band)
+        {
+            const int32 BeginY = Band * RowsPerBand;
+            const int32 EndY = FMath::Min(BeginY + RowsPerBand, Dest.SizeY);
+
+            int32 FirstSourceY = MAX_int32;
+            int32 LastSourceY = 0;
+            for (int32 Y = BeginY; Y < EndY; ++Y)
+            {
+                FirstSourceY = FMath::Min(FirstSourceY, WeightsY.FirstTap[Y]);
+                LastSourceY = FMath::Max(LastSourceY, WeightsY.FirstTap[Y] + WeightsY.NumTaps[Y] - 1);
+            }
+
+            TArray<float> SourceRow;
+            SourceRow.SetNumUninitialized(SourceRowValues);
+
+            TArray<float> FilteredRows;
+            FilteredRows.SetNumUninitialized((LastSourceY - FirstSourceY + 1) * DestRowValues);
+
+            for (int32 SourceY = FirstSourceY; SourceY <= LastSourceY; ++SourceY)
+            {
+                DecodeRow(Source, SourceY, SourceRow.GetData());
+                if (bPremultiply)
+                {
+                    PremultiplyRow(SourceRow.GetData(), Source.SizeX);
+                }
+                FilterRowHorizontal(SourceRow.GetData(), FilteredRows.GetData() + (SourceY - FirstSourceY) * DestRowValues, Dest.SizeX, NumChannels, WeightsX);
+            }
+
+            TArray<float> DestRow;
+            DestRow.SetNumUninitialized(DestRowValues);
+
+            TArray<float> ExpandedRow;
+            if (bExpandGray)
+            {
+                ExpandedRow.SetNumUninitialized(Dest.SizeX * 4);
+            }
+
+            for (int32 Y = BeginY; Y < EndY; ++Y)
+            {
+                FMemory::Memzero(DestRow.GetData(), DestRowValues * sizeof(float));
+
+                const float* RowWeights = WeightsY.Weights.GetData() + Y * WeightsY.MaxTaps;
+                for (int32 Tap = 0; Tap < WeightsY.NumTaps[Y]; ++Tap)
+                {
+                    const float* FilteredRow = FilteredRows.GetData() + (WeightsY.FirstTap[Y] + Tap - FirstSourceY) * DestRowValues;
+                    AccumulateRow(FilteredRow, RowWeights[Tap], DestRow.GetData(), DestRowValues);
+                }
+
+                if (bPremultiply)
+                {
+                    UnpremultiplyRow(DestRow.GetData(), Dest.SizeX);
+                }
+
+                if (bExpandGray)
+                {
+                    ExpandGrayRow(DestRow.GetData(), ExpandedRow.GetData(), Dest.SizeX);
+                    EncodeRow(ExpandedRow.GetData(), Dest, Y);
+                }
+                else
+                {
+                    EncodeRow(DestRow.GetData(), Dest, Y);
+                }
+            }
+        });
+    }
+
+    int32 GetNumMips(int32 SizeX, int32 SizeY)
+    {
+        return FMath::FloorLog2(FMath::Max(SizeX, SizeY)) + 1;
+    }
+
+    void GenerateMips(FRuntimeImageData& Image, EFilter Filter)
+    {
+        QUICK_SCOPE_CYCLE_COUNTER(STAT_FImageResampler_GenerateMips);
+
+        check(Image.NumMips == 1);
+        check(IsFormatSupported(Image.Format));
+
+        const int32 NumMips = GetNumMips(Image.SizeX, Image.SizeY);
+        if (NumMips <= 1)
+        {
+            return;
+        }
+
+        // mips are a third of mip 0 together, they are filtered into separate images and appended once
+        TArray<FImage> Mips;
+        Mips.Reserve(NumMips - 1);
+
+        const FImage* PreviousMip = &Image;
+        int64 ChainSize = Image.RawData.Num();
+        for (int32 MipIndex = 1; MipIndex < NumMips; ++MipIndex)
+        {
+            FImage& Mip = Mips.AddDefaulted_GetRef();
+            Mip.Init(FMath::Max(1, Image.SizeX >> MipIndex), FMath::Max(1, Image.SizeY >> MipIndex), Image.Format, Image.GammaSpace);
+            Resize(*PreviousMip, Mip, Filter);
+
+            ChainSize += Mip.RawData.Num();
+            PreviousMip = &Mip;
+        }
+
+        int64 Offset = Image.RawData.Num();
+        Image.RawData.SetNumUninitialized(ChainSize);
+        for (const FImage& Mip : Mips)
+        {
+            FMemory::Memcpy(Image.RawData.GetData() + Offset, Mip.RawData.GetData(), Mip.RawData.Num());
+            Offset += Mip.RawData.Num();
+        }
+
+        Image.NumMips = NumMips;
+    }
+}
@@ -0,0 +1,43 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ImageCore.h"
+#include "RuntimeImageData.h"
+
+
+namespace FImageResampler
+{
+    enum class EFilter : uint8
+    {
+        Box,
+        Bilinear,
+        // Catmull-Rom
+        Bicubic,
+        Lanczos3,
+        // Kaiser windowed sinc, sharper mips than box
+        Kaiser
+    };
+
+    bool IsFormatSupported(ERawImageFormat::Type Format);
+
+    /** True if Resize can convert the source format to the destination format, grayscale can be expanded to color but not the other way */
+    bool IsConversionSupported(ERawImageFormat::Type SourceFormat, ERawImageFormat::Type DestFormat);
+
+    /**
+     * Separable resize of the source into the destination image, which must already be initialised with the destination size, format and gamma space.
+     * Rows are filtered in bands on the task graph and encoded to the destination format as each band is done, so there is no intermediate image.
+     * sRGB images are filtered in linear space and RGBE images on decoded values, color is filtered premultiplied by alpha.
+     */
+    void Resize(const FImage& Source, FImage& Dest, EFilter Filter);
+
+    /** Number of mips of the full chain down to 1x1 */
+    int32 GetNumMips(int32 SizeX, int32 SizeY);
+
+    /**
+     * Appends the full mip chain to the single mip image, each mip is filtered from the previous one.
+     * The image must be in a supported format, sRGB images are filtered in linear space.
+     */
+    void GenerateMips(FRuntimeImageData& Image, EFilter Filter);
+}
@@ -0,0 +1,343 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "JPEGHelpers.h"
+#include "RuntimeImageUtils.h"
+
+#if WITH_LIBJPEGTURBO
+#include <stdio.h>
+#include <setjmp.h>
+
+THIRD_PARTY_INCLUDES_START
+#include "jpeglib.h"
+#include "jerror.h"
+THIRD_PARTY_INCLUDES_END
+#endif // WITH_LIBJPEGTURBO
+
+
+namespace FJPEGHelpers
+{
+#if WITH_LIBJPEGTURBO
+    struct FJpegErrorManager
+    {
+        jpeg_error_mgr Base;
+        jmp_buf JumpBuffer;
+        char Message[JMSG_LENGTH_MAX];
+    };
+
+    // default libjpeg error handler calls exit(), so jump back to the caller instead
+    static void HandleJpegError(j_common_ptr CInfo)
+    {
+        FJpegErrorManager* ErrorManager = reinterpret_cast<FJpegErrorManager*>(CInfo->err);
+        (*CInfo->err->format_message)(CInfo, ErrorManager->Message);
+        longjmp(ErrorManager->JumpBuffer, 1);
+    }
+
+    static void HandleJpegMessage(j_common_ptr CInfo)
+    {
+        // silence libjpeg warnings
+    }
+#endif // WITH_LIBJPEGTURBO
+
+    bool IsProgressiveJPEG(const uint8* Buffer, int32 Length)
+    {
+        if (Buffer == nullptr || Length < 4 || Buffer[0] != 0xFF || Buffer[1] != 0xD8)
+        {
+            return false;
+        }
+
+        // walk the marker segments till the first frame header
+        int32 Offset = 2;
+        while (Offset + 4 <= Length)
+        {
+            if (Buffer[Offset] != 0xFF)
+            {
+                return false;
+            }
+
+            const uint8 Marker = Buffer[Offset + 1];
+            if (Marker == 0xFF)
+            {
+                // fill byte
+                ++Offset;
+                continue;
+            }
+
+            switch (Marker)
+            {
+                // SOF2, SOF6, SOF10, SOF14 are progressive frames
+                case 0xC2: case 0xC6: case 0xCA: case 0xCE:
+                    return true;
+
+                // any other SOF or start of scan means baseline/sequential
+                case 0xC0: case 0xC1: case 0xC3: case 0xC5: case 0xC7:
+                case 0xC9: case 0xCB: case 0xCD: case 0xCF: case 0xDA:
+                    return false;
+
+                default:
+                    break;
+            }
+
+            const int32 SegmentLength = (Buffer[Offset + 2] << 8) | Buffer[Offset + 3];
+            Offset += 2 + SegmentLength;
+        }
+
+        return false;
+    }
+
+    bool GetImageSize(const uint8* Buffer, int64 Length, int32& OutWidth, int32& OutHeight)
+    {
+        if (Buffer == nullptr || Length < 4 || Buffer[0] != 0xFF || Buffer[1] != 0xD8)
+        {
+            return false;
+        }
+
+        int64 Offset = 2;
+        while (Offset + 4 <= Length)
+        {
+            if (Buffer[Offset] != 0xFF)
+            {
+                return false;
+            }
+
+            const uint8 Marker = Buffer[Offset + 1];
+            if (Marker == 0xFF)
+            {
+                ++Offset;
+                continue;
+            }
+
+            switch (Marker)
+            {
+                // SOFn: length, precision, height, width
+                case 0xC0: case 0xC1: case 0xC2: case 0xC3: case 0xC5: case 0xC6: case 0xC7:
+                case 0xC9: case 0xCA: case 0xCB: case 0xCD: case 0xCE: case 0xCF:
+                    if (Offset + 9 > Length)
+                    {
+                        return false;
+                    }
+                    OutHeight = (Buffer[Offset + 5] << 8) | Buffer[Offset + 6];
+                    OutWidth = (Buffer[Offset + 7] << 8) | Buffer[Offset + 8];
+                    return OutWidth > 0 && OutHeight > 0;
+
+                // start of scan before any frame header
+                case 0xDA:
+                    return false;
+
+                default:
+                    break;
+            }
+
+            const int32 SegmentLength = (Buffer[Offset + 2] << 8) | Buffer[Offset + 3];
+            Offset += 2 + SegmentLength;
+        }
+
+        return false;
+    }
+
+    bool DecodeProgressivePreview(const uint8* Buffer, int32 Length, FRuntimeImageData& OutImage, FString& OutError)
+    {
+#if WITH_LIBJPEGTURBO
+        QUICK_SCOPE_CYCLE_COUNTER(STAT_JPEGHelpers_DecodeProgressivePreview);
+
+        if (!IsProgressiveJPEG(Buffer, Length))
+        {
+            return false;
+        }
+
+        jpeg_decompress_struct CInfo;
+        FJpegErrorManager ErrorManager;
+
+        CInfo.err = jpeg_std_error(&ErrorManager.Base);
+        ErrorManager.Base.error_exit = HandleJpegError;
+        ErrorManager.Base.output_message = HandleJpegMessage;
+
+        if (setjmp(ErrorManager.JumpBuffer))
+        {
+            jpeg_destroy_decompress(&CInfo);
+
+            OutError = FString::Printf(TEXT("Failed to decode progressive JPEG preview: %s"), ANSI_TO_TCHAR(ErrorManager.Message));
+            return false;
+        }
+
+        jpeg_create_decompress(&CInfo);
+        jpeg_mem_src(&CInfo, const_cast<unsigned char*>(Buffer), Length);
+        jpeg_read_header(&CInfo, TRUE);
+
+        // CMYK can't be converted into BGRA by libjpeg
+        if (!jpeg_has_multiple_scans(&CInfo) || CInfo.jpeg_color_space == JCS_CMYK || CInfo.jpeg_color_space == JCS_YCCK)
+        {
+            jpeg_destroy_decompress(&CInfo);
+            return false;
+        }
+
+        CInfo.buffered_image = TRUE;
+        CInfo.scale_num = 1;
+        CInfo.scale_denom = 8;
+        CInfo.dct_method = JDCT_IFAST;
+        CInfo.out_color_space = JCS_EXT_BGRA;
+
+        jpeg_start_decompress(&CInfo);
+
+        // output pass displays the data up to the first scan, libjpeg consumes the input it needs on the go
+        jpeg_start_output(&CInfo, CInfo.input_scan_number);
+
+        OutImage.Init2D(CInfo.output_width, CInfo.output_height, TSF_BGRA8);
+        OutImage.SRGB = true;
+        OutImage.GammaSpace = EGammaSpace::sRGB;
+
+        const int32 Pitch = CInfo.output_width * 4;
+        while (CInfo.output_scanline < CInfo.output_height)
+        {
+            JSAMPROW Row = OutImage.RawData.GetData() + (int64)CInfo.output_scanline * Pitch;
+            jpeg_read_scanlines(&CInfo, &Row, 1);
+        }
+
+        jpeg_finish_output(&CInfo);
+
+        // memory source ends the data with a fake EOI, the rest of the scan is gray then
+        const bool bTruncated = CInfo.err->num_warnings > 0 && CInfo.err->msg_code == JWRN_JPEG_EOF;
+
+        jpeg_abort_decompress(&CInfo);
+        jpeg_destroy_decompress(&CInfo);
+
+        if (bTruncated)
+        {
+            OutError = TEXT("Progressive JPEG data ends within the first scan");
+            return false;
+        }
+
+        return true;
+#else
+        return false;
+#endif // WITH_LIBJPEGTURBO
+    }
+
+    int32 GetScaleDenominator(float MinScale)
+    {
+        for (int32 ScaleDenom = 8; ScaleDenom > 1; ScaleDenom /= 2)
+        {
+            if (1.0f / ScaleDenom >= MinScale)
+            {
+                return ScaleDenom;
+            }
+        }
+        return 1;
+    }
+
+    bool DecodeScaled(const uint8* Buffer, int64 Length, int32 ScaleDenom, const FIntRect& Region, FRuntimeImageData& OutImage, FString& OutError)
+    {
+#if WITH_LIBJPEGTURBO
+        QUICK_SCOPE_CYCLE_COUNTER(STAT_JPEGHelpers_DecodeScaled);
+
+        jpeg_decompress_struct CInfo;
+        FJpegErrorManager ErrorManager;
+
+        CInfo.err = jpeg_std_error(&ErrorManager.Base);
+        ErrorManager.Base.error_exit = HandleJpegError;
+        ErrorManager.Base.output_message = HandleJpegMessage;
+
+        if (setjmp(ErrorManager.JumpBuffer))
+        {
+            jpeg_destroy_decompress(&CInfo);
+
+            OutError = FString::Printf(TEXT("Failed to decode scaled JPEG: %s"), ANSI_TO_TCHAR(ErrorManager.Message));
+            return false;
+        }
+
+        jpeg_create_decompress(&CInfo);
+        jpeg_mem_src(&CInfo, const_cast<unsigned char*>(Buffer), (unsigned long)Length);
+        jpeg_read_header(&CInfo, TRUE);
+
+        // CMYK can't be converted into BGRA by libjpeg
+        if (CInfo.jpeg_color_space == JCS_CMYK || CInfo.jpeg_color_space == JCS_YCCK)
+        {
+            jpeg_destroy_decompress(&CInfo);
+            return false;
+        }
+
+        const bool bGrayscale = CInfo.jpeg_color_space == JCS_GRAYSCALE;
+
+        CInfo.scale_num = 1;
+        CInfo.scale_denom = ScaleDenom;
+        CInfo.out_color_space = bGrayscale ? JCS_GRAYSCALE : JCS_EXT_BGRA;
+
+        jpeg_start_decompress(&CInfo);
+
+        // rows and columns of the scaled output to decode
+        JDIMENSION FirstRow = 0;
+        JDIMENSION EndRow = CInfo.output_height;
+        if (Region.Area() > 0)
+        {
+            const FIntRect Clipped(
+                FMath::Max(Region.Min.X, 0), FMath::Max(Region.Min.Y, 0),
+                FMath::Min<int32>(Region.Max.X, CInfo.image_width), FMath::Min<int32>(Region.Max.Y, CInfo.image_height));
+            if (Clipped.Width() <= 0 || Clipped.Height() <= 0)
+            {
+                jpeg_destroy_decompress(&CInfo);
+
+                OutError = FString::Printf(TEXT("Region %s is outside of the image"), *Region.ToString());
+                return false;
+            }
+
+            // libjpeg widens the columns to the iMCU boundaries
+            JDIMENSION FirstColumn = Clipped.Min.X / ScaleDenom;
+            JDIMENSION NumColumns = FMath::Min<JDIMENSION>(FMath::DivideAndRoundUp(Clipped.Max.X, ScaleDenom), CInfo.output_width) - FirstColumn;
+            jpeg_crop_scanline(&CInfo, &FirstColumn, &NumColumns);
+
+            FirstRow = Clipped.Min.Y / ScaleDenom;
+            EndRow = FMath::Min<JDIMENSION>(FMath::DivideAndRoundUp(Clipped.Max.Y, ScaleDenom), CInfo.output_height);
+
+            OutImage.DecodedRegion = FIntRect(
+                FirstColumn * ScaleDenom, FirstRow * ScaleDenom,
+                FMath::Min<int32>((FirstColumn + NumColumns) * ScaleDenom, CInfo.image_width), FMath::Min<int32>(EndRow * ScaleDenom, CInfo.image_height));
+        }
+
+        // the region or the scale may still leave more pixels than a texture can hold
+        const int32 OutputWidth = CInfo.output_width;
+        const int32 OutputHeight = EndRow - FirstRow;
+        if (!FRuntimeImageUtils::IsImportResolutionValid(OutputWidth, OutputHeight, true))
+        {
+            jpeg_destroy_decompress(&CInfo);
+
+            OutError = FString::Printf(TEXT("Texture resolution is not supported: %d x %d"), OutputWidth, OutputHeight);
+            return false;
+        }
+
+        OutImage.Init2D(OutputWidth, OutputHeight, bGrayscale ? TSF_G8 : TSF_BGRA8);
+        OutImage.SourceSizeX = CInfo.image_width;
+        OutImage.SourceSizeY = CInfo.image_height;
+        OutImage.SRGB = true;
+        OutImage.GammaSpace = EGammaSpace::sRGB;
+        OutImage.AlphaUsage = ERuntimeImageAlphaUsage::Opaque;
+
+        if (FirstRow > 0)
+        {
+            jpeg_skip_scanlines(&CInfo, FirstRow);
+        }
+
+        const int64 Pitch = (int64)CInfo.output_width * CInfo.output_components;
+        while (CInfo.output_scanline < EndRow)
+        {
+            // libjpeg hands out up to rec_outbuf_height rows per call
+            JSAMPROW Rows[4];
+            const int32 NumRows = FMath::Min<int32>(UE_ARRAY_COUNT(Rows), EndRow - CInfo.output_scanline);
+            for (int32 RowIndex = 0; RowIndex < NumRows; ++RowIndex)
+            {
+                Rows[RowIndex] = OutImage.RawData.GetData() + (CInfo.output_scanline - FirstRow + RowIndex) * Pitch;
+            }
+            jpeg_read_scanlines(&CInfo, Rows, NumRows);
+        }
+
+        // rows below the region are never decoded, finishing would fail on them
+        if (CInfo.output_scanline == CInfo.output_height)
+        {
+            jpeg_finish_decompress(&CInfo);
+        }
+        jpeg_destroy_decompress(&CInfo);
+
+        return true;
+#else
+        return false;
+#endif // WITH_LIBJPEGTURBO
+    }
+}
@@ -0,0 +1,35 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "RuntimeImageData.h"
+
+
+namespace FJPEGHelpers
+{
+    /** Returns true if the buffer is a progressive (multi-scan) JPEG */
+    bool IsProgressiveJPEG(const uint8* Buffer, int32 Length);
+
+    /** Reads the image size from the frame header without initialising the decoder */
+    bool GetImageSize(const uint8* Buffer, int64 Length, int32& OutWidth, int32& OutHeight);
+
+    /**
+     * Decodes only the first scan of a progressive JPEG at 1/8 scale into BGRA8.
+     * The first scan usually carries the DC coefficients only, so the 1/8 scale result is as detailed as it gets.
+     * The buffer may be a prefix of the file, it fails if the prefix ends within the first scan.
+     */
+    bool DecodeProgressivePreview(const uint8* Buffer, int32 Length, FRuntimeImageData& OutImage, FString& OutError);
+
+    /** Returns denominator of the smallest DCT scale (1/2, 1/4 or 1/8) that keeps the image at least MinScale of its size, 1 if there is none */
+    int32 GetScaleDenominator(float MinScale);
+
+    /**
+     * Decodes JPEG downscaled by 1/ScaleDenom in DCT domain into BGRA8 or G8, which is much faster than decoding at full size and resizing.
+     * If the region (in pixels of the encoded image) is not empty, the rows above and below it are skipped and only the iMCU columns
+     * it touches are decoded. The decoded part is set as DecodedRegion of the image, it may be larger than the region.
+     * Returns false without an error if the image can't be decoded this way (e.g. CMYK), it has to be decoded at full size then.
+     */
+    bool DecodeScaled(const uint8* Buffer, int64 Length, int32 ScaleDenom, const FIntRect& Region, FRuntimeImageData& OutImage, FString& OutError);
+}
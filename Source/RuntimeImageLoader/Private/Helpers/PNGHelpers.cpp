@@ -1,9 +1,136 @@
 // Copyright 2023 Petr Leontev. All Rights Reserved.
 
 #include "PNGHelpers.h"
+#include "RuntimeImageUtils.h"
+#include "SIMDHelpers.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "zlib.h"
+
+#if WITH_FASTPNG
+#if RIL_SIMD_SSE4_1
+#define FASTPNG_SSE41 1
+#elif RIL_SIMD_NEON
+#define FASTPNG_NEON 1
+#endif
+#define FASTPNG_MALLOC(sz) FMemory::Malloc(sz)
+#define FASTPNG_FREE(p) FMemory::Free(p)
+#define FASTPNG_IMPLEMENTATION 1
+#include "fastpng.h"
+#endif // WITH_FASTPNG
+THIRD_PARTY_INCLUDES_END
 
 namespace FPNGHelpers
 {
+    int32 FindPixel(const uint32* Row, int32 Count, uint32 Value)
+    {
+        int32 X = 0;
+#if RIL_SIMD_SSE4_1
+        const __m128i Values = _mm_set1_epi32((int32)Value);
+        for (; X + 4 <= Count; X += 4)
+        {
+            const int32 Mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(Row + X)), Values)));
+            if (Mask != 0)
+            {
+                return X + FMath::CountTrailingZeros((uint32)Mask);
+            }
+        }
+#elif RIL_SIMD_NEON
+        const uint32x4_t Values = vdupq_n_u32(Value);
+        for (; X + 4 <= Count; X += 4)
+        {
+            if (vmaxvq_u32(vceqq_u32(vld1q_u32(Row + X), Values)) != 0)
+            {
+                break;
+            }
+        }
+#endif
+        for (; X < Count; ++X)
+        {
+            if (Row[X] == Value)
+            {
+                return X;
+            }
+        }
+        return Count;
+    }
+
+    int32 FindPixel(const uint64* Row, int32 Count, uint64 Value)
+    {
+        for (int32 X = 0; X < Count; ++X)
+        {
+            if (Row[X] == Value)
+            {
+                return X;
+            }
+        }
+        return Count;
+    }
+
+    void CopyColor(uint32* Dest, const uint32* Source, int32 Count)
+    {
+        int32 X = 0;
+#if RIL_SIMD_SSE4_1
+        const __m128i AlphaMask = _mm_set1_epi32((int32)0xFF000000);
+        for (; X + 4 <= Count; X += 4)
+        {
+            const __m128i Pixels = _mm_blendv_epi8(_mm_loadu_si128((const __m128i*)(Source + X)), _mm_loadu_si128((const __m128i*)(Dest + X)), AlphaMask);
+            _mm_storeu_si128((__m128i*)(Dest + X), Pixels);
+        }
+#elif RIL_SIMD_NEON
+        const uint32x4_t AlphaMask = vdupq_n_u32(0xFF000000);
+        for (; X + 4 <= Count; X += 4)
+        {
+            vst1q_u32(Dest + X, vbslq_u32(AlphaMask, vld1q_u32(Dest + X), vld1q_u32(Source + X)));
+        }
+#endif
+        for (; X < Count; ++X)
+        {
+            Dest[X] = (Dest[X] & 0xFF000000) | (Source[X] & 0x00FFFFFF);
+        }
+    }
+
+    void CopyColor(uint64* Dest, const uint64* Source, int32 Count)
+    {
+        for (int32 X = 0; X < Count; ++X)
+        {
+            Dest[X] = (Dest[X] & 0xFFFF000000000000ull) | (Source[X] & 0x0000FFFFFFFFFFFFull);
+        }
+    }
+
+    void SetColor(uint32* Dest, int32 Count, uint32 Color)
+    {
+        int32 X = 0;
+#if RIL_SIMD_SSE4_1
+        const __m128i AlphaMask = _mm_set1_epi32((int32)0xFF000000);
+        const __m128i Colors = _mm_set1_epi32((int32)(Color & 0x00FFFFFF));
+        for (; X + 4 <= Count; X += 4)
+        {
+            const __m128i Alpha = _mm_and_si128(_mm_loadu_si128((const __m128i*)(Dest + X)), AlphaMask);
+            _mm_storeu_si128((__m128i*)(Dest + X), _mm_or_si128(Alpha, Colors));
+        }
+#elif RIL_SIMD_NEON
+        const uint32x4_t AlphaMask = vdupq_n_u32(0xFF000000);
+        const uint32x4_t Colors = vdupq_n_u32(Color);
+        for (; X + 4 <= Count; X += 4)
+        {
+            vst1q_u32(Dest + X, vbslq_u32(AlphaMask, vld1q_u32(Dest + X), Colors));
+        }
+#endif
+        for (; X < Count; ++X)
+        {
+            Dest[X] = (Dest[X] & 0xFF000000) | (Color & 0x00FFFFFF);
+        }
+    }
+
+    void SetColor(uint64* Dest, int32 Count, uint64 Color)
+    {
+        for (int32 X = 0; X < Count; ++X)
+        {
+            Dest[X] = (Dest[X] & 0xFFFF000000000000ull) | (Color & 0x0000FFFFFFFFFFFFull);
+        }
+    }
+
     void FillZeroAlphaPNGData(int32 SizeX, int32 SizeY, ETextureSourceFormat SourceFormat, uint8* SourceData)
     {
         switch (SourceFormat)
@@ -23,4 +150,449 @@ namespace FPNGHelpers
             }
         }
     }
-}
\ No newline at end of file
+
+    static const uint8 PNGSignature[8] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+
+    struct FPNGHeader
+    {
+        int32 Width = 0;
+        int32 Height = 0;
+        uint8 BitDepth = 0;
+        uint8 ColorType = 0;
+        uint8 Interlace = 0;
+    };
+
+    struct FAdam7Pass
+    {
+        int32 StartX;
+        int32 StartY;
+        int32 StepX;
+        int32 StepY;
+    };
+
+    static const FAdam7Pass Adam7Passes[7] =
+    {
+        { 0, 0, 8, 8 }, { 4, 0, 8, 8 }, { 0, 4, 4, 8 }, { 2, 0, 4, 4 }, { 0, 2, 2, 4 }, { 1, 0, 2, 2 }, { 0, 1, 1, 2 }
+    };
+
+    static uint32 ReadBigEndian32(const uint8* Data)
+    {
+        return (uint32(Data[0]) << 24) | (uint32(Data[1]) << 16) | (uint32(Data[2]) << 8) | uint32(Data[3]);
+    }
+
+    static bool ReadPNGHeader(const uint8* Buffer, int32 Length, FPNGHeader& OutHeader)
+    {
+        // signature + IHDR chunk, which is always the first one
+        if (Buffer == nullptr || Length < 33 || FMemory::Memcmp(Buffer, PNGSignature, sizeof(PNGSignature)) != 0)
+        {
+            return false;
+        }
+
+        if (ReadBigEndian32(Buffer + 8) != 13 || FMemory::Memcmp(Buffer + 12, "IHDR", 4) != 0)
+        {
+            return false;
+        }
+
+        OutHeader.Width = ReadBigEndian32(Buffer + 16);
+        OutHeader.Height = ReadBigEndian32(Buffer + 20);
+        OutHeader.BitDepth = Buffer[24];
+        OutHeader.ColorType = Buffer[25];
+        OutHeader.Interlace = Buffer[28];
+
+        return OutHeader.Width > 0 && OutHeader.Height > 0;
+    }
+
+    static int32 GetNumChannels(uint8 ColorType)
+    {
+        switch (ColorType)
+        {
+            case 0: return 1; // gray
+            case 2: return 3; // rgb
+            case 3: return 1; // palette
+            case 4: return 2; // gray + alpha
+            case 6: return 4; // rgba
+            default: return 0;
+        }
+    }
+
+    static uint8 PaethPredictor(int32 A, int32 B, int32 C)
+    {
+        const int32 P = A + B - C;
+        const int32 PA = FMath::Abs(P - A);
+        const int32 PB = FMath::Abs(P - B);
+        const int32 PC = FMath::Abs(P - C);
+
+        if (PA <= PB && PA <= PC)
+        {
+            return A;
+        }
+        return (PB <= PC) ? B : C;
+    }
+
+    static bool UnfilterRow(uint8 FilterType, uint8* Row, const uint8* PrevRow, int32 RowBytes, int32 Bpp)
+    {
+        switch (FilterType)
+        {
+            case 0:
+                break;
+            case 1:
+                for (int32 Index = Bpp; Index < RowBytes; ++Index)
+                {
+                    Row[Index] += Row[Index - Bpp];
+                }
+                break;
+            case 2:
+                if (PrevRow)
+                {
+                    for (int32 Index = 0; Index < RowBytes; ++Index)
+                    {
+                        Row[Index] += PrevRow[Index];
+                    }
+                }
+                break;
+            case 3:
+                for (int32 Index = 0; Index < RowBytes; ++Index)
+                {
+                    const int32 Left = Index >= Bpp ? Row[Index - Bpp] : 0;
+                    const int32 Up = PrevRow ? PrevRow[Index] : 0;
+                    Row[Index] += uint8((Left + Up) >> 1);
+                }
+                break;
+            case 4:
+                for (int32 Index = 0; Index < RowBytes; ++Index)
+                {
+                    const int32 Left = Index >= Bpp ? Row[Index - Bpp] : 0;
+                    const int32 Up = PrevRow ? PrevRow[Index] : 0;
+                    const int32 UpLeft = (PrevRow && Index >= Bpp) ? PrevRow[Index - Bpp] : 0;
+                    Row[Index] += PaethPredictor(Left, Up, UpLeft);
+                }
+                break;
+            default:
+                return false;
+        }
+
+        return true;
+    }
+
+    /** Reads one channel of a pixel from an unfiltered row and returns it as 8-bit value */
+    static uint8 ReadSample(const uint8* Row, int32 X, int32 Channel, int32 NumChannels, int32 BitDepth, bool bScaleLowBitDepth)
+    {
+        if (BitDepth == 8)
+        {
+            return Row[X * NumChannels + Channel];
+        }
+
+        if (BitDepth == 16)
+        {
+            // high byte is good enough for preview
+            return Row[(X * NumChannels + Channel) * 2];
+        }
+
+        // 1, 2 and 4 bit samples only exist for single channel images
+        const int32 BitOffset = X * BitDepth;
+        const int32 MaxValue = (1 << BitDepth) - 1;
+        const int32 Value = (Row[BitOffset >> 3] >> (8 - BitDepth - (BitOffset & 7))) & MaxValue;
+
+        return bScaleLowBitDepth ? uint8(Value * 255 / MaxValue) : uint8(Value);
+    }
+
+    bool IsInterlacedPNG(const uint8* Buffer, int32 Length)
+    {
+        FPNGHeader Header;
+        return ReadPNGHeader(Buffer, Length, Header) && Header.Interlace == 1;
+    }
+
+    bool DecodeInterlacedPreview(const uint8* Buffer, int32 Length, FRuntimeImageData& OutImage, FString& OutError)
+    {
+        QUICK_SCOPE_CYCLE_COUNTER(STAT_PNGHelpers_DecodeInterlacedPreview);
+
+        FPNGHeader Header;
+        if (!ReadPNGHeader(Buffer, Length, Header) || Header.Interlace != 1)
+        {
+            return false;
+        }
+
+        const int32 NumChannels = GetNumChannels(Header.ColorType);
+        if (NumChannels == 0 || (Header.BitDepth < 8 && NumChannels != 1) || Header.BitDepth > 16)
+        {
+            OutError = FString::Printf(TEXT("Unsupported PNG color type: %d, bit depth: %d"), Header.ColorType, Header.BitDepth);
+            return false;
+        }
+
+        const int32 BitsPerPixel = NumChannels * Header.BitDepth;
+        const int32 Bpp = FMath::Max(1, BitsPerPixel / 8);
+
+        // only the first three passes are needed for every 4th pixel in both directions
+        constexpr int32 NumPreviewPasses = 3;
+        constexpr int32 PreviewStep = 4;
+
+        int32 PassWidth[NumPreviewPasses];
+        int32 PassHeight[NumPreviewPasses];
+        int64 PassRowBytes[NumPreviewPasses];
+        int64 RequiredBytes = 0;
+
+        for (int32 Pass = 0; Pass < NumPreviewPasses; ++Pass)
+        {
+            const FAdam7Pass& Adam7Pass = Adam7Passes[Pass];
+            PassWidth[Pass] = FMath::Max(0, (Header.Width - Adam7Pass.StartX + Adam7Pass.StepX - 1) / Adam7Pass.StepX);
+            PassHeight[Pass] = FMath::Max(0, (Header.Height - Adam7Pass.StartY + Adam7Pass.StepY - 1) / Adam7Pass.StepY);
+            PassRowBytes[Pass] = ((int64)PassWidth[Pass] * BitsPerPixel + 7) / 8;
+
+            // empty passes don't even store filter bytes
+            if (PassWidth[Pass] > 0 && PassHeight[Pass] > 0)
+            {
+                RequiredBytes += PassHeight[Pass] * (PassRowBytes[Pass] + 1);
+            }
+        }
+
+        if (RequiredBytes <= 0 || RequiredBytes > MAX_uint32)
+        {
+            return false;
+        }
+
+        TArray64<uint8> PassData;
+        PassData.SetNumUninitialized(RequiredBytes);
+
+        const uint8* Palette = nullptr;
+        int32 PaletteSize = 0;
+        const uint8* Transparency = nullptr;
+        int32 TransparencySize = 0;
+
+        z_stream Stream;
+        FMemory::Memzero(Stream);
+        if (inflateInit(&Stream) != Z_OK)
+        {
+            OutError = TEXT("Failed to initialize zlib stream");
+            return false;
+        }
+
+        Stream.next_out = PassData.GetData();
+        Stream.avail_out = (uInt)RequiredBytes;
+
+        // walk the chunks and inflate the leading part of the IDAT stream
+        int64 Offset = sizeof(PNGSignature);
+        while (Offset + 12 <= Length && Stream.avail_out > 0)
+        {
+            const uint32 ChunkLength = ReadBigEndian32(Buffer + Offset);
+            const uint8* ChunkType = Buffer + Offset + 4;
+            const uint8* ChunkData = Buffer + Offset + 8;
+
+            if (Offset + 12 + ChunkLength > (uint64)Length)
+            {
+                // buffer may be a prefix of the file that ends within an IDAT chunk, its available part is inflated too
+                if (FMemory::Memcmp(ChunkType, "IDAT", 4) == 0)
+                {
+                    Stream.next_in = const_cast<Bytef*>(ChunkData);
+                    Stream.avail_in = (uInt)(Length - Offset - 8);
+                    inflate(&Stream, Z_NO_FLUSH);
+                }
+                break;
+            }
+
+            if (FMemory::Memcmp(ChunkType, "PLTE", 4) == 0)
+            {
+                Palette = ChunkData;
+                PaletteSize = ChunkLength / 3;
+            }
+            else if (FMemory::Memcmp(ChunkType, "tRNS", 4) == 0)
+            {
+                Transparency = ChunkData;
+                TransparencySize = ChunkLength;
+            }
+            else if (FMemory::Memcmp(ChunkType, "IDAT", 4) == 0)
+            {
+                Stream.next_in = const_cast<Bytef*>(ChunkData);
+                Stream.avail_in = ChunkLength;
+
+                const int32 Result = inflate(&Stream, Z_NO_FLUSH);
+                if (Result != Z_OK && Result != Z_STREAM_END && Result != Z_BUF_ERROR)
+                {
+                    break;
+                }
+            }
+            else if (FMemory::Memcmp(ChunkType, "IEND", 4) == 0)
+            {
+                break;
+            }
+
+            Offset += 12 + ChunkLength;
+        }
+
+        const bool bInflated = Stream.avail_out == 0;
+        inflateEnd(&Stream);
+
+        if (!bInflated)
+        {
+            OutError = TEXT("Interlaced PNG data is truncated");
+            return false;
+        }
+
+        if (Header.ColorType == 3 && Palette == nullptr)
+        {
+            OutError = TEXT("Palette PNG doesn't have PLTE chunk");
+            return false;
+        }
+
+        const int32 PreviewSizeX = (Header.Width + PreviewStep - 1) / PreviewStep;
+        const int32 PreviewSizeY = (Header.Height + PreviewStep - 1) / PreviewStep;
+
+        OutImage.Init2D(PreviewSizeX, PreviewSizeY, TSF_BGRA8);
+        OutImage.SRGB = true;
+        OutImage.GammaSpace = EGammaSpace::sRGB;
+
+        uint8* PreviewData = OutImage.RawData.GetData();
+        uint8* PassRow = PassData.GetData();
+
+        for (int32 Pass = 0; Pass < NumPreviewPasses; ++Pass)
+        {
+            if (PassWidth[Pass] == 0 || PassHeight[Pass] == 0)
+            {
+                continue;
+            }
+
+            const FAdam7Pass& Adam7Pass = Adam7Passes[Pass];
+            const uint8* PrevRow = nullptr;
+
+            for (int32 PassY = 0; PassY < PassHeight[Pass]; ++PassY)
+            {
+                uint8* Row = PassRow + 1;
+                if (!UnfilterRow(PassRow[0], Row, PrevRow, (int32)PassRowBytes[Pass], Bpp))
+                {
+                    OutError = FString::Printf(TEXT("Invalid PNG filter type: %d"), PassRow[0]);
+                    return false;
+                }
+
+                const int32 Y = Adam7Pass.StartY + PassY * Adam7Pass.StepY;
+                uint8* PreviewRow = PreviewData + (int64)(Y / PreviewStep) * PreviewSizeX * 4;
+
+                for (int32 PassX = 0; PassX < PassWidth[Pass]; ++PassX)
+                {
+                    const int32 X = Adam7Pass.StartX + PassX * Adam7Pass.StepX;
+                    if (X % PreviewStep != 0)
+                    {
+                        continue;
+                    }
+
+                    uint8* Pixel = PreviewRow + (X / PreviewStep) * 4;
+                    switch (Header.ColorType)
+                    {
+                        case 0:
+                        {
+                            const uint8 Gray = ReadSample(Row, PassX, 0, 1, Header.BitDepth, true);
+                            Pixel[0] = Gray; Pixel[1] = Gray; Pixel[2] = Gray; Pixel[3] = 255;
+                            break;
+                        }
+                        case 2:
+                        {
+                            Pixel[0] = ReadSample(Row, PassX, 2, 3, Header.BitDepth, true);
+                            Pixel[1] = ReadSample(Row, PassX, 1, 3, Header.BitDepth, true);
+                            Pixel[2] = ReadSample(Row, PassX, 0, 3, Header.BitDepth, true);
+                            Pixel[3] = 255;
+                            break;
+                        }
+                        case 3:
+                        {
+                            const int32 Index = ReadSample(Row, PassX, 0, 1, Header.BitDepth, false);
+                            if (Index < PaletteSize)
+                            {
+                                Pixel[0] = Palette[Index * 3 + 2];
+                                Pixel[1] = Palette[Index * 3 + 1];
+                                Pixel[2] = Palette[Index * 3];
+                            }
+                            else
+                            {
+                                Pixel[0] = Pixel[1] = Pixel[2] = 0;
+                            }
+                            Pixel[3] = (Index < TransparencySize) ? Transparency[Index] : 255;
+                            break;
+                        }
+                        case 4:
+                        {
+                            const uint8 Gray = ReadSample(Row, PassX, 0, 2, Header.BitDepth, true);
+                            Pixel[0] = Gray; Pixel[1] = Gray; Pixel[2] = Gray;
+                            Pixel[3] = ReadSample(Row, PassX, 1, 2, Header.BitDepth, true);
+                            break;
+                        }
+                        case 6:
+                        {
+                            Pixel[0] = ReadSample(Row, PassX, 2, 4, Header.BitDepth, true);
+                            Pixel[1] = ReadSample(Row, PassX, 1, 4, Header.BitDepth, true);
+                            Pixel[2] = ReadSample(Row, PassX, 0, 4, Header.BitDepth, true);
+                            Pixel[3] = ReadSample(Row, PassX, 3, 4, Header.BitDepth, true);
+                            break;
+                        }
+                    }
+                }
+
+                PrevRow = Row;
+                PassRow += PassRowBytes[Pass] + 1;
+            }
+        }
+
+        return true;
+    }
+
+    bool DecodeFast(const uint8* Buffer, int64 Length, FRuntimeImageData& OutImage, FString& OutError)
+    {
+#if WITH_FASTPNG
+        QUICK_SCOPE_CYCLE_COUNTER(STAT_FPNGHelpers_DecodeFast);
+
+        fastpng_desc Desc;
+        if (!fastpng_read_header(Buffer, Length, &Desc))
+        {
+            return false;
+        }
+
+        if (!FRuntimeImageUtils::IsImportResolutionValid(Desc.width, Desc.height, true))
+        {
+            OutError = FString::Printf(TEXT("Texture resolution is not supported: %u x %u"), Desc.width, Desc.height);
+            return false;
+        }
+
+        const int32 SizeX = Desc.width;
+        const int32 SizeY = Desc.height;
+
+        TArray64<uint8> RawPNG;
+        RawPNG.SetNumUninitialized((int64)SizeX * SizeY * Desc.out_channels);
+
+        typedef PNGDataFill<uint8, uint32, 2, 1, 0, 3> FBGRADataFill;
+        FBGRADataFill Fill(SizeX, SizeY, RawPNG.GetData());
+
+        // the fill only looks at the rows above the current one, so it runs while the rows are still in cache
+        fastpng_row_callback RowCallback = nullptr;
+        if (Desc.has_alpha)
+        {
+            RowCallback = [](void* User, unsigned int Y, unsigned char* Row)
+            {
+                static_cast<FBGRADataFill*>(User)->ProcessRow(Y);
+            };
+        }
+
+        if (!fastpng_decode(Buffer, Length, &Desc, RawPNG.GetData(), RowCallback, &Fill))
+        {
+            OutError = TEXT("Failed to decode PNG image data");
+            return false;
+        }
+
+        if (Desc.has_alpha)
+        {
+            Fill.Finish();
+        }
+
+        if (!OutImage.Init2D(SizeX, SizeY, Desc.out_channels == 1 ? TSF_G8 : TSF_BGRA8, MoveTemp(RawPNG), OutError))
+        {
+            return false;
+        }
+        OutImage.SRGB = true;
+        OutImage.GammaSpace = EGammaSpace::sRGB;
+        if (!Desc.has_alpha)
+        {
+            OutImage.AlphaUsage = ERuntimeImageAlphaUsage::Opaque;
+        }
+
+        return true;
+#else
+        return false;
+#endif // WITH_FASTPNG
+    }
+}
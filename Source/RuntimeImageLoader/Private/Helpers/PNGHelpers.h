@@ -10,12 +10,28 @@
 
 namespace FPNGHelpers
 {
+    // Row kernels of the zero alpha fill. Pixels are compared and copied as whole words, alpha is the most significant channel.
+
+    /** Returns index of the first pixel equal to Value or Count if there is none */
+    int32 FindPixel(const uint32* Row, int32 Count, uint32 Value);
+    int32 FindPixel(const uint64* Row, int32 Count, uint64 Value);
+
+    /** Copies color channels of the source pixels keeping the destination alpha */
+    void CopyColor(uint32* Dest, const uint32* Source, int32 Count);
+    void CopyColor(uint64* Dest, const uint64* Source, int32 Count);
+
+    /** Sets color channels of the pixels to the color keeping their alpha */
+    void SetColor(uint32* Dest, int32 Count, uint32 Color);
+    void SetColor(uint64* Dest, int32 Count, uint64 Color);
+
     /**
      * This fills any pixels of a texture with have an alpha value of zero,
      * with an RGB from the nearest neighboring pixel which has non-zero alpha.
     */
     template<typename PixelDataType, typename ColorDataType, int32 RIdx, int32 GIdx, int32 BIdx, int32 AIdx> class PNGDataFill
     {
+        static_assert(AIdx == 3, "Color channels are copied as the low bits of the pixel");
+
     public:
 
         PNGDataFill(int32 SizeX, int32 SizeY, uint8* SourceTextureData)
@@ -27,27 +43,35 @@ namespace FPNGHelpers
 
         void ProcessData()
         {
-            int32 NumZeroedTopRowsToProcess = 0;
-            int32 FillColorRow = -1;
             for (int32 Y = 0; Y < TextureHeight; ++Y)
             {
-                if (!ProcessHorizontalRow(Y))
+                ProcessRow(Y);
+            }
+            Finish();
+        }
+
+        /* rows can be processed as soon as they are decoded, top to bottom */
+        void ProcessRow(int32 Y)
+        {
+            if (!ProcessHorizontalRow(Y))
+            {
+                if (FillColorRow != -1)
                 {
-                    if (FillColorRow != -1)
-                    {
-                        FillRowColorPixels(FillColorRow, Y);
-                    }
-                    else
-                    {
-                        NumZeroedTopRowsToProcess = Y;
-                    }
+                    FillRowColorPixels(FillColorRow, Y);
                 }
                 else
                 {
-                    FillColorRow = Y;
+                    NumZeroedTopRowsToProcess = Y;
                 }
             }
+            else
+            {
+                FillColorRow = Y;
+            }
+        }
 
+        void Finish()
+        {
             // Can only fill upwards if image not fully zeroed
             if (NumZeroedTopRowsToProcess > 0 && NumZeroedTopRowsToProcess + 1 < TextureHeight)
             {
@@ -62,37 +86,40 @@ namespace FPNGHelpers
         bool ProcessHorizontalRow(int32 Y)
         {
             // only wipe out colors that are affected by png turning valid colors white if alpha = 0
-            const uint32 WhiteWithZeroAlpha = FColor(255, 255, 255, 0).DWColor();
+            const ColorDataType WhiteWithZeroAlpha = FColor(255, 255, 255, 0).DWColor();
+
+            ColorDataType* Row = GetRow(Y);
+
+            // rows without white zero alpha pixels are left as they are after a vectorised scan
+            int32 X = FindPixel(Row, TextureWidth, WhiteWithZeroAlpha);
+            if (X == TextureWidth)
+            {
+                return true;
+            }
 
-            // Left -> Right
+            // Left -> Right, run by run
             int32 NumLeftmostZerosToProcess = 0;
-            const PixelDataType* FillColor = nullptr;
-            for (int32 X = 0; X < TextureWidth; ++X)
+            while (X < TextureWidth)
             {
-                PixelDataType* PixelData = SourceData + (Y * TextureWidth + X) * 4;
-                ColorDataType* ColorData = reinterpret_cast<ColorDataType*>(PixelData);
+                int32 RunEnd = X + 1;
+                while (RunEnd < TextureWidth && Row[RunEnd] == WhiteWithZeroAlpha)
+                {
+                    ++RunEnd;
+                }
 
-                if (*ColorData == WhiteWithZeroAlpha)
+                if (X > 0)
                 {
-                    if (FillColor)
-                    {
-                        PixelData[RIdx] = FillColor[RIdx];
-                        PixelData[GIdx] = FillColor[GIdx];
-                        PixelData[BIdx] = FillColor[BIdx];
-                    }
-                    else
-                    {
-                        // Mark pixel as needing fill
-                        *ColorData = 0;
-
-                        // Keep track of how many pixels to fill starting at beginning of row
-                        NumLeftmostZerosToProcess = X;
-                    }
+                    // pixel before the run is the nearest one with a color
+                    SetColor(Row + X, RunEnd - X, Row[X - 1]);
                 }
                 else
                 {
-                    FillColor = PixelData;
+                    // Mark pixels as needing fill, they are filled after the pass from the right
+                    FMemory::Memzero(Row, RunEnd * sizeof(ColorDataType));
+                    NumLeftmostZerosToProcess = RunEnd - 1;
                 }
+
+                X = RunEnd + FindPixel(Row + RunEnd, TextureWidth - RunEnd, WhiteWithZeroAlpha);
             }
 
             if (NumLeftmostZerosToProcess == 0)
@@ -107,37 +134,46 @@ namespace FPNGHelpers
                 return false;
             }
 
-            // Fill using non zero pixel immediately to the right of the beginning series of zeros
-            FillColor = SourceData + (Y * TextureWidth + NumLeftmostZerosToProcess + 1) * 4;
-
-            // Fill zero pixels found at beginning of row that could not be filled during the Left to Right pass
-            for (int32 X = 0; X <= NumLeftmostZerosToProcess; ++X)
-            {
-                PixelDataType* PixelData = SourceData + (Y * TextureWidth + X) * 4;
-                PixelData[RIdx] = FillColor[RIdx];
-                PixelData[GIdx] = FillColor[GIdx];
-                PixelData[BIdx] = FillColor[BIdx];
-            }
+            // Fill zero pixels found at beginning of row using non zero pixel immediately to the right of them
+            SetColor(Row, NumLeftmostZerosToProcess + 1, Row[NumLeftmostZerosToProcess + 1]);
 
             return true;
         }
 
         void FillRowColorPixels(int32 FillColorRow, int32 Y)
         {
-            for (int32 X = 0; X < TextureWidth; ++X)
-            {
-                const PixelDataType* FillColor = SourceData + (FillColorRow * TextureWidth + X) * 4;
-                PixelDataType* PixelData = SourceData + (Y * TextureWidth + X) * 4;
-                PixelData[RIdx] = FillColor[RIdx];
-                PixelData[GIdx] = FillColor[GIdx];
-                PixelData[BIdx] = FillColor[BIdx];
-            }
+            CopyColor(GetRow(Y), GetRow(FillColorRow), TextureWidth);
+        }
+
+        ColorDataType* GetRow(int32 Y) const
+        {
+            return reinterpret_cast<ColorDataType*>(SourceData + (int64)Y * TextureWidth * 4);
         }
 
         PixelDataType* SourceData;
         int32 TextureWidth;
         int32 TextureHeight;
+
+        int32 NumZeroedTopRowsToProcess = 0;
+        int32 FillColorRow = -1;
     };
 
     void FillZeroAlphaPNGData(int32 SizeX, int32 SizeY, ETextureSourceFormat SourceFormat, uint8* SourceData);
+
+    /**
+     * Decodes 8-bit non-interlaced PNGs straight into BGRA8 (G8 for grayscale) with the bundled fastpng decoder,
+     * zero alpha pixels are filled while the rows are decoded.
+     * Returns false without an error for the variants the decoder doesn't handle, those are left to ImageWrapper.
+     */
+    bool DecodeFast(const uint8* Buffer, int64 Length, FRuntimeImageData& OutImage, FString& OutError);
+
+    /** Returns true if the buffer is an Adam7 interlaced PNG */
+    bool IsInterlacedPNG(const uint8* Buffer, int32 Length);
+
+    /**
+     * Decodes the first three Adam7 passes of an interlaced PNG into a quarter resolution BGRA8 image.
+     * These passes hold 1/16 of the image data and are stored at the beginning of the compressed stream,
+     * so the buffer may be a prefix of the file.
+     */
+    bool DecodeInterlacedPreview(const uint8* Buffer, int32 Length, FRuntimeImageData& OutImage, FString& OutError);
 }
\ No newline at end of file
@@ -0,0 +1,193 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "PixelPackingHelpers.h"
+#include "SIMDHelpers.h"
+
+
+namespace FPixelPackingHelpers
+{
+    ERuntimeImageAlphaUsage ClassifyAlpha(const uint8* BGRAPixels, int64 NumPixels)
+    {
+        const uint32* Pixels = reinterpret_cast<const uint32*>(BGRAPixels);
+        bool bHasTransparent = false;
+        int64 Index = 0;
+
+#if RIL_SIMD_SSE4_1
+        const __m128i AlphaMask = _mm_set1_epi32((int32)0xFF000000);
+        const __m128i Zero = _mm_setzero_si128();
+        __m128i Transparent = Zero;
+        for (; Index + 4 <= NumPixels; Index += 4)
+        {
+            const __m128i Alpha = _mm_and_si128(_mm_loadu_si128((const __m128i*)(Pixels + Index)), AlphaMask);
+            const __m128i IsTransparent = _mm_cmpeq_epi32(Alpha, Zero);
+            const __m128i IsBinary = _mm_or_si128(IsTransparent, _mm_cmpeq_epi32(Alpha, AlphaMask));
+            if (_mm_movemask_epi8(IsBinary) != 0xFFFF)
+            {
+                return ERuntimeImageAlphaUsage::Translucent;
+            }
+            Transparent = _mm_or_si128(Transparent, IsTransparent);
+        }
+        bHasTransparent = !_mm_testz_si128(Transparent, Transparent);
+#elif RIL_SIMD_NEON
+        const uint32x4_t AlphaMask = vdupq_n_u32(0xFF000000);
+        const uint32x4_t Zero = vdupq_n_u32(0);
+        uint32x4_t Transparent = Zero;
+        for (; Index + 4 <= NumPixels; Index += 4)
+        {
+            const uint32x4_t Alpha = vandq_u32(vld1q_u32(Pixels + Index), AlphaMask);
+            const uint32x4_t IsTransparent = vceqq_u32(Alpha, Zero);
+            const uint32x4_t IsBinary = vorrq_u32(IsTransparent, vceqq_u32(Alpha, AlphaMask));
+            if (vminvq_u32(IsBinary) == 0)
+            {
+                return ERuntimeImageAlphaUsage::Translucent;
+            }
+            Transparent = vorrq_u32(Transparent, IsTransparent);
+        }
+        bHasTransparent = vmaxvq_u32(Transparent) != 0;
+#endif
+
+        for (; Index < NumPixels; ++Index)
+        {
+            const uint32 Alpha = Pixels[Index] >> 24;
+            if (Alpha != 0 && Alpha != 255)
+            {
+                return ERuntimeImageAlphaUsage::Translucent;
+            }
+            bHasTransparent |= (Alpha == 0);
+        }
+
+        return bHasTransparent ? ERuntimeImageAlphaUsage::Binary : ERuntimeImageAlphaUsage::Opaque;
+    }
+
+    // wide pixels are rare enough to be classified one by one
+    template<typename ChannelType, typename IsOpaqueFunc, typename IsTransparentFunc>
+    static ERuntimeImageAlphaUsage ClassifyAlphaChannel(const ChannelType* RGBAPixels, int64 NumPixels, IsOpaqueFunc IsOpaque, IsTransparentFunc IsTransparent)
+    {
+        bool bHasTransparent = false;
+        for (int64 Index = 0; Index < NumPixels; ++Index)
+        {
+            const ChannelType Alpha = RGBAPixels[Index * 4 + 3];
+            if (IsOpaque(Alpha))
+            {
+                continue;
+            }
+            if (!IsTransparent(Alpha))
+            {
+                return ERuntimeImageAlphaUsage::Translucent;
+            }
+            bHasTransparent = true;
+        }
+
+        return bHasTransparent ? ERuntimeImageAlphaUsage::Binary : ERuntimeImageAlphaUsage::Opaque;
+    }
+
+    ERuntimeImageAlphaUsage ClassifyAlpha16(const uint16* RGBAPixels, int64 NumPixels)
+    {
+        return ClassifyAlphaChannel(RGBAPixels, NumPixels,
+            [](uint16 Alpha) { return Alpha == 0xFFFF; },
+            [](uint16 Alpha) { return Alpha == 0; });
+    }
+
+    ERuntimeImageAlphaUsage ClassifyAlpha16F(const uint16* RGBAPixels, int64 NumPixels)
+    {
+        // positive halves order like their bits, 0x3C00 is 1.0 and anything with the sign bit is at most -0
+        return ClassifyAlphaChannel(RGBAPixels, NumPixels,
+            [](uint16 Alpha) { return Alpha >= 0x3C00 && Alpha < 0x8000; },
+            [](uint16 Alpha) { return Alpha == 0 || Alpha >= 0x8000; });
+    }
+
+    ERuntimeImageAlphaUsage ClassifyAlpha32F(const float* RGBAPixels, int64 NumPixels)
+    {
+        return ClassifyAlphaChannel(RGBAPixels, NumPixels,
+            [](float Alpha) { return Alpha >= 1.0f; },
+            [](float Alpha) { return Alpha <= 0.0f; });
+    }
+
+    EPixelFormat GetPackedFormat(const FRuntimeImageData& Image)
+    {
+        if (Image.Format != ERawImageFormat::BGRA8)
+        {
+            return PF_Unknown;
+        }
+
+        switch (Image.AlphaUsage)
+        {
+            // mips filtered from opaque pixels are opaque too
+            case ERuntimeImageAlphaUsage::Opaque:
+                return PF_R5G6B5_UNORM;
+
+            // filtered mips blend the edges of the cut-outs into partial alpha, the whole chain has to fit into one bit
+            case ERuntimeImageAlphaUsage::Binary:
+                if (Image.NumMips == 1 || ClassifyAlpha(Image.RawData.GetData(), Image.RawData.Num() / 4) == ERuntimeImageAlphaUsage::Binary)
+                {
+                    return PF_B5G5R5A1_UNORM;
+                }
+                return PF_Unknown;
+
+            default:
+                return PF_Unknown;
+        }
+    }
+
+    // sRGB byte -> linear value scaled to 5 and 6 bits, in 1/256 of a level
+    struct FLinearQuantizeTables
+    {
+        uint16 To5Bits[256];
+        uint16 To6Bits[256];
+
+        FLinearQuantizeTables()
+        {
+            for (int32 Index = 0; Index < 256; ++Index)
+            {
+                const float Linear = FLinearColor::sRGBToLinearTable[Index];
+                To5Bits[Index] = (uint16)FMath::RoundToInt(Linear * 31.0f * 256.0f);
+                To6Bits[Index] = (uint16)FMath::RoundToInt(Linear * 63.0f * 256.0f);
+            }
+        }
+    };
+
+    static const FLinearQuantizeTables& GetQuantizeTables()
+    {
+        static const FLinearQuantizeTables Tables;
+        return Tables;
+    }
+
+    // 4x4 Bayer thresholds in 1/256 of a level, a flat area averages to its unquantised value
+    static const uint16 DitherThresholds[4][4] =
+    {
+        {   8, 136,  40, 168 },
+        { 200,  72, 232, 104 },
+        {  56, 184,  24, 152 },
+        { 248, 120, 216,  88 }
+    };
+
+    template<typename PackFunc>
+    static void PackDithered(const uint8* BGRAPixels, uint16* OutTexels, int32 SizeX, int32 SizeY, PackFunc Pack)
+    {
+        const FLinearQuantizeTables& Tables = GetQuantizeTables();
+        for (int32 Y = 0; Y < SizeY; ++Y)
+        {
+            const uint16* Thresholds = DitherThresholds[Y & 3];
+            for (int32 X = 0; X < SizeX; ++X, BGRAPixels += 4)
+            {
+                *OutTexels++ = Pack(Tables, BGRAPixels, Thresholds[X & 3]);
+            }
+        }
+    }
+
+    void PackR5G6B5(const uint8* BGRAPixels, uint16* OutTexels, int32 SizeX, int32 SizeY)
+    {
+        PackDithered(BGRAPixels, OutTexels, SizeX, SizeY, [](const FLinearQuantizeTables& Tables, const uint8* Pixel, uint16 Threshold)
+        {
+            return (uint16)(((Tables.To5Bits[Pixel[0]] + Threshold) >> 8) | (((Tables.To6Bits[Pixel[1]] + Threshold) >> 8) << 5) | (((Tables.To5Bits[Pixel[2]] + Threshold) >> 8) << 11));
+        });
+    }
+
+    void PackB5G5R5A1(const uint8* BGRAPixels, uint16* OutTexels, int32 SizeX, int32 SizeY)
+    {
+        PackDithered(BGRAPixels, OutTexels, SizeX, SizeY, [](const FLinearQuantizeTables& Tables, const uint8* Pixel, uint16 Threshold)
+        {
+            return (uint16)(((Tables.To5Bits[Pixel[0]] + Threshold) >> 8) | (((Tables.To5Bits[Pixel[1]] + Threshold) >> 8) << 5) | (((Tables.To5Bits[Pixel[2]] + Threshold) >> 8) << 10) | ((Pixel[3] >> 7) << 15));
+        });
+    }
+}
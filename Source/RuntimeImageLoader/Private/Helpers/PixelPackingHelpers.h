@@ -0,0 +1,31 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RuntimeImageData.h"
+
+
+namespace FPixelPackingHelpers
+{
+    ERuntimeImageAlphaUsage ClassifyAlpha(const uint8* BGRAPixels, int64 NumPixels);
+
+    /** Alpha is the last of the four channels, 1 and above is opaque and 0 and below is transparent for half and float pixels */
+    ERuntimeImageAlphaUsage ClassifyAlpha16(const uint16* RGBAPixels, int64 NumPixels);
+    ERuntimeImageAlphaUsage ClassifyAlpha16F(const uint16* RGBAPixels, int64 NumPixels);
+    ERuntimeImageAlphaUsage ClassifyAlpha32F(const float* RGBAPixels, int64 NumPixels);
+
+    /**
+     * 16-bit format the BGRA8 image and all of its mips can be packed to, PF_Unknown if alpha needs more than one bit.
+     * Alpha of the image must be classified already, RHI support of the format is not checked
+     */
+    EPixelFormat GetPackedFormat(const FRuntimeImageData& Image);
+
+    /**
+     * Packs sRGB encoded BGRA8 pixels of a SizeX x SizeY image to 16-bit texels, the texels are linear as there are no sRGB variants of these formats.
+     * Linear 5 and 6 bits have few dark levels, so the pixels are ordered dithered between the two nearest ones.
+     * R5G6B5 drops alpha, B5G5R5A1 keeps alpha >= 128 as opaque.
+     */
+    void PackR5G6B5(const uint8* BGRAPixels, uint16* OutTexels, int32 SizeX, int32 SizeY);
+    void PackB5G5R5A1(const uint8* BGRAPixels, uint16* OutTexels, int32 SizeX, int32 SizeY);
+}
@@ -1,6 +1,7 @@
 // Copyright 2023 Petr Leontev. All Rights Reserved.
 
 #include "QOIHelpers.h"
+#include "SIMDHelpers.h"
 
 #define QOI_IMPLEMENTATION 1
 
@@ -42,42 +43,211 @@ bool FQOILoader::IsValidImage(const uint8* Buffer, uint32 Length) const
 }
 
 
-bool FQOILoader::Load(const uint8* Buffer, uint32 Length)
+// pixel in the byte order of TSF_BGRA8, so decoded pixels and index entries are stored as they are
+union FQOIPixel
 {
-    qoi_desc ImageDescr;
-    uint8* DecodedPixels = reinterpret_cast<uint8*>(qoi_decode(Buffer, Length, &ImageDescr, 0));
-    if (DecodedPixels == nullptr)
+    struct
+    {
+        uint8 B, G, R, A;
+    } BGRA;
+    uint32 Value;
+};
+
+static FORCEINLINE int32 GetQOIHash(const FQOIPixel& Pixel)
+{
+    return (Pixel.BGRA.R * 3 + Pixel.BGRA.G * 5 + Pixel.BGRA.B * 7 + Pixel.BGRA.A * 11) % 64;
+}
+
+static FORCEINLINE void FillPixels(uint32* Dest, int64 Count, uint32 Value)
+{
+#if RIL_SIMD_SSE4_1
+    const __m128i Pixels = _mm_set1_epi32((int32)Value);
+    for (; Count >= 4; Count -= 4, Dest += 4)
+    {
+        _mm_storeu_si128((__m128i*)Dest, Pixels);
+    }
+#elif RIL_SIMD_NEON
+    const uint32x4_t Pixels = vdupq_n_u32(Value);
+    for (; Count >= 4; Count -= 4, Dest += 4)
+    {
+        vst1q_u32(Dest, Pixels);
+    }
+#endif
+    for (; Count > 0; --Count)
+    {
+        *Dest++ = Value;
+    }
+}
+
+// decoder position in the chunk stream, pixels can be decoded in any number of steps
+struct FQOIDecodeState
+{
+    const uint8* Buffer;
+    int64 ChunksLength;
+    int64 Position;
+
+    uint32 Index[64];
+    FQOIPixel Pixel;
+
+    // pixels of the current run that are not written yet
+    int64 RunLeft = 0;
+
+    // images without alpha channel are opaque whatever the stream says
+    uint32 AlphaMask;
+};
+
+static void DecodePixels(FQOIDecodeState& State, uint32* Dest, int64 Count)
+{
+    // position is kept in a register during the loop
+    const uint8* Buffer = State.Buffer;
+    int64 Position = State.Position;
+    FQOIPixel& Pixel = State.Pixel;
+    uint32* const DestEnd = Dest + Count;
+
+    if (State.RunLeft > 0)
+    {
+        const int64 RunLength = FMath::Min<int64>(State.RunLeft, DestEnd - Dest);
+        FillPixels(Dest, RunLength, Pixel.Value | State.AlphaMask);
+        Dest += RunLength;
+        State.RunLeft -= RunLength;
+    }
+
+    while (Dest < DestEnd)
+    {
+        if (Position >= State.ChunksLength)
+        {
+            // truncated stream, the rest repeats the last pixel like the reference decoder does
+            FillPixels(Dest, DestEnd - Dest, Pixel.Value | State.AlphaMask);
+            State.RunLeft = MAX_int64;
+            break;
+        }
+
+        const uint8 B1 = Buffer[Position++];
+
+        if (B1 == QOI_OP_RGB)
+        {
+            Pixel.BGRA.R = Buffer[Position++];
+            Pixel.BGRA.G = Buffer[Position++];
+            Pixel.BGRA.B = Buffer[Position++];
+        }
+        else if (B1 == QOI_OP_RGBA)
+        {
+            Pixel.BGRA.R = Buffer[Position++];
+            Pixel.BGRA.G = Buffer[Position++];
+            Pixel.BGRA.B = Buffer[Position++];
+            Pixel.BGRA.A = Buffer[Position++];
+        }
+        else
+        {
+            switch (B1 & QOI_MASK_2)
+            {
+                case QOI_OP_INDEX:
+                {
+                    Pixel.Value = State.Index[B1];
+                    break;
+                }
+                case QOI_OP_DIFF:
+                {
+                    Pixel.BGRA.R += ((B1 >> 4) & 0x03) - 2;
+                    Pixel.BGRA.G += ((B1 >> 2) & 0x03) - 2;
+                    Pixel.BGRA.B += (B1 & 0x03) - 2;
+                    break;
+                }
+                case QOI_OP_LUMA:
+                {
+                    const uint8 B2 = Buffer[Position++];
+                    const int32 VG = (B1 & 0x3f) - 32;
+                    Pixel.BGRA.R += VG - 8 + ((B2 >> 4) & 0x0f);
+                    Pixel.BGRA.G += VG;
+                    Pixel.BGRA.B += VG - 8 + (B2 & 0x0f);
+                    break;
+                }
+                case QOI_OP_RUN:
+                {
+                    // the current pixel plus the repeats, runs are at most 62 pixels long and may continue in the next call
+                    const int64 RunLength = (B1 & 0x3f) + 1;
+                    const int64 NumWritten = FMath::Min<int64>(RunLength, DestEnd - Dest);
+                    State.Index[GetQOIHash(Pixel)] = Pixel.Value;
+                    FillPixels(Dest, NumWritten, Pixel.Value | State.AlphaMask);
+                    Dest += NumWritten;
+                    State.RunLeft = RunLength - NumWritten;
+                    continue;
+                }
+            }
+        }
+
+        State.Index[GetQOIHash(Pixel)] = Pixel.Value;
+        *Dest++ = Pixel.Value | State.AlphaMask;
+    }
+
+    State.Position = Position;
+}
+
+bool FQOILoader::Load(const uint8* Buffer, uint32 Length, const FIntRect& InRegion)
+{
+    if (!IsValidImage(Buffer, Length))
     {
         ErrorMessage = TEXT("Can't decode input QOI image! Make sure the image is valid!");
         return false;
     }
 
-    Width = ImageDescr.width;
-    Height = ImageDescr.height;
+    int p = 4;
+    Width = qoi_read_32(Buffer, &p);
+    Height = qoi_read_32(Buffer, &p);
+    const uint8 Channels = Buffer[p++];
+    const uint8 Colorspace = Buffer[p++];
+
     TextureSourceFormat = TSF_BGRA8;
-    bSRGB = (ImageDescr.colorspace == QOI_SRGB);
+    bSRGB = (Colorspace == QOI_SRGB);
 
-    // reserver enough memory for BGRA8 
-    RawData.SetNumUninitialized(Width * Height * 4);
+    Region = FIntRect(0, 0, Width, Height);
+    if (InRegion.Area() > 0)
+    {
+        Region = FIntRect(FMath::Max(InRegion.Min.X, 0), FMath::Max(InRegion.Min.Y, 0), FMath::Min(InRegion.Max.X, Width), FMath::Min(InRegion.Max.Y, Height));
+        if (Region.Width() <= 0 || Region.Height() <= 0)
+        {
+            ErrorMessage = FString::Printf(TEXT("Region %s is outside of the image"), *InRegion.ToString());
+            return false;
+        }
+    }
 
-    bool bSourceHasAlpha = static_cast<uint8>(ImageDescr.channels) == 4;
+    FQOIDecodeState State;
+    State.Buffer = Buffer;
+    State.ChunksLength = (int64)Length - sizeof(qoi_padding);
+    State.Position = QOI_HEADER_SIZE;
+    State.AlphaMask = (Channels == 4) ? 0 : 0xFF000000;
+    FMemory::Memzero(State.Index);
+    State.Pixel.Value = 0;
+    State.Pixel.BGRA.A = 255;
 
-    const int32 PixelsLen = Width * Height * ImageDescr.channels;
-    const uint32 Step = ImageDescr.channels;
-    int32 RawDataIndex = 0;
+    // the decode loop writes BGRA8 pixels straight into the texture data
+    RawData.SetNumUninitialized((int64)Region.Width() * Region.Height() * 4);
+    uint32* Dest = reinterpret_cast<uint32*>(RawData.GetData());
 
-    // convert RGBA to BGRA
-    for (int32 Index = 0; Index < PixelsLen; Index += Step)
+    if (Region.Width() == Width)
     {
-        RawData[RawDataIndex]     = DecodedPixels[Index + 2];
-        RawData[RawDataIndex + 1] = DecodedPixels[Index + 1];
-        RawData[RawDataIndex + 2] = DecodedPixels[Index];
-        RawData[RawDataIndex + 3] = (bSourceHasAlpha) ? DecodedPixels[Index + 3] : 255;
-        
-        RawDataIndex += 4;
+        // rows above the region are decoded into the first rows of the data and overwritten
+        for (int32 Y = 0; Y < Region.Min.Y; ++Y)
+        {
+            DecodePixels(State, Dest, Width);
+        }
+        DecodePixels(State, Dest, (int64)Width * Region.Height());
     }
+    else
+    {
+        // the stream can't be skipped, whole rows are decoded and only the part in the region is kept
+        TArray<uint32> Row;
+        Row.SetNumUninitialized(Width);
 
-    QOI_FREE(DecodedPixels);
+        for (int32 Y = 0; Y < Region.Max.Y; ++Y)
+        {
+            DecodePixels(State, Row.GetData(), Width);
+            if (Y >= Region.Min.Y)
+            {
+                FMemory::Memcpy(Dest + (int64)(Y - Region.Min.Y) * Region.Width(), Row.GetData() + Region.Min.X, Region.Width() * sizeof(uint32));
+            }
+        }
+    }
 
     return true;
 }
@@ -85,4 +255,141 @@ bool FQOILoader::Load(const uint8* Buffer, uint32 Length)
 FString FQOILoader::GetLastError()
 {
     return ErrorMessage;
-}
\ No newline at end of file
+}
+
+FQOIWriter::FQOIWriter(FArchive& InArchive, int32 InWidth, int32 InHeight, bool bInHasAlpha, bool bInSRGB)
+    : Archive(InArchive)
+    , bHasAlpha(bInHasAlpha)
+    , PixelsLeft((int64)InWidth * InHeight)
+{
+    FMemory::Memzero(Index);
+
+    FQOIPixel Pixel;
+    Pixel.Value = 0;
+    Pixel.BGRA.A = 255;
+    PreviousPixel = Pixel.Value;
+
+    Block.Reserve(64 * 1024);
+
+    uint8 Header[QOI_HEADER_SIZE];
+    int p = 0;
+    qoi_write_32(Header, &p, QOI_MAGIC);
+    qoi_write_32(Header, &p, InWidth);
+    qoi_write_32(Header, &p, InHeight);
+    Header[p++] = bHasAlpha ? 4 : 3;
+    Header[p++] = bInSRGB ? QOI_SRGB : QOI_LINEAR;
+
+    Block.Append(Header, QOI_HEADER_SIZE);
+}
+
+void FQOIWriter::WriteByte(uint8 Value)
+{
+    Block.Add(Value);
+}
+
+void FQOIWriter::Flush()
+{
+    if (Block.Num() > 0)
+    {
+        Archive.Serialize(Block.GetData(), Block.Num());
+        Block.Reset();
+    }
+}
+
+void FQOIWriter::WritePixels(const uint8* BGRAPixels, int64 NumPixels)
+{
+    NumPixels = FMath::Min(NumPixels, PixelsLeft);
+
+    for (int64 PixelIndex = 0; PixelIndex < NumPixels; ++PixelIndex)
+    {
+        FQOIPixel Pixel;
+        FMemory::Memcpy(&Pixel.Value, BGRAPixels + PixelIndex * 4, 4);
+        if (!bHasAlpha)
+        {
+            Pixel.BGRA.A = 255;
+        }
+
+        --PixelsLeft;
+
+        // worst case of a pixel is 5 bytes
+        if (Block.Num() + 5 > Block.Max())
+        {
+            Flush();
+        }
+
+        if (Pixel.Value == PreviousPixel)
+        {
+            ++Run;
+            if (Run == 62 || PixelsLeft == 0)
+            {
+                WriteByte(QOI_OP_RUN | (Run - 1));
+                Run = 0;
+            }
+            continue;
+        }
+
+        if (Run > 0)
+        {
+            WriteByte(QOI_OP_RUN | (Run - 1));
+            Run = 0;
+        }
+
+        const int32 IndexPosition = GetQOIHash(Pixel);
+        if (Index[IndexPosition] == Pixel.Value)
+        {
+            WriteByte(QOI_OP_INDEX | IndexPosition);
+        }
+        else
+        {
+            Index[IndexPosition] = Pixel.Value;
+
+            FQOIPixel Previous;
+            Previous.Value = PreviousPixel;
+
+            if (Pixel.BGRA.A == Previous.BGRA.A)
+            {
+                const int8 VR = Pixel.BGRA.R - Previous.BGRA.R;
+                const int8 VG = Pixel.BGRA.G - Previous.BGRA.G;
+                const int8 VB = Pixel.BGRA.B - Previous.BGRA.B;
+
+                const int8 VGR = VR - VG;
+                const int8 VGB = VB - VG;
+
+                if (VR > -3 && VR < 2 && VG > -3 && VG < 2 && VB > -3 && VB < 2)
+                {
+                    WriteByte(QOI_OP_DIFF | (VR + 2) << 4 | (VG + 2) << 2 | (VB + 2));
+                }
+                else if (VGR > -9 && VGR < 8 && VG > -33 && VG < 32 && VGB > -9 && VGB < 8)
+                {
+                    WriteByte(QOI_OP_LUMA | (VG + 32));
+                    WriteByte((VGR + 8) << 4 | (VGB + 8));
+                }
+                else
+                {
+                    WriteByte(QOI_OP_RGB);
+                    WriteByte(Pixel.BGRA.R);
+                    WriteByte(Pixel.BGRA.G);
+                    WriteByte(Pixel.BGRA.B);
+                }
+            }
+            else
+            {
+                WriteByte(QOI_OP_RGBA);
+                WriteByte(Pixel.BGRA.R);
+                WriteByte(Pixel.BGRA.G);
+                WriteByte(Pixel.BGRA.B);
+                WriteByte(Pixel.BGRA.A);
+            }
+        }
+
+        PreviousPixel = Pixel.Value;
+    }
+}
+
+bool FQOIWriter::Finish()
+{
+    Block.Append(qoi_padding, sizeof(qoi_padding));
+    Flush();
+
+    return PixelsLeft == 0 && !Archive.IsError();
+}
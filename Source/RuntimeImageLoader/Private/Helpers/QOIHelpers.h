@@ -8,19 +8,53 @@ class FQOILoader
 {
 public:
     bool IsValidImage(const uint8* Buffer, uint32 Length) const;
-    bool Load(const uint8* Buffer, uint32 Length);
+    /** Decodes only the rows down to the end of the region if it's not empty, pixels outside of the region are not stored */
+    bool Load(const uint8* Buffer, uint32 Length, const FIntRect& InRegion = FIntRect());
 
     FString GetLastError();
 
 public:
     // Resulting image data and properties
-    TArray<uint8> RawData;
+    TArray64<uint8> RawData;
     int32 Width;
     int32 Height;
+    // part of the image in RawData
+    FIntRect Region;
     ETextureSourceFormat TextureSourceFormat = TSF_Invalid;
     TextureCompressionSettings CompressionSettings = TC_Default;
     bool bSRGB = true;
 
 private:
     FString ErrorMessage;
+};
+
+/**
+ * Encodes BGRA8 pixels into QOI while they are written, the output goes to the archive in small blocks
+ * so images of any size are encoded without a full size intermediate buffer.
+ */
+class FQOIWriter
+{
+public:
+    FQOIWriter(FArchive& InArchive, int32 InWidth, int32 InHeight, bool bInHasAlpha, bool bInSRGB);
+
+    /** Pixels are written in the row order, any number of pixels at a time */
+    void WritePixels(const uint8* BGRAPixels, int64 NumPixels);
+
+    /** Returns false if not all pixels were written or the archive failed */
+    bool Finish();
+
+private:
+    void WriteByte(uint8 Value);
+    void Flush();
+
+private:
+    FArchive& Archive;
+    bool bHasAlpha;
+
+    int64 PixelsLeft;
+    uint32 Index[64];
+    uint32 PreviousPixel;
+    int32 Run = 0;
+
+    TArray<uint8> Block;
 };
\ No newline at end of file
@@ -0,0 +1,35 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Integer SIMD kernels are picked at compile time from the instruction sets the target platform always has,
+// everything else falls back to the scalar code paths.
+
+#if defined(PLATFORM_ALWAYS_HAS_AVX_2) && PLATFORM_ALWAYS_HAS_AVX_2
+    #define RIL_SIMD_AVX2 1
+#else
+    #define RIL_SIMD_AVX2 0
+#endif
+
+#if RIL_SIMD_AVX2 || (defined(PLATFORM_ALWAYS_HAS_SSE4_1) && PLATFORM_ALWAYS_HAS_SSE4_1)
+    #define RIL_SIMD_SSE4_1 1
+#else
+    #define RIL_SIMD_SSE4_1 0
+#endif
+
+// table lookups (vqtbl1q_u8) are AArch64 only
+#if !RIL_SIMD_SSE4_1 && defined(PLATFORM_ENABLE_VECTORINTRINSICS_NEON) && PLATFORM_ENABLE_VECTORINTRINSICS_NEON && PLATFORM_64BITS
+    #define RIL_SIMD_NEON 1
+#else
+    #define RIL_SIMD_NEON 0
+#endif
+
+#if RIL_SIMD_AVX2
+    #include <immintrin.h>
+#elif RIL_SIMD_SSE4_1
+    #include <smmintrin.h>
+#elif RIL_SIMD_NEON
+    #include <arm_neon.h>
+#endif
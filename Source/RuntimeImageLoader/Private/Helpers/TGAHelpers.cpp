@@ -1,10 +1,144 @@
 // Copyright 2023 Petr Leontev. All Rights Reserved.
 
 #include "TGAHelpers.h"
+#include "SIMDHelpers.h"
 
 
 namespace FTGAHelpers
 {
+    // B8G8R8 -> B8G8R8A8
+    static void ConvertRow_24bpp(const uint8* Source, uint32* Dest, int32 Width)
+    {
+        int32 X = 0;
+#if RIL_SIMD_SSE4_1
+        const __m128i Shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+        const __m128i Alpha = _mm_set1_epi32((int32)0xFF000000);
+        // 16 bytes are loaded for 4 pixels (12 bytes), so the last pixels of the row are left to the scalar loop
+        for (; X + 6 <= Width; X += 4)
+        {
+            const __m128i Pixels = _mm_loadu_si128((const __m128i*)(Source + X * 3));
+            _mm_storeu_si128((__m128i*)(Dest + X), _mm_or_si128(_mm_shuffle_epi8(Pixels, Shuffle), Alpha));
+        }
+#elif RIL_SIMD_NEON
+        for (; X + 16 <= Width; X += 16)
+        {
+            const uint8x16x3_t BGR = vld3q_u8(Source + X * 3);
+            uint8x16x4_t BGRA;
+            BGRA.val[0] = BGR.val[0];
+            BGRA.val[1] = BGR.val[1];
+            BGRA.val[2] = BGR.val[2];
+            BGRA.val[3] = vdupq_n_u8(255);
+            vst4q_u8((uint8*)(Dest + X), BGRA);
+        }
+#endif
+        for (; X < Width; ++X)
+        {
+            const uint8* Pixel = Source + X * 3;
+            Dest[X] = Pixel[0] | (Pixel[1] << 8) | (Pixel[2] << 16) | 0xFF000000;
+        }
+    }
+
+    static FORCEINLINE uint32 ConvertPixel_16bpp(uint16 FilePixel)
+    {
+        // Convert file format A1R5G5B5 into pixel format B8G8R8A8
+        uint32 TexturePixel = (FilePixel & 0x001F) << 3;
+        TexturePixel |= (FilePixel & 0x03E0) << 6;
+        TexturePixel |= (FilePixel & 0x7C00) << 9;
+        TexturePixel |= (FilePixel & 0x8000) << 16;
+        return TexturePixel;
+    }
+
+    // A1R5G5B5 -> B8G8R8A8
+    static void ConvertRow_16bpp(const uint16* Source, uint32* Dest, int32 Width)
+    {
+        int32 X = 0;
+#if RIL_SIMD_SSE4_1
+        const __m128i MaskB = _mm_set1_epi32(0x001F);
+        const __m128i MaskG = _mm_set1_epi32(0x03E0);
+        const __m128i MaskR = _mm_set1_epi32(0x7C00);
+        const __m128i MaskA = _mm_set1_epi32(0x8000);
+        for (; X + 4 <= Width; X += 4)
+        {
+            const __m128i Pixels = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)(Source + X)));
+            __m128i Result = _mm_slli_epi32(_mm_and_si128(Pixels, MaskB), 3);
+            Result = _mm_or_si128(Result, _mm_slli_epi32(_mm_and_si128(Pixels, MaskG), 6));
+            Result = _mm_or_si128(Result, _mm_slli_epi32(_mm_and_si128(Pixels, MaskR), 9));
+            Result = _mm_or_si128(Result, _mm_slli_epi32(_mm_and_si128(Pixels, MaskA), 16));
+            _mm_storeu_si128((__m128i*)(Dest + X), Result);
+        }
+#elif RIL_SIMD_NEON
+        for (; X + 4 <= Width; X += 4)
+        {
+            const uint32x4_t Pixels = vmovl_u16(vld1_u16(Source + X));
+            uint32x4_t Result = vshlq_n_u32(vandq_u32(Pixels, vdupq_n_u32(0x001F)), 3);
+            Result = vorrq_u32(Result, vshlq_n_u32(vandq_u32(Pixels, vdupq_n_u32(0x03E0)), 6));
+            Result = vorrq_u32(Result, vshlq_n_u32(vandq_u32(Pixels, vdupq_n_u32(0x7C00)), 9));
+            Result = vorrq_u32(Result, vshlq_n_u32(vandq_u32(Pixels, vdupq_n_u32(0x8000)), 16));
+            vst1q_u32(Dest + X, Result);
+        }
+#endif
+        for (; X < Width; ++X)
+        {
+            Dest[X] = ConvertPixel_16bpp(Source[X]);
+        }
+    }
+
+    // reverses the row in place, swapping blocks of pixels from both ends
+    static void ReverseRow_32bpp(uint32* Row, int32 Width)
+    {
+        int32 Left = 0;
+        int32 Right = Width;
+#if RIL_SIMD_SSE4_1
+        for (; Right - Left >= 8; Left += 4, Right -= 4)
+        {
+            const __m128i LeftPixels = _mm_loadu_si128((const __m128i*)(Row + Left));
+            const __m128i RightPixels = _mm_loadu_si128((const __m128i*)(Row + Right - 4));
+            _mm_storeu_si128((__m128i*)(Row + Left), _mm_shuffle_epi32(RightPixels, _MM_SHUFFLE(0, 1, 2, 3)));
+            _mm_storeu_si128((__m128i*)(Row + Right - 4), _mm_shuffle_epi32(LeftPixels, _MM_SHUFFLE(0, 1, 2, 3)));
+        }
+#elif RIL_SIMD_NEON
+        for (; Right - Left >= 8; Left += 4, Right -= 4)
+        {
+            const uint32x4_t LeftPixels = vrev64q_u32(vld1q_u32(Row + Left));
+            const uint32x4_t RightPixels = vrev64q_u32(vld1q_u32(Row + Right - 4));
+            vst1q_u32(Row + Left, vextq_u32(RightPixels, RightPixels, 2));
+            vst1q_u32(Row + Right - 4, vextq_u32(LeftPixels, LeftPixels, 2));
+        }
+#endif
+        for (--Right; Left < Right; ++Left, --Right)
+        {
+            Swap(Row[Left], Row[Right]);
+        }
+    }
+
+    static void ReverseRow_8bpp(uint8* Row, int32 Width)
+    {
+        int32 Left = 0;
+        int32 Right = Width;
+#if RIL_SIMD_SSE4_1
+        const __m128i Reverse = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+        for (; Right - Left >= 32; Left += 16, Right -= 16)
+        {
+            const __m128i LeftPixels = _mm_loadu_si128((const __m128i*)(Row + Left));
+            const __m128i RightPixels = _mm_loadu_si128((const __m128i*)(Row + Right - 16));
+            _mm_storeu_si128((__m128i*)(Row + Left), _mm_shuffle_epi8(RightPixels, Reverse));
+            _mm_storeu_si128((__m128i*)(Row + Right - 16), _mm_shuffle_epi8(LeftPixels, Reverse));
+        }
+#elif RIL_SIMD_NEON
+        for (; Right - Left >= 32; Left += 16, Right -= 16)
+        {
+            const uint8x16_t LeftPixels = vrev64q_u8(vld1q_u8(Row + Left));
+            const uint8x16_t RightPixels = vrev64q_u8(vld1q_u8(Row + Right - 16));
+            vst1q_u8(Row + Left, vextq_u8(RightPixels, RightPixels, 8));
+            vst1q_u8(Row + Right - 16, vextq_u8(LeftPixels, LeftPixels, 8));
+        }
+#endif
+        for (--Right; Left < Right; ++Left, --Right)
+        {
+            Swap(Row[Left], Row[Right]);
+        }
+    }
+
     void DecompressTGA_RLE_32bpp(const FTGAFileHeader* TGA, uint32* TextureData)
     {
         uint8* IdData = (uint8*)TGA + sizeof(FTGAFileHeader);
@@ -99,7 +233,6 @@ namespace FTGAHelpers
         uint8* ColorMap = IdData + TGA->IdFieldLength;
         uint16* ImageData = (uint16*)(ColorMap + (TGA->ColorMapEntrySize + 4) / 8 * TGA->ColorMapLength);
         uint16 FilePixel = 0;
-        uint32 TexturePixel = 0;
         int32 RLERun = 0;
         int32 RAWRun = 0;
 
@@ -130,13 +263,8 @@ namespace FTGAHelpers
                     RAWRun--;
                     RLERun--;
                 }
-                // Convert file format A1R5G5B5 into pixel format B8G8R8B8
-                TexturePixel = (FilePixel & 0x001F) << 3;
-                TexturePixel |= (FilePixel & 0x03E0) << 6;
-                TexturePixel |= (FilePixel & 0x7C00) << 9;
-                TexturePixel |= (FilePixel & 0x8000) << 16;
                 // Store.
-                *((TextureData + Y * TGA->Width) + X) = TexturePixel;
+                *((TextureData + Y * TGA->Width) + X) = ConvertPixel_16bpp(FilePixel);
             }
         }
     }
@@ -159,22 +287,10 @@ namespace FTGAHelpers
         uint8* IdData = (uint8*)TGA + sizeof(FTGAFileHeader);
         uint8* ColorMap = IdData + TGA->IdFieldLength;
         uint16* ImageData = (uint16*)(ColorMap + (TGA->ColorMapEntrySize + 4) / 8 * TGA->ColorMapLength);
-        uint16 FilePixel = 0;
-        uint32 TexturePixel = 0;
 
-        for (int32 Y = TGA->Height - 1; Y >= 0; Y--)
+        for (int32 Y = 0; Y < TGA->Height; Y++)
         {
-            for (int32 X = 0; X < TGA->Width; X++)
-            {
-                FilePixel = *ImageData++;
-                // Convert file format A1R5G5B5 into pixel format B8G8R8A8
-                TexturePixel = (FilePixel & 0x001F) << 3;
-                TexturePixel |= (FilePixel & 0x03E0) << 6;
-                TexturePixel |= (FilePixel & 0x7C00) << 9;
-                TexturePixel |= (FilePixel & 0x8000) << 16;
-                // Store.
-                *((TextureData + Y * TGA->Width) + X) = TexturePixel;
-            }
+            ConvertRow_16bpp(ImageData + (TGA->Height - Y - 1) * TGA->Width, TextureData + Y * TGA->Width, TGA->Width);
         }
     }
 
@@ -183,18 +299,10 @@ namespace FTGAHelpers
         uint8* IdData = (uint8*)TGA + sizeof(FTGAFileHeader);
         uint8* ColorMap = IdData + TGA->IdFieldLength;
         uint8* ImageData = (uint8*)(ColorMap + (TGA->ColorMapEntrySize + 4) / 8 * TGA->ColorMapLength);
-        uint8 Pixel[4];
 
         for (int32 Y = 0; Y < TGA->Height; Y++)
         {
-            for (int32 X = 0; X < TGA->Width; X++)
-            {
-                Pixel[0] = *((ImageData + (TGA->Height - Y - 1)*TGA->Width * 3) + X * 3 + 0);
-                Pixel[1] = *((ImageData + (TGA->Height - Y - 1)*TGA->Width * 3) + X * 3 + 1);
-                Pixel[2] = *((ImageData + (TGA->Height - Y - 1)*TGA->Width * 3) + X * 3 + 2);
-                Pixel[3] = 255;
-                *((TextureData + Y * TGA->Width) + X) = *(uint32*)&Pixel;
-            }
+            ConvertRow_24bpp(ImageData + (TGA->Height - Y - 1) * TGA->Width * 3, TextureData + Y * TGA->Width, TGA->Width);
         }
     }
 
@@ -279,29 +387,35 @@ namespace FTGAHelpers
         bool FlipY = (TGA->ImageDescriptor & 0x20) ? 1 : 0;
         if (FlipY || FlipX)
         {
-            TArray<uint8> FlippedData;
-            FlippedData.AddUninitialized(TextureDataSize);
-
-            int32 NumBlocksX = TGA->Width;
-            int32 NumBlocksY = TGA->Height;
-            int32 BlockBytes = TGA->BitsPerPixel == 8 ? 1 : 4;
+            const int32 Width = TGA->Width;
+            const int32 Height = TGA->Height;
+            const int32 PixelBytes = TGA->BitsPerPixel == 8 ? 1 : 4;
+            const int32 RowBytes = Width * PixelBytes;
 
             uint8* MipData = (uint8*)TextureData;
 
-            for (int32 Y = 0; Y < NumBlocksY; Y++)
+            if (FlipY)
             {
-                for (int32 X = 0; X < NumBlocksX; X++)
+                for (int32 Y = 0; Y < Height / 2; Y++)
                 {
-                    int32 DestX = FlipX ? (NumBlocksX - X - 1) : X;
-                    int32 DestY = FlipY ? (NumBlocksY - Y - 1) : Y;
-                    FMemory::Memcpy(
-                        &FlippedData[(DestX + DestY * NumBlocksX) * BlockBytes],
-                        &MipData[(X + Y * NumBlocksX) * BlockBytes],
-                        BlockBytes
-                    );
+                    FMemory::Memswap(MipData + Y * RowBytes, MipData + (Height - Y - 1) * RowBytes, RowBytes);
+                }
+            }
+
+            if (FlipX)
+            {
+                for (int32 Y = 0; Y < Height; Y++)
+                {
+                    if (PixelBytes == 1)
+                    {
+                        ReverseRow_8bpp(MipData + Y * RowBytes, Width);
+                    }
+                    else
+                    {
+                        ReverseRow_32bpp((uint32*)(MipData + Y * RowBytes), Width);
+                    }
                 }
             }
-            FMemory::Memcpy(MipData, FlippedData.GetData(), FlippedData.Num());
         }
 
         return true;
@@ -366,4 +480,87 @@ namespace FTGAHelpers
 
         return DecompressTGA_helper(TGA, TextureData, TextureDataSize, OutError);
     }
-}
\ No newline at end of file
+
+    bool CanDecompressRegion(const FTGAFileHeader* TGA)
+    {
+        if (TGA->ImageTypeCode == 2)
+        {
+            return TGA->BitsPerPixel == 32 || TGA->BitsPerPixel == 24 || TGA->BitsPerPixel == 16;
+        }
+
+        return TGA->BitsPerPixel == 8 && ((TGA->ColorMapType == 1 && TGA->ImageTypeCode == 1) || (TGA->ColorMapType == 0 && TGA->ImageTypeCode == 3));
+    }
+
+    bool DecompressTGARegion(const FTGAFileHeader* TGA, int64 Length, const FIntRect& Region, FRuntimeImageData& OutImage, FString& OutError)
+    {
+        check(CanDecompressRegion(TGA));
+
+        const int32 Width = TGA->Width;
+        const int32 Height = TGA->Height;
+        const int32 SourcePixelBytes = TGA->BitsPerPixel / 8;
+
+        // rows are read in place, so the header, id, color map and all rows must be in the file
+        const int64 ImageDataOffset = (int64)sizeof(FTGAFileHeader) + TGA->IdFieldLength + (TGA->ColorMapEntrySize + 4) / 8 * TGA->ColorMapLength;
+        if (Length < (int64)sizeof(FTGAFileHeader) || ImageDataOffset + (int64)Width * Height * SourcePixelBytes > Length)
+        {
+            OutError = FString::Printf(TEXT("TGA data is truncated: %lld bytes"), Length);
+            return false;
+        }
+
+        const FIntRect Clipped(FMath::Max(Region.Min.X, 0), FMath::Max(Region.Min.Y, 0), FMath::Min(Region.Max.X, Width), FMath::Min(Region.Max.Y, Height));
+        if (Clipped.Width() <= 0 || Clipped.Height() <= 0)
+        {
+            OutError = FString::Printf(TEXT("Region %s is outside of the image"), *Region.ToString());
+            return false;
+        }
+
+        const bool bGrayscale = TGA->BitsPerPixel == 8;
+        OutImage.Init2D(Clipped.Width(), Clipped.Height(), bGrayscale ? TSF_G8 : TSF_BGRA8);
+        if (bGrayscale)
+        {
+            OutImage.CompressionSettings = TC_Grayscale;
+        }
+
+        const uint8* IdData = (const uint8*)TGA + sizeof(FTGAFileHeader);
+        const uint8* ColorMap = IdData + TGA->IdFieldLength;
+        const uint8* ImageData = ColorMap + (TGA->ColorMapEntrySize + 4) / 8 * TGA->ColorMapLength;
+
+        // rows are stored bottom up and columns left to right unless the descriptor flips them
+        const bool FlipX = (TGA->ImageDescriptor & 0x10) ? 1 : 0;
+        const bool FlipY = (TGA->ImageDescriptor & 0x20) ? 1 : 0;
+
+        const int32 FirstColumn = FlipX ? Width - Clipped.Max.X : Clipped.Min.X;
+        const int32 RegionWidth = Clipped.Width();
+        const int64 DestPitch = (int64)RegionWidth * (bGrayscale ? 1 : 4);
+
+        for (int32 Y = Clipped.Min.Y; Y < Clipped.Max.Y; ++Y)
+        {
+            const int32 SourceRow = FlipY ? Y : Height - Y - 1;
+            const uint8* Source = ImageData + ((int64)SourceRow * Width + FirstColumn) * SourcePixelBytes;
+            uint8* Dest = OutImage.RawData.GetData() + (Y - Clipped.Min.Y) * DestPitch;
+
+            switch (TGA->BitsPerPixel)
+            {
+                case 32: FMemory::Memcpy(Dest, Source, DestPitch); break;
+                case 24: ConvertRow_24bpp(Source, (uint32*)Dest, RegionWidth); break;
+                case 16: ConvertRow_16bpp((const uint16*)Source, (uint32*)Dest, RegionWidth); break;
+                default: FMemory::Memcpy(Dest, Source, DestPitch); break;
+            }
+
+            if (FlipX)
+            {
+                if (bGrayscale)
+                {
+                    ReverseRow_8bpp(Dest, RegionWidth);
+                }
+                else
+                {
+                    ReverseRow_32bpp((uint32*)Dest, RegionWidth);
+                }
+            }
+        }
+
+        OutImage.DecodedRegion = Clipped;
+        return true;
+    }
+}
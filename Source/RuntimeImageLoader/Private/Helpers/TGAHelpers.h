@@ -41,4 +41,10 @@ namespace FTGAHelpers
     bool DecompressTGA_helper(const FTGAFileHeader* TGA, uint32*& TextureData, const int32 TextureDataSize, FString& OutError);
     bool DecompressTGA(const FTGAFileHeader* TGA, FRuntimeImageData& OutImage, FString& OutError);
 
+    /** Uncompressed images can be read row by row, so a region is read without decompressing the rest of the image */
+    bool CanDecompressRegion(const FTGAFileHeader* TGA);
+
+    /** Reads only the region (clipped to the image) of the uncompressed image, fails if the Length bytes of the file end before its rows */
+    bool DecompressTGARegion(const FTGAFileHeader* TGA, int64 Length, const FIntRect& Region, FRuntimeImageData& OutImage, FString& OutError);
+
 }
\ No newline at end of file
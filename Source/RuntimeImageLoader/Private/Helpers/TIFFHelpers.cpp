@@ -0,0 +1,597 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "TIFFHelpers.h"
+#include "RuntimeImageUtils.h"
+#include "Async/ParallelFor.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "zlib.h"
+THIRD_PARTY_INCLUDES_END
+
+
+namespace FTIFFHelpers
+{
+    // baseline and extension tags of the first image file directory
+    enum ETag : uint16
+    {
+        ImageWidth = 256,
+        ImageLength = 257,
+        BitsPerSample = 258,
+        Compression = 259,
+        PhotometricInterpretation = 262,
+        FillOrder = 266,
+        StripOffsets = 273,
+        SamplesPerPixel = 277,
+        RowsPerStrip = 278,
+        StripByteCounts = 279,
+        PlanarConfiguration = 284,
+        Predictor = 317,
+        TileWidth = 322,
+        TileLength = 323,
+        TileOffsets = 324,
+        TileByteCounts = 325,
+        SampleFormat = 339
+    };
+
+    enum ECompression : uint32
+    {
+        None = 1,
+        LZW = 5,
+        Deflate = 8,
+        // Deflate as written by older encoders
+        AdobeDeflate = 32946
+    };
+
+    struct FFileReader
+    {
+        const uint8* Buffer = nullptr;
+        int64 Length = 0;
+        bool bBigEndian = false;
+
+        uint16 ReadUInt16(int64 Offset) const
+        {
+            return bBigEndian
+                ? (uint16)(((uint32)Buffer[Offset] << 8) | Buffer[Offset + 1])
+                : (uint16)(Buffer[Offset] | ((uint32)Buffer[Offset + 1] << 8));
+        }
+
+        uint32 ReadUInt32(int64 Offset) const
+        {
+            return bBigEndian
+                ? ((uint32)ReadUInt16(Offset) << 16) | ReadUInt16(Offset + 2)
+                : (uint32)ReadUInt16(Offset) | ((uint32)ReadUInt16(Offset + 2) << 16);
+        }
+
+        /** BYTE, SHORT or LONG values of a directory entry, stored in the entry itself if they fit in 4 bytes */
+        bool ReadValues(int64 EntryOffset, TArray<uint32>& OutValues) const
+        {
+            const uint16 Type = ReadUInt16(EntryOffset + 2);
+            const uint32 Count = ReadUInt32(EntryOffset + 4);
+            const int32 ValueSize = (Type == 1) ? 1 : (Type == 3) ? 2 : (Type == 4) ? 4 : 0;
+            if (ValueSize == 0 || Count == 0)
+            {
+                return false;
+            }
+
+            const int64 ValuesSize = (int64)Count * ValueSize;
+            const int64 ValuesOffset = (ValuesSize <= 4) ? EntryOffset + 8 : ReadUInt32(EntryOffset + 8);
+            if (ValuesOffset + ValuesSize > Length)
+            {
+                return false;
+            }
+
+            OutValues.SetNumUninitialized(Count);
+            for (uint32 Index = 0; Index < Count; ++Index)
+            {
+                const int64 Offset = ValuesOffset + (int64)Index * ValueSize;
+                OutValues[Index] = (ValueSize == 1) ? Buffer[Offset] : (ValueSize == 2) ? ReadUInt16(Offset) : ReadUInt32(Offset);
+            }
+            return true;
+        }
+    };
+
+    /** Where the samples are and how they are stored, chunks are the strips or the tiles */
+    struct FLayout
+    {
+        int32 Width = 0;
+        int32 Height = 0;
+        int32 SamplesPerPixel = 1;
+        int32 BytesPerSample = 1;
+        uint32 Compression = ECompression::None;
+        uint32 Predictor = 1;
+        bool bBigEndian = false;
+        bool bTiled = false;
+
+        int32 ChunkWidth = 0;
+        int32 ChunkHeight = 0;
+        int32 ChunksAcross = 1;
+        TArray<uint32> Offsets;
+        TArray<uint32> ByteCounts;
+
+        const TCHAR* GetChunkName() const { return bTiled ? TEXT("tile") : TEXT("strip"); }
+        int64 GetSourceBytesPerPixel() const { return (int64)SamplesPerPixel * BytesPerSample; }
+        int32 GetDestBytesPerPixel() const { return (SamplesPerPixel == 1 ? 1 : 4) * BytesPerSample; }
+
+        // strips at the bottom of the image only hold the remaining rows, tiles are always whole
+        int32 GetChunkRows(int32 Chunk) const
+        {
+            return bTiled ? ChunkHeight : FMath::Min(ChunkHeight, Height - Chunk * ChunkHeight);
+        }
+
+        int64 GetChunkSize(int32 Chunk) const
+        {
+            return (int64)ChunkWidth * GetChunkRows(Chunk) * GetSourceBytesPerPixel();
+        }
+
+        // rows are byte swapped and the horizontal differencing undone before they are converted
+        bool NeedsRowPreparation() const
+        {
+            return Predictor == 2 || (bBigEndian && BytesPerSample == 2);
+        }
+    };
+
+    bool DecodeLZW(const uint8* Source, int64 SourceSize, uint8* Dest, int64 DestSize)
+    {
+        const int32 ClearCode = 256;
+        const int32 EndCode = 257;
+        const int32 FirstCode = 258;
+        const int32 MaxCodes = 4096;
+
+        // strings are stored as their prefix code and last byte
+        uint16 Prefixes[MaxCodes];
+        uint8 Suffixes[MaxCodes];
+        uint8 FirstBytes[MaxCodes];
+        uint16 Lengths[MaxCodes];
+        for (int32 Code = 0; Code < 256; ++Code)
+        {
+            Suffixes[Code] = FirstBytes[Code] = (uint8)Code;
+            Lengths[Code] = 1;
+        }
+
+        int32 CodeWidth = 9;
+        int32 NextCode = FirstCode;
+        int32 PreviousCode = -1;
+
+        uint32 BitBuffer = 0;
+        int32 NumBits = 0;
+        int64 SourceOffset = 0;
+        int64 DestOffset = 0;
+
+        while (DestOffset < DestSize)
+        {
+            // codes are packed from the most significant bit
+            while (NumBits < CodeWidth && SourceOffset < SourceSize)
+            {
+                BitBuffer = (BitBuffer << 8) | Source[SourceOffset++];
+                NumBits += 8;
+            }
+            if (NumBits < CodeWidth)
+            {
+                return false;
+            }
+
+            const int32 Code = (int32)((BitBuffer >> (NumBits - CodeWidth)) & ((1u << CodeWidth) - 1));
+            NumBits -= CodeWidth;
+
+            if (Code == EndCode)
+            {
+                return false;
+            }
+
+            if (Code == ClearCode)
+            {
+                CodeWidth = 9;
+                NextCode = FirstCode;
+                PreviousCode = -1;
+                continue;
+            }
+
+            if (PreviousCode < 0)
+            {
+                if (Code >= 256)
+                {
+                    return false;
+                }
+                Dest[DestOffset++] = (uint8)Code;
+                PreviousCode = Code;
+                continue;
+            }
+
+            if (Code > NextCode)
+            {
+                return false;
+            }
+
+            // the code may be the one being added, its string is the previous one followed by its own first byte
+            if (NextCode < MaxCodes)
+            {
+                Prefixes[NextCode] = (uint16)PreviousCode;
+                FirstBytes[NextCode] = FirstBytes[PreviousCode];
+                Suffixes[NextCode] = (Code == NextCode) ? FirstBytes[PreviousCode] : FirstBytes[Code];
+                Lengths[NextCode] = Lengths[PreviousCode] + 1;
+                ++NextCode;
+
+                // TIFF widens the codes one code early
+                if (NextCode >= (1 << CodeWidth) - 1 && CodeWidth < 12)
+                {
+                    ++CodeWidth;
+                }
+            }
+            else if (Code == NextCode)
+            {
+                return false;
+            }
+
+            // written back to front, strings past the end of the chunk are cut
+            const int32 Length = Lengths[Code];
+            int32 StringCode = Code;
+            for (int32 Index = Length - 1; Index >= 0; --Index)
+            {
+                if (DestOffset + Index < DestSize)
+                {
+                    Dest[DestOffset + Index] = Suffixes[StringCode];
+                }
+                StringCode = Prefixes[StringCode];
+            }
+            DestOffset = FMath::Min(DestOffset + Length, DestSize);
+            PreviousCode = Code;
+        }
+
+        return true;
+    }
+
+    static bool Inflate(const uint8* Source, int64 SourceSize, uint8* Dest, int64 DestSize)
+    {
+        if (SourceSize > MAX_uint32 || DestSize > MAX_uint32)
+        {
+            return false;
+        }
+
+        z_stream Stream;
+        FMemory::Memzero(Stream);
+        if (inflateInit(&Stream) != Z_OK)
+        {
+            return false;
+        }
+
+        Stream.next_in = const_cast<Bytef*>(Source);
+        Stream.avail_in = (uInt)SourceSize;
+        Stream.next_out = Dest;
+        Stream.avail_out = (uInt)DestSize;
+        inflate(&Stream, Z_FINISH);
+
+        const bool bInflated = Stream.avail_out == 0;
+        inflateEnd(&Stream);
+        return bInflated;
+    }
+
+    static void PrepareRow(uint8* Row, int32 NumPixels, const FLayout& Layout)
+    {
+        const int32 NumValues = NumPixels * Layout.SamplesPerPixel;
+        const int32 Stride = Layout.SamplesPerPixel;
+
+        if (Layout.BytesPerSample == 1)
+        {
+            for (int32 Index = Stride; Index < NumValues; ++Index)
+            {
+                Row[Index] += Row[Index - Stride];
+            }
+            return;
+        }
+
+        uint16* Values = reinterpret_cast<uint16*>(Row);
+        if (Layout.bBigEndian)
+        {
+            for (int32 Index = 0; Index < NumValues; ++Index)
+            {
+                Values[Index] = BYTESWAP_ORDER16(Values[Index]);
+            }
+        }
+
+        if (Layout.Predictor == 2)
+        {
+            for (int32 Index = Stride; Index < NumValues; ++Index)
+            {
+                Values[Index] += Values[Index - Stride];
+            }
+        }
+    }
+
+    /** Grayscale rows are copied, RGB(A) rows become BGRA8 or RGBA16 with opaque alpha if there is none */
+    static void ConvertRow(const uint8* Row, uint8* Dest, int32 NumPixels, const FLayout& Layout)
+    {
+        if (Layout.SamplesPerPixel == 1 || (Layout.SamplesPerPixel == 4 && Layout.BytesPerSample == 2))
+        {
+            FMemory::Memcpy(Dest, Row, NumPixels * Layout.GetSourceBytesPerPixel());
+            return;
+        }
+
+        if (Layout.BytesPerSample == 2)
+        {
+            const uint16* Values = reinterpret_cast<const uint16*>(Row);
+            uint16* DestValues = reinterpret_cast<uint16*>(Dest);
+            for (int32 X = 0; X < NumPixels; ++X)
+            {
+                DestValues[X * 4 + 0] = Values[X * 3 + 0];
+                DestValues[X * 4 + 1] = Values[X * 3 + 1];
+                DestValues[X * 4 + 2] = Values[X * 3 + 2];
+                DestValues[X * 4 + 3] = 0xFFFF;
+            }
+            return;
+        }
+
+        const bool bAlpha = Layout.SamplesPerPixel == 4;
+        for (int32 X = 0; X < NumPixels; ++X)
+        {
+            const uint8* Pixel = Row + X * Layout.SamplesPerPixel;
+            Dest[X * 4 + 0] = Pixel[2];
+            Dest[X * 4 + 1] = Pixel[1];
+            Dest[X * 4 + 2] = Pixel[0];
+            Dest[X * 4 + 3] = bAlpha ? Pixel[3] : 255;
+        }
+    }
+
+    /** Reads the first directory, false if the image is not one of the layouts read here */
+    static bool ReadLayout(const FFileReader& Reader, FLayout& OutLayout)
+    {
+        const uint32 DirectoryOffset = Reader.ReadUInt32(4);
+        if ((int64)DirectoryOffset + 2 > Reader.Length)
+        {
+            return false;
+        }
+
+        const uint16 NumEntries = Reader.ReadUInt16(DirectoryOffset);
+        if ((int64)DirectoryOffset + 2 + NumEntries * 12 > Reader.Length)
+        {
+            return false;
+        }
+
+        TArray<uint32> BitsPerSampleValues = { 1 };
+        TArray<uint32> SampleFormats = { 1 };
+        uint32 Photometric = MAX_uint32;
+        uint32 RowsPerStripValue = MAX_uint32;
+        uint32 PlanarConfig = 1;
+        uint32 FillOrderValue = 1;
+
+        TArray<uint32> Values;
+        for (int32 Entry = 0; Entry < NumEntries; ++Entry)
+        {
+            const int64 EntryOffset = DirectoryOffset + 2 + Entry * 12;
+            const uint16 Tag = Reader.ReadUInt16(EntryOffset);
+
+            switch (Tag)
+            {
+                case ImageWidth:
+                case ImageLength:
+                case BitsPerSample:
+                case Compression:
+                case PhotometricInterpretation:
+                case FillOrder:
+                case StripOffsets:
+                case SamplesPerPixel:
+                case RowsPerStrip:
+                case StripByteCounts:
+                case PlanarConfiguration:
+                case Predictor:
+                case TileWidth:
+                case TileLength:
+                case TileOffsets:
+                case TileByteCounts:
+                case SampleFormat:
+                    if (!Reader.ReadValues(EntryOffset, Values))
+                    {
+                        return false;
+                    }
+                    break;
+
+                default:
+                    continue;
+            }
+
+            switch (Tag)
+            {
+                case ImageWidth:                OutLayout.Width = (int32)Values[0]; break;
+                case ImageLength:               OutLayout.Height = (int32)Values[0]; break;
+                case BitsPerSample:             BitsPerSampleValues = Values; break;
+                case Compression:               OutLayout.Compression = Values[0]; break;
+                case PhotometricInterpretation: Photometric = Values[0]; break;
+                case FillOrder:                 FillOrderValue = Values[0]; break;
+                case SamplesPerPixel:           OutLayout.SamplesPerPixel = (int32)Values[0]; break;
+                case RowsPerStrip:              RowsPerStripValue = Values[0]; break;
+                case PlanarConfiguration:       PlanarConfig = Values[0]; break;
+                case Predictor:                 OutLayout.Predictor = Values[0]; break;
+                case TileWidth:                 OutLayout.ChunkWidth = (int32)Values[0]; OutLayout.bTiled = true; break;
+                case TileLength:                OutLayout.ChunkHeight = (int32)Values[0]; OutLayout.bTiled = true; break;
+                case SampleFormat:              SampleFormats = Values; break;
+                case StripOffsets:
+                case TileOffsets:               OutLayout.Offsets = Values; break;
+                case StripByteCounts:
+                case TileByteCounts:            OutLayout.ByteCounts = Values; break;
+                default:                        break;
+            }
+        }
+
+        // samples must all be unsigned integers of the same depth
+        const uint32 Bits = BitsPerSampleValues[0];
+        for (uint32 Value : BitsPerSampleValues)
+        {
+            if (Value != Bits)
+            {
+                return false;
+            }
+        }
+        for (uint32 Value : SampleFormats)
+        {
+            if (Value != 1)
+            {
+                return false;
+            }
+        }
+
+        const bool bGray = Photometric == 1 && OutLayout.SamplesPerPixel == 1;
+        const bool bColor = Photometric == 2 && (OutLayout.SamplesPerPixel == 3 || OutLayout.SamplesPerPixel == 4);
+        const bool bCompressionSupported = OutLayout.Compression == ECompression::None || OutLayout.Compression == ECompression::LZW
+            || OutLayout.Compression == ECompression::Deflate || OutLayout.Compression == ECompression::AdobeDeflate;
+
+        if ((Bits != 8 && Bits != 16) || (!bGray && !bColor) || !bCompressionSupported || (OutLayout.Predictor != 1 && OutLayout.Predictor != 2)
+            || (PlanarConfig != 1 && !bGray) || FillOrderValue != 1 || OutLayout.Width <= 0 || OutLayout.Height <= 0)
+        {
+            return false;
+        }
+
+        OutLayout.BytesPerSample = (int32)Bits / 8;
+        OutLayout.bBigEndian = Reader.bBigEndian;
+
+        if (OutLayout.bTiled)
+        {
+            if (OutLayout.ChunkWidth <= 0 || OutLayout.ChunkHeight <= 0)
+            {
+                return false;
+            }
+            OutLayout.ChunksAcross = FMath::DivideAndRoundUp(OutLayout.Width, OutLayout.ChunkWidth);
+        }
+        else
+        {
+            OutLayout.ChunkWidth = OutLayout.Width;
+            OutLayout.ChunkHeight = (int32)FMath::Clamp<uint32>(RowsPerStripValue, 1, (uint32)OutLayout.Height);
+            OutLayout.ChunksAcross = 1;
+        }
+
+        const int32 NumChunks = OutLayout.ChunksAcross * FMath::DivideAndRoundUp(OutLayout.Height, OutLayout.ChunkHeight);
+        return OutLayout.Offsets.Num() >= NumChunks && OutLayout.ByteCounts.Num() >= NumChunks;
+    }
+
+    bool DecodeParallel(const uint8* Buffer, int64 Length, FRuntimeImageData& OutImage, FString& OutError)
+    {
+        if (Length < 8)
+        {
+            return false;
+        }
+
+        FFileReader Reader;
+        Reader.Buffer = Buffer;
+        Reader.Length = Length;
+        Reader.bBigEndian = Buffer[0] == 'M';
+
+        // BigTIFF (43) is left to FreeImage
+        FLayout Layout;
+        if (Buffer[0] != Buffer[1] || (Buffer[0] != 'I' && Buffer[0] != 'M') || Reader.ReadUInt16(2) != 42 || !ReadLayout(Reader, Layout))
+        {
+            return false;
+        }
+
+        if (!FRuntimeImageUtils::IsImportResolutionValid(Layout.Width, Layout.Height, true))
+        {
+            OutError = FString::Printf(TEXT("Texture resolution is not supported: %d x %d"), Layout.Width, Layout.Height);
+            return false;
+        }
+
+        const int32 ChunksDown = FMath::DivideAndRoundUp(Layout.Height, Layout.ChunkHeight);
+        const int32 NumChunks = Layout.ChunksAcross * ChunksDown;
+
+        for (int32 Chunk = 0; Chunk < NumChunks; ++Chunk)
+        {
+            const bool bShort = Layout.Compression == ECompression::None && Layout.ByteCounts[Chunk] < Layout.GetChunkSize(Chunk);
+            if ((int64)Layout.Offsets[Chunk] + Layout.ByteCounts[Chunk] > Length || bShort)
+            {
+                OutError = FString::Printf(TEXT("TIFF %s %d is truncated"), Layout.GetChunkName(), Chunk);
+                return false;
+            }
+        }
+
+        // LZW of the first libtiff versions has its bits in the other order
+        if (Layout.Compression == ECompression::LZW && Layout.ByteCounts[0] >= 2 && Buffer[Layout.Offsets[0]] == 0 && (Buffer[Layout.Offsets[0] + 1] & 1))
+        {
+            return false;
+        }
+
+        const bool bGray = Layout.SamplesPerPixel == 1;
+        const bool b16Bit = Layout.BytesPerSample == 2;
+        OutImage.Init2D(Layout.Width, Layout.Height, bGray ? (b16Bit ? TSF_G16 : TSF_G8) : (b16Bit ? TSF_RGBA16 : TSF_BGRA8));
+        OutImage.SRGB = !bGray && !b16Bit;
+        OutImage.CompressionSettings = bGray ? TC_Grayscale : TC_Default;
+
+        const int64 SourceRowBytes = Layout.ChunkWidth * Layout.GetSourceBytesPerPixel();
+        const int64 DestRowBytes = (int64)Layout.Width * Layout.GetDestBytesPerPixel();
+        uint8* DestData = OutImage.RawData.GetData();
+
+        if (Layout.Compression == ECompression::None && !Layout.bTiled)
+        {
+            // uncompressed rows can be found directly, so even an image stored as one strip is converted in bands
+            const int32 RowsPerBand = 64;
+            ParallelFor(FMath::DivideAndRoundUp(Layout.Height, RowsPerBand), [&](int32 Band)
+            {
+                TArray64<uint8> PreparedRow;
+                if (Layout.NeedsRowPreparation())
+                {
+                    PreparedRow.SetNumUninitialized(SourceRowBytes);
+                }
+
+                const int32 EndY = FMath::Min((Band + 1) * RowsPerBand, Layout.Height);
+                for (int32 Y = Band * RowsPerBand; Y < EndY; ++Y)
+                {
+                    const uint8* Row = Buffer + Layout.Offsets[Y / Layout.ChunkHeight] + (Y % Layout.ChunkHeight) * SourceRowBytes;
+                    if (Layout.NeedsRowPreparation())
+                    {
+                        FMemory::Memcpy(PreparedRow.GetData(), Row, SourceRowBytes);
+                        PrepareRow(PreparedRow.GetData(), Layout.Width, Layout);
+                        Row = PreparedRow.GetData();
+                    }
+                    ConvertRow(Row, DestData + Y * DestRowBytes, Layout.Width, Layout);
+                }
+            });
+            return true;
+        }
+
+        TArray<bool> FailedChunks;
+        FailedChunks.SetNumZeroed(NumChunks);
+
+        ParallelFor(NumChunks, [&](int32 Chunk)
+        {
+            const uint8* Source = Buffer + Layout.Offsets[Chunk];
+            const int64 SourceSize = Layout.ByteCounts[Chunk];
+
+            TArray64<uint8> Decoded;
+            Decoded.SetNumUninitialized(Layout.GetChunkSize(Chunk));
+
+            bool bDecoded = true;
+            switch (Layout.Compression)
+            {
+                case ECompression::LZW: bDecoded = DecodeLZW(Source, SourceSize, Decoded.GetData(), Decoded.Num()); break;
+                case ECompression::None: FMemory::Memcpy(Decoded.GetData(), Source, Decoded.Num()); break;
+                default: bDecoded = Inflate(Source, SourceSize, Decoded.GetData(), Decoded.Num()); break;
+            }
+
+            if (!bDecoded)
+            {
+                FailedChunks[Chunk] = true;
+                return;
+            }
+
+            // tiles over the right and bottom edges are padded
+            const int32 X0 = (Chunk % Layout.ChunksAcross) * Layout.ChunkWidth;
+            const int32 Y0 = (Chunk / Layout.ChunksAcross) * Layout.ChunkHeight;
+            const int32 VisibleWidth = FMath::Min(Layout.ChunkWidth, Layout.Width - X0);
+            const int32 VisibleRows = FMath::Min(Layout.GetChunkRows(Chunk), Layout.Height - Y0);
+
+            for (int32 Row = 0; Row < VisibleRows; ++Row)
+            {
+                uint8* SourceRow = Decoded.GetData() + Row * SourceRowBytes;
+                if (Layout.NeedsRowPreparation())
+                {
+                    PrepareRow(SourceRow, Layout.ChunkWidth, Layout);
+                }
+                ConvertRow(SourceRow, DestData + (Y0 + Row) * DestRowBytes + (int64)X0 * Layout.GetDestBytesPerPixel(), VisibleWidth, Layout);
+            }
+        });
+
+        const int32 FailedChunk = FailedChunks.Find(true);
+        if (FailedChunk != INDEX_NONE)
+        {
+            OutError = FString::Printf(TEXT("Failed to decompress TIFF %s %d"), Layout.GetChunkName(), FailedChunk);
+            return false;
+        }
+
+        return true;
+    }
+}
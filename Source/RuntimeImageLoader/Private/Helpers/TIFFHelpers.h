@@ -0,0 +1,20 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RuntimeImageData.h"
+
+
+namespace FTIFFHelpers
+{
+    /**
+     * Decodes baseline TIFFs of 8 or 16-bit grayscale, RGB or RGBA samples, uncompressed or LZW or Deflate compressed, in strips or tiles.
+     * Strips and tiles are decoded in parallel on the task graph and uncompressed rows in bands, so the largest scans use all cores.
+     * Returns false without an error for the other TIFFs (e.g. JPEG or PackBits compression, palettes, planar or float samples), FreeImage decodes those
+     */
+    bool DecodeParallel(const uint8* Buffer, int64 Length, FRuntimeImageData& OutImage, FString& OutError);
+
+    /** Decodes one TIFF LZW compressed strip or tile into exactly DestSize bytes, false if the data ends before */
+    bool DecodeLZW(const uint8* Source, int64 SourceSize, uint8* Dest, int64 DestSize);
+}
@@ -7,6 +7,7 @@ DEFINE_LOG_CATEGORY_STATIC(LogRuntimeImageLoaderTIFFLoader, Log, All);
 #if WITH_FREEIMAGE_LIB
 
 #include "Misc/Paths.h"
+#include "Async/ParallelFor.h"
 
 #if PLATFORM_WINDOWS
 #include "Windows/AllowWindowsPlatformTypes.h"
@@ -21,29 +22,33 @@ class FFreeImageWrapper
 public:
 	static bool IsValid() { return FreeImageDllHandle != nullptr; }
 
-	static void FreeImage_Initialise(bool bLoadLocalPluginsOnly); // Loads and inits FreeImage on first call
+	static void FreeImage_Initialise(bool bLoadLocalPluginsOnly); // Loads and inits FreeImage on first call, safe to call from any thread
 
 private:
 	static void* FreeImageDllHandle; // Lazy init on first use, never release for now
+	static FCriticalSection InitialiseMutex;
+	static bool bInitialiseAttempted;
 };
 
 void* FFreeImageWrapper::FreeImageDllHandle = nullptr;
+FCriticalSection FFreeImageWrapper::InitialiseMutex;
+bool FFreeImageWrapper::bInitialiseAttempted = false;
 
 void FFreeImageWrapper::FreeImage_Initialise(bool bLoadLocalPluginsOnly)
 {
-	if (FreeImageDllHandle != nullptr)
+	FScopeLock InitialiseLock(&InitialiseMutex);
+
+	if (bInitialiseAttempted)
 	{
 		return;
 	}
+	bInitialiseAttempted = true;
 
-	if (FreeImageDllHandle == nullptr)
-	{
-		FString FreeImageDir = FPaths::Combine(FPaths::EngineDir(), TEXT("Binaries/ThirdParty/FreeImage"), FPlatformProcess::GetBinariesSubdirectory());
-		FString FreeImageLibDir = FPaths::Combine( FreeImageDir, TEXT(FREEIMAGE_LIB_FILENAME));
-		FPlatformProcess::PushDllDirectory(*FreeImageDir);
-		FreeImageDllHandle = FPlatformProcess::GetDllHandle(*FreeImageLibDir);
-		FPlatformProcess::PopDllDirectory(*FreeImageDir);
-	}
+	FString FreeImageDir = FPaths::Combine(FPaths::EngineDir(), TEXT("Binaries/ThirdParty/FreeImage"), FPlatformProcess::GetBinariesSubdirectory());
+	FString FreeImageLibDir = FPaths::Combine( FreeImageDir, TEXT(FREEIMAGE_LIB_FILENAME));
+	FPlatformProcess::PushDllDirectory(*FreeImageDir);
+	FreeImageDllHandle = FPlatformProcess::GetDllHandle(*FreeImageLibDir);
+	FPlatformProcess::PopDllDirectory(*FreeImageDir);
 
 	if (FreeImageDllHandle)
 	{
@@ -55,6 +60,31 @@ void FFreeImageWrapper::FreeImage_Initialise(bool bLoadLocalPluginsOnly)
 #include "Windows/HideWindowsPlatformTypes.h"
 #endif // PLATFORM_WINDOWS
 
+namespace
+{
+	// conversions of 8k-16k images are split into bands of scanlines, each band is converted on its own worker
+	void ParallelForScanlines(int32 Height, TFunctionRef<void(int32 Y)> ConvertScanline)
+	{
+		const int32 ScanlinesPerBand = 64;
+		const int32 NumBands = FMath::DivideAndRoundUp(Height, ScanlinesPerBand);
+
+		ParallelFor(NumBands, [&](int32 Band)
+		{
+			const int32 EndY = FMath::Min((Band + 1) * ScanlinesPerBand, Height);
+			for (int32 Y = Band * ScanlinesPerBand; Y < EndY; ++Y)
+			{
+				ConvertScanline(Y);
+			}
+		});
+	}
+
+	// FreeImage keeps all images upside-down, scanlines are read bottom to top instead of flipping the bitmap
+	const BYTE* GetSourceScanline(FIBITMAP* Bitmap, int32 Height, int32 Y)
+	{
+		return FreeImage_GetBits(Bitmap) + (int64)FreeImage_GetPitch(Bitmap) * (Height - 1 - Y);
+	}
+}
+
 FRuntimeTiffLoadHelper::FRuntimeTiffLoadHelper()
 {
 	FFreeImageWrapper::FreeImage_Initialise(false);
@@ -76,20 +106,17 @@ bool FRuntimeTiffLoadHelper::Load(const uint8 * Buffer, uint32 Length)
 {
 	FREE_IMAGE_FORMAT FileType = FIF_TIFF;
 
+	Reset();
+
 	Memory = FreeImage_OpenMemory(const_cast<uint8*>(Buffer), Length);
 	Bitmap = FreeImage_LoadFromMemory(FileType, Memory, 0);
 
 	if (!Bitmap)
 	{
+		SetError(TEXT("FreeImage can't load the image"));
 		return false;
 	}
 
-	// FreeImage keeps all images upside-down
-	if (!ensure(FreeImage_FlipVertical(Bitmap)))
-	{
-		UE_LOG(LogRuntimeImageLoaderTIFFLoader, Error, TEXT("Can't flip TIFF image"));
-	}
-
 	const int32 BitsPerPixel = FreeImage_GetBPP(Bitmap);
 
 	bool bIsSourceSupported = true;
@@ -168,7 +195,7 @@ bool FRuntimeTiffLoadHelper::Load(const uint8 * Buffer, uint32 Length)
 
 	if (!bIsSourceSupported)
 	{
-		UE_LOG(LogRuntimeImageLoaderTIFFLoader, Error, TEXT("Unsupported TIFF format"));
+		SetError(TEXT("Unsupported TIFF format"));
 		return false;
 	}
 
@@ -178,7 +205,7 @@ bool FRuntimeTiffLoadHelper::Load(const uint8 * Buffer, uint32 Length)
 	if (bIsSourceFloatingPoint)
 	{
 		// Floating point images converted to RGBA16F
-		RawData.SetNumUninitialized(Height * Width * 4 * sizeof(FFloat16));
+		RawData.SetNumUninitialized((int64)Height * Width * 4 * sizeof(FFloat16));
 
 		TextureSourceFormat = TSF_RGBA16F;
 		CompressionSettings = TC_HDR_Compressed;
@@ -187,42 +214,40 @@ bool FRuntimeTiffLoadHelper::Load(const uint8 * Buffer, uint32 Length)
 		FIBITMAP* ConvertedBitmap = FreeImage_ConvertToType(Bitmap, FIT_RGBAF, true);
 		if (ConvertedBitmap)
 		{
-			BYTE* Bits = FreeImage_GetBits(ConvertedBitmap);
-			int32 Pitch = FreeImage_GetPitch(ConvertedBitmap);
-			for (int Y = 0; Y < Height; Y++)
+			ParallelForScanlines(Height, [&](int32 Y)
 			{
-				BYTE* ScanLine = Bits + Pitch * Y;
-				FIRGBAF* Pixels = (FIRGBAF*)ScanLine;
-				for (int X = 0; X < Width; X++)
+				const FIRGBAF* Pixels = (const FIRGBAF*)GetSourceScanline(ConvertedBitmap, Height, Y);
+				FFloat16* TargetPixel = ((FFloat16*)RawData.GetData()) + (int64)Y * Width * 4;
+				for (int32 X = 0; X < Width; X++, TargetPixel += 4)
 				{
-					FIRGBAF P = Pixels[X];
-					FFloat16* TargetPixel = ((FFloat16*)RawData.GetData()) + (X + Y * Width) * 4;
+					const FIRGBAF& P = Pixels[X];
 					TargetPixel[0].Set(P.red);
 					TargetPixel[1].Set(P.green);
 					TargetPixel[2].Set(P.blue);
 					TargetPixel[3].Set(P.alpha);
 				}
-			}
+			});
 
 			FreeImage_Unload(ConvertedBitmap);
 		}
 	}
 	else if (bIsSourceGrayScale)
 	{
-		// Grayscale images converted to either G8 or RGBA16
-		if (bIsSource16BitsPerChannel)
+		// Grayscale images converted to either G8 or G16
+		if (ImageType == FIT_UINT16)
 		{
-			ConvertToRGBA16();
+			ConvertToG16();
 		}
+		else
 		{
-			RawData.SetNumUninitialized(Height * Width * 4);
+			RawData.SetNumUninitialized((int64)Height * Width);
 
 			TextureSourceFormat = TSF_G8;
 			CompressionSettings = TC_Grayscale;
 			bSRGB = false;
 
 			FIBITMAP* ConvertedBitmap;
-			if (bShouldConvertToByte) {
+			if (bShouldConvertToByte || ImageType == FIT_UINT32) {
 				ConvertedBitmap = FreeImage_ConvertToStandardType(Bitmap, true);
 			}
 			else
@@ -232,19 +257,10 @@ bool FRuntimeTiffLoadHelper::Load(const uint8 * Buffer, uint32 Length)
 
 			if (ConvertedBitmap)
 			{
-
-				BYTE* Bits = FreeImage_GetBits(ConvertedBitmap);
-				int32 Pitch = FreeImage_GetPitch(ConvertedBitmap);
-				for (int Y = 0; Y < Height; Y++)
+				ParallelForScanlines(Height, [&](int32 Y)
 				{
-					BYTE* ScanLine = Bits + Pitch * Y;
-					uint8* TargetPixels = ((uint8*)RawData.GetData()) + Y * Width;
-					for (int X = 0; X < Width; X++)
-					{
-						uint8 P = ScanLine[X];
-						TargetPixels[X] = P;
-					}
-				}
+					FMemory::Memcpy(RawData.GetData() + (int64)Y * Width, GetSourceScanline(ConvertedBitmap, Height, Y), Width);
+				});
 				FreeImage_Unload(ConvertedBitmap);
 			}
 		}
@@ -259,7 +275,7 @@ bool FRuntimeTiffLoadHelper::Load(const uint8 * Buffer, uint32 Length)
 		{
 			// Convert to RGBA(8-bit)
 
-			RawData.SetNumUninitialized(Height * Width * 4);
+			RawData.SetNumUninitialized((int64)Height * Width * 4);
 
 			TextureSourceFormat = TSF_BGRA8;
 			CompressionSettings = TC_Default;
@@ -268,23 +284,25 @@ bool FRuntimeTiffLoadHelper::Load(const uint8 * Buffer, uint32 Length)
 			FIBITMAP* ConvertedBitmap = FreeImage_ConvertTo32Bits(Bitmap);
 			if (ConvertedBitmap)
 			{
-
-				BYTE* Bits = FreeImage_GetBits(ConvertedBitmap);
-				int32 Pitch = FreeImage_GetPitch(ConvertedBitmap);
-				for (int Y = 0; Y < Height; Y++)
+				ParallelForScanlines(Height, [&](int32 Y)
 				{
-					BYTE* ScanLine = Bits + Pitch * Y;
-					for (int X = 0; X < Width; X++)
+					const BYTE* ScanLine = GetSourceScanline(ConvertedBitmap, Height, Y);
+					uint8* TargetPixel = RawData.GetData() + (int64)Y * Width * 4;
+#if FREEIMAGE_COLORORDER == FREEIMAGE_COLORORDER_BGR
+					// already BGRA
+					FMemory::Memcpy(TargetPixel, ScanLine, (int64)Width * 4);
+#else
+					for (int32 X = 0; X < Width; X++, TargetPixel += 4)
 					{
-						uint8* P = ScanLine + X * 4;
-						uint8* TargetPixel = ((uint8*)RawData.GetData()) + (X + Y * Width) * 4;
+						const BYTE* P = ScanLine + X * 4;
 						// FI_RGBA_X - cross-platform way to retrieve channels
 						TargetPixel[0] = P[FI_RGBA_BLUE];
 						TargetPixel[1] = P[FI_RGBA_GREEN];
 						TargetPixel[2] = P[FI_RGBA_RED];
 						TargetPixel[3] = P[FI_RGBA_ALPHA];
 					}
-				}
+#endif
+				});
 
 				FreeImage_Unload(ConvertedBitmap);
 			}
@@ -296,7 +314,7 @@ bool FRuntimeTiffLoadHelper::Load(const uint8 * Buffer, uint32 Length)
 
 bool FRuntimeTiffLoadHelper::ConvertToRGBA16()
 {
-	RawData.SetNumUninitialized(Height * Width * 4 * 2);
+	RawData.SetNumUninitialized((int64)Height * Width * 4 * 2);
 
 	TextureSourceFormat = TSF_RGBA16;
 	CompressionSettings = TC_Default;
@@ -305,23 +323,11 @@ bool FRuntimeTiffLoadHelper::ConvertToRGBA16()
 	FIBITMAP* ConvertedBitmap = FreeImage_ConvertToType(Bitmap, FIT_RGBA16, true);
 	if (ConvertedBitmap)
 	{
-		BYTE* Bits = FreeImage_GetBits(ConvertedBitmap);
-		int32 Pitch = FreeImage_GetPitch(ConvertedBitmap);
-		for (int Y = 0; Y < Height; Y++)
+		// FIRGBA16 is laid out as red, green, blue, alpha on every platform, same as TSF_RGBA16
+		ParallelForScanlines(Height, [&](int32 Y)
 		{
-			BYTE* ScanLine = Bits + Pitch * Y;
-			FIRGBA16* Pixels = (FIRGBA16*)ScanLine;
-			uint16* TargetScanLine = ((uint16*)RawData.GetData()) + Y * Width * 4;
-			for (int X = 0; X < Width; X++)
-			{
-				FIRGBA16 P = Pixels[X];
-				uint16* TargetPixel = TargetScanLine + X * 4;
-				TargetPixel[0] = P.red;
-				TargetPixel[1] = P.green;
-				TargetPixel[2] = P.blue;
-				TargetPixel[3] = P.alpha;
-			}
-		}
+			FMemory::Memcpy(RawData.GetData() + (int64)Y * Width * 8, GetSourceScanline(ConvertedBitmap, Height, Y), (int64)Width * 8);
+		});
 
 		FreeImage_Unload(ConvertedBitmap);
 		return true;
@@ -329,6 +335,21 @@ bool FRuntimeTiffLoadHelper::ConvertToRGBA16()
 	return false;
 }
 
+void FRuntimeTiffLoadHelper::ConvertToG16()
+{
+	RawData.SetNumUninitialized((int64)Height * Width * 2);
+
+	TextureSourceFormat = TSF_G16;
+	CompressionSettings = TC_Grayscale;
+	bSRGB = false;
+
+	// FIT_UINT16 scanlines are already G16
+	ParallelForScanlines(Height, [&](int32 Y)
+	{
+		FMemory::Memcpy(RawData.GetData() + (int64)Y * Width * 2, GetSourceScanline(Bitmap, Height, Y), (int64)Width * 2);
+	});
+}
+
 void FRuntimeTiffLoadHelper::SetError(const FString& InErrorMessage)
 {
 	ErrorMessage = InErrorMessage;
@@ -341,15 +362,17 @@ FString FRuntimeTiffLoadHelper::GetError()
 
 void FRuntimeTiffLoadHelper::Reset()
 {
-    if (Memory)
-    {
-        FreeImage_CloseMemory(Memory);
-    }
-
-    if (Bitmap)
-    {
-        FreeImage_Unload(Bitmap);
-    }
+	if (Bitmap)
+	{
+		FreeImage_Unload(Bitmap);
+		Bitmap = nullptr;
+	}
+
+	if (Memory)
+	{
+		FreeImage_CloseMemory(Memory);
+		Memory = nullptr;
+	}
 }
 
 bool FRuntimeTiffLoadHelper::IsValid()
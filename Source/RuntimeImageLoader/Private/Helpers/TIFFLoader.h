@@ -25,7 +25,7 @@ public:
 
 public:
 	// Resulting image data and properties
-	TArray<uint8> RawData;
+	TArray64<uint8> RawData;
 	int32 Width;
 	int32 Height;
 	ETextureSourceFormat TextureSourceFormat = TSF_Invalid;
@@ -35,6 +35,7 @@ public:
 
 private:
 	bool ConvertToRGBA16();
+	void ConvertToG16();
 
 private:
 	bool bIsValid = false;
@@ -0,0 +1,569 @@
+/*
+
+fastpng - decoder of the common PNG variants straight into BGRA8/G8
+
+-- About
+
+Decodes 8-bit non-interlaced gray, gray+alpha, RGB, RGBA and palette PNGs.
+Rows are inflated one at a time into a pair of small row buffers, unfiltered
+(with SSE4.1/NEON where available) and swizzled right into the output image,
+so no full size intermediate buffer is ever allocated.
+
+Everything else (16-bit, sub-byte depths, Adam7 interlacing, tRNS color keys)
+is reported as unsupported by fastpng_read_header and should be decoded with
+a full featured decoder. Chunk CRCs are not verified.
+
+
+-- Synopsis
+
+// Define `FASTPNG_IMPLEMENTATION` in *one* C/C++ file before including this
+// library to create the implementation. zlib.h must be available.
+
+#define FASTPNG_IMPLEMENTATION
+#include "fastpng.h"
+
+fastpng_desc desc;
+if (fastpng_read_header(data, size, &desc)) {
+	size_t out_size = desc.width * desc.height * desc.out_channels;
+	unsigned char *pixels = malloc(out_size);
+	fastpng_decode(data, size, &desc, pixels, NULL, NULL);
+}
+
+
+-- Configuration
+
+FASTPNG_SSE41 or FASTPNG_NEON (AArch64) enable the vectorised unfiltering
+and swizzling.
+
+FASTPNG_MALLOC and FASTPNG_FREE replace malloc() and free() of the row
+buffers.
+
+*/
+
+#ifndef FASTPNG_H
+#define FASTPNG_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+	unsigned int width;
+	unsigned int height;
+	unsigned char color_type;
+	/* 1 for gray, 4 for BGRA, which is used for all the other color types */
+	unsigned char out_channels;
+	/* image has an alpha channel or transparent palette entries */
+	unsigned char has_alpha;
+} fastpng_desc;
+
+/* Called after each row of the output is written */
+typedef void (*fastpng_row_callback)(void *user, unsigned int y, unsigned char *row);
+
+/* Reads the header. Returns 1 if the image is a PNG that fastpng_decode can
+decode, 0 otherwise. */
+int fastpng_read_header(const void *data, size_t size, fastpng_desc *desc);
+
+/* Decodes the image into out, which must hold width * height * out_channels
+bytes, rows are tightly packed. Returns 1 on success, 0 if the image data is
+corrupted. */
+int fastpng_decode(const void *data, size_t size, const fastpng_desc *desc, void *out, fastpng_row_callback row_callback, void *user);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* FASTPNG_H */
+
+
+/* -----------------------------------------------------------------------------
+Implementation */
+
+#ifdef FASTPNG_IMPLEMENTATION
+#include <string.h>
+#include "zlib.h"
+
+#ifndef FASTPNG_MALLOC
+	#include <stdlib.h>
+	#define FASTPNG_MALLOC(sz) malloc(sz)
+	#define FASTPNG_FREE(p)    free(p)
+#endif
+
+#if defined(FASTPNG_SSE41)
+	#include <smmintrin.h>
+#elif defined(FASTPNG_NEON)
+	#include <arm_neon.h>
+#endif
+
+/* row buffers are padded so that vector loads may read past the row */
+#define FASTPNG_ROW_PADDING 32
+
+typedef struct {
+	const unsigned char *data;
+	size_t size;
+	size_t pos;
+	/* bytes left in the current IDAT chunk */
+	size_t idat_left;
+	unsigned char palette[256 * 4];
+	int palette_size;
+} fastpng_reader;
+
+static unsigned int fastpng_read_32(const unsigned char *p) {
+	return ((unsigned int)p[0] << 24) | ((unsigned int)p[1] << 16) | ((unsigned int)p[2] << 8) | (unsigned int)p[3];
+}
+
+static int fastpng_channels(int color_type) {
+	switch (color_type) {
+		case 0: return 1;
+		case 2: return 3;
+		case 3: return 1;
+		case 4: return 2;
+		case 6: return 4;
+		default: return 0;
+	}
+}
+
+/* Walks the chunks before the first IDAT, collects the palette and leaves the
+reader at the beginning of the first IDAT chunk */
+static int fastpng_read_chunks(fastpng_reader *r, int color_type, int *has_trns) {
+	int i;
+
+	r->pos = 8;
+	r->palette_size = 0;
+	*has_trns = 0;
+
+	for (i = 0; i < 256; i++) {
+		r->palette[i * 4 + 0] = 0;
+		r->palette[i * 4 + 1] = 0;
+		r->palette[i * 4 + 2] = 0;
+		r->palette[i * 4 + 3] = 255;
+	}
+
+	while (r->pos + 12 <= r->size) {
+		unsigned int length = fastpng_read_32(r->data + r->pos);
+		const unsigned char *type = r->data + r->pos + 4;
+		const unsigned char *chunk = r->data + r->pos + 8;
+
+		if (length > r->size - r->pos - 12) {
+			return 0;
+		}
+
+		if (memcmp(type, "IDAT", 4) == 0) {
+			return color_type != 3 || r->palette_size > 0;
+		}
+		else if (memcmp(type, "PLTE", 4) == 0) {
+			unsigned int entries = length / 3;
+			if (entries > 256 || length % 3 != 0) {
+				return 0;
+			}
+			for (i = 0; i < (int)entries; i++) {
+				/* stored as BGRA */
+				r->palette[i * 4 + 0] = chunk[i * 3 + 2];
+				r->palette[i * 4 + 1] = chunk[i * 3 + 1];
+				r->palette[i * 4 + 2] = chunk[i * 3 + 0];
+			}
+			r->palette_size = (int)entries;
+		}
+		else if (memcmp(type, "tRNS", 4) == 0) {
+			/* only palette alpha is supported, color keys are left to the full decoders */
+			if (color_type != 3 || length > 256) {
+				return 0;
+			}
+			for (i = 0; i < (int)length; i++) {
+				r->palette[i * 4 + 3] = chunk[i];
+			}
+			*has_trns = 1;
+		}
+		else if (memcmp(type, "IEND", 4) == 0) {
+			return 0;
+		}
+
+		r->pos += 12 + length;
+	}
+
+	return 0;
+}
+
+int fastpng_read_header(const void *data, size_t size, fastpng_desc *desc) {
+	static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+	const unsigned char *bytes = (const unsigned char *)data;
+	fastpng_reader r;
+	int has_trns;
+
+	if (data == NULL || desc == NULL || size < 33 || memcmp(bytes, signature, 8) != 0 ||
+		fastpng_read_32(bytes + 8) != 13 || memcmp(bytes + 12, "IHDR", 4) != 0) {
+		return 0;
+	}
+
+	desc->width = fastpng_read_32(bytes + 16);
+	desc->height = fastpng_read_32(bytes + 20);
+	desc->color_type = bytes[25];
+
+	/* bit depth 8, deflate, adaptive filtering, no interlacing */
+	if (desc->width == 0 || desc->height == 0 || desc->width > (1u << 24) || desc->height > (1u << 24) ||
+		bytes[24] != 8 || fastpng_channels(desc->color_type) == 0 || bytes[26] != 0 || bytes[27] != 0 || bytes[28] != 0) {
+		return 0;
+	}
+
+	r.data = bytes;
+	r.size = size;
+	if (!fastpng_read_chunks(&r, desc->color_type, &has_trns)) {
+		return 0;
+	}
+
+	desc->out_channels = (desc->color_type == 0) ? 1 : 4;
+	desc->has_alpha = (desc->color_type == 4 || desc->color_type == 6 || has_trns) ? 1 : 0;
+
+	return 1;
+}
+
+/* Moves the reader to the next IDAT chunk, returns 0 if there is none */
+static int fastpng_next_idat(fastpng_reader *r, const unsigned char **chunk, unsigned int *chunk_length) {
+	while (r->pos + 12 <= r->size) {
+		unsigned int length = fastpng_read_32(r->data + r->pos);
+		const unsigned char *type = r->data + r->pos + 4;
+
+		if (length > r->size - r->pos - 12) {
+			return 0;
+		}
+
+		r->pos += 12 + length;
+
+		if (memcmp(type, "IDAT", 4) == 0) {
+			*chunk = r->data + r->pos - 4 - length;
+			*chunk_length = length;
+			return 1;
+		}
+		if (memcmp(type, "IEND", 4) == 0) {
+			return 0;
+		}
+	}
+	return 0;
+}
+
+/* Inflates exactly size bytes, feeding the stream from the IDAT chunks */
+static int fastpng_inflate(fastpng_reader *r, z_stream *stream, unsigned char *dst, size_t size) {
+	stream->next_out = dst;
+	stream->avail_out = (uInt)size;
+
+	while (stream->avail_out > 0) {
+		int status;
+
+		if (stream->avail_in == 0) {
+			const unsigned char *chunk;
+			unsigned int chunk_length;
+			if (!fastpng_next_idat(r, &chunk, &chunk_length)) {
+				return 0;
+			}
+			stream->next_in = (Bytef *)chunk;
+			stream->avail_in = chunk_length;
+			continue;
+		}
+
+		status = inflate(stream, Z_NO_FLUSH);
+		if (status == Z_STREAM_END) {
+			return stream->avail_out == 0;
+		}
+		if (status != Z_OK) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static unsigned char fastpng_paeth(int a, int b, int c) {
+	int p = a + b - c;
+	int pa = p > a ? p - a : a - p;
+	int pb = p > b ? p - b : b - p;
+	int pc = p > c ? p - c : c - p;
+	if (pa <= pb && pa <= pc) return (unsigned char)a;
+	if (pb <= pc) return (unsigned char)b;
+	return (unsigned char)c;
+}
+
+#if defined(FASTPNG_SSE41)
+static __m128i fastpng_load_pixel(const unsigned char *p, int bpp) {
+	int v = 0;
+	memcpy(&v, p, bpp);
+	return _mm_cvtsi32_si128(v);
+}
+
+static void fastpng_store_pixel(unsigned char *p, __m128i v, int bpp) {
+	int s = _mm_cvtsi128_si32(v);
+	memcpy(p, &s, bpp);
+}
+
+static __m128i fastpng_abs_epi16(__m128i x) {
+	return _mm_abs_epi16(x);
+}
+
+static __m128i fastpng_select(__m128i mask, __m128i a, __m128i b) {
+	return _mm_blendv_epi8(b, a, mask);
+}
+#endif
+
+/* Reverses the filter of the row in place, prev is the already unfiltered row above (zeros for the first one) */
+static void fastpng_unfilter(int filter, unsigned char *row, const unsigned char *prev, size_t row_bytes, int bpp) {
+	size_t i = 0;
+
+	switch (filter) {
+		case 0:
+			break;
+
+		case 1: /* sub */
+#if defined(FASTPNG_SSE41)
+			if (bpp == 3 || bpp == 4) {
+				__m128i a = _mm_setzero_si128();
+				for (; i < row_bytes; i += bpp) {
+					a = _mm_add_epi8(a, fastpng_load_pixel(row + i, bpp));
+					fastpng_store_pixel(row + i, a, bpp);
+				}
+				break;
+			}
+#endif
+			for (i = bpp; i < row_bytes; i++) {
+				row[i] = (unsigned char)(row[i] + row[i - bpp]);
+			}
+			break;
+
+		case 2: /* up */
+#if defined(FASTPNG_SSE41)
+			for (; i + 16 <= row_bytes; i += 16) {
+				__m128i x = _mm_loadu_si128((const __m128i *)(row + i));
+				__m128i b = _mm_loadu_si128((const __m128i *)(prev + i));
+				_mm_storeu_si128((__m128i *)(row + i), _mm_add_epi8(x, b));
+			}
+#elif defined(FASTPNG_NEON)
+			for (; i + 16 <= row_bytes; i += 16) {
+				vst1q_u8(row + i, vaddq_u8(vld1q_u8(row + i), vld1q_u8(prev + i)));
+			}
+#endif
+			for (; i < row_bytes; i++) {
+				row[i] = (unsigned char)(row[i] + prev[i]);
+			}
+			break;
+
+		case 3: /* average */
+#if defined(FASTPNG_SSE41)
+			if (bpp == 3 || bpp == 4) {
+				const __m128i one = _mm_set1_epi8(1);
+				__m128i a = _mm_setzero_si128();
+				for (; i < row_bytes; i += bpp) {
+					__m128i b = fastpng_load_pixel(prev + i, bpp);
+					/* avg_epu8 rounds up, floor((a + b) / 2) is needed */
+					__m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+					a = _mm_add_epi8(avg, fastpng_load_pixel(row + i, bpp));
+					fastpng_store_pixel(row + i, a, bpp);
+				}
+				break;
+			}
+#endif
+			for (i = 0; i < (size_t)bpp && i < row_bytes; i++) {
+				row[i] = (unsigned char)(row[i] + (prev[i] >> 1));
+			}
+			for (; i < row_bytes; i++) {
+				row[i] = (unsigned char)(row[i] + ((row[i - bpp] + prev[i]) >> 1));
+			}
+			break;
+
+		case 4: /* paeth */
+#if defined(FASTPNG_SSE41)
+			if (bpp == 3 || bpp == 4) {
+				const __m128i zero = _mm_setzero_si128();
+				__m128i a = zero, c = zero;
+				for (; i < row_bytes; i += bpp) {
+					__m128i b = _mm_unpacklo_epi8(fastpng_load_pixel(prev + i, bpp), zero);
+					__m128i x = fastpng_load_pixel(row + i, bpp);
+
+					/* pa = |b - c|, pb = |a - c|, pc = |a + b - 2c| in 16 bits */
+					__m128i pa_signed = _mm_sub_epi16(b, c);
+					__m128i pb_signed = _mm_sub_epi16(a, c);
+					__m128i pa = fastpng_abs_epi16(pa_signed);
+					__m128i pb = fastpng_abs_epi16(pb_signed);
+					__m128i pc = fastpng_abs_epi16(_mm_add_epi16(pa_signed, pb_signed));
+					__m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+
+					__m128i predictor = fastpng_select(_mm_cmpeq_epi16(smallest, pa), a,
+						fastpng_select(_mm_cmpeq_epi16(smallest, pb), b, c));
+
+					x = _mm_add_epi8(x, _mm_packus_epi16(predictor, predictor));
+					fastpng_store_pixel(row + i, x, bpp);
+
+					a = _mm_unpacklo_epi8(x, zero);
+					c = b;
+				}
+				break;
+			}
+#endif
+			for (i = 0; i < (size_t)bpp && i < row_bytes; i++) {
+				row[i] = (unsigned char)(row[i] + prev[i]);
+			}
+			for (; i < row_bytes; i++) {
+				row[i] = (unsigned char)(row[i] + fastpng_paeth(row[i - bpp], prev[i], prev[i - bpp]));
+			}
+			break;
+	}
+}
+
+/* Converts the unfiltered row into the output format */
+static void fastpng_swizzle(const fastpng_reader *r, int color_type, const unsigned char *row, unsigned char *out, unsigned int width) {
+	unsigned int x = 0;
+
+	switch (color_type) {
+		case 0: /* gray -> G8 */
+			memcpy(out, row, width);
+			break;
+
+		case 2: /* RGB -> BGRA */
+#if defined(FASTPNG_SSE41)
+			{
+				const __m128i shuffle = _mm_setr_epi8(2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+				const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+				/* 16 bytes are loaded for 4 pixels, row padding covers the overrun */
+				for (; x + 4 <= width; x += 4) {
+					__m128i rgb = _mm_loadu_si128((const __m128i *)(row + x * 3));
+					_mm_storeu_si128((__m128i *)(out + x * 4), _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), alpha));
+				}
+			}
+#elif defined(FASTPNG_NEON)
+			for (; x + 16 <= width; x += 16) {
+				uint8x16x3_t rgb = vld3q_u8(row + x * 3);
+				uint8x16x4_t bgra;
+				bgra.val[0] = rgb.val[2];
+				bgra.val[1] = rgb.val[1];
+				bgra.val[2] = rgb.val[0];
+				bgra.val[3] = vdupq_n_u8(255);
+				vst4q_u8(out + x * 4, bgra);
+			}
+#endif
+			for (; x < width; x++) {
+				out[x * 4 + 0] = row[x * 3 + 2];
+				out[x * 4 + 1] = row[x * 3 + 1];
+				out[x * 4 + 2] = row[x * 3 + 0];
+				out[x * 4 + 3] = 255;
+			}
+			break;
+
+		case 3: /* palette -> BGRA */
+			for (; x < width; x++) {
+				memcpy(out + x * 4, r->palette + row[x] * 4, 4);
+			}
+			break;
+
+		case 4: /* gray + alpha -> BGRA */
+#if defined(FASTPNG_SSE41)
+			{
+				const __m128i lo = _mm_setr_epi8(0, 0, 0, 1, 2, 2, 2, 3, 4, 4, 4, 5, 6, 6, 6, 7);
+				const __m128i hi = _mm_setr_epi8(8, 8, 8, 9, 10, 10, 10, 11, 12, 12, 12, 13, 14, 14, 14, 15);
+				for (; x + 8 <= width; x += 8) {
+					__m128i ga = _mm_loadu_si128((const __m128i *)(row + x * 2));
+					_mm_storeu_si128((__m128i *)(out + x * 4), _mm_shuffle_epi8(ga, lo));
+					_mm_storeu_si128((__m128i *)(out + x * 4 + 16), _mm_shuffle_epi8(ga, hi));
+				}
+			}
+#endif
+			for (; x < width; x++) {
+				out[x * 4 + 0] = row[x * 2];
+				out[x * 4 + 1] = row[x * 2];
+				out[x * 4 + 2] = row[x * 2];
+				out[x * 4 + 3] = row[x * 2 + 1];
+			}
+			break;
+
+		case 6: /* RGBA -> BGRA */
+#if defined(FASTPNG_SSE41)
+			{
+				const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+				for (; x + 4 <= width; x += 4) {
+					__m128i rgba = _mm_loadu_si128((const __m128i *)(row + x * 4));
+					_mm_storeu_si128((__m128i *)(out + x * 4), _mm_shuffle_epi8(rgba, shuffle));
+				}
+			}
+#elif defined(FASTPNG_NEON)
+			for (; x + 16 <= width; x += 16) {
+				uint8x16x4_t rgba = vld4q_u8(row + x * 4);
+				uint8x16_t red = rgba.val[0];
+				rgba.val[0] = rgba.val[2];
+				rgba.val[2] = red;
+				vst4q_u8(out + x * 4, rgba);
+			}
+#endif
+			for (; x < width; x++) {
+				out[x * 4 + 0] = row[x * 4 + 2];
+				out[x * 4 + 1] = row[x * 4 + 1];
+				out[x * 4 + 2] = row[x * 4 + 0];
+				out[x * 4 + 3] = row[x * 4 + 3];
+			}
+			break;
+	}
+}
+
+int fastpng_decode(const void *data, size_t size, const fastpng_desc *desc, void *out, fastpng_row_callback row_callback, void *user) {
+	fastpng_reader r;
+	z_stream stream;
+	unsigned char *buffer, *row, *prev, *tmp;
+	size_t row_bytes, out_stride;
+	unsigned int y;
+	int bpp, has_trns, result = 1;
+
+	r.data = (const unsigned char *)data;
+	r.size = size;
+	if (!fastpng_read_chunks(&r, desc->color_type, &has_trns)) {
+		return 0;
+	}
+
+	bpp = fastpng_channels(desc->color_type);
+	row_bytes = (size_t)desc->width * bpp;
+	out_stride = (size_t)desc->width * desc->out_channels;
+
+	/* filter byte + row, twice; the previous row starts zeroed */
+	buffer = (unsigned char *)FASTPNG_MALLOC(2 * (row_bytes + FASTPNG_ROW_PADDING));
+	if (buffer == NULL) {
+		return 0;
+	}
+	memset(buffer, 0, 2 * (row_bytes + FASTPNG_ROW_PADDING));
+	row = buffer + FASTPNG_ROW_PADDING / 2;
+	prev = buffer + row_bytes + FASTPNG_ROW_PADDING + FASTPNG_ROW_PADDING / 2;
+
+	memset(&stream, 0, sizeof(stream));
+	if (inflateInit(&stream) != Z_OK) {
+		FASTPNG_FREE(buffer);
+		return 0;
+	}
+
+	for (y = 0; y < desc->height; y++) {
+		unsigned char *out_row = (unsigned char *)out + y * out_stride;
+		unsigned char filter;
+
+		/* filter type byte goes right before the row */
+		if (!fastpng_inflate(&r, &stream, row - 1, row_bytes + 1)) {
+			result = 0;
+			break;
+		}
+
+		filter = row[-1];
+		if (filter > 4) {
+			result = 0;
+			break;
+		}
+
+		fastpng_unfilter(filter, row, prev, row_bytes, bpp);
+		fastpng_swizzle(&r, desc->color_type, row, out_row, desc->width);
+
+		if (row_callback) {
+			row_callback(user, y, out_row);
+		}
+
+		tmp = prev;
+		prev = row;
+		row = tmp;
+	}
+
+	inflateEnd(&stream);
+	FASTPNG_FREE(buffer);
+
+	return result;
+}
+
+#endif /* FASTPNG_IMPLEMENTATION */
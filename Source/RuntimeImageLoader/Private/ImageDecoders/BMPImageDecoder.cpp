@@ -0,0 +1,148 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "BMPImageDecoder.h"
+#include "IImageWrapperModule.h"
+#include "IImageWrapper.h"
+#include "Modules/ModuleManager.h"
+#include "RuntimeImageUtils.h"
+
+void FBMPImageDecoder::GetLeadBytes(TArray<uint8>& OutLeadBytes) const
+{
+    OutLeadBytes.Add('B');
+}
+
+bool FBMPImageDecoder::Sniff(const uint8* Buffer, int64 Length) const
+{
+    return Length >= 2 && Buffer[0] == 'B' && Buffer[1] == 'M';
+}
+
+bool FBMPImageDecoder::GetImageSize(const uint8* Buffer, int64 Length, int32& OutWidth, int32& OutHeight) const
+{
+    // BITMAPINFOHEADER and its successors, height is negative for top-down images
+    if (!Sniff(Buffer, Length) || Length < 26 || (Buffer[14] | (Buffer[15] << 8)) < 40)
+    {
+        return false;
+    }
+
+    OutWidth = Buffer[18] | (Buffer[19] << 8) | (Buffer[20] << 16) | (Buffer[21] << 24);
+    OutHeight = FMath::Abs((int32)(Buffer[22] | (Buffer[23] << 8) | (Buffer[24] << 16) | (Buffer[25] << 24)));
+    return OutWidth > 0 && OutHeight > 0;
+}
+
+/** Reads the region of uncompressed 24-bit BMP straight from its rows, returns false without an error for the other BMPs */
+static bool DecodeRegion(const uint8* Buffer, int64 Length, const FImageDecodeParams& Params, FRuntimeImageData& OutImage, FString& OutError)
+{
+    auto ReadUInt16 = [Buffer](int64 Offset) { return (uint32)(Buffer[Offset] | (Buffer[Offset + 1] << 8)); };
+    auto ReadUInt32 = [Buffer](int64 Offset) { return (uint32)(Buffer[Offset] | (Buffer[Offset + 1] << 8) | (Buffer[Offset + 2] << 16) | (Buffer[Offset + 3] << 24)); };
+
+    // BITMAPINFOHEADER with BI_RGB compression
+    if (Length < 54 || ReadUInt32(14) < 40 || ReadUInt16(28) != 24 || ReadUInt32(30) != 0)
+    {
+        return false;
+    }
+
+    const int64 DataOffset = ReadUInt32(10);
+    const int32 Width = (int32)ReadUInt32(18);
+    const int32 SignedHeight = (int32)ReadUInt32(22);
+    const int32 Height = FMath::Abs(SignedHeight);
+    const int64 Pitch = ((int64)Width * 3 + 3) & ~3;
+
+    if (Width <= 0 || Height <= 0 || DataOffset + Pitch * Height > Length)
+    {
+        return false;
+    }
+
+    if (!FRuntimeImageUtils::IsImportResolutionValid(Width, Height, true))
+    {
+        OutError = FString::Printf(TEXT("Texture resolution is not supported: %d x %d"), Width, Height);
+        return false;
+    }
+
+    const FIntRect Region = Params.GetClippedRegion(Width, Height);
+    if (Region.Area() == 0)
+    {
+        OutError = FString::Printf(TEXT("Region %s is outside of the image"), *Params.Region.ToString());
+        return false;
+    }
+
+    OutImage.Init2D(Region.Width(), Region.Height(), TSF_BGRA8);
+    OutImage.DecodedRegion = Region;
+    OutImage.SRGB = true;
+    OutImage.GammaSpace = EGammaSpace::sRGB;
+
+    // positive height means the rows are stored bottom up
+    const bool bBottomUp = SignedHeight > 0;
+
+    for (int32 Y = Region.Min.Y; Y < Region.Max.Y; ++Y)
+    {
+        const int32 SourceRow = bBottomUp ? Height - Y - 1 : Y;
+        const uint8* Source = Buffer + DataOffset + SourceRow * Pitch + Region.Min.X * 3;
+        FColor* Dest = reinterpret_cast<FColor*>(OutImage.RawData.GetData()) + (int64)(Y - Region.Min.Y) * Region.Width();
+
+        for (int32 X = 0; X < Region.Width(); ++X)
+        {
+            Dest[X] = FColor(Source[X * 3 + 2], Source[X * 3 + 1], Source[X * 3 + 0], 255);
+        }
+    }
+
+    return true;
+}
+
+bool FBMPImageDecoder::Decode(const uint8* Buffer, int64 Length, const FImageDecodeParams& Params, FRuntimeImageData& OutImage, FString& OutError) const
+{
+    QUICK_SCOPE_CYCLE_COUNTER(STAT_FBMPImageDecoder_Decode);
+
+    if (Params.HasRegion())
+    {
+        if (DecodeRegion(Buffer, Length, Params, OutImage, OutError))
+        {
+            return true;
+        }
+
+        if (!OutError.IsEmpty())
+        {
+            return false;
+        }
+    }
+
+    IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+
+    TSharedPtr<IImageWrapper> BmpImageWrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::BMP);
+    if (!BmpImageWrapper.IsValid() || !BmpImageWrapper->SetCompressed(Buffer, Length))
+    {
+        OutError = TEXT("Failed to decode BMP image header");
+        return false;
+    }
+
+    // Check the resolution of the imported texture to ensure validity
+    if (!FRuntimeImageUtils::IsImportResolutionValid(BmpImageWrapper->GetWidth(), BmpImageWrapper->GetHeight(), true))
+    {
+        OutError = FString::Printf(TEXT("Texture resolution is not supported: %d x %d"), BmpImageWrapper->GetWidth(), BmpImageWrapper->GetHeight());
+        return false;
+    }
+
+    TArray64<uint8> RawBMP;
+    if (BmpImageWrapper->GetRaw(BmpImageWrapper->GetFormat(), BmpImageWrapper->GetBitDepth(), RawBMP))
+    {
+        // Set texture properties.
+        if (!OutImage.Init2D(
+            BmpImageWrapper->GetWidth(),
+            BmpImageWrapper->GetHeight(),
+            TSF_BGRA8,
+            MoveTemp(RawBMP),
+            OutError))
+        {
+            return false;
+        }
+        
+        OutImage.SRGB = true;
+        OutImage.GammaSpace = OutImage.SRGB ? EGammaSpace::sRGB : EGammaSpace::Linear;
+    }
+    else
+    {
+        OutError = FString::Printf(TEXT("Failed to decode BMP. Bit depth: %d"), BmpImageWrapper->GetBitDepth());
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,238 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "DDSImageDecoder.h"
+#include "RuntimeImageUtils.h"
+
+namespace DDS
+{
+    // DDS_HEADER flags
+    constexpr uint32 FlagMipMapCount = 0x00020000;
+    constexpr uint32 PixelFormatFourCC = 0x00000004;
+    constexpr uint32 Caps2Cubemap = 0x00000200;
+    constexpr uint32 Caps2CubemapAllFaces = 0x0000FC00;
+    constexpr uint32 Caps2Volume = 0x00200000;
+
+    // DDS_HEADER_DXT10
+    constexpr uint32 DimensionTexture2D = 3;
+    constexpr uint32 MiscTextureCube = 0x4;
+
+    static uint32 ReadUInt32(const uint8* Buffer, int64 Offset)
+    {
+        return (uint32)Buffer[Offset] | ((uint32)Buffer[Offset + 1] << 8) | ((uint32)Buffer[Offset + 2] << 16) | ((uint32)Buffer[Offset + 3] << 24);
+    }
+
+    static constexpr uint32 MakeFourCC(char A, char B, char C, char D)
+    {
+        return (uint32)(uint8)A | ((uint32)(uint8)B << 8) | ((uint32)(uint8)C << 16) | ((uint32)(uint8)D << 24);
+    }
+
+    static EPixelFormat GetFourCCPixelFormat(uint32 FourCC, bool& OutSRGB)
+    {
+        // legacy files don't tell the color space, DXTn are color textures
+        OutSRGB = true;
+        switch (FourCC)
+        {
+            case MakeFourCC('D', 'X', 'T', '1'): return PF_DXT1;
+            case MakeFourCC('D', 'X', 'T', '3'): return PF_DXT3;
+            case MakeFourCC('D', 'X', 'T', '5'): return PF_DXT5;
+            default: break;
+        }
+
+        OutSRGB = false;
+        switch (FourCC)
+        {
+            case MakeFourCC('A', 'T', 'I', '1'):
+            case MakeFourCC('B', 'C', '4', 'U'): return PF_BC4;
+            case MakeFourCC('A', 'T', 'I', '2'):
+            case MakeFourCC('B', 'C', '5', 'U'): return PF_BC5;
+            default: return PF_Unknown;
+        }
+    }
+
+    /** DXGI formats of BCn blocks that have no Unreal pixel format: signed BC4 and BC5 and signed BC6H */
+    static bool IsSignedDXGIFormat(uint32 DXGIFormat)
+    {
+        return DXGIFormat == 81 || DXGIFormat == 84 || DXGIFormat == 96;
+    }
+
+    static bool IsSignedFourCC(uint32 FourCC)
+    {
+        return FourCC == MakeFourCC('B', 'C', '4', 'S') || FourCC == MakeFourCC('B', 'C', '5', 'S');
+    }
+
+    static EPixelFormat GetDXGIPixelFormat(uint32 DXGIFormat, bool& OutSRGB)
+    {
+        // DXGI_FORMAT values, the sRGB variants follow their UNORM formats
+        OutSRGB = DXGIFormat == 72 || DXGIFormat == 75 || DXGIFormat == 78 || DXGIFormat == 99;
+        switch (DXGIFormat)
+        {
+            case 71: case 72: return PF_DXT1;
+            case 74: case 75: return PF_DXT3;
+            case 77: case 78: return PF_DXT5;
+            case 80:          return PF_BC4;
+            case 83:          return PF_BC5;
+            case 95:          return PF_BC6H;
+            case 98: case 99: return PF_BC7;
+            default:          return PF_Unknown;
+        }
+    }
+}
+
+void FDDSImageDecoder::GetLeadBytes(TArray<uint8>& OutLeadBytes) const
+{
+    OutLeadBytes.Add('D');
+}
+
+bool FDDSImageDecoder::Sniff(const uint8* Buffer, int64 Length) const
+{
+    return Length >= 4 && DDS::ReadUInt32(Buffer, 0) == DDS::MakeFourCC('D', 'D', 'S', ' ');
+}
+
+bool FDDSImageDecoder::GetImageSize(const uint8* Buffer, int64 Length, int32& OutWidth, int32& OutHeight) const
+{
+    if (!Sniff(Buffer, Length) || Length < 128)
+    {
+        return false;
+    }
+
+    OutWidth = (int32)DDS::ReadUInt32(Buffer, 16);
+    OutHeight = (int32)DDS::ReadUInt32(Buffer, 12);
+    return OutWidth > 0 && OutHeight > 0;
+}
+
+bool FDDSImageDecoder::Decode(const uint8* Buffer, int64 Length, const FImageDecodeParams& Params, FRuntimeImageData& OutImage, FString& OutError) const
+{
+    QUICK_SCOPE_CYCLE_COUNTER(STAT_FDDSImageDecoder_Decode);
+
+    if (!Sniff(Buffer, Length) || Length < 128 || DDS::ReadUInt32(Buffer, 4) != 124)
+    {
+        OutError = TEXT("Failed to decode DDS image header");
+        return false;
+    }
+
+    const uint32 Flags = DDS::ReadUInt32(Buffer, 8);
+    const int32 Height = (int32)DDS::ReadUInt32(Buffer, 12);
+    const int32 Width = (int32)DDS::ReadUInt32(Buffer, 16);
+    const uint32 MipMapCount = DDS::ReadUInt32(Buffer, 28);
+    const uint32 PixelFormatFlags = DDS::ReadUInt32(Buffer, 80);
+    const uint32 FourCC = DDS::ReadUInt32(Buffer, 84);
+    const uint32 Caps2 = DDS::ReadUInt32(Buffer, 112);
+
+    if ((PixelFormatFlags & DDS::PixelFormatFourCC) == 0)
+    {
+        OutError = TEXT("Only block compressed DDS images are supported");
+        return false;
+    }
+
+    if (Caps2 & DDS::Caps2Volume)
+    {
+        OutError = TEXT("Volume DDS images are not supported");
+        return false;
+    }
+
+    int64 DataOffset = 128;
+    bool bCubemap = (Caps2 & DDS::Caps2Cubemap) != 0;
+    uint32 ArraySize = 1;
+    bool bSRGB = false;
+    EPixelFormat PixelFormat = PF_Unknown;
+
+    if (FourCC == DDS::MakeFourCC('D', 'X', '1', '0'))
+    {
+        if (Length < 148)
+        {
+            OutError = TEXT("Failed to decode DDS image header");
+            return false;
+        }
+
+        if (DDS::ReadUInt32(Buffer, 132) != DDS::DimensionTexture2D)
+        {
+            OutError = TEXT("Only 2D DDS images are supported");
+            return false;
+        }
+
+        const uint32 DXGIFormat = DDS::ReadUInt32(Buffer, 128);
+        PixelFormat = DDS::GetDXGIPixelFormat(DXGIFormat, bSRGB);
+        bCubemap = (DDS::ReadUInt32(Buffer, 136) & DDS::MiscTextureCube) != 0;
+        ArraySize = DDS::ReadUInt32(Buffer, 140);
+        DataOffset = 148;
+
+        if (DDS::IsSignedDXGIFormat(DXGIFormat))
+        {
+            OutError = FString::Printf(TEXT("Signed DDS DXGI format %u is not supported, only unsigned BC4, BC5 and BC6H are"), DXGIFormat);
+            return false;
+        }
+
+        // a cubemap array counts cubes, not faces
+        if (ArraySize != 1)
+        {
+            OutError = FString::Printf(TEXT("DDS texture arrays are not supported, array size: %u"), ArraySize);
+            return false;
+        }
+
+        if (PixelFormat == PF_Unknown)
+        {
+            OutError = FString::Printf(TEXT("DDS DXGI format %u is not supported"), DDS::ReadUInt32(Buffer, 128));
+            return false;
+        }
+    }
+    else
+    {
+        PixelFormat = DDS::GetFourCCPixelFormat(FourCC, bSRGB);
+
+        if (DDS::IsSignedFourCC(FourCC))
+        {
+            OutError = TEXT("Signed DDS formats BC4S and BC5S are not supported, only unsigned BC4 and BC5 are");
+            return false;
+        }
+
+        if (PixelFormat == PF_Unknown)
+        {
+            OutError = FString::Printf(TEXT("DDS format %c%c%c%c is not supported"), FourCC & 0xFF, (FourCC >> 8) & 0xFF, (FourCC >> 16) & 0xFF, FourCC >> 24);
+            return false;
+        }
+
+        if (bCubemap && (Caps2 & DDS::Caps2CubemapAllFaces) != DDS::Caps2CubemapAllFaces)
+        {
+            OutError = TEXT("DDS cubemaps without all six faces are not supported");
+            return false;
+        }
+    }
+
+    if (!FRuntimeImageUtils::IsImportResolutionValid(Width, Height, true) || Width <= 0 || Height <= 0 || (bCubemap && Width != Height))
+    {
+        OutError = FString::Printf(TEXT("Texture resolution is not supported: %d x %d"), Width, Height);
+        return false;
+    }
+
+    if (!FRuntimeImageUtils::IsWholeBlockSize(PixelFormat, Width, Height))
+    {
+        OutError = FString::Printf(TEXT("%d x %d is not a whole number of %s blocks"), Width, Height, GPixelFormats[PixelFormat].Name);
+        return false;
+    }
+
+    const int32 MaxMips = FMath::FloorLog2(FMath::Max(Width, Height)) + 1;
+    const int32 NumMips = (Flags & DDS::FlagMipMapCount) ? FMath::Clamp((int32)MipMapCount, 1, MaxMips) : 1;
+
+    OutImage.SizeX = Width;
+    OutImage.SizeY = Height;
+    OutImage.NumSlices = bCubemap ? 6 : 1;
+    OutImage.NumMips = NumMips;
+    OutImage.PixelFormat = PixelFormat;
+    OutImage.SRGB = bSRGB;
+    OutImage.GammaSpace = bSRGB ? EGammaSpace::sRGB : EGammaSpace::Linear;
+    OutImage.CompressionSettings = (PixelFormat == PF_BC6H) ? TC_HDR : TC_Default;
+    OutImage.bPrecompressed = true;
+
+    // faces follow each other with all of their mips, as the RHIs take cubemap bulk data
+    const int64 DataSize = OutImage.GetMipOffset(NumMips) * OutImage.NumSlices;
+    if (DataOffset + DataSize > Length)
+    {
+        OutError = TEXT("DDS image data is truncated");
+        return false;
+    }
+
+    OutImage.RawData.SetNumUninitialized(DataSize);
+    FMemory::Memcpy(OutImage.RawData.GetData(), Buffer + DataOffset, DataSize);
+
+    return true;
+}
@@ -0,0 +1,84 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "EXRImageDecoder.h"
+#include "IImageWrapperModule.h"
+#include "IImageWrapper.h"
+#include "Modules/ModuleManager.h"
+#include "RuntimeImageUtils.h"
+
+void FEXRImageDecoder::GetLeadBytes(TArray<uint8>& OutLeadBytes) const
+{
+    OutLeadBytes.Add(0x76);
+}
+
+bool FEXRImageDecoder::Sniff(const uint8* Buffer, int64 Length) const
+{
+    static const uint8 Signature[4] = { 0x76, 0x2F, 0x31, 0x01 };
+    return Length >= sizeof(Signature) && FMemory::Memcmp(Buffer, Signature, sizeof(Signature)) == 0;
+}
+
+bool FEXRImageDecoder::Decode(const uint8* Buffer, int64 Length, const FImageDecodeParams& Params, FRuntimeImageData& OutImage, FString& OutError) const
+{
+    QUICK_SCOPE_CYCLE_COUNTER(STAT_FEXRImageDecoder_Decode);
+
+    IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+
+    TSharedPtr<IImageWrapper> ExrImageWrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::EXR);
+    if (!ExrImageWrapper.IsValid() || !ExrImageWrapper->SetCompressed(Buffer, Length))
+    {
+        OutError = TEXT("Failed to decode EXR image header");
+        return false;
+    }
+
+    int32 Width = ExrImageWrapper->GetWidth();
+    int32 Height = ExrImageWrapper->GetHeight();
+
+    if (!FRuntimeImageUtils::IsImportResolutionValid(Width, Height, true))
+    {
+        OutError = FString::Printf(TEXT("Texture resolution is not supported: %d x %d"), Width, Height);
+        return false;
+    }
+
+    // Select the texture's source format
+    ETextureSourceFormat TextureFormat = TSF_Invalid;
+    int32 BitDepth = ExrImageWrapper->GetBitDepth();
+    ERGBFormat Format = ExrImageWrapper->GetFormat();
+
+    if (Format == ERGBFormat::RGBA && BitDepth == 16)
+    {
+        TextureFormat = TSF_RGBA16F;
+        Format = ERGBFormat::BGRA;
+    }
+
+    if (TextureFormat == TSF_Invalid)
+    {
+        OutError = TEXT("EXR file contains data in an unsupported format.");
+        return false;
+    }
+
+    // OpenEXR decodes the whole image in this one call inside ImageWrapper, its line blocks can't be spread over the task graph from here
+    TArray64<uint8> RawExr;
+    if (ExrImageWrapper->GetRaw(Format, BitDepth, RawExr))
+    {
+        if (!OutImage.Init2D(
+            Width,
+            Height,
+            TextureFormat,
+            MoveTemp(RawExr),
+            OutError))
+        {
+            return false;
+        }
+
+        OutImage.SRGB = false;
+        OutImage.GammaSpace = OutImage.SRGB ? EGammaSpace::sRGB : EGammaSpace::Linear;
+        OutImage.CompressionSettings = TC_HDR;
+    }
+    else
+    {
+        OutError = FString::Printf(TEXT("Failed to decode EXR. Bit depth: %d"), BitDepth);
+        return false;
+    }
+
+    return true;
+}
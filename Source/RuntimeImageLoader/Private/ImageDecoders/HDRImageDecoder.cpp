@@ -0,0 +1,68 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "HDRImageDecoder.h"
+#include "IImageWrapperModule.h"
+#include "IImageWrapper.h"
+#include "Modules/ModuleManager.h"
+#include "RuntimeImageUtils.h"
+
+void FHDRImageDecoder::GetLeadBytes(TArray<uint8>& OutLeadBytes) const
+{
+    OutLeadBytes.Add('#');
+}
+
+bool FHDRImageDecoder::Sniff(const uint8* Buffer, int64 Length) const
+{
+    // "#?RADIANCE" or "#?RGBE" header line
+    return Length >= 2 && Buffer[0] == '#' && Buffer[1] == '?';
+}
+
+bool FHDRImageDecoder::Decode(const uint8* Buffer, int64 Length, const FImageDecodeParams& Params, FRuntimeImageData& OutImage, FString& OutError) const
+{
+    QUICK_SCOPE_CYCLE_COUNTER(STAT_FHDRImageDecoder_Decode);
+
+    IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+
+    TSharedPtr<IImageWrapper> HdrImageWrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::HDR);
+    if (!HdrImageWrapper.IsValid() || !HdrImageWrapper->SetCompressed(Buffer, Length))
+    {
+        OutError = TEXT("Failed to decode HDR image header");
+        return false;
+    }
+
+    if (!FRuntimeImageUtils::IsImportResolutionValid(HdrImageWrapper->GetWidth(), HdrImageWrapper->GetHeight(), true))
+    {
+        OutError = FString::Printf(TEXT("HDR Texture resolution is not supported: %d x %d"), HdrImageWrapper->GetWidth(), HdrImageWrapper->GetHeight());
+        return false;
+    }
+
+    // Select the texture's source format
+    ETextureSourceFormat TextureFormat = TSF_BGRE8;
+    int32 BitDepth = HdrImageWrapper->GetBitDepth();
+    ERGBFormat Format = HdrImageWrapper->GetFormat();
+
+    TArray64<uint8> RawHDR;
+    if (HdrImageWrapper->GetRaw(ERGBFormat::BGRE, BitDepth, RawHDR))
+    {
+        if (!OutImage.Init2D(
+            HdrImageWrapper->GetWidth(),
+            HdrImageWrapper->GetHeight(),
+            TextureFormat,
+            MoveTemp(RawHDR),
+            OutError))
+        {
+            return false;
+        }
+
+        OutImage.SRGB = false;
+        OutImage.GammaSpace = EGammaSpace::Linear;
+        OutImage.CompressionSettings = TC_HDR;
+    }
+    else
+    {
+        OutError = TEXT("Failed to load .HDR image. Input image is not valid cubemap texture!");
+        return false;
+    }
+
+    return true;
+}
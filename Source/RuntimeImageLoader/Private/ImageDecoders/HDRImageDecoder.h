@@ -0,0 +1,15 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ImageDecoders/IImageDecoder.h"
+
+class FHDRImageDecoder : public IImageDecoder
+{
+public:
+    virtual FName GetName() const override { return TEXT("HDR"); }
+    virtual void GetLeadBytes(TArray<uint8>& OutLeadBytes) const override;
+    virtual bool Sniff(const uint8* Buffer, int64 Length) const override;
+    virtual bool Decode(const uint8* Buffer, int64 Length, const FImageDecodeParams& Params, FRuntimeImageData& OutImage, FString& OutError) const override;
+};
@@ -0,0 +1,110 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "ImageDecoders/ImageDecoderRegistry.h"
+#include "Misc/ScopeRWLock.h"
+
+#include "PNGImageDecoder.h"
+#include "JPEGImageDecoder.h"
+#include "BMPImageDecoder.h"
+#include "TGAImageDecoder.h"
+#include "EXRImageDecoder.h"
+#include "TIFFImageDecoder.h"
+#include "QOIImageDecoder.h"
+#include "HDRImageDecoder.h"
+#include "WebPImageDecoder.h"
+#include "DDSImageDecoder.h"
+#include "KTX2ImageDecoder.h"
+
+FImageDecoderRegistry& FImageDecoderRegistry::Get()
+{
+    static FImageDecoderRegistry Registry;
+    return Registry;
+}
+
+FImageDecoderRegistry::FImageDecoderRegistry()
+{
+    RegisterBuiltInDecoders();
+}
+
+void FImageDecoderRegistry::RegisterBuiltInDecoders()
+{
+    RegisterDecoder(MakeShared<FPNGImageDecoder, ESPMode::ThreadSafe>());
+    RegisterDecoder(MakeShared<FJPEGImageDecoder, ESPMode::ThreadSafe>());
+    RegisterDecoder(MakeShared<FBMPImageDecoder, ESPMode::ThreadSafe>());
+    RegisterDecoder(MakeShared<FTGAImageDecoder, ESPMode::ThreadSafe>());
+    RegisterDecoder(MakeShared<FEXRImageDecoder, ESPMode::ThreadSafe>());
+#if WITH_FREEIMAGE_LIB
+    RegisterDecoder(MakeShared<FTIFFImageDecoder, ESPMode::ThreadSafe>());
+#endif
+    RegisterDecoder(MakeShared<FQOIImageDecoder, ESPMode::ThreadSafe>());
+    RegisterDecoder(MakeShared<FHDRImageDecoder, ESPMode::ThreadSafe>());
+#if WITH_LIBWEBP
+    RegisterDecoder(MakeShared<FWebPImageDecoder, ESPMode::ThreadSafe>());
+#endif
+    RegisterDecoder(MakeShared<FDDSImageDecoder, ESPMode::ThreadSafe>());
+    RegisterDecoder(MakeShared<FKTX2ImageDecoder, ESPMode::ThreadSafe>());
+}
+
+void FImageDecoderRegistry::RegisterDecoder(const FImageDecoderRef& Decoder)
+{
+    UnregisterDecoder(Decoder->GetName());
+
+    TArray<uint8> LeadBytes;
+    Decoder->GetLeadBytes(LeadBytes);
+
+    FWriteScopeLock WriteLock(DecodersLock);
+
+    if (LeadBytes.Num() == 0)
+    {
+        FallbackDecoders.Insert(Decoder, 0);
+        return;
+    }
+
+    for (const uint8 LeadByte : LeadBytes)
+    {
+        DecodersByLeadByte[LeadByte].Insert(Decoder, 0);
+    }
+}
+
+void FImageDecoderRegistry::UnregisterDecoder(FName DecoderName)
+{
+    FWriteScopeLock WriteLock(DecodersLock);
+
+    auto HasName = [DecoderName](const FImageDecoderRef& Decoder) { return Decoder->GetName() == DecoderName; };
+
+    for (TArray<FImageDecoderRef>& Decoders : DecodersByLeadByte)
+    {
+        Decoders.RemoveAll(HasName);
+    }
+    FallbackDecoders.RemoveAll(HasName);
+}
+
+FImageDecoderPtr FImageDecoderRegistry::FindDecoder(const uint8* Buffer, int64 Length) const
+{
+    QUICK_SCOPE_CYCLE_COUNTER(STAT_FImageDecoderRegistry_FindDecoder);
+
+    if (Buffer == nullptr || Length <= 0)
+    {
+        return nullptr;
+    }
+
+    FReadScopeLock ReadLock(DecodersLock);
+
+    for (const FImageDecoderRef& Decoder : DecodersByLeadByte[Buffer[0]])
+    {
+        if (Decoder->Sniff(Buffer, Length))
+        {
+            return Decoder;
+        }
+    }
+
+    for (const FImageDecoderRef& Decoder : FallbackDecoders)
+    {
+        if (Decoder->Sniff(Buffer, Length))
+        {
+            return Decoder;
+        }
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,115 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "JPEGImageDecoder.h"
+#include "IImageWrapperModule.h"
+#include "IImageWrapper.h"
+#include "Modules/ModuleManager.h"
+#include "RuntimeImageUtils.h"
+#include "Helpers/JPEGHelpers.h"
+
+void FJPEGImageDecoder::GetLeadBytes(TArray<uint8>& OutLeadBytes) const
+{
+    OutLeadBytes.Add(0xFF);
+}
+
+bool FJPEGImageDecoder::Sniff(const uint8* Buffer, int64 Length) const
+{
+    // SOI marker followed by any other marker
+    return Length >= 3 && Buffer[0] == 0xFF && Buffer[1] == 0xD8 && Buffer[2] == 0xFF;
+}
+
+bool FJPEGImageDecoder::GetImageSize(const uint8* Buffer, int64 Length, int32& OutWidth, int32& OutHeight) const
+{
+    return FJPEGHelpers::GetImageSize(Buffer, Length, OutWidth, OutHeight);
+}
+
+bool FJPEGImageDecoder::Decode(const uint8* Buffer, int64 Length, const FImageDecodeParams& Params, FRuntimeImageData& OutImage, FString& OutError) const
+{
+    QUICK_SCOPE_CYCLE_COUNTER(STAT_FJPEGImageDecoder_Decode);
+
+    // downscaling is requested anyway, decode at the nearest DCT scale above the target and leave the rest to the resampler.
+    // Regions skip the rows and iMCU columns around them
+    const int32 ScaleDenom = FJPEGHelpers::GetScaleDenominator(Params.MinScale);
+    if (ScaleDenom > 1 || Params.HasRegion())
+    {
+        if (FJPEGHelpers::DecodeScaled(Buffer, Length, ScaleDenom, Params.Region, OutImage, OutError))
+        {
+            return true;
+        }
+
+        if (!OutError.IsEmpty())
+        {
+            return false;
+        }
+    }
+
+    IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+
+    // JPEG can only be 8-bit depth
+    TSharedPtr<IImageWrapper> JpegImageWrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::JPEG);
+    if (!JpegImageWrapper.IsValid() || !JpegImageWrapper->SetCompressed(Buffer, Length))
+    {
+        OutError = TEXT("Failed to decode JPEG image header");
+        return false;
+    }
+
+    if (!FRuntimeImageUtils::IsImportResolutionValid(JpegImageWrapper->GetWidth(), JpegImageWrapper->GetHeight(), true))
+    {
+        OutError = FString::Printf(TEXT("Texture resolution is not supported: %d x %d"), JpegImageWrapper->GetWidth(), JpegImageWrapper->GetHeight());
+        return false;
+    }
+
+    // Select the texture's source format
+    ETextureSourceFormat TextureFormat = TSF_Invalid;
+    int32 BitDepth = JpegImageWrapper->GetBitDepth();
+    ERGBFormat Format = JpegImageWrapper->GetFormat();
+
+    if (Format == ERGBFormat::Gray)
+    {
+        if (BitDepth <= 8)
+        {
+            TextureFormat = TSF_G8;
+            Format = ERGBFormat::Gray;
+            BitDepth = 8;
+        }
+    }
+    else if (Format == ERGBFormat::RGBA || Format == ERGBFormat::BGRA)
+    {
+        if (BitDepth <= 8)
+        {
+            TextureFormat = TSF_BGRA8;
+            Format = ERGBFormat::BGRA;
+            BitDepth = 8;
+        }
+    }
+
+    if (TextureFormat == TSF_Invalid)
+    {
+        OutError = FString::Printf(TEXT("JPEG file contains data in an unsupported format. Bit depth: %d"), BitDepth);
+        return false;
+    }
+
+    TArray64<uint8> RawJPEG;
+    if (JpegImageWrapper->GetRaw(Format, BitDepth, RawJPEG))
+    {
+        if (!OutImage.Init2D(
+            JpegImageWrapper->GetWidth(),
+            JpegImageWrapper->GetHeight(),
+            TextureFormat,
+            MoveTemp(RawJPEG),
+            OutError))
+        {
+            return false;
+        }
+        OutImage.SRGB = true;
+        OutImage.GammaSpace = OutImage.SRGB ? EGammaSpace::sRGB : EGammaSpace::Linear;
+        OutImage.AlphaUsage = ERuntimeImageAlphaUsage::Opaque;
+    }
+    else
+    {
+        OutError = TEXT("Failed to decode JPEG. Please contact devs");
+        return false;
+    }
+
+    return true;
+}
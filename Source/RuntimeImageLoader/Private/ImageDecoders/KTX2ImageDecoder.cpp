@@ -0,0 +1,247 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "KTX2ImageDecoder.h"
+#include "RuntimeImageUtils.h"
+
+namespace KTX2
+{
+    static const uint8 Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+    // header and the level index that follows it, each level is byteOffset, byteLength and uncompressedByteLength
+    constexpr int64 HeaderSize = 80;
+    constexpr int64 LevelIndexEntrySize = 24;
+
+    // VkFormat values of the block formats, the sRGB variants follow their UNORM formats
+    enum class EVkFormat : uint32
+    {
+        BC1_RGB_UNORM = 131, BC1_RGB_SRGB, BC1_RGBA_UNORM, BC1_RGBA_SRGB,
+        BC2_UNORM, BC2_SRGB, BC3_UNORM, BC3_SRGB,
+        BC4_UNORM, BC4_SNORM, BC5_UNORM, BC5_SNORM,
+        BC6H_UFLOAT, BC6H_SFLOAT, BC7_UNORM, BC7_SRGB,
+        ETC2_R8G8B8_UNORM, ETC2_R8G8B8_SRGB, ETC2_R8G8B8A1_UNORM, ETC2_R8G8B8A1_SRGB, ETC2_R8G8B8A8_UNORM, ETC2_R8G8B8A8_SRGB,
+        EAC_R11_UNORM, EAC_R11_SNORM, EAC_R11G11_UNORM, EAC_R11G11_SNORM,
+        ASTC_4x4_UNORM, ASTC_4x4_SRGB, ASTC_5x4_UNORM, ASTC_5x4_SRGB, ASTC_5x5_UNORM, ASTC_5x5_SRGB, ASTC_6x5_UNORM, ASTC_6x5_SRGB,
+        ASTC_6x6_UNORM, ASTC_6x6_SRGB, ASTC_8x5_UNORM, ASTC_8x5_SRGB, ASTC_8x6_UNORM, ASTC_8x6_SRGB, ASTC_8x8_UNORM, ASTC_8x8_SRGB,
+        ASTC_10x5_UNORM, ASTC_10x5_SRGB, ASTC_10x6_UNORM, ASTC_10x6_SRGB, ASTC_10x8_UNORM, ASTC_10x8_SRGB, ASTC_10x10_UNORM, ASTC_10x10_SRGB,
+        ASTC_12x10_UNORM, ASTC_12x10_SRGB, ASTC_12x12_UNORM, ASTC_12x12_SRGB
+    };
+
+    static uint32 ReadUInt32(const uint8* Buffer, int64 Offset)
+    {
+        return (uint32)Buffer[Offset] | ((uint32)Buffer[Offset + 1] << 8) | ((uint32)Buffer[Offset + 2] << 16) | ((uint32)Buffer[Offset + 3] << 24);
+    }
+
+    static uint64 ReadUInt64(const uint8* Buffer, int64 Offset)
+    {
+        return (uint64)ReadUInt32(Buffer, Offset) | ((uint64)ReadUInt32(Buffer, Offset + 4) << 32);
+    }
+
+    /** Signed formats have no Unreal pixel format, the blocks would be read as unsigned */
+    static bool IsSignedFormat(uint32 VkFormat)
+    {
+        switch ((EVkFormat)VkFormat)
+        {
+            case EVkFormat::BC4_SNORM:
+            case EVkFormat::BC5_SNORM:
+            case EVkFormat::BC6H_SFLOAT:
+            case EVkFormat::EAC_R11_SNORM:
+            case EVkFormat::EAC_R11G11_SNORM:
+                return true;
+
+            default:
+                return false;
+        }
+    }
+
+    /** Formats with an Unreal pixel format, the block sizes without one (e.g. ASTC 5x4) aren't supported */
+    static EPixelFormat GetPixelFormat(uint32 VkFormat, bool& OutSRGB)
+    {
+        switch ((EVkFormat)VkFormat)
+        {
+            case EVkFormat::BC1_RGB_SRGB:
+            case EVkFormat::BC1_RGBA_SRGB:
+            case EVkFormat::BC2_SRGB:
+            case EVkFormat::BC3_SRGB:
+            case EVkFormat::BC7_SRGB:
+            case EVkFormat::ETC2_R8G8B8_SRGB:
+            case EVkFormat::ETC2_R8G8B8A8_SRGB:
+            case EVkFormat::ASTC_4x4_SRGB:
+            case EVkFormat::ASTC_6x6_SRGB:
+            case EVkFormat::ASTC_8x8_SRGB:
+            case EVkFormat::ASTC_10x10_SRGB:
+            case EVkFormat::ASTC_12x12_SRGB:
+                OutSRGB = true;
+                break;
+
+            default:
+                OutSRGB = false;
+                break;
+        }
+
+        switch ((EVkFormat)VkFormat)
+        {
+            case EVkFormat::BC1_RGB_UNORM:
+            case EVkFormat::BC1_RGB_SRGB:
+            case EVkFormat::BC1_RGBA_UNORM:
+            case EVkFormat::BC1_RGBA_SRGB:      return PF_DXT1;
+            case EVkFormat::BC2_UNORM:
+            case EVkFormat::BC2_SRGB:           return PF_DXT3;
+            case EVkFormat::BC3_UNORM:
+            case EVkFormat::BC3_SRGB:           return PF_DXT5;
+            case EVkFormat::BC4_UNORM:          return PF_BC4;
+            case EVkFormat::BC5_UNORM:          return PF_BC5;
+            case EVkFormat::BC6H_UFLOAT:        return PF_BC6H;
+            case EVkFormat::BC7_UNORM:
+            case EVkFormat::BC7_SRGB:           return PF_BC7;
+            case EVkFormat::ETC2_R8G8B8_UNORM:
+            case EVkFormat::ETC2_R8G8B8_SRGB:   return PF_ETC2_RGB;
+            case EVkFormat::ETC2_R8G8B8A8_UNORM:
+            case EVkFormat::ETC2_R8G8B8A8_SRGB: return PF_ETC2_RGBA;
+            case EVkFormat::EAC_R11_UNORM:      return PF_ETC2_R11_EAC;
+            case EVkFormat::EAC_R11G11_UNORM:   return PF_ETC2_RG11_EAC;
+            case EVkFormat::ASTC_4x4_UNORM:
+            case EVkFormat::ASTC_4x4_SRGB:      return PF_ASTC_4x4;
+            case EVkFormat::ASTC_6x6_UNORM:
+            case EVkFormat::ASTC_6x6_SRGB:      return PF_ASTC_6x6;
+            case EVkFormat::ASTC_8x8_UNORM:
+            case EVkFormat::ASTC_8x8_SRGB:      return PF_ASTC_8x8;
+            case EVkFormat::ASTC_10x10_UNORM:
+            case EVkFormat::ASTC_10x10_SRGB:    return PF_ASTC_10x10;
+            case EVkFormat::ASTC_12x12_UNORM:
+            case EVkFormat::ASTC_12x12_SRGB:    return PF_ASTC_12x12;
+            default:                            return PF_Unknown;
+        }
+    }
+}
+
+void FKTX2ImageDecoder::GetLeadBytes(TArray<uint8>& OutLeadBytes) const
+{
+    OutLeadBytes.Add(KTX2::Identifier[0]);
+}
+
+bool FKTX2ImageDecoder::Sniff(const uint8* Buffer, int64 Length) const
+{
+    return Length >= sizeof(KTX2::Identifier) && FMemory::Memcmp(Buffer, KTX2::Identifier, sizeof(KTX2::Identifier)) == 0;
+}
+
+bool FKTX2ImageDecoder::GetImageSize(const uint8* Buffer, int64 Length, int32& OutWidth, int32& OutHeight) const
+{
+    if (!Sniff(Buffer, Length) || Length < KTX2::HeaderSize)
+    {
+        return false;
+    }
+
+    OutWidth = (int32)KTX2::ReadUInt32(Buffer, 20);
+    OutHeight = (int32)KTX2::ReadUInt32(Buffer, 24);
+    return OutWidth > 0 && OutHeight > 0;
+}
+
+bool FKTX2ImageDecoder::Decode(const uint8* Buffer, int64 Length, const FImageDecodeParams& Params, FRuntimeImageData& OutImage, FString& OutError) const
+{
+    QUICK_SCOPE_CYCLE_COUNTER(STAT_FKTX2ImageDecoder_Decode);
+
+    if (!Sniff(Buffer, Length) || Length < KTX2::HeaderSize)
+    {
+        OutError = TEXT("Failed to decode KTX2 image header");
+        return false;
+    }
+
+    const uint32 VkFormat = KTX2::ReadUInt32(Buffer, 12);
+    const int32 Width = (int32)KTX2::ReadUInt32(Buffer, 20);
+    const int32 Height = (int32)KTX2::ReadUInt32(Buffer, 24);
+    const uint32 Depth = KTX2::ReadUInt32(Buffer, 28);
+    const uint32 LayerCount = KTX2::ReadUInt32(Buffer, 32);
+    const uint32 FaceCount = KTX2::ReadUInt32(Buffer, 36);
+    const uint32 LevelCount = KTX2::ReadUInt32(Buffer, 40);
+    const uint32 SupercompressionScheme = KTX2::ReadUInt32(Buffer, 44);
+
+    if (SupercompressionScheme != 0)
+    {
+        OutError = FString::Printf(TEXT("Supercompressed KTX2 images are not supported, scheme: %u"), SupercompressionScheme);
+        return false;
+    }
+
+    if (Height == 0 || Depth > 0 || (FaceCount != 1 && FaceCount != 6))
+    {
+        OutError = TEXT("Only 2D and cubemap KTX2 images are supported");
+        return false;
+    }
+
+    // layer count 0 is a texture that is not an array
+    if (LayerCount > 1)
+    {
+        OutError = FString::Printf(TEXT("KTX2 texture arrays are not supported, layer count: %u"), LayerCount);
+        return false;
+    }
+
+    if (KTX2::IsSignedFormat(VkFormat))
+    {
+        OutError = FString::Printf(TEXT("Signed KTX2 format %u is not supported, only unsigned BC4, BC5, BC6H and EAC are"), VkFormat);
+        return false;
+    }
+
+    bool bSRGB = false;
+    const EPixelFormat PixelFormat = KTX2::GetPixelFormat(VkFormat, bSRGB);
+    if (PixelFormat == PF_Unknown)
+    {
+        OutError = FString::Printf(TEXT("KTX2 format %u is not supported"), VkFormat);
+        return false;
+    }
+
+    if (!FRuntimeImageUtils::IsImportResolutionValid(Width, Height, true) || Width <= 0 || (FaceCount == 6 && Width != Height))
+    {
+        OutError = FString::Printf(TEXT("Texture resolution is not supported: %d x %d"), Width, Height);
+        return false;
+    }
+
+    if (!FRuntimeImageUtils::IsWholeBlockSize(PixelFormat, Width, Height))
+    {
+        OutError = FString::Printf(TEXT("%d x %d is not a whole number of %s blocks"), Width, Height, GPixelFormats[PixelFormat].Name);
+        return false;
+    }
+
+    // level count 0 asks the loader to generate the mips, blocks can't be filtered so only the first level is used
+    const int32 MaxMips = FMath::FloorLog2(FMath::Max(Width, Height)) + 1;
+    const int32 NumMips = FMath::Clamp((int32)LevelCount, 1, MaxMips);
+    if (KTX2::HeaderSize + NumMips * KTX2::LevelIndexEntrySize > Length)
+    {
+        OutError = TEXT("Failed to decode KTX2 level index");
+        return false;
+    }
+
+    OutImage.SizeX = Width;
+    OutImage.SizeY = Height;
+    OutImage.NumSlices = (int32)FaceCount;
+    OutImage.NumMips = NumMips;
+    OutImage.PixelFormat = PixelFormat;
+    OutImage.SRGB = bSRGB;
+    OutImage.GammaSpace = bSRGB ? EGammaSpace::sRGB : EGammaSpace::Linear;
+    OutImage.CompressionSettings = (PixelFormat == PF_BC6H) ? TC_HDR : TC_Default;
+    OutImage.bPrecompressed = true;
+
+    const int64 FaceSize = OutImage.GetMipOffset(NumMips);
+    OutImage.RawData.SetNumUninitialized(FaceSize * FaceCount);
+
+    // KTX2 keeps the faces inside each level, RHIs take the faces one after another with all of their mips
+    for (int32 MipIndex = 0; MipIndex < NumMips; ++MipIndex)
+    {
+        const int64 IndexOffset = KTX2::HeaderSize + MipIndex * KTX2::LevelIndexEntrySize;
+        const uint64 LevelOffset = KTX2::ReadUInt64(Buffer, IndexOffset);
+        const uint64 LevelLength = KTX2::ReadUInt64(Buffer, IndexOffset + 8);
+        const int64 MipSize = OutImage.GetMipDataSize(MipIndex);
+
+        // offsets come from the file, they are compared without adding them up so they can't wrap around
+        if (LevelLength < (uint64)(MipSize * FaceCount) || LevelOffset > (uint64)Length || LevelLength > (uint64)Length - LevelOffset)
+        {
+            OutError = FString::Printf(TEXT("KTX2 level %d is truncated"), MipIndex);
+            return false;
+        }
+
+        for (uint32 Face = 0; Face < FaceCount; ++Face)
+        {
+            FMemory::Memcpy(OutImage.RawData.GetData() + Face * FaceSize + OutImage.GetMipOffset(MipIndex), Buffer + LevelOffset + Face * MipSize, MipSize);
+        }
+    }
+
+    return true;
+}
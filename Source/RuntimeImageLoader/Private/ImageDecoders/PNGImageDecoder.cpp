@@ -0,0 +1,135 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "PNGImageDecoder.h"
+#include "IImageWrapperModule.h"
+#include "IImageWrapper.h"
+#include "Modules/ModuleManager.h"
+#include "RuntimeImageUtils.h"
+#include "Helpers/PNGHelpers.h"
+
+void FPNGImageDecoder::GetLeadBytes(TArray<uint8>& OutLeadBytes) const
+{
+    OutLeadBytes.Add(0x89);
+}
+
+bool FPNGImageDecoder::Sniff(const uint8* Buffer, int64 Length) const
+{
+    static const uint8 Signature[8] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+    return Length >= sizeof(Signature) && FMemory::Memcmp(Buffer, Signature, sizeof(Signature)) == 0;
+}
+
+bool FPNGImageDecoder::GetImageSize(const uint8* Buffer, int64 Length, int32& OutWidth, int32& OutHeight) const
+{
+    // IHDR is always the first chunk
+    if (!Sniff(Buffer, Length) || Length < 24)
+    {
+        return false;
+    }
+
+    OutWidth = (Buffer[16] << 24) | (Buffer[17] << 16) | (Buffer[18] << 8) | Buffer[19];
+    OutHeight = (Buffer[20] << 24) | (Buffer[21] << 16) | (Buffer[22] << 8) | Buffer[23];
+    return OutWidth > 0 && OutHeight > 0;
+}
+
+bool FPNGImageDecoder::Decode(const uint8* Buffer, int64 Length, const FImageDecodeParams& Params, FRuntimeImageData& OutImage, FString& OutError) const
+{
+    QUICK_SCOPE_CYCLE_COUNTER(STAT_FPNGImageDecoder_Decode);
+
+    if (FPNGHelpers::DecodeFast(Buffer, Length, OutImage, OutError))
+    {
+        return true;
+    }
+
+    if (!OutError.IsEmpty())
+    {
+        return false;
+    }
+
+    // 16-bit, low bit depth, interlaced and color keyed images
+    IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+
+    // PNG support both 8 and 16 bit depth images (24 and 48 bits per pixel respectively or 32 and 64 bits when alpha channel is used) 
+    TSharedPtr<IImageWrapper> PngImageWrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::PNG);
+    if (!PngImageWrapper.IsValid() || !PngImageWrapper->SetCompressed(Buffer, Length))
+    {
+        OutError = TEXT("Failed to decode PNG image header");
+        return false;
+    }
+
+    if (!FRuntimeImageUtils::IsImportResolutionValid(PngImageWrapper->GetWidth(), PngImageWrapper->GetHeight(), true))
+    {
+        OutError = FString::Printf(TEXT("Texture resolution is not supported: %d x %d"), PngImageWrapper->GetWidth(), PngImageWrapper->GetHeight());
+        return false;
+    }
+
+    // Select the texture's source format
+    ETextureSourceFormat TextureFormat = TSF_Invalid;
+    int32 BitDepth = PngImageWrapper->GetBitDepth();
+    ERGBFormat Format = PngImageWrapper->GetFormat();
+
+    if (Format == ERGBFormat::Gray)
+    {
+        if (BitDepth <= 8)
+        {
+            TextureFormat = TSF_G8;
+            Format = ERGBFormat::Gray;
+            BitDepth = 8;
+        }
+        else if (BitDepth == 16)
+        {
+            TextureFormat = TSF_G16;
+            Format = ERGBFormat::Gray;
+            BitDepth = 16;
+        }
+    }
+    else if (Format == ERGBFormat::RGBA || Format == ERGBFormat::BGRA)
+    {
+        if (BitDepth <= 8)
+        {
+            TextureFormat = TSF_BGRA8;
+            Format = ERGBFormat::BGRA;
+            BitDepth = 8;
+        }
+        else if (BitDepth == 16)
+        {
+            TextureFormat = TSF_RGBA16;
+            Format = ERGBFormat::RGBA;
+            BitDepth = 16;
+        }
+    }
+
+    if (BitDepth > 16)
+    {
+        OutError = TEXT("Only 8 and 16 bit depth PNG images are currently supported.");
+        return false;
+    }
+
+    TArray64<uint8> RawPNG;
+    if (PngImageWrapper->GetRaw(Format, BitDepth, RawPNG))
+    {
+        if (!OutImage.Init2D(
+            PngImageWrapper->GetWidth(),
+            PngImageWrapper->GetHeight(),
+            TextureFormat,
+            MoveTemp(RawPNG),
+            OutError))
+        {
+            return false;
+        }
+        OutImage.SRGB = BitDepth < 16;
+        OutImage.GammaSpace = OutImage.SRGB ? EGammaSpace::sRGB : EGammaSpace::Linear; 
+
+        // there is nothing to fill in opaque images, the classification is kept for the loader
+        if (OutImage.ClassifyAlpha() != ERuntimeImageAlphaUsage::Opaque)
+        {
+            FPNGHelpers::FillZeroAlphaPNGData(OutImage.SizeX, OutImage.SizeY, OutImage.TextureSourceFormat, OutImage.RawData.GetData());
+        }
+    }
+    else
+    {
+        OutError = FString::Printf(TEXT("Failed to decode PNG. Bit depth: %d"), BitDepth);
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,58 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "QOIImageDecoder.h"
+#include "Helpers/QOIHelpers.h"
+
+void FQOIImageDecoder::GetLeadBytes(TArray<uint8>& OutLeadBytes) const
+{
+    OutLeadBytes.Add('q');
+}
+
+bool FQOIImageDecoder::Sniff(const uint8* Buffer, int64 Length) const
+{
+    return FQOILoader().IsValidImage(Buffer, Length);
+}
+
+bool FQOIImageDecoder::GetImageSize(const uint8* Buffer, int64 Length, int32& OutWidth, int32& OutHeight) const
+{
+    if (!Sniff(Buffer, Length))
+    {
+        return false;
+    }
+
+    OutWidth = (Buffer[4] << 24) | (Buffer[5] << 16) | (Buffer[6] << 8) | Buffer[7];
+    OutHeight = (Buffer[8] << 24) | (Buffer[9] << 16) | (Buffer[10] << 8) | Buffer[11];
+    return OutWidth > 0 && OutHeight > 0;
+}
+
+bool FQOIImageDecoder::Decode(const uint8* Buffer, int64 Length, const FImageDecodeParams& Params, FRuntimeImageData& OutImage, FString& OutError) const
+{
+    QUICK_SCOPE_CYCLE_COUNTER(STAT_FQOIImageDecoder_Decode);
+
+    FQOILoader QOILoader;
+    if (!QOILoader.Load(Buffer, Length, Params.Region))
+    {
+        OutError = QOILoader.GetLastError();
+        return false;
+    }
+
+    if (!OutImage.Init2D(
+        QOILoader.Region.Width(),
+        QOILoader.Region.Height(),
+        QOILoader.TextureSourceFormat,
+        MoveTemp(QOILoader.RawData),
+        OutError))
+    {
+        return false;
+    }
+    if (Params.HasRegion())
+    {
+        OutImage.DecodedRegion = QOILoader.Region;
+    }
+
+    OutImage.SRGB = QOILoader.bSRGB;
+    OutImage.GammaSpace = OutImage.SRGB ? EGammaSpace::sRGB : EGammaSpace::Linear;
+    OutImage.CompressionSettings = QOILoader.CompressionSettings;
+
+    return true;
+}
@@ -0,0 +1,73 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "TGAImageDecoder.h"
+#include "RuntimeImageUtils.h"
+#include "Helpers/TGAHelpers.h"
+
+void FTGAImageDecoder::GetLeadBytes(TArray<uint8>& OutLeadBytes) const
+{
+    // TGA has no signature, header is sniffed after all the other formats
+}
+
+bool FTGAImageDecoder::Sniff(const uint8* Buffer, int64 Length) const
+{
+    const FTGAHelpers::FTGAFileHeader* TGA = (const FTGAHelpers::FTGAFileHeader*)Buffer;
+    return Length >= sizeof(FTGAHelpers::FTGAFileHeader) &&
+        ((TGA->ColorMapType == 0 && TGA->ImageTypeCode == 2) ||
+        // ImageTypeCode 3 is greyscale
+        (TGA->ColorMapType == 0 && TGA->ImageTypeCode == 3) ||
+        (TGA->ColorMapType == 0 && TGA->ImageTypeCode == 10) ||
+        // Support for alpha stored as pseudo-color 8-bit TGA
+        (TGA->ColorMapType == 1 && TGA->ImageTypeCode == 1 && TGA->BitsPerPixel == 8));
+}
+
+bool FTGAImageDecoder::GetImageSize(const uint8* Buffer, int64 Length, int32& OutWidth, int32& OutHeight) const
+{
+    if (!Sniff(Buffer, Length))
+    {
+        return false;
+    }
+
+    const FTGAHelpers::FTGAFileHeader* TGA = (const FTGAHelpers::FTGAFileHeader*)Buffer;
+    OutWidth = TGA->Width;
+    OutHeight = TGA->Height;
+    return OutWidth > 0 && OutHeight > 0;
+}
+
+bool FTGAImageDecoder::Decode(const uint8* Buffer, int64 Length, const FImageDecodeParams& Params, FRuntimeImageData& OutImage, FString& OutError) const
+{
+    QUICK_SCOPE_CYCLE_COUNTER(STAT_FTGAImageDecoder_Decode);
+
+    const FTGAHelpers::FTGAFileHeader* TGA = (const FTGAHelpers::FTGAFileHeader*)Buffer;
+
+    // Check the resolution of the imported texture to ensure validity
+    if (!FRuntimeImageUtils::IsImportResolutionValid(TGA->Width, TGA->Height, true))
+    {
+        OutError = FString::Printf(TEXT("Texture resolution is not supported: %d x %d"), TGA->Width, TGA->Height);
+        return false;
+    }
+
+    const bool bResult = (Params.HasRegion() && FTGAHelpers::CanDecompressRegion(TGA))
+        ? FTGAHelpers::DecompressTGARegion(TGA, Length, Params.Region, OutImage, OutError)
+        : FTGAHelpers::DecompressTGA(TGA, OutImage, OutError);
+    if (bResult)
+    {
+        if (OutImage.CompressionSettings == TC_Grayscale && TGA->ImageTypeCode == 3)
+        {
+            // default grayscales to linear as they wont get compression otherwise and are commonly used as masks
+            OutImage.SRGB = false;
+        }
+
+        OutImage.GammaSpace = OutImage.SRGB ? EGammaSpace::sRGB : EGammaSpace::Linear;
+    }
+    else
+    {
+        if (OutError.IsEmpty())
+        {
+            OutError = TEXT("Failed to decompress TGA. Please contact devs");
+        }
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,71 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "TIFFImageDecoder.h"
+#include "Helpers/TIFFHelpers.h"
+#include "Helpers/TIFFLoader.h"
+
+void FTIFFImageDecoder::GetLeadBytes(TArray<uint8>& OutLeadBytes) const
+{
+    OutLeadBytes.Add('I');
+    OutLeadBytes.Add('M');
+}
+
+bool FTIFFImageDecoder::Sniff(const uint8* Buffer, int64 Length) const
+{
+    // little endian "II*\0" or big endian "MM\0*"
+    return Length >= 4 &&
+        ((Buffer[0] == 'I' && Buffer[1] == 'I' && Buffer[2] == 42 && Buffer[3] == 0) ||
+        (Buffer[0] == 'M' && Buffer[1] == 'M' && Buffer[2] == 0 && Buffer[3] == 42));
+}
+
+bool FTIFFImageDecoder::Decode(const uint8* Buffer, int64 Length, const FImageDecodeParams& Params, FRuntimeImageData& OutImage, FString& OutError) const
+{
+    QUICK_SCOPE_CYCLE_COUNTER(STAT_FTIFFImageDecoder_Decode);
+
+    // the common layouts are decoded here with their strips or tiles in parallel, FreeImage decodes the rest on this thread
+    if (FTIFFHelpers::DecodeParallel(Buffer, Length, OutImage, OutError))
+    {
+        OutImage.GammaSpace = OutImage.SRGB ? EGammaSpace::sRGB : EGammaSpace::Linear;
+        return true;
+    }
+
+    if (!OutError.IsEmpty())
+    {
+        return false;
+    }
+
+#if WITH_FREEIMAGE_LIB
+    // FreeImage is initialised once per process, bitmaps are per call so TIFFs can be decoded on several reader threads
+    FRuntimeTiffLoadHelper TiffLoaderHelper;
+    if (!TiffLoaderHelper.IsValid())
+    {
+        OutError = TiffLoaderHelper.GetError();
+        return false;
+    }
+
+    if (!TiffLoaderHelper.Load(Buffer, Length))
+    {
+        OutError = FString::Printf(TEXT("Failed to decode TIFF. Error: %s"), *TiffLoaderHelper.GetError());
+        return false;
+    }
+
+    if (!OutImage.Init2D(
+        TiffLoaderHelper.Width,
+        TiffLoaderHelper.Height,
+        TiffLoaderHelper.TextureSourceFormat,
+        MoveTemp(TiffLoaderHelper.RawData),
+        OutError))
+    {
+        return false;
+    }
+
+    OutImage.SRGB = TiffLoaderHelper.bSRGB;
+    OutImage.GammaSpace = OutImage.SRGB ? EGammaSpace::sRGB : EGammaSpace::Linear;
+    OutImage.CompressionSettings = TiffLoaderHelper.CompressionSettings;
+
+    return true;
+#else
+    OutError = TEXT("TIFF images are not supported on this platform");
+    return false;
+#endif // WITH_FREEIMAGE_LIB
+}
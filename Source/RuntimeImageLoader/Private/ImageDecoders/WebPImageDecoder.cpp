@@ -0,0 +1,151 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "WebPImageDecoder.h"
+#include "RuntimeImageUtils.h"
+
+#if WITH_LIBWEBP
+THIRD_PARTY_INCLUDES_START
+#include "webp/decode.h"
+THIRD_PARTY_INCLUDES_END
+#endif // WITH_LIBWEBP
+
+void FWebPImageDecoder::GetLeadBytes(TArray<uint8>& OutLeadBytes) const
+{
+    OutLeadBytes.Add('R');
+}
+
+bool FWebPImageDecoder::Sniff(const uint8* Buffer, int64 Length) const
+{
+    // "RIFF" <size> "WEBP"
+    return Length >= 12 && FMemory::Memcmp(Buffer, "RIFF", 4) == 0 && FMemory::Memcmp(Buffer + 8, "WEBP", 4) == 0;
+}
+
+bool FWebPImageDecoder::GetImageSize(const uint8* Buffer, int64 Length, int32& OutWidth, int32& OutHeight) const
+{
+#if WITH_LIBWEBP
+    int Width = 0;
+    int Height = 0;
+    if (!WebPGetInfo(Buffer, Length, &Width, &Height))
+    {
+        return false;
+    }
+
+    OutWidth = Width;
+    OutHeight = Height;
+    return true;
+#else
+    return false;
+#endif // WITH_LIBWEBP
+}
+
+bool FWebPImageDecoder::Decode(const uint8* Buffer, int64 Length, const FImageDecodeParams& Params, FRuntimeImageData& OutImage, FString& OutError) const
+{
+    QUICK_SCOPE_CYCLE_COUNTER(STAT_FWebPImageDecoder_Decode);
+
+#if WITH_LIBWEBP
+    WebPDecoderConfig Config;
+    if (!WebPInitDecoderConfig(&Config))
+    {
+        OutError = TEXT("Failed to initialize WebP decoder");
+        return false;
+    }
+
+    if (WebPGetFeatures(Buffer, Length, &Config.input) != VP8_STATUS_OK)
+    {
+        OutError = TEXT("Failed to decode WebP image header");
+        return false;
+    }
+
+    if (Config.input.has_animation)
+    {
+        OutError = TEXT("Animated WebP images are supported by RuntimeGifReader only");
+        return false;
+    }
+
+    int32 Width = Config.input.width;
+    int32 Height = Config.input.height;
+
+    // libwebp crops before scaling, the crop starts at even coordinates so it may cover a pixel more than the region
+    FIntRect DecodedRegion;
+    FIntPoint RegionSize(Width, Height);
+    if (Params.HasRegion())
+    {
+        const FIntRect Clipped = Params.GetClippedRegion(Width, Height);
+        if (Clipped.Area() == 0)
+        {
+            OutError = FString::Printf(TEXT("Region %s is outside of the image"), *Params.Region.ToString());
+            return false;
+        }
+
+        RegionSize = Clipped.Size();
+        DecodedRegion = FIntRect(Clipped.Min.X & ~1, Clipped.Min.Y & ~1, Clipped.Max.X, Clipped.Max.Y);
+        Width = DecodedRegion.Width();
+        Height = DecodedRegion.Height();
+
+        Config.options.use_cropping = 1;
+        Config.options.crop_left = DecodedRegion.Min.X;
+        Config.options.crop_top = DecodedRegion.Min.Y;
+        Config.options.crop_width = Width;
+        Config.options.crop_height = Height;
+    }
+
+    int32 OutputWidth = Width;
+    int32 OutputHeight = Height;
+
+    // libwebp resamples while decoding rows, full size image is never allocated. Only downscales are done here,
+    // the extra column or row of an odd crop is scaled along so the region itself comes out at the target size
+    const FIntPoint& TargetSize = Params.TargetSize;
+    if (TargetSize.X > 0 && TargetSize.Y > 0 && TargetSize.X <= RegionSize.X && TargetSize.Y <= RegionSize.Y && TargetSize != RegionSize)
+    {
+        OutputWidth = (int32)FMath::DivideAndRoundUp((int64)TargetSize.X * Width, (int64)RegionSize.X);
+        OutputHeight = (int32)FMath::DivideAndRoundUp((int64)TargetSize.Y * Height, (int64)RegionSize.Y);
+
+        Config.options.use_scaling = 1;
+        Config.options.scaled_width = OutputWidth;
+        Config.options.scaled_height = OutputHeight;
+    }
+
+    if (!FRuntimeImageUtils::IsImportResolutionValid(OutputWidth, OutputHeight, true))
+    {
+        OutError = FString::Printf(TEXT("Texture resolution is not supported: %d x %d"), OutputWidth, OutputHeight);
+        return false;
+    }
+
+    Config.options.use_threads = 1;
+
+    OutImage.Init2D(OutputWidth, OutputHeight, TSF_BGRA8);
+    if (Config.options.use_scaling)
+    {
+        OutImage.SourceSizeX = Width;
+        OutImage.SourceSizeY = Height;
+    }
+    OutImage.DecodedRegion = DecodedRegion;
+    OutImage.SRGB = true;
+    OutImage.GammaSpace = EGammaSpace::sRGB;
+    if (!Config.input.has_alpha)
+    {
+        OutImage.AlphaUsage = ERuntimeImageAlphaUsage::Opaque;
+    }
+
+    // decode straight into the image
+    Config.output.colorspace = MODE_BGRA;
+    Config.output.is_external_memory = 1;
+    Config.output.u.RGBA.rgba = OutImage.RawData.GetData();
+    Config.output.u.RGBA.stride = OutputWidth * 4;
+    Config.output.u.RGBA.size = OutImage.RawData.Num();
+
+    const VP8StatusCode Status = WebPDecode(Buffer, Length, &Config);
+    WebPFreeDecBuffer(&Config.output);
+
+    if (Status != VP8_STATUS_OK)
+    {
+        OutError = FString::Printf(TEXT("Failed to decode WebP image. Status: %d"), (int32)Status);
+        return false;
+    }
+
+    return true;
+#else
+    OutError = TEXT("WebP images are not supported on this platform");
+    return false;
+#endif // WITH_LIBWEBP
+}
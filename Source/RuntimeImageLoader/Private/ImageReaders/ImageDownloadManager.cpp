@@ -0,0 +1,950 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "ImageDownloadManager.h"
+#include "PlatformHttp.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/SecureHash.h"
+#include "Async/TaskGraphInterfaces.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogImageDownloadManager, Log, All);
+
+static TUniquePtr<FImageDownloadManager> GImageDownloadManager;
+static FCriticalSection GImageDownloadManagerMutex;
+
+// files of at least this size are split into ranged chunks
+static constexpr int64 ChunkedDownloadThreshold = 32 * 1024 * 1024;
+static constexpr int64 MinChunkSize = 16 * 1024 * 1024;
+static constexpr int32 MaxRetries = 2;
+// previewed files get a leading range of at least 1/8 of the file, the first scan of a progressive JPEG
+// or the first Adam7 passes of an interlaced PNG are usually within it
+static constexpr int64 MinPrefixSize = 64 * 1024;
+
+
+int64 FImageDownloadManager::ParseContentRangeTotal(const FString& ContentRange)
+{
+    // bytes <start>-<end>/<total>
+    int32 SlashIndex = INDEX_NONE;
+    if (ContentRange.FindLastChar(TEXT('/'), SlashIndex))
+    {
+        const FString Total = ContentRange.Mid(SlashIndex + 1).TrimStartAndEnd();
+        if (Total.IsNumeric())
+        {
+            return FCString::Atoi64(*Total);
+        }
+    }
+    return INDEX_NONE;
+}
+
+int64 FImageDownloadManager::ParseContentRangeStart(const FString& ContentRange)
+{
+    FString Range = ContentRange.TrimStartAndEnd();
+    if (!Range.RemoveFromStart(TEXT("bytes ")))
+    {
+        return INDEX_NONE;
+    }
+
+    int32 DashIndex = INDEX_NONE;
+    if (Range.FindChar(TEXT('-'), DashIndex))
+    {
+        const FString Start = Range.Left(DashIndex).TrimStartAndEnd();
+        if (Start.IsNumeric())
+        {
+            return FCString::Atoi64(*Start);
+        }
+    }
+    return INDEX_NONE;
+}
+
+
+FImageDownload::FImageDownload(const FString& InURL, bool bInLargeDownload)
+: URL(InURL),
+    Host(FPlatformHttp::GetUrlDomain(InURL)),
+    CompletionState(MakeShared<TFutureState<bool>, ESPMode::ThreadSafe>()),
+    PrefixState(MakeShared<TFutureState<bool>, ESPMode::ThreadSafe>()),
+    bLargeDownload(bInLargeDownload)
+{
+}
+
+TArray<uint8> FImageDownload::TakeContent()
+{
+    FScopeLock ContentLock(&ContentMutex);
+
+    return (--NumReaders <= 0) ? MoveTemp(Content) : Content;
+}
+
+
+FImageDownloadManager& FImageDownloadManager::Get()
+{
+    FScopeLock InstanceLock(&GImageDownloadManagerMutex);
+
+    if (!GImageDownloadManager.IsValid())
+    {
+        GImageDownloadManager = MakeUnique<FImageDownloadManager>();
+    }
+    return *GImageDownloadManager;
+}
+
+void FImageDownloadManager::Shutdown()
+{
+    FScopeLock InstanceLock(&GImageDownloadManagerMutex);
+
+    GImageDownloadManager.Reset();
+}
+
+FImageDownloadManager::~FImageDownloadManager()
+{
+    // requests must not call back into destroyed manager
+    bShuttingDown = true;
+
+    CancelAll();
+
+    // partial bodies of the cancelled downloads are still being written
+    for (;;)
+    {
+        FGraphEventRef Task;
+        {
+            FScopeLock DownloadsLock(&DownloadsMutex);
+
+            if (ResumeStateTasks.Num() == 0)
+            {
+                break;
+            }
+            Task = ResumeStateTasks.CreateConstIterator().Value().LastTask;
+        }
+        Task->Wait();
+    }
+}
+
+void FImageDownloadManager::Prefetch(const FString& URL, bool bLargeDownload, bool bWantsPrefix)
+{
+    {
+        FScopeLock DownloadsLock(&DownloadsMutex);
+
+        // the same image queued again is read from the same download
+        FImageDownloadPtr Download;
+        if (FImageDownloadRef* PrefetchedDownload = PrefetchedDownloads.Find(URL))
+        {
+            Download = *PrefetchedDownload;
+        }
+        else if (FImageDownloadRef* AcquiredDownload = AcquiredDownloads.Find(URL))
+        {
+            Download = *AcquiredDownload;
+            PrefetchedDownloads.Add(URL, Download.ToSharedRef());
+        }
+
+        if (Download.IsValid())
+        {
+            ++Download->NumPrefetches;
+
+            FScopeLock ContentLock(&Download->ContentMutex);
+            ++Download->NumReaders;
+            return;
+        }
+
+        // the reader downloads the image when it gets to it
+        if (PrefetchedDownloads.Num() >= MaxPrefetchedDownloads)
+        {
+            UE_LOG(LogImageDownloadManager, Verbose, TEXT("Not prefetching %s, %d downloads are waiting for a reader already"), *URL, PrefetchedDownloads.Num());
+            return;
+        }
+
+        FImageDownloadRef NewDownload = MakeShared<FImageDownload, ESPMode::ThreadSafe>(URL, bLargeDownload);
+        NewDownload->bWantsPrefix = bWantsPrefix;
+        NewDownload->NumPrefetches = 1;
+        NewDownload->NumReaders = 1;
+
+        PrefetchedDownloads.Add(URL, NewDownload);
+        PendingDownloads.Add(NewDownload);
+    }
+
+    StartPendingDownloads();
+}
+
+FImageDownloadRef FImageDownloadManager::Acquire(const FString& URL, bool bWantsPrefix)
+{
+    FImageDownloadPtr Download;
+    {
+        FScopeLock DownloadsLock(&DownloadsMutex);
+
+        if (FImageDownloadRef* PrefetchedDownload = PrefetchedDownloads.Find(URL))
+        {
+            // the reader was counted when the image was prefetched
+            Download = *PrefetchedDownload;
+            if (--Download->NumPrefetches <= 0)
+            {
+                PrefetchedDownloads.Remove(URL);
+            }
+        }
+        else
+        {
+            if (FImageDownloadRef* AcquiredDownload = AcquiredDownloads.Find(URL))
+            {
+                Download = *AcquiredDownload;
+            }
+            else
+            {
+                Download = MakeShared<FImageDownload, ESPMode::ThreadSafe>(URL, false);
+            }
+
+            FScopeLock ContentLock(&Download->ContentMutex);
+            ++Download->NumReaders;
+        }
+
+        Download->bAcquired = true;
+        if (!Download->IsComplete())
+        {
+            AcquiredDownloads.Add(URL, Download.ToSharedRef());
+        }
+
+        // reader is blocked on this one so it goes first
+        if (!Download->bStarted && !Download->IsComplete())
+        {
+            Download->bWantsPrefix |= bWantsPrefix;
+
+            PendingDownloads.Remove(Download.ToSharedRef());
+            PendingDownloads.Insert(Download.ToSharedRef(), 0);
+        }
+    }
+
+    StartPendingDownloads();
+
+    return Download.ToSharedRef();
+}
+
+void FImageDownloadManager::Cancel(const FImageDownloadRef& Download)
+{
+    {
+        FScopeLock ContentLock(&Download->ContentMutex);
+
+        // other readers of the URL still wait for the download
+        if (Download->NumReaders > 1)
+        {
+            --Download->NumReaders;
+            return;
+        }
+    }
+
+    CancelDownload(Download);
+}
+
+void FImageDownloadManager::CancelDownload(const FImageDownloadRef& Download)
+{
+    TArray<FImageDownloadRequestPtr> HttpRequests;
+    {
+        FScopeLock DownloadsLock(&DownloadsMutex);
+
+        Download->bCancelled = true;
+
+        HttpRequests.Add(Download->ProbeRequest);
+        for (const FImageDownloadChunk& Chunk : Download->Chunks)
+        {
+            HttpRequests.Add(Chunk.HttpRequest);
+        }
+
+        const FImageDownloadRef* PrefetchedDownload = PrefetchedDownloads.Find(Download->URL);
+        if (PrefetchedDownload && *PrefetchedDownload == Download)
+        {
+            PrefetchedDownloads.Remove(Download->URL);
+        }
+    }
+
+    for (const FImageDownloadRequestPtr& HttpRequest : HttpRequests)
+    {
+        if (HttpRequest.IsValid())
+        {
+            // otherwise completion handler persists the partial body for resuming later
+            if (bShuttingDown)
+            {
+                HttpRequest->OnProcessRequestComplete().Unbind();
+            }
+            HttpRequest->CancelRequest();
+        }
+    }
+
+    CompleteDownload(Download, false);
+}
+
+void FImageDownloadManager::CancelAll()
+{
+    TArray<FImageDownloadRef> DownloadsToCancel;
+    {
+        FScopeLock DownloadsLock(&DownloadsMutex);
+
+        DownloadsToCancel = ActiveDownloads;
+        DownloadsToCancel.Append(PendingDownloads);
+
+        PendingDownloads.Empty();
+        PrefetchedDownloads.Empty();
+    }
+
+    for (const FImageDownloadRef& Download : DownloadsToCancel)
+    {
+        CancelDownload(Download);
+    }
+}
+
+void FImageDownloadManager::SetConcurrencyLimits(int32 InMaxConcurrentDownloads, int32 InMaxConcurrentDownloadsPerHost)
+{
+    {
+        FScopeLock DownloadsLock(&DownloadsMutex);
+
+        MaxConcurrentDownloads = FMath::Max(1, InMaxConcurrentDownloads);
+        MaxConcurrentDownloadsPerHost = FMath::Clamp(InMaxConcurrentDownloadsPerHost, 1, MaxConcurrentDownloads);
+    }
+
+    StartPendingDownloads();
+}
+
+void FImageDownloadManager::SetPrefetchLimits(int32 InMaxPrefetchedDownloads, int64 InMaxPrefetchedBytes)
+{
+    {
+        FScopeLock DownloadsLock(&DownloadsMutex);
+
+        MaxPrefetchedDownloads = FMath::Max(0, InMaxPrefetchedDownloads);
+        MaxPrefetchedBytes = FMath::Max<int64>(0, InMaxPrefetchedBytes);
+    }
+
+    StartPendingDownloads();
+}
+
+void FImageDownloadManager::SetRequestFactory(FCreateImageDownloadRequestFunc InCreateRequest)
+{
+    FScopeLock DownloadsLock(&DownloadsMutex);
+
+    CreateRequestFunc = MoveTemp(InCreateRequest);
+}
+
+FImageDownloadRequestPtr FImageDownloadManager::CreateRequest() const
+{
+    return CreateRequestFunc ? CreateRequestFunc() : FImageDownloadTransport::CreateHttpRequest();
+}
+
+bool FImageDownloadManager::CanStartPrefetch(const FImageDownload& Download) const
+{
+    // a reader waits for the acquired ones
+    if (Download.bAcquired)
+    {
+        return true;
+    }
+
+    // bodies of the downloads in flight are not known yet, so the limit may be exceeded by them
+    int64 PrefetchedBytes = 0;
+    for (const TPair<FString, FImageDownloadRef>& PrefetchedDownload : PrefetchedDownloads)
+    {
+        if (!PrefetchedDownload.Value->bAcquired && PrefetchedDownload.Value->IsComplete())
+        {
+            PrefetchedBytes += PrefetchedDownload.Value->Content.Num();
+        }
+    }
+
+    return PrefetchedBytes < MaxPrefetchedBytes;
+}
+
+void FImageDownloadManager::StartPendingDownloads()
+{
+    TArray<FImageDownloadRef> DownloadsToStart;
+    {
+        FScopeLock DownloadsLock(&DownloadsMutex);
+
+        int32 Index = 0;
+        while (Index < PendingDownloads.Num() && ActiveDownloads.Num() < MaxConcurrentDownloads)
+        {
+            FImageDownloadRef Download = PendingDownloads[Index];
+
+            int32& NumHostDownloads = ActiveDownloadsPerHost.FindOrAdd(Download->Host);
+            if (NumHostDownloads >= MaxConcurrentDownloadsPerHost || !CanStartPrefetch(*Download))
+            {
+                ++Index;
+                continue;
+            }
+
+            ++NumHostDownloads;
+            Download->bStarted = true;
+
+            ActiveDownloads.Add(Download);
+            DownloadsToStart.Add(Download);
+            PendingDownloads.RemoveAt(Index);
+        }
+    }
+
+    for (const FImageDownloadRef& Download : DownloadsToStart)
+    {
+        StartDownload(Download);
+    }
+}
+
+void FImageDownloadManager::StartDownload(const FImageDownloadRef& Download)
+{
+    UE_LOG(LogImageDownloadManager, Verbose, TEXT("Starting download: %s"), *Download->URL);
+
+    // resume state is read on a background thread after the previous download of the URL has written it
+    EnqueueResumeStateTask(*Download, [this, Download]()
+    {
+        FString Validator;
+        int64 TotalSize = INDEX_NONE;
+        const bool bHasResumeState = LoadResumeState(*Download, Validator, TotalSize);
+
+        FScopeLock DownloadsLock(&DownloadsMutex);
+
+        // cancelled while the resume state was being read
+        if (Download->bCancelled || Download->IsComplete() || bShuttingDown)
+        {
+            return;
+        }
+
+        if (bHasResumeState)
+        {
+            Download->Validator = Validator;
+            Download->bAcceptRanges = true;
+
+            // size of the file decides on the chunks of large and previewed downloads only, others are resumed as a single body
+            if (Download->bLargeDownload || Download->bWantsPrefix)
+            {
+                Download->TotalSize = TotalSize;
+            }
+        }
+
+        // size of large and previewed files is probed first to find out if they can be downloaded in parallel chunks
+        if ((Download->bLargeDownload || Download->bWantsPrefix) && Download->TotalSize == INDEX_NONE)
+        {
+            FImageDownloadRequestPtr ProbeRequest = CreateRequest();
+            {
+                ProbeRequest->OnProcessRequestComplete().BindRaw(this, &FImageDownloadManager::HandleProbeComplete, Download);
+
+                ProbeRequest->SetURL(Download->URL);
+                ProbeRequest->SetVerb(TEXT("HEAD"));
+                ProbeRequest->SetTimeout(60.0f);
+            }
+
+            Download->ProbeRequest = ProbeRequest;
+            ProbeRequest->ProcessRequest();
+            return;
+        }
+
+        StartChunks(Download);
+    });
+}
+
+void FImageDownloadManager::StartChunks(const FImageDownloadRef& Download)
+{
+    FScopeLock DownloadsLock(&DownloadsMutex);
+
+    const bool bCanResume = Download->bAcceptRanges && !Download->Validator.IsEmpty();
+    const bool bSplitIntoChunks = Download->bAcceptRanges && Download->TotalSize >= ChunkedDownloadThreshold;
+
+    // short leading range of a previewed file arrives ahead of the rest, the preview is decoded from it while the rest is downloading
+    int64 PrefixSize = 0;
+    if (Download->bWantsPrefix && Download->bAcceptRanges && Download->TotalSize > 0)
+    {
+        PrefixSize = FMath::Max(Download->TotalSize / 8, MinPrefixSize);
+        if (PrefixSize * 2 > Download->TotalSize)
+        {
+            PrefixSize = 0;
+        }
+    }
+
+    const int64 SplitSize = Download->TotalSize - PrefixSize;
+    const int32 NumSplitChunks = bSplitIntoChunks ? FMath::Clamp(int32(SplitSize / MinChunkSize), 2, MaxConcurrentDownloadsPerHost) : 1;
+    const int32 NumPrefixChunks = PrefixSize > 0 ? 1 : 0;
+    const int32 NumChunks = NumPrefixChunks + NumSplitChunks;
+
+    Download->Chunks.Reset();
+    Download->Chunks.SetNum(NumChunks);
+
+    for (int32 ChunkIndex = 0; ChunkIndex < NumChunks; ++ChunkIndex)
+    {
+        FImageDownloadChunk& Chunk = Download->Chunks[ChunkIndex];
+        if (ChunkIndex < NumPrefixChunks)
+        {
+            Chunk.RangeStart = 0;
+            Chunk.RangeEnd = PrefixSize - 1;
+        }
+        else if (bSplitIntoChunks || PrefixSize > 0)
+        {
+            const int32 SplitIndex = ChunkIndex - NumPrefixChunks;
+            Chunk.RangeStart = PrefixSize + SplitSize * SplitIndex / NumSplitChunks;
+            Chunk.RangeEnd = PrefixSize + SplitSize * (SplitIndex + 1) / NumSplitChunks - 1;
+        }
+    }
+
+    if (!bCanResume)
+    {
+        StartLoadedChunks(Download);
+        return;
+    }
+
+    // pick up partial bodies of the previous attempt, they are read on a background thread and handed over under the lock
+    TArray<FString> PartialFilenames;
+    for (int32 ChunkIndex = 0; ChunkIndex < NumChunks; ++ChunkIndex)
+    {
+        PartialFilenames.Add(GetPartialFilename(*Download, ChunkIndex));
+    }
+
+    EnqueueResumeStateTask(*Download, [this, Download, PartialFilenames]()
+    {
+        TArray<TArray<uint8>> PartialBodies;
+        PartialBodies.SetNum(PartialFilenames.Num());
+        for (int32 ChunkIndex = 0; ChunkIndex < PartialFilenames.Num(); ++ChunkIndex)
+        {
+            FFileHelper::LoadFileToArray(PartialBodies[ChunkIndex], *PartialFilenames[ChunkIndex], FILEREAD_Silent);
+        }
+
+        FScopeLock DownloadsLock(&DownloadsMutex);
+
+        // cancelled while the resume state was being read
+        if (Download->bCancelled || Download->IsComplete() || bShuttingDown)
+        {
+            return;
+        }
+
+        for (int32 ChunkIndex = 0; ChunkIndex < Download->Chunks.Num(); ++ChunkIndex)
+        {
+            FImageDownloadChunk& Chunk = Download->Chunks[ChunkIndex];
+            Chunk.Content = MoveTemp(PartialBodies[ChunkIndex]);
+
+            if (Chunk.RangeEnd != INDEX_NONE && Chunk.Content.Num() > Chunk.RangeEnd - Chunk.RangeStart + 1)
+            {
+                Chunk.Content.Reset();
+            }
+            Chunk.NumPersistedBytes = Chunk.Content.Num();
+
+            Chunk.bCompleted = Chunk.RangeEnd != INDEX_NONE && Chunk.Content.Num() == Chunk.RangeEnd - Chunk.RangeStart + 1;
+
+            if (Chunk.Content.Num() > 0)
+            {
+                UE_LOG(LogImageDownloadManager, Log, TEXT("Resuming download of %s from %d bytes"), *Download->URL, Chunk.Content.Num());
+            }
+        }
+
+        StartLoadedChunks(Download);
+    });
+}
+
+void FImageDownloadManager::StartLoadedChunks(const FImageDownloadRef& Download)
+{
+    FScopeLock DownloadsLock(&DownloadsMutex);
+
+    // leading chunk may have been completed by the previous attempt
+    CompletePrefix(*Download);
+
+    bool bAllChunksCompleted = true;
+    for (int32 ChunkIndex = 0; ChunkIndex < Download->Chunks.Num(); ++ChunkIndex)
+    {
+        if (!Download->Chunks[ChunkIndex].bCompleted)
+        {
+            StartChunk(Download, ChunkIndex);
+            bAllChunksCompleted = false;
+        }
+    }
+
+    if (bAllChunksCompleted)
+    {
+        for (FImageDownloadChunk& Chunk : Download->Chunks)
+        {
+            Download->Content.Append(MoveTemp(Chunk.Content));
+        }
+
+        DeleteResumeState(*Download);
+        CompleteDownload(Download, true);
+    }
+}
+
+void FImageDownloadManager::StartChunk(const FImageDownloadRef& Download, int32 ChunkIndex)
+{
+    FScopeLock DownloadsLock(&DownloadsMutex);
+
+    FImageDownloadChunk& Chunk = Download->Chunks[ChunkIndex];
+
+    FImageDownloadRequestPtr HttpRequest = CreateRequest();
+    {
+        HttpRequest->OnProcessRequestComplete().BindRaw(this, &FImageDownloadManager::HandleChunkComplete, Download, ChunkIndex);
+
+        HttpRequest->SetURL(Download->URL);
+        HttpRequest->SetVerb(TEXT("GET"));
+        HttpRequest->SetTimeout(60.0f);
+
+        const int64 ResumeOffset = Chunk.RangeStart + Chunk.Content.Num();
+        if (ResumeOffset > 0 || Chunk.RangeEnd != INDEX_NONE)
+        {
+            const FString Range = (Chunk.RangeEnd != INDEX_NONE)
+                ? FString::Printf(TEXT("bytes=%lld-%lld"), ResumeOffset, Chunk.RangeEnd)
+                : FString::Printf(TEXT("bytes=%lld-"), ResumeOffset);
+
+            HttpRequest->SetHeader(TEXT("Range"), Range);
+        }
+
+        // server sends the whole file if it has changed since the partial body was stored
+        if (Chunk.Content.Num() > 0)
+        {
+            HttpRequest->SetHeader(TEXT("If-Range"), Download->Validator);
+        }
+    }
+
+    Chunk.HttpRequest = HttpRequest;
+    HttpRequest->ProcessRequest();
+}
+
+void FImageDownloadManager::CompleteDownload(const FImageDownloadRef& Download, bool bSuccess)
+{
+    {
+        FScopeLock DownloadsLock(&DownloadsMutex);
+
+        if (ActiveDownloads.Remove(Download) > 0)
+        {
+            int32* NumHostDownloads = ActiveDownloadsPerHost.Find(Download->Host);
+            if (NumHostDownloads && --(*NumHostDownloads) <= 0)
+            {
+                ActiveDownloadsPerHost.Remove(Download->Host);
+            }
+        }
+
+        PendingDownloads.Remove(Download);
+
+        const FImageDownloadRef* AcquiredDownload = AcquiredDownloads.Find(Download->URL);
+        if (AcquiredDownload && *AcquiredDownload == Download)
+        {
+            AcquiredDownloads.Remove(Download->URL);
+        }
+    }
+
+    // readers waiting for the prefix read the whole body instead
+    if (!Download->PrefixState->IsComplete())
+    {
+        Download->PrefixState->EmplaceResult(false);
+    }
+
+    if (!Download->CompletionState->IsComplete())
+    {
+        Download->CompletionState->EmplaceResult(bSuccess);
+    }
+
+    if (!bShuttingDown)
+    {
+        StartPendingDownloads();
+    }
+}
+
+void FImageDownloadManager::CompletePrefix(FImageDownload& Download)
+{
+    // the first chunk is a prefix of the file only if the file is split
+    if (!Download.bWantsPrefix || Download.PrefixState->IsComplete() || Download.Chunks.Num() < 2 || !Download.Chunks[0].bCompleted)
+    {
+        return;
+    }
+
+    Download.Prefix = Download.Chunks[0].Content;
+    Download.PrefixState->EmplaceResult(true);
+}
+
+void FImageDownloadManager::HandleProbeComplete(FImageDownloadResponsePtr HttpResponse, bool bSucceeded, FImageDownloadRef Download)
+{
+    FScopeLock DownloadsLock(&DownloadsMutex);
+
+    Download->ProbeRequest.Reset();
+    if (Download->IsComplete())
+    {
+        return;
+    }
+
+    if (bSucceeded && HttpResponse.IsValid() && HttpResponse->GetResponseCode() == 200)
+    {
+        const FString ETag = HttpResponse->GetHeader(TEXT("ETag"));
+        Download->Validator = ETag.IsEmpty() ? HttpResponse->GetHeader(TEXT("Last-Modified")) : ETag;
+        Download->bAcceptRanges = HttpResponse->GetHeader(TEXT("Accept-Ranges")).Contains(TEXT("bytes"));
+
+        const FString ContentLength = HttpResponse->GetHeader(TEXT("Content-Length"));
+        Download->TotalSize = ContentLength.IsNumeric() ? FCString::Atoi64(*ContentLength) : INDEX_NONE;
+    }
+
+    // falls back to a single request if the server didn't tell enough
+    StartChunks(Download);
+}
+
+void FImageDownloadManager::HandleChunkComplete(FImageDownloadResponsePtr HttpResponse, bool bSucceeded, FImageDownloadRef Download, int32 ChunkIndex)
+{
+    FScopeLock DownloadsLock(&DownloadsMutex);
+
+    // e.g. another chunk has received the whole file already
+    if (!Download->Chunks.IsValidIndex(ChunkIndex) || (Download->IsComplete() && !Download->bCancelled))
+    {
+        return;
+    }
+
+    FImageDownloadChunk& Chunk = Download->Chunks[ChunkIndex];
+    Chunk.HttpRequest.Reset();
+
+    const int32 ResponseCode = HttpResponse.IsValid() ? HttpResponse->GetResponseCode() : 0;
+
+    // body of a different range than the requested one can't be appended to the partial body
+    bool bRangeMatches = true;
+    if (HttpResponse.IsValid() && ResponseCode == 206)
+    {
+        const FString ContentRange = HttpResponse->GetHeader(TEXT("Content-Range"));
+        const int64 ExpectedStart = Chunk.RangeStart + Chunk.Content.Num();
+        if (ParseContentRangeStart(ContentRange) != ExpectedStart)
+        {
+            UE_LOG(LogImageDownloadManager, Warning, TEXT("Download of %s received range '%s' instead of the one starting at %lld, restarting the chunk"), *Download->URL, *ContentRange, ExpectedStart);
+            bRangeMatches = false;
+        }
+    }
+
+    if (HttpResponse.IsValid() && (ResponseCode == 200 || ResponseCode == 206))
+    {
+        const FString ETag = HttpResponse->GetHeader(TEXT("ETag"));
+        const FString Validator = ETag.IsEmpty() ? HttpResponse->GetHeader(TEXT("Last-Modified")) : ETag;
+        if (!Validator.IsEmpty())
+        {
+            Download->Validator = Validator;
+        }
+
+        Download->bAcceptRanges |= ResponseCode == 206 || HttpResponse->GetHeader(TEXT("Accept-Ranges")).Contains(TEXT("bytes"));
+
+        const int64 TotalSize = (ResponseCode == 206)
+            ? ParseContentRangeTotal(HttpResponse->GetHeader(TEXT("Content-Range")))
+            : FCString::Atoi64(*HttpResponse->GetHeader(TEXT("Content-Length")));
+        if (TotalSize > 0)
+        {
+            Download->TotalSize = TotalSize;
+        }
+    }
+
+    if (bSucceeded && ResponseCode == 200 && !Download->bCancelled)
+    {
+        // whole body, either no range was requested or the file has changed
+        Download->Content = HttpResponse->GetContent();
+
+        for (FImageDownloadChunk& OtherChunk : Download->Chunks)
+        {
+            if (OtherChunk.HttpRequest.IsValid())
+            {
+                OtherChunk.HttpRequest->OnProcessRequestComplete().Unbind();
+                OtherChunk.HttpRequest->CancelRequest();
+                OtherChunk.HttpRequest.Reset();
+            }
+        }
+
+        DeleteResumeState(*Download);
+        CompleteDownload(Download, true);
+        return;
+    }
+
+    if (bSucceeded && ResponseCode == 206 && bRangeMatches && !Download->bCancelled)
+    {
+        Chunk.Content.Append(HttpResponse->GetContent());
+        Chunk.bCompleted = true;
+
+        if (ChunkIndex == 0)
+        {
+            CompletePrefix(*Download);
+        }
+
+        for (const FImageDownloadChunk& OtherChunk : Download->Chunks)
+        {
+            if (!OtherChunk.bCompleted)
+            {
+                return;
+            }
+        }
+
+        for (FImageDownloadChunk& CompletedChunk : Download->Chunks)
+        {
+            Download->Content.Append(MoveTemp(CompletedChunk.Content));
+        }
+
+        DeleteResumeState(*Download);
+        CompleteDownload(Download, true);
+        return;
+    }
+
+    if (!bRangeMatches)
+    {
+        // neither the partial body nor the received one can be trusted, the chunk starts over from its range start
+        Chunk.Content.Reset();
+        DeletePartialBody(*Download, ChunkIndex);
+    }
+    // keep what has been received before the failure
+    else if (HttpResponse.IsValid() && HttpResponse->GetContent().Num() > 0)
+    {
+        if (ResponseCode == 206)
+        {
+            Chunk.Content.Append(HttpResponse->GetContent());
+        }
+        else if (ResponseCode == 200 && Download->Chunks.Num() == 1)
+        {
+            Chunk.Content = HttpResponse->GetContent();
+            Chunk.NumPersistedBytes = 0;
+        }
+    }
+
+    const bool bCanResume = Download->bAcceptRanges && !Download->Validator.IsEmpty() && ResponseCode != 416;
+    if (bCanResume && Chunk.Content.Num() > 0)
+    {
+        SaveResumeState(*Download, ChunkIndex, HttpResponse);
+    }
+    else
+    {
+        Chunk.Content.Reset();
+    }
+
+    if (Download->bCancelled || bShuttingDown)
+    {
+        return;
+    }
+
+    const bool bTransientError = ResponseCode == 0 || ResponseCode == 200 || ResponseCode == 206 || ResponseCode == 416 || ResponseCode >= 500;
+    if (bTransientError && Chunk.NumRetries < MaxRetries)
+    {
+        UE_LOG(LogImageDownloadManager, Log, TEXT("Retrying download of %s, received %d bytes so far"), *Download->URL, Chunk.Content.Num());
+
+        ++Chunk.NumRetries;
+        StartChunk(Download, ChunkIndex);
+        return;
+    }
+
+    if (HttpResponse.IsValid())
+    {
+        Download->Error = FString::Printf(TEXT("Error code: %d, Content: %s"), ResponseCode, *HttpResponse->GetContentAsString());
+    }
+    else
+    {
+        Download->Error = FString::Printf(TEXT("Failed to connect to %s"), *Download->Host);
+    }
+
+    // remaining chunks persist their partial bodies on cancellation
+    Download->bCancelled = true;
+    for (FImageDownloadChunk& OtherChunk : Download->Chunks)
+    {
+        if (OtherChunk.HttpRequest.IsValid())
+        {
+            OtherChunk.HttpRequest->CancelRequest();
+        }
+    }
+
+    CompleteDownload(Download, false);
+}
+
+FString FImageDownloadManager::GetPartialFilename(const FImageDownload& Download, int32 ChunkIndex) const
+{
+    // range start is a part of the name so that partial bodies of a different chunk layout are never mixed up
+    const FImageDownloadChunk& Chunk = Download.Chunks[ChunkIndex];
+    return FPaths::GetPath(GetResumeStateFilename(Download)) / FString::Printf(TEXT("%s_%lld.part"), *FMD5::HashAnsiString(*Download.URL), Chunk.RangeStart);
+}
+
+FString FImageDownloadManager::GetResumeStateFilename(const FImageDownload& Download) const
+{
+    return FPaths::ProjectSavedDir() / TEXT("RuntimeImageLoader") / TEXT("Downloads") / (FMD5::HashAnsiString(*Download.URL) + TEXT(".resume"));
+}
+
+bool FImageDownloadManager::LoadResumeState(const FImageDownload& Download, FString& OutValidator, int64& OutTotalSize) const
+{
+    // validator, total size in bytes
+    TArray<FString> Lines;
+    if (!FFileHelper::LoadFileToStringArray(Lines, *GetResumeStateFilename(Download)) || Lines.Num() < 2 || Lines[0].IsEmpty())
+    {
+        return false;
+    }
+
+    OutValidator = Lines[0];
+    OutTotalSize = Lines[1].IsNumeric() ? FCString::Atoi64(*Lines[1]) : INDEX_NONE;
+    return true;
+}
+
+void FImageDownloadManager::SaveResumeState(FImageDownload& Download, int32 ChunkIndex, FImageDownloadResponsePtr HttpResponse)
+{
+    FImageDownloadChunk& Chunk = Download.Chunks[ChunkIndex];
+
+    const FString ResumeState = FString::Printf(TEXT("%s\n%lld\n"), *Download.Validator, Download.TotalSize);
+    const FString ResumeStateFilename = GetResumeStateFilename(Download);
+    const FString PartialFilename = GetPartialFilename(Download, ChunkIndex);
+
+    // received body is written straight from the response, appended to the bytes the file has already.
+    // The partial body is copied only if the file can't be continued
+    const int64 NumReceived = HttpResponse.IsValid() ? HttpResponse->GetContent().Num() : 0;
+    const bool bAppend = HttpResponse.IsValid() && Chunk.NumPersistedBytes > 0 && Chunk.NumPersistedBytes + NumReceived == Chunk.Content.Num();
+    const bool bWholeResponse = Chunk.NumPersistedBytes == 0 && NumReceived == Chunk.Content.Num();
+
+    TArray<uint8> ContentCopy;
+    if (!bAppend && !bWholeResponse)
+    {
+        ContentCopy = Chunk.Content;
+    }
+    Chunk.NumPersistedBytes = Chunk.Content.Num();
+
+    EnqueueResumeStateTask(Download, [ResumeState, ResumeStateFilename, PartialFilename, HttpResponse, ContentCopy = MoveTemp(ContentCopy), bAppend, bWholeResponse]()
+    {
+        FFileHelper::SaveStringToFile(ResumeState, *ResumeStateFilename);
+
+        if (bAppend || bWholeResponse)
+        {
+            FFileHelper::SaveArrayToFile(HttpResponse->GetContent(), *PartialFilename, &IFileManager::Get(), bAppend ? FILEWRITE_Append : FILEWRITE_None);
+        }
+        else
+        {
+            FFileHelper::SaveArrayToFile(ContentCopy, *PartialFilename);
+        }
+    });
+}
+
+void FImageDownloadManager::DeletePartialBody(FImageDownload& Download, int32 ChunkIndex)
+{
+    Download.Chunks[ChunkIndex].NumPersistedBytes = 0;
+
+    const FString PartialFilename = GetPartialFilename(Download, ChunkIndex);
+    EnqueueResumeStateTask(Download, [PartialFilename]()
+    {
+        IFileManager::Get().Delete(*PartialFilename, false, false, true);
+    });
+}
+
+void FImageDownloadManager::DeleteResumeState(const FImageDownload& Download)
+{
+    const FString ResumeStateFilename = GetResumeStateFilename(Download);
+    const FString PartialFilenamePattern = FMD5::HashAnsiString(*Download.URL) + TEXT("_*.part");
+
+    EnqueueResumeStateTask(Download, [ResumeStateFilename, PartialFilenamePattern]()
+    {
+        const FString DownloadsDir = FPaths::GetPath(ResumeStateFilename);
+
+        TArray<FString> PartialFilenames;
+        IFileManager::Get().FindFiles(PartialFilenames, *(DownloadsDir / PartialFilenamePattern), true, false);
+
+        for (const FString& PartialFilename : PartialFilenames)
+        {
+            IFileManager::Get().Delete(*(DownloadsDir / PartialFilename), false, false, true);
+        }
+
+        IFileManager::Get().Delete(*ResumeStateFilename, false, false, true);
+    });
+}
+
+void FImageDownloadManager::EnqueueResumeStateTask(const FImageDownload& Download, TUniqueFunction<void()>&& Task)
+{
+    FScopeLock DownloadsLock(&DownloadsMutex);
+
+    // partial bodies of large images take long to read and write, so it's done on a background thread instead of
+    // the HTTP completion one. Tasks of a URL run one after another in the order they were queued
+    FResumeStateTasks& Tasks = ResumeStateTasks.FindOrAdd(Download.URL);
+
+    FGraphEventArray Prerequisites;
+    if (Tasks.LastTask.IsValid())
+    {
+        Prerequisites.Add(Tasks.LastTask);
+    }
+    ++Tasks.NumQueued;
+
+    Tasks.LastTask = FFunctionGraphTask::CreateAndDispatchWhenReady([this, URL = Download.URL, Task = MoveTemp(Task)]()
+    {
+        Task();
+
+        // the queue is dropped once it has drained, so it doesn't hold an entry for every URL ever downloaded
+        FScopeLock DownloadsLock(&DownloadsMutex);
+
+        FResumeStateTasks* Tasks = ResumeStateTasks.Find(URL);
+        if (Tasks && --Tasks->NumQueued <= 0)
+        {
+            ResumeStateTasks.Remove(URL);
+        }
+    }, TStatId(), &Prerequisites, ENamedThreads::AnyBackgroundThreadNormalTask);
+}
@@ -0,0 +1,181 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "ImageDownloadTransport.h"
+
+
+/** Byte range of a download that is fetched with its own request */
+struct FImageDownloadChunk
+{
+    int64 RangeStart = 0;
+    // inclusive, INDEX_NONE for the rest of the file
+    int64 RangeEnd = INDEX_NONE;
+
+    // resumed partial body followed by the received bytes
+    TArray<uint8> Content;
+    // leading bytes of Content that the partial body file holds
+    int64 NumPersistedBytes = 0;
+
+    FImageDownloadRequestPtr HttpRequest;
+    int32 NumRetries = 0;
+    bool bCompleted = false;
+};
+
+/** Single image download shared between the download manager and the readers that consume it */
+class FImageDownload
+{
+public:
+    FImageDownload(const FString& InURL, bool bInLargeDownload);
+
+    /** Body of the completed download. Readers of the same URL share the download, the last one takes the body and the others copy it */
+    TArray<uint8> TakeContent();
+
+    bool IsComplete() const { return CompletionState->IsComplete(); }
+    bool WaitForResult() const { return CompletionState->GetResult(); }
+
+    /** Prefix is ready once the leading range of a split download has arrived, or the download has completed without one */
+    bool IsPrefixReady() const { return PrefixState->IsComplete(); }
+    bool WaitForPrefix() const { return PrefixState->GetResult(); }
+
+public:
+    FString URL;
+    FString Host;
+
+    TArray<uint8> Content;
+    FString Error;
+
+    // leading bytes of the file, set before the prefix is ready
+    TArray<uint8> Prefix;
+
+private:
+    friend class FImageDownloadManager;
+
+    TSharedRef<TFutureState<bool>, ESPMode::ThreadSafe> CompletionState;
+    TSharedRef<TFutureState<bool>, ESPMode::ThreadSafe> PrefixState;
+    bool bStarted = false;
+    bool bCancelled = false;
+
+    // large downloads are probed with HEAD request first so they can be split into ranged chunks
+    bool bLargeDownload = false;
+    // previewed downloads are probed too and fetch a short leading range ahead of the rest
+    bool bWantsPrefix = false;
+    FImageDownloadRequestPtr ProbeRequest;
+
+    TArray<FImageDownloadChunk> Chunks;
+
+    // readers that have acquired the download or will acquire it as prefetched, guarded by ContentMutex
+    int32 NumReaders = 0;
+    FCriticalSection ContentMutex;
+    // prefetches of the URL that have not been acquired yet, guarded by the manager
+    int32 NumPrefetches = 0;
+    bool bAcquired = false;
+
+    // resume state, persisted next to the partial bodies
+    FString Validator;
+    int64 TotalSize = INDEX_NONE;
+    bool bAcceptRanges = false;
+};
+
+typedef TSharedRef<FImageDownload, ESPMode::ThreadSafe> FImageDownloadRef;
+typedef TSharedPtr<FImageDownload, ESPMode::ThreadSafe> FImageDownloadPtr;
+
+
+/**
+ * Keeps several HTTP downloads in flight, limited globally and per host.
+ * Images are prefetched as soon as load requests are queued, so the reader thread only waits for
+ * the body of the image it decodes next while the following ones keep downloading.
+ * Prefetches of a URL that is being downloaded join that download. Prefetching is limited by the number of
+ * downloads waiting for a reader and by the size of the bodies they hold.
+ *
+ * Partial bodies of failed or cancelled downloads are persisted to Saved/RuntimeImageLoader/Downloads
+ * and resumed with Range requests when the server supports them. Large files are split into ranged chunks
+ * that are downloaded in parallel.
+ */
+class FImageDownloadManager
+{
+public:
+    static FImageDownloadManager& Get();
+    static void Shutdown();
+
+    ~FImageDownloadManager();
+
+    /** Queues download of the image, completed body is kept till a reader acquires it. Ignored beyond the prefetch limits */
+    void Prefetch(const FString& URL, bool bLargeDownload = false, bool bWantsPrefix = false);
+
+    /** Returns prefetched or in-flight download of the URL, or starts a new one ahead of the prefetched ones */
+    FImageDownloadRef Acquire(const FString& URL, bool bWantsPrefix = false);
+
+    /** Cancels the download unless other readers still wait for it */
+    void Cancel(const FImageDownloadRef& Download);
+    void CancelAll();
+
+    void SetConcurrencyLimits(int32 InMaxConcurrentDownloads, int32 InMaxConcurrentDownloadsPerHost);
+    void SetPrefetchLimits(int32 InMaxPrefetchedDownloads, int64 InMaxPrefetchedBytes);
+
+    /** Replaces the HTTP module as the source of requests, e.g. with a local stand-in in tests. Unbound function restores the HTTP module */
+    void SetRequestFactory(FCreateImageDownloadRequestFunc InCreateRequest);
+
+    /** Fields of a "bytes <start>-<end>/<total>" Content-Range header, INDEX_NONE if the field is missing or not a number */
+    static int64 ParseContentRangeStart(const FString& ContentRange);
+    static int64 ParseContentRangeTotal(const FString& ContentRange);
+
+private:
+    FImageDownloadRequestPtr CreateRequest() const;
+    void CancelDownload(const FImageDownloadRef& Download);
+    bool CanStartPrefetch(const FImageDownload& Download) const;
+
+    void StartPendingDownloads();
+    void StartDownload(const FImageDownloadRef& Download);
+    void StartChunks(const FImageDownloadRef& Download);
+    void StartLoadedChunks(const FImageDownloadRef& Download);
+    void StartChunk(const FImageDownloadRef& Download, int32 ChunkIndex);
+    void CompleteDownload(const FImageDownloadRef& Download, bool bSuccess);
+    void CompletePrefix(FImageDownload& Download);
+
+    void HandleProbeComplete(FImageDownloadResponsePtr HttpResponse, bool bSucceeded, FImageDownloadRef Download);
+    void HandleChunkComplete(FImageDownloadResponsePtr HttpResponse, bool bSucceeded, FImageDownloadRef Download, int32 ChunkIndex);
+
+    /** Resume state */
+    FString GetPartialFilename(const FImageDownload& Download, int32 ChunkIndex) const;
+    FString GetResumeStateFilename(const FImageDownload& Download) const;
+    bool LoadResumeState(const FImageDownload& Download, FString& OutValidator, int64& OutTotalSize) const;
+    void SaveResumeState(FImageDownload& Download, int32 ChunkIndex, FImageDownloadResponsePtr HttpResponse);
+    void DeletePartialBody(FImageDownload& Download, int32 ChunkIndex);
+    void DeleteResumeState(const FImageDownload& Download);
+    void EnqueueResumeStateTask(const FImageDownload& Download, TUniqueFunction<void()>&& Task);
+
+private:
+    FCriticalSection DownloadsMutex;
+
+    // downloads that have not been acquired by a reader yet
+    TMap<FString, FImageDownloadRef> PrefetchedDownloads;
+    // acquired downloads that have not completed yet, later readers of the URL join them
+    TMap<FString, FImageDownloadRef> AcquiredDownloads;
+    // downloads that wait for a free slot, in start order
+    TArray<FImageDownloadRef> PendingDownloads;
+    TArray<FImageDownloadRef> ActiveDownloads;
+    TMap<FString, int32> ActiveDownloadsPerHost;
+
+    int32 MaxConcurrentDownloads = 8;
+    int32 MaxConcurrentDownloadsPerHost = 4;
+
+    // prefetched downloads that no reader has acquired yet, and the bodies they may hold before more of them are started
+    int32 MaxPrefetchedDownloads = 32;
+    int64 MaxPrefetchedBytes = 256 * 1024 * 1024;
+
+    FCreateImageDownloadRequestFunc CreateRequestFunc;
+
+    /** Reads and writes of the resume state of a URL, queued one after another */
+    struct FResumeStateTasks
+    {
+        FGraphEventRef LastTask;
+        int32 NumQueued = 0;
+    };
+    TMap<FString, FResumeStateTasks> ResumeStateTasks;
+
+    bool bShuttingDown = false;
+};
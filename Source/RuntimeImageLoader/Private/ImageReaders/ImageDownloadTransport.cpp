@@ -0,0 +1,76 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "ImageDownloadTransport.h"
+#include "Interfaces/IHttpRequest.h"
+#include "Interfaces/IHttpResponse.h"
+#include "HttpModule.h"
+
+namespace
+{
+    class FHttpImageDownloadResponse : public IImageDownloadResponse
+    {
+    public:
+        FHttpImageDownloadResponse(FHttpResponsePtr InHttpResponse)
+            : HttpResponse(InHttpResponse)
+        {}
+
+        virtual int32 GetResponseCode() const override { return HttpResponse->GetResponseCode(); }
+        virtual FString GetHeader(const FString& HeaderName) const override { return HttpResponse->GetHeader(HeaderName); }
+        virtual const TArray<uint8>& GetContent() const override { return HttpResponse->GetContent(); }
+        virtual FString GetContentAsString() const override { return HttpResponse->GetContentAsString(); }
+
+    private:
+        FHttpResponsePtr HttpResponse;
+    };
+
+    class FHttpImageDownloadRequest : public IImageDownloadRequest, public TSharedFromThis<FHttpImageDownloadRequest, ESPMode::ThreadSafe>
+    {
+    public:
+        FHttpImageDownloadRequest()
+            : HttpRequest(FHttpModule::Get().CreateRequest())
+        {}
+
+        virtual void SetURL(const FString& URL) override { HttpRequest->SetURL(URL); }
+        virtual void SetVerb(const FString& Verb) override { HttpRequest->SetVerb(Verb); }
+        virtual void SetHeader(const FString& HeaderName, const FString& HeaderValue) override { HttpRequest->SetHeader(HeaderName, HeaderValue); }
+        virtual void SetTimeout(float InTimeoutSecs) override { HttpRequest->SetTimeout(InTimeoutSecs); }
+
+        virtual bool ProcessRequest() override
+        {
+            // HTTP module keeps the request alive till it completes, the owner may have let go of this one by then
+            TWeakPtr<FHttpImageDownloadRequest, ESPMode::ThreadSafe> WeakThis = AsShared();
+            HttpRequest->OnProcessRequestComplete().BindLambda(
+                [WeakThis](FHttpRequestPtr, FHttpResponsePtr HttpResponse, bool bSucceeded)
+                {
+                    if (TSharedPtr<FHttpImageDownloadRequest, ESPMode::ThreadSafe> This = WeakThis.Pin())
+                    {
+                        FImageDownloadResponsePtr Response;
+                        if (HttpResponse.IsValid())
+                        {
+                            Response = MakeShared<FHttpImageDownloadResponse, ESPMode::ThreadSafe>(HttpResponse);
+                        }
+                        This->OnComplete.ExecuteIfBound(Response, bSucceeded);
+                    }
+                }
+            );
+
+            return HttpRequest->ProcessRequest();
+        }
+
+        virtual void CancelRequest() override { HttpRequest->CancelRequest(); }
+
+        virtual FOnImageDownloadRequestComplete& OnProcessRequestComplete() override { return OnComplete; }
+
+    private:
+        TSharedRef<IHttpRequest, ESPMode::ThreadSafe> HttpRequest;
+        FOnImageDownloadRequestComplete OnComplete;
+    };
+}
+
+namespace FImageDownloadTransport
+{
+    FImageDownloadRequestPtr CreateHttpRequest()
+    {
+        return MakeShared<FHttpImageDownloadRequest, ESPMode::ThreadSafe>();
+    }
+}
@@ -0,0 +1,52 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+/** Received response of a download request, complete or the part that arrived before a failure */
+class IImageDownloadResponse
+{
+public:
+    virtual ~IImageDownloadResponse() = default;
+
+    virtual int32 GetResponseCode() const = 0;
+    virtual FString GetHeader(const FString& HeaderName) const = 0;
+    virtual const TArray<uint8>& GetContent() const = 0;
+    virtual FString GetContentAsString() const = 0;
+};
+
+typedef TSharedPtr<IImageDownloadResponse, ESPMode::ThreadSafe> FImageDownloadResponsePtr;
+
+DECLARE_DELEGATE_TwoParams(FOnImageDownloadRequestComplete, FImageDownloadResponsePtr /*Response*/, bool /*bSucceeded*/);
+
+/**
+ * HTTP request of the download manager, the part of IHttpRequest it needs.
+ * Requests are created by FImageDownloadManager::SetRequestFactory, by the HTTP module unless it's replaced, e.g. by a local stand-in in tests.
+ */
+class IImageDownloadRequest
+{
+public:
+    virtual ~IImageDownloadRequest() = default;
+
+    virtual void SetURL(const FString& URL) = 0;
+    virtual void SetVerb(const FString& Verb) = 0;
+    virtual void SetHeader(const FString& HeaderName, const FString& HeaderValue) = 0;
+    virtual void SetTimeout(float InTimeoutSecs) = 0;
+
+    virtual bool ProcessRequest() = 0;
+    virtual void CancelRequest() = 0;
+
+    /** Executed once when the request has completed, failed or has been cancelled. Cancelled requests complete as failed */
+    virtual FOnImageDownloadRequestComplete& OnProcessRequestComplete() = 0;
+};
+
+typedef TSharedPtr<IImageDownloadRequest, ESPMode::ThreadSafe> FImageDownloadRequestPtr;
+typedef TFunction<FImageDownloadRequestPtr()> FCreateImageDownloadRequestFunc;
+
+namespace FImageDownloadTransport
+{
+    /** Request sent by the HTTP module */
+    FImageDownloadRequestPtr CreateHttpRequest();
+}
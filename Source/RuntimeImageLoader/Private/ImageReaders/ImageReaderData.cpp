@@ -0,0 +1,87 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "ImageReaderData.h"
+#include "Helpers/Base64Helpers.h"
+#include "Stats/Stats.h"
+
+TArray<uint8> FImageReaderData::ReadImage(const FString& ImageURI)
+{
+    QUICK_SCOPE_CYCLE_COUNTER(STAT_FImageReaderData_ReadImage);
+
+    int32 CommaIndex = INDEX_NONE;
+    if (!ImageURI.FindChar(TEXT(','), CommaIndex))
+    {
+        OutError = TEXT("Malformed data URI, no data");
+        return TArray<uint8>();
+    }
+
+    const FString MediaType = ImageURI.Mid(5, CommaIndex - 5);
+    if (!MediaType.EndsWith(TEXT(";base64"), ESearchCase::IgnoreCase))
+    {
+        OutError = FString::Printf(TEXT("Only base64 encoded data URIs are supported: data:%s"), *MediaType);
+        return TArray<uint8>();
+    }
+
+    const TCHAR* Payload = *ImageURI + CommaIndex + 1;
+    const int32 PayloadLength = ImageURI.Len() - CommaIndex - 1;
+
+    TArray<uint8> ImageData;
+    ImageData.SetNumUninitialized(FBase64Helpers::GetMaxDecodedSize(PayloadLength));
+
+    // payload is narrowed and stripped of whitespace in small chunks and decoded straight into the image buffer,
+    // chunk length is a multiple of 4 so that the chunks decode independently
+    constexpr int32 ChunkSize = 4096;
+    ANSICHAR Chunk[ChunkSize];
+    int32 ChunkLength = 0;
+    int64 DecodedSize = 0;
+
+    for (int32 Index = 0; Index <= PayloadLength; ++Index)
+    {
+        if (Index < PayloadLength)
+        {
+            const TCHAR Character = Payload[Index];
+            if (FChar::IsWhitespace(Character))
+            {
+                continue;
+            }
+
+            // anything outside of ASCII is rejected by the decoder
+            Chunk[ChunkLength++] = (Character < 128) ? (ANSICHAR)Character : '*';
+            if (ChunkLength < ChunkSize)
+            {
+                continue;
+            }
+        }
+
+        if (ChunkLength > 0)
+        {
+            const int64 ChunkDecodedSize = FBase64Helpers::Decode(Chunk, ChunkLength, ImageData.GetData() + DecodedSize);
+            if (ChunkDecodedSize == INDEX_NONE)
+            {
+                OutError = TEXT("Data URI is not valid base64");
+                return TArray<uint8>();
+            }
+
+            DecodedSize += ChunkDecodedSize;
+            ChunkLength = 0;
+        }
+    }
+
+    ImageData.SetNumUninitialized(DecodedSize);
+    return ImageData;
+}
+
+FString FImageReaderData::GetLastError() const
+{
+    return OutError;
+}
+
+void FImageReaderData::Flush()
+{
+    // decoding is synchronous
+}
+
+void FImageReaderData::Cancel()
+{
+    // decoding is synchronous
+}
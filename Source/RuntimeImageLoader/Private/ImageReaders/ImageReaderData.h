@@ -0,0 +1,21 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ImageReaders/IImageReader.h"
+
+/** Decodes images embedded into data:[<media type>];base64,<data> URIs */
+class FImageReaderData : public IImageReader
+{
+public:
+    virtual ~FImageReaderData() {}
+
+    virtual TArray<uint8> ReadImage(const FString& ImageURI) override;
+    virtual FString GetLastError() const override;
+    virtual void Flush() override;
+    virtual void Cancel() override;
+
+private:
+    FString OutError;
+};
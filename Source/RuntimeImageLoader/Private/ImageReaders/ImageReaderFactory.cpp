@@ -1,13 +1,165 @@
-#include "ImageReaderFactory.h"
+#include "ImageReaders/ImageReaderFactory.h"
 #include "ImageReaderLocal.h"
 #include "ImageReaderHttp.h"
+#include "ImageReaderData.h"
+#include "ImageDownloadManager.h"
+
+namespace
+{
+    FCriticalSection SchemesMutex;
+
+    TMap<FString, FImageReaderScheme>& GetSchemes()
+    {
+        static TMap<FString, FImageReaderScheme> Schemes = []()
+        {
+            TMap<FString, FImageReaderScheme> BuiltInSchemes;
+
+            FImageReaderScheme HttpScheme;
+            HttpScheme.CreateReader = []() { return MakeShared<FImageReaderHttp, ESPMode::ThreadSafe>(); };
+            // downloads are throttled by the download manager
+            HttpScheme.MaxConcurrentReads = 8;
+
+            BuiltInSchemes.Add(TEXT("http"), HttpScheme);
+            BuiltInSchemes.Add(TEXT("https"), HttpScheme);
+
+            FImageReaderScheme DataScheme;
+            DataScheme.CreateReader = []() { return MakeShared<FImageReaderData, ESPMode::ThreadSafe>(); };
+            // decoding is CPU bound
+            DataScheme.MaxConcurrentReads = FPlatformMisc::NumberOfCores();
+
+            BuiltInSchemes.Add(TEXT("data"), DataScheme);
+
+            return BuiltInSchemes;
+        }();
+
+        return Schemes;
+    }
+
+    // schemes registered from outside, http(s) ones replace the download manager
+    TSet<FString> CustomSchemes;
+}
 
 TSharedPtr<IImageReader, ESPMode::ThreadSafe> FImageReaderFactory::CreateReader(const FString& ImageURI)
 {
-    if (ImageURI.StartsWith("http://") || ImageURI.StartsWith("https://"))
+    const FString Scheme = GetScheme(ImageURI);
+    if (!Scheme.IsEmpty())
     {
-        return MakeShared<FImageReaderHttp, ESPMode::ThreadSafe>();
+        FCreateImageReaderFunc CreateReaderFunc;
+        {
+            FScopeLock SchemesLock(&SchemesMutex);
+
+            if (const FImageReaderScheme* ReaderScheme = GetSchemes().Find(Scheme))
+            {
+                CreateReaderFunc = ReaderScheme->CreateReader;
+            }
+        }
+
+        if (CreateReaderFunc)
+        {
+            TSharedPtr<IImageReader, ESPMode::ThreadSafe> Reader = CreateReaderFunc();
+            if (Reader.IsValid())
+            {
+                return Reader;
+            }
+        }
     }
 
     return MakeShared<FImageReaderLocal, ESPMode::ThreadSafe>();
 }
+
+void FImageReaderFactory::PrefetchImage(const FString& ImageURI, bool bExpectLargeImage /*= false*/, bool bWantsPreview /*= false*/)
+{
+    const FString Scheme = GetScheme(ImageURI);
+    if (Scheme != TEXT("http") && Scheme != TEXT("https"))
+    {
+        return;
+    }
+
+    // a custom reader may have been registered for the scheme
+    {
+        FScopeLock SchemesLock(&SchemesMutex);
+
+        if (CustomSchemes.Contains(Scheme) || !GetSchemes().Contains(Scheme))
+        {
+            return;
+        }
+    }
+
+    FImageDownloadManager::Get().Prefetch(ImageURI, bExpectLargeImage, bWantsPreview);
+}
+
+void FImageReaderFactory::RegisterScheme(const FString& Scheme, FCreateImageReaderFunc CreateReaderFunc, int32 MaxConcurrentReads /*= 1*/)
+{
+    check(!Scheme.IsEmpty() && CreateReaderFunc);
+
+    FImageReaderScheme ReaderScheme;
+    ReaderScheme.CreateReader = MoveTemp(CreateReaderFunc);
+    ReaderScheme.MaxConcurrentReads = FMath::Max(1, MaxConcurrentReads);
+
+    FScopeLock SchemesLock(&SchemesMutex);
+    GetSchemes().Add(Scheme.ToLower(), MoveTemp(ReaderScheme));
+    CustomSchemes.Add(Scheme.ToLower());
+}
+
+void FImageReaderFactory::UnregisterScheme(const FString& Scheme)
+{
+    FScopeLock SchemesLock(&SchemesMutex);
+    GetSchemes().Remove(Scheme.ToLower());
+    CustomSchemes.Remove(Scheme.ToLower());
+}
+
+int32 FImageReaderFactory::GetMaxConcurrentReads(const FString& ImageURI)
+{
+    const FString Scheme = GetScheme(ImageURI);
+    if (!Scheme.IsEmpty())
+    {
+        FScopeLock SchemesLock(&SchemesMutex);
+
+        if (const FImageReaderScheme* ReaderScheme = GetSchemes().Find(Scheme))
+        {
+            return ReaderScheme->MaxConcurrentReads;
+        }
+    }
+
+    return 1;
+}
+
+bool FImageReaderFactory::IsDataURI(const FString& ImageURI)
+{
+    return ImageURI.StartsWith(TEXT("data:"), ESearchCase::IgnoreCase);
+}
+
+FString FImageReaderFactory::SanitizeURI(const FString& ImageURI)
+{
+    if (!IsDataURI(ImageURI))
+    {
+        return ImageURI;
+    }
+
+    int32 CommaIndex = INDEX_NONE;
+    if (!ImageURI.FindChar(TEXT(','), CommaIndex))
+    {
+        return FString::Printf(TEXT("data: (%d characters)"), ImageURI.Len());
+    }
+
+    return FString::Printf(TEXT("%s,... (%d characters)"), *ImageURI.Left(FMath::Min(CommaIndex, 64)), ImageURI.Len() - CommaIndex - 1);
+}
+
+FString FImageReaderFactory::GetScheme(const FString& ImageURI)
+{
+    // data URIs have no authority part
+    if (IsDataURI(ImageURI))
+    {
+        return TEXT("data");
+    }
+
+    const int32 SchemeEnd = ImageURI.Find(TEXT("://"), ESearchCase::CaseSensitive);
+
+    // single letter is a drive on Windows
+    if (SchemeEnd <= 1)
+    {
+        return FString();
+    }
+
+    return ImageURI.Left(SchemeEnd).ToLower();
+}
@@ -2,46 +2,63 @@
 
 #include "ImageReaderHttp.h"
 #include "Runtime/Launch/Resources/Version.h"
-#include "Interfaces/IHttpRequest.h"
-#include "Interfaces/IHttpResponse.h"
 #include "HttpManager.h"
 #include "HttpModule.h"
 
 FImageReaderHttp::~FImageReaderHttp()
 {
-    DownloadFuture = nullptr;
+    Download = nullptr;
 }
 
 TArray<uint8> FImageReaderHttp::ReadImage(const FString& ImageURI)
 {
-    check (!DownloadFuture.IsValid());
-
-    DownloadFuture = MakeShared<TFutureState<bool>, ESPMode::ThreadSafe>();
-
-    // Create the Http request and add to pending request list
-    CurrentHttpRequest = FHttpModule::Get().CreateRequest();
+    // joins the download if it has been prefetched already, or the one the prefix was read from
+    if (!Download.IsValid())
     {
-        CurrentHttpRequest->OnProcessRequestComplete().BindRaw(this, &FImageReaderHttp::HandleImageRequest);
-
-        CurrentHttpRequest->SetURL(ImageURI);
-        CurrentHttpRequest->SetVerb(TEXT("GET"));
-        CurrentHttpRequest->SetTimeout(60.0f);
-        CurrentHttpRequest->ProcessRequest();
+        Download = FImageDownloadManager::Get().Acquire(ImageURI);
     }
 
     if (IsInGameThread())
     {
-        Flush();
+        while (!Download->IsComplete())
+        {
+            Flush();
+        }
     }
 
-    bool bResult = DownloadFuture->GetResult();
+    bool bResult = Download->WaitForResult();
     if (bResult)
     {
-        return OutImageData;
+        return Download->TakeContent();
     }
+
+    OutError = Download->Error;
     return TArray<uint8>();
 }
 
+bool FImageReaderHttp::ReadImagePrefix(const FString& ImageURI, TArray<uint8>& OutPrefix)
+{
+    check (!Download.IsValid());
+
+    Download = FImageDownloadManager::Get().Acquire(ImageURI, true);
+
+    if (IsInGameThread())
+    {
+        while (!Download->IsPrefixReady())
+        {
+            Flush();
+        }
+    }
+
+    if (!Download->WaitForPrefix())
+    {
+        return false;
+    }
+
+    OutPrefix = Download->Prefix;
+    return true;
+}
+
 FString FImageReaderHttp::GetLastError() const
 {
     return OutError;
@@ -58,29 +75,8 @@ void FImageReaderHttp::Flush()
 
 void FImageReaderHttp::Cancel()
 {
-    if (CurrentHttpRequest.IsValid() && DownloadFuture.IsValid() && !DownloadFuture->IsComplete())
+    if (Download.IsValid() && !Download->IsComplete())
     {
-        CurrentHttpRequest->OnProcessRequestComplete().Unbind();
-        CurrentHttpRequest->CancelRequest();
-        DownloadFuture->EmplaceResult(false);
+        FImageDownloadManager::Get().Cancel(Download.ToSharedRef());
     }
 }
-
-void FImageReaderHttp::HandleImageRequest(FHttpRequestPtr HttpRequest, FHttpResponsePtr HttpResponse, bool bSucceeded)
-{
-    bool bSuccess = HttpResponse->GetResponseCode() == 200;
-    
-    if (bSuccess)
-    {
-        OutImageData.Append(HttpResponse->GetContent().GetData(), HttpResponse->GetContentLength());
-    }
-    else
-    {
-        OutError = FString::Printf(TEXT("Error code: %d, Content: %d"), HttpResponse->GetResponseCode(), *HttpResponse->GetContentAsString());
-    }
-
-    if (DownloadFuture && !DownloadFuture->IsComplete())
-    {
-        DownloadFuture->EmplaceResult(bSuccess);
-    }
-}
\ No newline at end of file
@@ -3,9 +3,8 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "Interfaces/IHttpRequest.h"
-#include "Async/Future.h"
 #include "ImageReaders/IImageReader.h"
+#include "ImageDownloadManager.h"
 
 class FImageReaderHttp : public IImageReader
 {
@@ -13,19 +12,13 @@ public:
     virtual ~FImageReaderHttp();
 
     virtual TArray<uint8> ReadImage(const FString& ImageURI) override;
+    virtual bool ReadImagePrefix(const FString& ImageURI, TArray<uint8>& OutPrefix) override;
     virtual FString GetLastError() const override;
     virtual void Flush() override;
     virtual void Cancel() override;
 
 private:
-    /** Handles image requests coming from the web */
-    void HandleImageRequest(FHttpRequestPtr HttpRequest, FHttpResponsePtr HttpResponse, bool bSucceeded);
+    FImageDownloadPtr Download;
 
-private:
-    TSharedPtr<TFutureState<bool>, ESPMode::ThreadSafe> DownloadFuture;
-
-    TSharedPtr<IHttpRequest, ESPMode::ThreadSafe> CurrentHttpRequest;
-
-    TArray<uint8> OutImageData;
     FString OutError;
-};
\ No newline at end of file
+};
@@ -1,6 +1,8 @@
 // Copyright 2023 Petr Leontev. All Rights Reserved.
 
 #include "RuntimeImageData.h"
+#include "RenderUtils.h"
+#include "Helpers/PixelPackingHelpers.h"
 
 // Duplicate the code in "int32 FTextureSource::GetBytesPerPixel(ETextureSourceFormat Format)"
 // Because that was Editor only code
@@ -46,13 +48,117 @@ void FRuntimeImageData::Init2D(int32 InSizeX, int32 InSizeY, ETextureSourceForma
     NumMips = 1;
     TextureSourceFormat = InFormat;
     Format = ToRawImageFormat(InFormat);
+    AlphaUsage = ERuntimeImageAlphaUsage::Unknown;
 
-    const int32 RawDataSize = SizeX * SizeY * GetBytesPerPixel();
+    const int64 RawDataSize = (int64)SizeX * SizeY * GetBytesPerPixel();
 
-    RawData.AddUninitialized(RawDataSize);
+    RawData.SetNumUninitialized(RawDataSize);
 
     if (InData)
     {
         FMemory::Memcpy(RawData.GetData(), InData, RawData.Num());
     }
 }
+
+bool FRuntimeImageData::Init2D(int32 InSizeX, int32 InSizeY, ETextureSourceFormat InFormat, TArray64<uint8>&& InRawData, FString& OutError)
+{
+    const int64 ExpectedSize = (int64)InSizeX * InSizeY * ::GetBytesPerPixel(InFormat);
+    if (InSizeX <= 0 || InSizeY <= 0 || ExpectedSize == 0 || InRawData.Num() != ExpectedSize)
+    {
+        OutError = FString::Printf(TEXT("Decoded image data size %lld doesn't match %d x %d image, expected %lld bytes"), InRawData.Num(), InSizeX, InSizeY, ExpectedSize);
+        return false;
+    }
+
+    SizeX = InSizeX;
+    SizeY = InSizeY;
+    NumSlices = 1;
+    NumMips = 1;
+    TextureSourceFormat = InFormat;
+    Format = ToRawImageFormat(InFormat);
+    AlphaUsage = ERuntimeImageAlphaUsage::Unknown;
+
+    RawData = MoveTemp(InRawData);
+
+    return true;
+}
+
+int32 FRuntimeImageData::GetMipSizeX(int32 MipIndex) const
+{
+    return FMath::Max(1, SizeX >> MipIndex);
+}
+
+int32 FRuntimeImageData::GetMipSizeY(int32 MipIndex) const
+{
+    return FMath::Max(1, SizeY >> MipIndex);
+}
+
+int64 FRuntimeImageData::GetMipOffset(int32 MipIndex) const
+{
+    int64 Offset = 0;
+    for (int32 Index = 0; Index < MipIndex; ++Index)
+    {
+        Offset += GetMipDataSize(Index);
+    }
+    return Offset;
+}
+
+int64 FRuntimeImageData::GetMipDataSize(int32 MipIndex) const
+{
+    const FPixelFormatInfo& FormatInfo = GPixelFormats[PixelFormat];
+    const int64 NumBlocksX = FMath::DivideAndRoundUp(GetMipSizeX(MipIndex), FormatInfo.BlockSizeX);
+    const int64 NumBlocksY = FMath::DivideAndRoundUp(GetMipSizeY(MipIndex), FormatInfo.BlockSizeY);
+    return NumBlocksX * NumBlocksY * FormatInfo.BlockBytes;
+}
+
+ERuntimeImageAlphaUsage FRuntimeImageData::ClassifyAlpha()
+{
+    if (AlphaUsage != ERuntimeImageAlphaUsage::Unknown || bPrecompressed)
+    {
+        return AlphaUsage;
+    }
+
+    QUICK_SCOPE_CYCLE_COUNTER(STAT_FRuntimeImageData_ClassifyAlpha);
+
+    const int64 NumPixels = (int64)SizeX * SizeY;
+    switch (Format)
+    {
+        case ERawImageFormat::G8:
+        case ERawImageFormat::G16:
+        case ERawImageFormat::BGRE8:
+        case ERawImageFormat::R16F:
+#if ENGINE_MAJOR_VERSION >= 5
+        case ERawImageFormat::R32F:
+#endif
+            AlphaUsage = ERuntimeImageAlphaUsage::Opaque;
+            break;
+
+        case ERawImageFormat::BGRA8:
+            AlphaUsage = FPixelPackingHelpers::ClassifyAlpha(RawData.GetData(), NumPixels);
+            break;
+
+        case ERawImageFormat::RGBA16:
+            AlphaUsage = FPixelPackingHelpers::ClassifyAlpha16(reinterpret_cast<const uint16*>(RawData.GetData()), NumPixels);
+            break;
+
+        case ERawImageFormat::RGBA16F:
+            AlphaUsage = FPixelPackingHelpers::ClassifyAlpha16F(reinterpret_cast<const uint16*>(RawData.GetData()), NumPixels);
+            break;
+
+        case ERawImageFormat::RGBA32F:
+            AlphaUsage = FPixelPackingHelpers::ClassifyAlpha32F(reinterpret_cast<const float*>(RawData.GetData()), NumPixels);
+            break;
+
+        default:
+            break;
+    }
+
+    return AlphaUsage;
+}
+
+void FRuntimeImageData::InvalidateAlphaUsage()
+{
+    if (AlphaUsage != ERuntimeImageAlphaUsage::Opaque)
+    {
+        AlphaUsage = ERuntimeImageAlphaUsage::Unknown;
+    }
+}
@@ -10,6 +10,8 @@
 #include "Interfaces/IPluginManager.h"
 #include "RuntimeImageUtils.h"
 #include "InputImageDescription.h"
+#include "ImageReaders/ImageReaderFactory.h"
+#include "ImageReaders/ImageDownloadManager.h"
 
 DEFINE_LOG_CATEGORY_STATIC(LogRuntimeImageLoader, Log, All);
 
@@ -29,7 +31,7 @@ bool URuntimeImageLoader::DoesSupportWorldType(EWorldType::Type WorldType) const
     return WorldType == EWorldType::PIE || WorldType == EWorldType::Game;
 }
 
-void URuntimeImageLoader::LoadImageAsync(const FString& ImageFilename, const FTransformImageParams& TransformParams, UTexture2D*& OutTexture, bool& bSuccess, FString& OutError, FLatentActionInfo LatentInfo, UObject* WorldContextObject /*= nullptr*/)
+void URuntimeImageLoader::LoadImageAsync(const FString& ImageFilename, const FTransformImageParams& TransformParams, UTexture2D*& OutTexture, ERuntimeImageAlphaUsage& OutAlphaUsage, FRuntimeTextureStats& OutTextureStats, bool& bSuccess, FString& OutError, FLatentActionInfo LatentInfo, UObject* WorldContextObject /*= nullptr*/)
 {
     if (!IsValid(WorldContextObject))
     {
@@ -42,7 +44,7 @@ void URuntimeImageLoader::LoadImageAsync(const FString& ImageFilename, const FTr
         Request.Params.TransformParams = TransformParams;
 
         Request.OnRequestCompleted.BindLambda(
-            [this, &OutTexture, &bSuccess, &OutError, LatentInfo](const FImageReadResult& ReadResult)
+            [this, &OutTexture, &OutAlphaUsage, &OutTextureStats, &bSuccess, &OutError, LatentInfo](const FImageReadResult& ReadResult)
             {
                 FWeakObjectPtr CallbackTargetPtr = LatentInfo.CallbackTarget;
                 if (UObject* CallbackTarget = CallbackTargetPtr.Get())
@@ -67,6 +69,8 @@ void URuntimeImageLoader::LoadImageAsync(const FString& ImageFilename, const FTr
 
                         bSuccess = ReadResult.OutError.IsEmpty();
                         OutTexture = ReadResult.OutTexture;
+                        OutAlphaUsage = ReadResult.AlphaUsage;
+                        OutTextureStats = ReadResult.TextureStats;
                         OutError = ReadResult.OutError;
 
                         if (Linkage != -1)
@@ -80,9 +84,10 @@ void URuntimeImageLoader::LoadImageAsync(const FString& ImageFilename, const FTr
     }
 
     Requests.Enqueue(Request);
+    FImageReaderFactory::PrefetchImage(Request.Params.InputImage.ImageFilename, false, Request.Params.TransformParams.WantsPreview());
 }
 
-void URuntimeImageLoader::LoadImageFromBytesAsync(UPARAM(ref) TArray<uint8>& ImageBytes, const FTransformImageParams& TransformParams, UTexture2D*& OutTexture, bool& bSuccess, FString& OutError, FLatentActionInfo LatentInfo, UObject* WorldContextObject /*= nullptr*/)
+void URuntimeImageLoader::LoadImageFromBytesAsync(UPARAM(ref) TArray<uint8>& ImageBytes, const FTransformImageParams& TransformParams, UTexture2D*& OutTexture, ERuntimeImageAlphaUsage& OutAlphaUsage, FRuntimeTextureStats& OutTextureStats, bool& bSuccess, FString& OutError, FLatentActionInfo LatentInfo, UObject* WorldContextObject /*= nullptr*/)
 {
     if (!IsValid(WorldContextObject))
     {
@@ -95,7 +100,7 @@ void URuntimeImageLoader::LoadImageFromBytesAsync(UPARAM(ref) TArray<uint8>& Ima
         Request.Params.TransformParams = TransformParams;
 
         Request.OnRequestCompleted.BindLambda(
-            [this, &OutTexture, &bSuccess, &OutError, LatentInfo](const FImageReadResult& ReadResult)
+            [this, &OutTexture, &OutAlphaUsage, &OutTextureStats, &bSuccess, &OutError, LatentInfo](const FImageReadResult& ReadResult)
             {
                 FWeakObjectPtr CallbackTargetPtr = LatentInfo.CallbackTarget;
                 if (UObject* CallbackTarget = CallbackTargetPtr.Get())
@@ -120,6 +125,8 @@ void URuntimeImageLoader::LoadImageFromBytesAsync(UPARAM(ref) TArray<uint8>& Ima
 
                         bSuccess = ReadResult.OutError.IsEmpty();
                         OutTexture = ReadResult.OutTexture;
+                        OutAlphaUsage = ReadResult.AlphaUsage;
+                        OutTextureStats = ReadResult.TextureStats;
                         OutError = ReadResult.OutError;
 
                         if (Linkage != -1)
@@ -195,14 +202,17 @@ void URuntimeImageLoader::LoadHDRIAsCubemapAsync(const FString& ImageFilename, c
     }
 
     Requests.Enqueue(Request);
+    FImageReaderFactory::PrefetchImage(Request.Params.InputImage.ImageFilename, true);
 }
 
-void URuntimeImageLoader::LoadImageSync(const FString& ImageFilename, const FTransformImageParams& TransformParams, UTexture2D*& OutTexture, bool& bSuccess, FString& OutError)
+void URuntimeImageLoader::LoadImageSync(const FString& ImageFilename, const FTransformImageParams& TransformParams, UTexture2D*& OutTexture, ERuntimeImageAlphaUsage& OutAlphaUsage, FRuntimeTextureStats& OutTextureStats, bool& bSuccess, FString& OutError)
 {
     FImageReadRequest ReadRequest;
     {
         ReadRequest.InputImage = FInputImageDescription(ImageFilename);
         ReadRequest.TransformParams = TransformParams;
+        // nothing can show the preview while the game thread is blocked
+        ReadRequest.TransformParams.bProgressivePreview = false;
     }
 
     ImageReader->BlockTillAllRequestsFinished();
@@ -214,15 +224,19 @@ void URuntimeImageLoader::LoadImageSync(const FString& ImageFilename, const FTra
 
     bSuccess = ReadResult.OutError.IsEmpty();
     OutTexture = ReadResult.OutTexture;
+    OutAlphaUsage = ReadResult.AlphaUsage;
+    OutTextureStats = ReadResult.TextureStats;
     OutError = ReadResult.OutError;
 }
 
-void URuntimeImageLoader::LoadImageFromBytesSync(UPARAM(ref) TArray<uint8>& ImageBytes, const FTransformImageParams& TransformParams, UTexture2D*& OutTexture, bool& bSuccess, FString& OutError)
+void URuntimeImageLoader::LoadImageFromBytesSync(UPARAM(ref) TArray<uint8>& ImageBytes, const FTransformImageParams& TransformParams, UTexture2D*& OutTexture, ERuntimeImageAlphaUsage& OutAlphaUsage, FRuntimeTextureStats& OutTextureStats, bool& bSuccess, FString& OutError)
 {
     FImageReadRequest ReadRequest;
     {
         ReadRequest.InputImage = FInputImageDescription(MoveTemp(ImageBytes));
         ReadRequest.TransformParams = TransformParams;
+        // nothing can show the preview while the game thread is blocked
+        ReadRequest.TransformParams.bProgressivePreview = false;
     }
 
     ImageReader->BlockTillAllRequestsFinished();
@@ -234,10 +248,12 @@ void URuntimeImageLoader::LoadImageFromBytesSync(UPARAM(ref) TArray<uint8>& Imag
 
     bSuccess = ReadResult.OutError.IsEmpty();
     OutTexture = ReadResult.OutTexture;
+    OutAlphaUsage = ReadResult.AlphaUsage;
+    OutTextureStats = ReadResult.TextureStats;
     OutError = ReadResult.OutError;
 }
 
-void URuntimeImageLoader::LoadImagePixels(const FInputImageDescription& InputImage, const FTransformImageParams& TransformParams, TArray<FColor>& OutImagePixels, bool& bSuccess, FString& OutError, FLatentActionInfo LatentInfo, UObject* WorldContextObject /*= nullptr*/)
+void URuntimeImageLoader::LoadImagePixels(const FInputImageDescription& InputImage, const FTransformImageParams& TransformParams, TArray<FColor>& OutImagePixels, ERuntimeImageAlphaUsage& OutAlphaUsage, bool& bSuccess, FString& OutError, FLatentActionInfo LatentInfo, UObject* WorldContextObject /*= nullptr*/)
 {
     if (!IsValid(WorldContextObject))
     {
@@ -251,7 +267,7 @@ void URuntimeImageLoader::LoadImagePixels(const FInputImageDescription& InputIma
         Request.Params.TransformParams.bOnlyPixels = true;
 
         Request.OnRequestCompleted.BindLambda(
-        [this, &OutImagePixels, &bSuccess, &OutError, LatentInfo](const FImageReadResult& ReadResult)
+        [this, &OutImagePixels, &OutAlphaUsage, &bSuccess, &OutError, LatentInfo](const FImageReadResult& ReadResult)
         {
             FWeakObjectPtr CallbackTargetPtr = LatentInfo.CallbackTarget;
             if (UObject* CallbackTarget = CallbackTargetPtr.Get())
@@ -276,6 +292,7 @@ void URuntimeImageLoader::LoadImagePixels(const FInputImageDescription& InputIma
 
                     bSuccess = ReadResult.OutError.IsEmpty();
                     OutImagePixels = ReadResult.OutImagePixels;
+                    OutAlphaUsage = ReadResult.AlphaUsage;
                     OutError = ReadResult.OutError;
 
                     if (Linkage != -1)
@@ -289,6 +306,7 @@ void URuntimeImageLoader::LoadImagePixels(const FInputImageDescription& InputIma
     }
 
     Requests.Enqueue(Request);
+    FImageReaderFactory::PrefetchImage(Request.Params.InputImage.ImageFilename);
 }
 
 void URuntimeImageLoader::CancelAll()
@@ -306,6 +324,18 @@ void URuntimeImageLoader::CancelAll()
     ActiveRequest.Invalidate();
 
     ImageReader->Clear();
+
+    FImageDownloadManager::Get().CancelAll();
+}
+
+void URuntimeImageLoader::SetHttpConcurrencyLimits(int32 MaxConcurrentDownloads, int32 MaxConcurrentDownloadsPerHost)
+{
+    FImageDownloadManager::Get().SetConcurrencyLimits(MaxConcurrentDownloads, MaxConcurrentDownloadsPerHost);
+}
+
+void URuntimeImageLoader::SetHttpPrefetchLimits(int32 MaxPrefetchedImages, int32 MaxPrefetchedMegabytes)
+{
+    FImageDownloadManager::Get().SetPrefetchLimits(MaxPrefetchedImages, (int64)MaxPrefetchedMegabytes * 1024 * 1024);
 }
 
 TArray<uint8> URuntimeImageLoader::LoadFileToByteArray(const FString& ImageFilename)
@@ -381,11 +411,16 @@ void URuntimeImageLoader::Tick(float DeltaTime)
         ImageReader->Trigger();
     }
 
-    if (ActiveRequest.IsRequestValid() && ImageReader->IsWorkCompleted())
+    // preview texture of the active request, the request completes with the same texture later
+    FImageReadResult PreviewResult;
+    if (ActiveRequest.IsRequestValid() && ImageReader->GetPreview(PreviewResult))
     {
-        FImageReadResult ReadResult;
-        ImageReader->GetResult(ReadResult);
+        OnImagePreviewReady.Broadcast(PreviewResult.ImageFilename, PreviewResult.OutTexture, PreviewResult.AlphaUsage);
+    }
 
+    FImageReadResult ReadResult;
+    if (ActiveRequest.IsRequestValid() && ImageReader->GetResult(ReadResult))
+    {
         ensure(ActiveRequest.OnRequestCompleted.IsBound());
 
         ActiveRequest.OnRequestCompleted.Execute(ReadResult);
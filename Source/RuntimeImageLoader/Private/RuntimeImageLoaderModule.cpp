@@ -1,6 +1,7 @@
 // Copyright 2023 Petr Leontev. All Rights Reserved.
 
 #include "RuntimeImageLoaderModule.h"
+#include "ImageReaders/ImageDownloadManager.h"
 
 #define LOCTEXT_NAMESPACE "FRuntimeImageLoaderModule"
 
@@ -10,6 +11,7 @@ void FRuntimeImageLoaderModule::StartupModule()
 
 void FRuntimeImageLoaderModule::ShutdownModule()
 {
+	FImageDownloadManager::Shutdown();
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -20,10 +20,72 @@
 #include "TextureFactory/RuntimeTextureFactory.h"
 #include "RuntimeImageUtils.h"
 #include "Helpers/CubemapUtils.h"
+#include "Helpers/PixelPackingHelpers.h"
+#include "Helpers/ImageResampler.h"
+#include "Helpers/BlockCompression.h"
 
 
 DEFINE_LOG_CATEGORY_STATIC(LogRuntimeImageReader, Log, All);
 
+static FImageResampler::EFilter GetResamplerFilter(ERuntimeImageResizeFilter Filter)
+{
+    switch (Filter)
+    {
+        case ERuntimeImageResizeFilter::Box:        return FImageResampler::EFilter::Box;
+        case ERuntimeImageResizeFilter::Bicubic:    return FImageResampler::EFilter::Bicubic;
+        case ERuntimeImageResizeFilter::Lanczos3:   return FImageResampler::EFilter::Lanczos3;
+        default:                                    return FImageResampler::EFilter::Bilinear;
+    }
+}
+
+static const TCHAR* GetAlphaUsageName(ERuntimeImageAlphaUsage AlphaUsage)
+{
+    switch (AlphaUsage)
+    {
+        case ERuntimeImageAlphaUsage::Opaque:       return TEXT("opaque");
+        case ERuntimeImageAlphaUsage::Binary:       return TEXT("binary");
+        case ERuntimeImageAlphaUsage::Translucent:  return TEXT("translucent");
+        default:                                    return TEXT("unknown");
+    }
+}
+
+bool FTransformImageParams::GetTargetSize(int32 SourceSizeX, int32 SourceSizeY, int32& OutSizeX, int32& OutSizeY) const
+{
+    OutSizeX = SourceSizeX;
+    OutSizeY = SourceSizeY;
+
+    if (IsPercentSizeValid())
+    {
+        OutSizeX = FMath::Max(1, FMath::FloorToInt(SourceSizeX * (PercentSizeX * 0.01f)));
+        OutSizeY = FMath::Max(1, FMath::FloorToInt(SourceSizeY * (PercentSizeY * 0.01f)));
+    }
+
+    if (HasSizeLimit())
+    {
+        if (FitMode == ERuntimeImageFitMode::Stretch)
+        {
+            OutSizeX = (MaxWidth > 0) ? MaxWidth : OutSizeX;
+            OutSizeY = (MaxHeight > 0) ? MaxHeight : OutSizeY;
+        }
+        else
+        {
+            const double ScaleX = (MaxWidth > 0) ? (double)MaxWidth / OutSizeX : DBL_MAX;
+            const double ScaleY = (MaxHeight > 0) ? (double)MaxHeight / OutSizeY : DBL_MAX;
+
+            // Fill with a single limit has nothing to cover on the other axis
+            const bool bCover = FitMode == ERuntimeImageFitMode::Fill && MaxWidth > 0 && MaxHeight > 0;
+            const double Scale = bCover ? FMath::Max(ScaleX, ScaleY) : FMath::Min(ScaleX, ScaleY);
+            if (Scale < 1.0)
+            {
+                OutSizeX = FMath::Max(1, FMath::RoundToInt(OutSizeX * Scale));
+                OutSizeY = FMath::Max(1, FMath::RoundToInt(OutSizeY * Scale));
+            }
+        }
+    }
+
+    return OutSizeX != SourceSizeX || OutSizeY != SourceSizeY;
+}
+
 
 void URuntimeImageReader::Initialize()
 {
@@ -55,7 +117,7 @@ uint32 URuntimeImageReader::Run()
     while (!bStopThread)
     {
         ThreadSemaphore->Wait();
-        
+
         BlockTillAllRequestsFinished();
     }
 
@@ -80,7 +142,24 @@ bool URuntimeImageReader::GetResult(FImageReadResult& OutResult)
 
     if (Results.Num() > 0)
     {
-        OutResult = Results.Pop();
+        // results are handed out in the order of the requests
+        OutResult = Results[0];
+        Results.RemoveAt(0);
+
+        return true;
+    }
+
+    return false;
+}
+
+bool URuntimeImageReader::GetPreview(FImageReadResult& OutPreview)
+{
+    FScopeLock ResultsLock(&ResultsMutex);
+
+    if (Previews.Num() > 0)
+    {
+        OutPreview = Previews[0];
+        Previews.RemoveAt(0);
 
         return true;
     }
@@ -95,6 +174,7 @@ void URuntimeImageReader::Clear()
     {
         FScopeLock ResultsLock(&ResultsMutex);
         Results.Empty();
+        Previews.Empty();
     }
 
     if (ImageReader.IsValid())
@@ -145,7 +225,7 @@ void URuntimeImageReader::BlockTillAllRequestsFinished()
             PendingReadResult.ImageFilename = Request.InputImage.ImageFilename;
             if (PendingReadResult.ImageFilename.Len() > 0)
             {
-                UE_LOG(LogRuntimeImageReader, Log, TEXT("Reading image from file: %s"), *PendingReadResult.ImageFilename);
+                UE_LOG(LogRuntimeImageReader, Log, TEXT("Reading image from file: %s"), *FImageReaderFactory::SanitizeURI(PendingReadResult.ImageFilename));
             }
             else if (Request.InputImage.ImageBytes.Num() > 0)
             {
@@ -160,10 +240,27 @@ void URuntimeImageReader::BlockTillAllRequestsFinished()
                 UE_LOG(LogRuntimeImageReader, Warning, TEXT("Failed to process request"));
             }
 
-            FScopeLock ResultsLock(&ResultsMutex);
-            Results.Add(PendingReadResult);
+            if (bPendingPreviewPublished)
+            {
+                // preview texture has been handed out already and was updated in place, the result completes the request with it
+                if (!PendingReadResult.OutError.IsEmpty())
+                {
+                    UE_LOG(LogRuntimeImageReader, Warning, TEXT("Failed to replace preview texture with full resolution image. Error: %s"), *PendingReadResult.OutError);
+                }
+
+                if (IsValid(PendingReadResult.OutTexture))
+                {
+                    PendingReadResult.OutTexture->RemoveFromRoot();
+                }
+            }
+
+            {
+                FScopeLock ResultsLock(&ResultsMutex);
+                Results.Add(PendingReadResult);
+            }
 
             PendingReadResult = FImageReadResult();
+            bPendingPreviewPublished = false;
         }
 
         bCompletedWork.AtomicSet(Requests.IsEmpty());
@@ -173,35 +270,84 @@ void URuntimeImageReader::BlockTillAllRequestsFinished()
 bool URuntimeImageReader::ProcessRequest(FImageReadRequest& Request)
 {
     TArray<uint8> ImageBuffer;
+    TArrayView<const uint8> ImageView;
+
+    const bool bWantsPreview = Request.TransformParams.WantsPreview();
 
     // read image data from using URI
     // if not then read from bytes
     if (Request.InputImage.ImageFilename.Len() > 0)
     {
         ImageReader = FImageReaderFactory::CreateReader(Request.InputImage.ImageFilename);
+
+        // leading bytes of a download arrive before the rest of it, the preview is shown while the rest is downloading
+        TArray<uint8> ImagePrefix;
+        if (bWantsPreview && ImageReader->ReadImagePrefix(Request.InputImage.ImageFilename, ImagePrefix))
         {
-            ImageBuffer = ImageReader->ReadImage(Request.InputImage.ImageFilename);
-            if (ImageBuffer.Num() == 0)
-            {
-                PendingReadResult.OutError = FString::Printf(TEXT("Failed to read %s image. Error: %s"), *Request.InputImage.ImageFilename, *ImageReader->GetLastError());
-                return false;
-            }
+            PublishPreview(ImagePrefix.GetData(), ImagePrefix.Num(), Request);
+        }
 
+        // reader keeps the viewed memory alive till the image is decoded
+        if (!ImageReader->ReadImageView(Request.InputImage.ImageFilename, ImageView))
+        {
+            ImageBuffer = ImageReader->ReadImage(Request.InputImage.ImageFilename);
+            ImageView = ImageBuffer;
         }
 
-        ImageReader = nullptr;
+        if (ImageView.Num() == 0)
+        {
+            PendingReadResult.OutError = FString::Printf(TEXT("Failed to read %s image. Error: %s"), *FImageReaderFactory::SanitizeURI(Request.InputImage.ImageFilename), *ImageReader->GetLastError());
+            ImageReader = nullptr;
+            return false;
+        }
     }
     else if (Request.InputImage.ImageBytes.Num() > 0)
     {
         ImageBuffer = MoveTemp(Request.InputImage.ImageBytes);
+        ImageView = ImageBuffer;
     }
 
     // sanity check
-    check(ImageBuffer.Num() > 0);
+    check(ImageView.Num() > 0);
+
+    // images without a prefix are previewed from the whole buffer, it still saves the time of the full decode
+    if (bWantsPreview && !bPendingPreviewPublished)
+    {
+        PublishPreview(ImageView.GetData(), ImageView.Num(), Request);
+    }
+
+    // target size is resolved from the header so decoders that can downscale cheaply (JPEG, WebP) skip most of the resize
+    FImageDecodeParams DecodeParams;
+    DecodeParams.Region = Request.TransformParams.GetRegion();
+
+    int32 HeaderSizeX = 0, HeaderSizeY = 0;
+    if (!Request.TransformParams.bOnlyPixels
+        && (Request.TransformParams.IsPercentSizeValid() || Request.TransformParams.HasSizeLimit())
+        && FRuntimeImageUtils::GetImageSize(ImageView.GetData(), ImageView.Num(), HeaderSizeX, HeaderSizeY))
+    {
+        if (DecodeParams.HasRegion())
+        {
+            const FIntRect ClippedRegion = DecodeParams.GetClippedRegion(HeaderSizeX, HeaderSizeY);
+            HeaderSizeX = ClippedRegion.Width();
+            HeaderSizeY = ClippedRegion.Height();
+        }
 
+        int32 TargetSizeX = 0, TargetSizeY = 0;
+        if (HeaderSizeX > 0 && HeaderSizeY > 0 && Request.TransformParams.GetTargetSize(HeaderSizeX, HeaderSizeY, TargetSizeX, TargetSizeY))
+        {
+            DecodeParams.MinScale = FMath::Min(1.0f, FMath::Max((float)TargetSizeX / HeaderSizeX, (float)TargetSizeY / HeaderSizeY));
+            DecodeParams.TargetSize = FIntPoint(TargetSizeX, TargetSizeY);
+        }
+    }
 
     FRuntimeImageData ImageData;
-    if (!FRuntimeImageUtils::ImportBufferAsImage(ImageBuffer.GetData(), ImageBuffer.Num(), ImageData, PendingReadResult.OutError))
+    const bool bImported = FRuntimeImageUtils::ImportBufferAsImage(ImageView.GetData(), ImageView.Num(), ImageData, PendingReadResult.OutError, DecodeParams);
+
+    ImageReader = nullptr;
+    ImageView = TArrayView<const uint8>();
+    ImageBuffer.Empty();
+
+    if (!bImported)
     {
         return false;
     }
@@ -213,6 +359,14 @@ bool URuntimeImageReader::ProcessRequest(FImageReadRequest& Request)
 
     if (Request.TransformParams.bOnlyPixels)
     {
+        if (ImageData.bPrecompressed)
+        {
+            PendingReadResult.OutError = FString::Printf(TEXT("Pixels of pre-compressed %s images can't be read"), GPixelFormats[ImageData.PixelFormat].Name);
+            return false;
+        }
+
+        PendingReadResult.AlphaUsage = ImageData.ClassifyAlpha();
+
         if (ImageData.TextureSourceFormat == TSF_BGRE8)
         {
             PendingReadResult.OutImagePixels = ImageData.AsBGRE8();
@@ -227,18 +381,34 @@ bool URuntimeImageReader::ProcessRequest(FImageReadRequest& Request)
 
     // sanity checks
     check(ImageData.RawData.Num() > 0);
-    check(ImageData.TextureSourceFormat != TSF_Invalid);
+    check(ImageData.bPrecompressed || ImageData.TextureSourceFormat != TSF_Invalid);
 
-    ImageData.PixelFormat = DeterminePixelFormat(ImageData.Format, Request.TransformParams);
-    if (ImageData.PixelFormat == PF_Unknown)
+    if (ImageData.bPrecompressed)
     {
-        PendingReadResult.OutError = FString::Printf(TEXT("Pixel format is not supported: %d"), (int32)ImageData.PixelFormat);
-        return false;
+        // blocks read from DDS and KTX2 are uploaded as they are, without any transform
+        if (!GPixelFormats[ImageData.PixelFormat].Supported)
+        {
+            PendingReadResult.OutError = FString::Printf(TEXT("Pixel format %s is not supported by the RHI"), GPixelFormats[ImageData.PixelFormat].Name);
+            return false;
+        }
+        ImageData.FilterMode = Request.TransformParams.FilterMode;
+    }
+    else
+    {
+        ImageData.PixelFormat = DeterminePixelFormat(ImageData.Format, Request.TransformParams);
+        if (ImageData.PixelFormat == PF_Unknown)
+        {
+            PendingReadResult.OutError = FString::Printf(TEXT("Pixel format is not supported: %d"), (int32)ImageData.PixelFormat);
+            return false;
+        }
+
+        // decoders that needed it have classified alpha already
+        ImageData.ClassifyAlpha();
     }
 
     // TODO: Below code should be unified and texture source format should be respected by transformation layers
     // cubemaps texture source format
-    if (ImageData.TextureSourceFormat == TSF_BGRE8)
+    if (ImageData.TextureSourceFormat == TSF_BGRE8 || (ImageData.bPrecompressed && ImageData.NumSlices == 6))
     {
         PendingReadResult.OutTextureCube = TextureFactory->CreateTextureCube({ Request.InputImage.ImageFilename, &ImageData });
 
@@ -246,7 +416,10 @@ bool URuntimeImageReader::ProcessRequest(FImageReadRequest& Request)
         // FIXME: this transformation should be done after texture cube is created
         // as texture cube object creation depends on image data params -> bad design!
         // FIXME: this is not exactly compatible with transform params
-        ApplySizeFormatTransformations(ImageData, Request.TransformParams);
+        if (!ImageData.bPrecompressed)
+        {
+            ApplySizeFormatTransformations(ImageData, Request.TransformParams);
+        }
 
         FRuntimeRHITextureCubeFactory RHITextureCubeFactory(PendingReadResult.OutTextureCube, ImageData);
         if (!RHITextureCubeFactory.Create())
@@ -259,10 +432,22 @@ bool URuntimeImageReader::ProcessRequest(FImageReadRequest& Request)
     else
     {
         // TODO: Split into multiple transformation layers?
-        ApplySizeFormatTransformations(ImageData, Request.TransformParams);
+        if (!ImageData.bPrecompressed)
+        {
+            ApplySizeFormatTransformations(ImageData, Request.TransformParams);
+            CompressForGPU(ImageData, Request.TransformParams.Compression);
+        }
 
-        PendingReadResult.OutTexture = TextureFactory->CreateTexture2D({ Request.InputImage.ImageFilename, &ImageData });
-        PendingReadResult.OutTexture->RemoveFromRoot();
+        if (bPendingPreviewPublished)
+        {
+            // keep the texture object that was handed out, only its size and resource are replaced
+            TextureFactory->UpdateTexture2D(PendingReadResult.OutTexture, { Request.InputImage.ImageFilename, &ImageData });
+        }
+        else
+        {
+            PendingReadResult.OutTexture = TextureFactory->CreateTexture2D({ Request.InputImage.ImageFilename, &ImageData });
+            PendingReadResult.OutTexture->RemoveFromRoot();
+        }
 
         FRuntimeRHITexture2DFactory RHITexture2DFactory(PendingReadResult.OutTexture, ImageData);
         if (!RHITexture2DFactory.Create())
@@ -272,6 +457,55 @@ bool URuntimeImageReader::ProcessRequest(FImageReadRequest& Request)
         }
     }
 
+    PendingReadResult.TextureStats.TextureMemorySize = ImageData.RawData.Num();
+    PendingReadResult.AlphaUsage = ImageData.AlphaUsage;
+    UE_LOG(LogRuntimeImageReader, Log, TEXT("Created texture %d x %d, %s, %d mips, %lld KB, %s alpha: %s"),
+        ImageData.SizeX, ImageData.SizeY, GPixelFormats[ImageData.PixelFormat].Name, ImageData.NumMips, PendingReadResult.TextureStats.TextureMemorySize / 1024,
+        GetAlphaUsageName(ImageData.AlphaUsage),
+        *FImageReaderFactory::SanitizeURI(Request.InputImage.ImageFilename));
+
+    return true;
+}
+
+bool URuntimeImageReader::PublishPreview(const uint8* Buffer, int32 Length, FImageReadRequest& Request)
+{
+    FRuntimeImageData PreviewData;
+    FString PreviewError;
+    if (!FRuntimeImageUtils::ImportBufferAsPreviewImage(Buffer, Length, PreviewData, PreviewError))
+    {
+        if (PreviewError.Len() > 0)
+        {
+            UE_LOG(LogRuntimeImageReader, Warning, TEXT("Failed to decode preview image. Error: %s"), *PreviewError);
+        }
+        return false;
+    }
+
+    PreviewData.PixelFormat = PF_B8G8R8A8;
+    PreviewData.FilterMode = Request.TransformParams.FilterMode;
+
+    UTexture2D* PreviewTexture = TextureFactory->CreateTexture2D({ Request.InputImage.ImageFilename, &PreviewData });
+    if (!IsValid(PreviewTexture))
+    {
+        return false;
+    }
+
+    FRuntimeRHITexture2DFactory RHITexture2DFactory(PreviewTexture, PreviewData);
+    if (!RHITexture2DFactory.Create())
+    {
+        PreviewTexture->RemoveFromRoot();
+        return false;
+    }
+
+    UE_LOG(LogRuntimeImageReader, Log, TEXT("Published preview texture: %d x %d"), PreviewData.SizeX, PreviewData.SizeY);
+
+    // texture stays rooted till the full resolution image replaces the preview
+    PendingReadResult.OutTexture = PreviewTexture;
+    {
+        FScopeLock ResultsLock(&ResultsMutex);
+        Previews.Add(PendingReadResult);
+    }
+    bPendingPreviewPublished = true;
+
     return true;
 }
 
@@ -286,7 +520,7 @@ EPixelFormat URuntimeImageReader::DeterminePixelFormat(ERawImageFormat::Type Ima
         case ERawImageFormat::G16:           PixelFormat = PF_G16; break;
         case ERawImageFormat::BGRA8:         PixelFormat = PF_B8G8R8A8; break;
         case ERawImageFormat::BGRE8:         PixelFormat = PF_B8G8R8A8; break;
-        case ERawImageFormat::RGBA16:        PixelFormat = PF_R16G16B16A16_SINT; break;
+        case ERawImageFormat::RGBA16:        PixelFormat = PF_R16G16B16A16_UNORM; break;
         case ERawImageFormat::RGBA16F:       PixelFormat = PF_FloatRGBA; break;
         case ERawImageFormat::RGBA32F:       PixelFormat = PF_A32B32G32R32F; break;
         default:                             PixelFormat = PF_Unknown; break;
@@ -295,53 +529,232 @@ EPixelFormat URuntimeImageReader::DeterminePixelFormat(ERawImageFormat::Type Ima
     return PixelFormat;
 }
 
+void URuntimeImageReader::CropCentered(FRuntimeImageData& ImageData, int32 SizeX, int32 SizeY)
+{
+    const FIntPoint Offset((ImageData.SizeX - SizeX) / 2, (ImageData.SizeY - SizeY) / 2);
+    FRuntimeImageUtils::CropImage(ImageData, FIntRect(Offset, Offset + FIntPoint(SizeX, SizeY)));
+}
+
+void URuntimeImageReader::ConvertForUI(FRuntimeImageData& ImageData, ERawImageFormat::Type Format, ETextureSourceFormat TextureSourceFormat)
+{
+    if (ImageData.Format != Format)
+    {
+        FImage ConvertedImage;
+        ConvertedImage.Init(ImageData.SizeX, ImageData.SizeY, Format);
+        ImageData.CopyTo(ConvertedImage, Format, EGammaSpace::sRGB);
+
+        ImageData.RawData = MoveTemp(ConvertedImage.RawData);
+        ImageData.Format = Format;
+        ImageData.TextureSourceFormat = TextureSourceFormat;
+        ImageData.InvalidateAlphaUsage();
+    }
+
+    ImageData.SRGB = true;
+    ImageData.GammaSpace = EGammaSpace::sRGB;
+}
+
+void URuntimeImageReader::PackForUI(FRuntimeImageData& ImageData)
+{
+    // format is chosen after the mips are generated, filtered mips of a 1-bit alpha image may need more than one bit
+    const EPixelFormat PackedFormat = FPixelPackingHelpers::GetPackedFormat(ImageData);
+    if (PackedFormat == PF_Unknown || !GPixelFormats[PackedFormat].Supported)
+    {
+        return;
+    }
+
+    TArray64<uint8> PackedData;
+    PackedData.SetNumUninitialized(ImageData.RawData.Num() / 2);
+
+    // mips stay tightly packed, each one is dithered by its own pixel positions
+    for (int32 MipIndex = 0; MipIndex < ImageData.NumMips; ++MipIndex)
+    {
+        const int64 MipOffset = ImageData.GetMipOffset(MipIndex);
+        const uint8* Pixels = ImageData.RawData.GetData() + MipOffset;
+        uint16* Texels = reinterpret_cast<uint16*>(PackedData.GetData() + MipOffset / 2);
+
+        if (PackedFormat == PF_R5G6B5_UNORM)
+        {
+            FPixelPackingHelpers::PackR5G6B5(Pixels, Texels, ImageData.GetMipSizeX(MipIndex), ImageData.GetMipSizeY(MipIndex));
+        }
+        else
+        {
+            FPixelPackingHelpers::PackB5G5R5A1(Pixels, Texels, ImageData.GetMipSizeX(MipIndex), ImageData.GetMipSizeY(MipIndex));
+        }
+    }
+
+    // RawData holds texels of the packed pixel format from here on, there is no raw image format for them
+    ImageData.RawData = MoveTemp(PackedData);
+    ImageData.PixelFormat = PackedFormat;
+    ImageData.SRGB = false;
+    ImageData.GammaSpace = EGammaSpace::Linear;
+}
+
+static bool SelectBlockFormat(const FRuntimeImageData& ImageData, ERuntimeTextureCompression Compression, FBlockCompression::EFormat& OutFormat)
+{
+    auto Select = [&OutFormat](FBlockCompression::EFormat Format)
+    {
+        OutFormat = Format;
+        return GPixelFormats[FBlockCompression::GetPixelFormat(Format)].Supported;
+    };
+
+    const bool bBCSupported = GPixelFormats[PF_DXT1].Supported && GPixelFormats[PF_DXT5].Supported;
+
+    if (ImageData.PixelFormat == PF_FloatRGBA)
+    {
+        return Select(FBlockCompression::EFormat::BC6H);
+    }
+
+    if (ImageData.PixelFormat == PF_G8)
+    {
+        // there is no sRGB BC4, sRGB grayscale is compressed as color
+        if (!ImageData.SRGB && Select(FBlockCompression::EFormat::BC4))
+        {
+            return true;
+        }
+        return Select(bBCSupported ? FBlockCompression::EFormat::BC1 : FBlockCompression::EFormat::ETC2_RGB);
+    }
+
+    if (ImageData.PixelFormat != PF_B8G8R8A8 || ImageData.Format != ERawImageFormat::BGRA8)
+    {
+        return false;
+    }
+
+    if (ImageData.CompressionSettings == TC_Normalmap && Select(FBlockCompression::EFormat::BC5))
+    {
+        return true;
+    }
+
+    if (bBCSupported && Compression == ERuntimeTextureCompression::Quality && Select(FBlockCompression::EFormat::BC7))
+    {
+        return true;
+    }
+
+    const bool bOpaque = ImageData.AlphaUsage == ERuntimeImageAlphaUsage::Opaque;
+    if (bBCSupported)
+    {
+        return Select(bOpaque ? FBlockCompression::EFormat::BC1 : FBlockCompression::EFormat::BC3);
+    }
+    return Select(bOpaque ? FBlockCompression::EFormat::ETC2_RGB : FBlockCompression::EFormat::ETC2_RGBA);
+}
+
+void URuntimeImageReader::CompressForGPU(FRuntimeImageData& ImageData, ERuntimeTextureCompression Compression)
+{
+    if (Compression == ERuntimeTextureCompression::None)
+    {
+        return;
+    }
+
+    // D3D needs whole blocks in the first mip
+    if (ImageData.SizeX % 4 != 0 || ImageData.SizeY % 4 != 0)
+    {
+        UE_LOG(LogRuntimeImageReader, Log, TEXT("Texture %d x %d is not a multiple of 4, it stays uncompressed"), ImageData.SizeX, ImageData.SizeY);
+        return;
+    }
+
+    FBlockCompression::EFormat BlockFormat;
+    if (!SelectBlockFormat(ImageData, Compression, BlockFormat) || !FBlockCompression::CanCompress(ImageData, BlockFormat))
+    {
+        UE_LOG(LogRuntimeImageReader, Log, TEXT("No block format for %s textures, it stays uncompressed"), GPixelFormats[ImageData.PixelFormat].Name);
+        return;
+    }
+
+    QUICK_SCOPE_CYCLE_COUNTER(STAT_RuntimeImageReader_CompressForGPU);
+
+    TArray64<uint8> CompressedData;
+    FBlockCompression::FStats Stats;
+    FBlockCompression::Compress(ImageData, BlockFormat, CompressedData, Stats);
+
+    PendingReadResult.TextureStats.CompressionRatio = (float)ImageData.RawData.Num() / CompressedData.Num();
+    PendingReadResult.TextureStats.CompressionPSNR = (float)Stats.PSNR;
+    PendingReadResult.TextureStats.CompressionTimeMs = (float)(Stats.Seconds * 1000.0);
+
+    UE_LOG(LogRuntimeImageReader, Log, TEXT("Compressed %d x %d to %s in %.1f ms (%.1f MPix/s), ratio %.1f:1, PSNR %.2f dB"),
+        ImageData.SizeX, ImageData.SizeY, FBlockCompression::GetName(BlockFormat), PendingReadResult.TextureStats.CompressionTimeMs,
+        (double)ImageData.SizeX * ImageData.SizeY / FMath::Max(Stats.Seconds, 1e-6) / 1e6, PendingReadResult.TextureStats.CompressionRatio, Stats.PSNR);
+
+    // like the packed texels, the blocks have no raw image format
+    ImageData.RawData = MoveTemp(CompressedData);
+    ImageData.PixelFormat = FBlockCompression::GetPixelFormat(BlockFormat);
+    if (BlockFormat == FBlockCompression::EFormat::BC5 || BlockFormat == FBlockCompression::EFormat::BC6H)
+    {
+        // normal maps are linear whatever the decoder assumed, there is no sRGB BC6H
+        ImageData.SRGB = false;
+        ImageData.GammaSpace = EGammaSpace::Linear;
+    }
+}
+
 void URuntimeImageReader::ApplySizeFormatTransformations(FRuntimeImageData& ImageData, FTransformImageParams TransformParams)
 {
-    if (TransformParams.IsPercentSizeValid())
+    // format of the UI texture, float RGBA and HDR are not converted
+    ERawImageFormat::Type UIFormat = ImageData.Format;
+    ETextureSourceFormat UITextureSourceFormat = ImageData.TextureSourceFormat;
+    const bool bConvertForUI = TransformParams.bForUI && ImageData.TextureSourceFormat != TSF_RGBA16F && ImageData.TextureSourceFormat != TSF_BGRE8;
+    if (bConvertForUI)
+    {
+        const bool bGrayscale = ImageData.Format == ERawImageFormat::G8 || ImageData.Format == ERawImageFormat::G16;
+        const bool bKeepGrayscale = bGrayscale && TransformParams.UIFormat != ERuntimeUITextureFormat::BGRA8;
+        UIFormat = bKeepGrayscale ? ERawImageFormat::G8 : ERawImageFormat::BGRA8;
+        UITextureSourceFormat = bKeepGrayscale ? TSF_G8 : TSF_BGRA8;
+    }
+
+    // target size is relative to the encoded image, decoder may have downscaled it already
+    const int32 SourceSizeX = (ImageData.SourceSizeX > 0) ? ImageData.SourceSizeX : ImageData.SizeX;
+    const int32 SourceSizeY = (ImageData.SourceSizeY > 0) ? ImageData.SourceSizeY : ImageData.SizeY;
+
+    int32 TransformedSizeX = 0, TransformedSizeY = 0;
+    if (TransformParams.GetTargetSize(SourceSizeX, SourceSizeY, TransformedSizeX, TransformedSizeY)
+        && (TransformedSizeX != ImageData.SizeX || TransformedSizeY != ImageData.SizeY))
     {
-        const int32 TransformedSizeX = FMath::Floor(ImageData.SizeX * TransformParams.PercentSizeX * 0.01f);
-        const int32 TransformedSizeY = FMath::Floor(ImageData.SizeY * TransformParams.PercentSizeY * 0.01f);
-        
         FImage TransformedImage;
-        TransformedImage.Init(TransformedSizeX, TransformedSizeY, ImageData.Format);
 
-        ImageData.ResizeTo(TransformedImage, TransformedImage.SizeX, TransformedImage.SizeY, ImageData.Format, ImageData.GammaSpace);
+        if (FImageResampler::IsConversionSupported(ImageData.Format, UIFormat))
+        {
+            // resized rows are encoded straight to the UI format, there is no full size intermediate
+            TransformedImage.Init(TransformedSizeX, TransformedSizeY, UIFormat, bConvertForUI ? EGammaSpace::sRGB : ImageData.GammaSpace);
+            FImageResampler::Resize(ImageData, TransformedImage, GetResamplerFilter(TransformParams.ResizeFilter));
+
+            ImageData.Format = TransformedImage.Format;
+            ImageData.GammaSpace = TransformedImage.GammaSpace;
+            ImageData.TextureSourceFormat = UITextureSourceFormat;
+        }
+        else
+        {
+            TransformedImage.Init(TransformedSizeX, TransformedSizeY, ImageData.Format);
+            ImageData.ResizeTo(TransformedImage, TransformedImage.SizeX, TransformedImage.SizeY, ImageData.Format, ImageData.GammaSpace);
+        }
 
         ImageData.RawData = MoveTemp(TransformedImage.RawData);
         ImageData.SizeX = TransformedImage.SizeX;
         ImageData.SizeY = TransformedImage.SizeY;
+        ImageData.InvalidateAlphaUsage();
     }
-    else
+
+    if (TransformParams.FitMode == ERuntimeImageFitMode::Fill && TransformParams.MaxWidth > 0 && TransformParams.MaxHeight > 0)
     {
-        UE_LOG(LogRuntimeImageReader, Verbose, TEXT("Supplied transform params are not valid! PercentSizeX, PercentSizeX: (%d, %d)"), TransformParams.PercentSizeX, TransformParams.PercentSizeY);
+        CropCentered(ImageData, FMath::Min(ImageData.SizeX, TransformParams.MaxWidth), FMath::Min(ImageData.SizeY, TransformParams.MaxHeight));
     }
 
-    if (TransformParams.bForUI)
+    if (bConvertForUI)
     {
-        // no need to convert float RGBA and HDR
-        if (ImageData.TextureSourceFormat != TSF_RGBA16F && ImageData.TextureSourceFormat != TSF_BGRE8)
-        {
-            FImage BGRAImage;
-            BGRAImage.Init(ImageData.SizeX, ImageData.SizeY, ERawImageFormat::BGRA8);
-            ImageData.CopyTo(BGRAImage, ERawImageFormat::BGRA8, EGammaSpace::sRGB);
+        // no-op if the resize has converted the image already
+        ConvertForUI(ImageData, UIFormat, UITextureSourceFormat);
+        ImageData.PixelFormat = (UIFormat == ERawImageFormat::G8) ? PF_G8 : PF_B8G8R8A8;
+    }
 
-            ImageData.RawData = MoveTemp(BGRAImage.RawData);
-            ImageData.SRGB = true;
-            ImageData.GammaSpace = EGammaSpace::sRGB;
+    // packing and block compression pick their formats by it, both replace the pixels
+    ImageData.ClassifyAlpha();
 
-            // modify pixel format
-            switch (ImageData.Format)
-            {
-                case ERawImageFormat::G8:
-                case ERawImageFormat::RGBA16:
-                {
-                    ImageData.PixelFormat = PF_B8G8R8A8;
-                    break;
-                }
-                default:
-                    break;
-            }
-        }
+    // mips are filtered before packing, there is no raw image format for the packed texels
+    if (TransformParams.bGenerateMips && ImageData.TextureSourceFormat != TSF_BGRE8 && FImageResampler::IsFormatSupported(ImageData.Format))
+    {
+        const FImageResampler::EFilter MipFilter = (TransformParams.MipFilter == ERuntimeImageMipFilter::Kaiser) ? FImageResampler::EFilter::Kaiser : FImageResampler::EFilter::Box;
+        FImageResampler::GenerateMips(ImageData, MipFilter);
+    }
+
+    if (bConvertForUI && UIFormat == ERawImageFormat::BGRA8 && TransformParams.UIFormat == ERuntimeUITextureFormat::Packed16
+        && TransformParams.Compression == ERuntimeTextureCompression::None)
+    {
+        PackForUI(ImageData);
     }
     
     if (ImageData.TextureSourceFormat == TSF_BGRE8)
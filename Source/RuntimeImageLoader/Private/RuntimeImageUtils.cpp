@@ -14,9 +14,6 @@
 #include "HAL/UnrealMemory.h"
 #include "Serialization/BulkData.h"
 #include "Serialization/Archive.h"
-#include "IImageWrapperModule.h"
-#include "Modules/ModuleManager.h"
-#include "IImageWrapper.h"
 #include "RHI.h"
 #include "RenderUtils.h"
 #include "RHIDefinitions.h"
@@ -27,10 +24,11 @@
 #include "DDSLoader.h"
 #endif
 
-#include "Helpers/TGAHelpers.h"
 #include "Helpers/PNGHelpers.h"
-#include "Helpers/TIFFLoader.h"
+#include "Helpers/JPEGHelpers.h"
 #include "Helpers/QOIHelpers.h"
+#include "ImageDecoders/ImageDecoderRegistry.h"
+#include "ImageReaders/ImageReaderFactory.h"
 
 #define MAX_SUPPORTED_TEXTURE_SIZE int32(1 << (MAX_TEXTURE_MIP_COUNT - 1))
 
@@ -59,389 +57,188 @@ namespace FRuntimeImageUtils
         return bValid;
     }
 
-    bool ImportBufferAsImage(const uint8* Buffer, int32 Length, FRuntimeImageData& OutImage, FString& OutError)
+    bool IsWholeBlockSize(EPixelFormat PixelFormat, int32 Width, int32 Height)
     {
-        QUICK_SCOPE_CYCLE_COUNTER(STAT_EvoImageUtils_ImportFileAsTexture_ImportBufferAsImage);
-        
-        IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
-
-        //
-        // PNG
-        //
-        // PNG support both 8 and 16 bit depth images (24 and 48 bits per pixel respectively or 32 and 64 bits when alpha channel is used) 
-        TSharedPtr<IImageWrapper> PngImageWrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::PNG);
-        if (PngImageWrapper.IsValid() && PngImageWrapper->SetCompressed(Buffer, Length))
+        const FPixelFormatInfo& FormatInfo = GPixelFormats[PixelFormat];
+        return Width % FormatInfo.BlockSizeX == 0 && Height % FormatInfo.BlockSizeY == 0;
+    }
+
+    void CropImage(FRuntimeImageData& Image, const FIntRect& Rect)
+    {
+        if (Rect.Min == FIntPoint::ZeroValue && Rect.Width() == Image.SizeX && Rect.Height() == Image.SizeY)
         {
-            if (!IsImportResolutionValid(PngImageWrapper->GetWidth(), PngImageWrapper->GetHeight(), true))
-            {
-                OutError = FString::Printf(TEXT("Texture resolution is not supported: %d x %d"), PngImageWrapper->GetWidth(), PngImageWrapper->GetHeight());
-                return false;
-            }
+            return;
+        }
 
-            // Select the texture's source format
-            ETextureSourceFormat TextureFormat = TSF_Invalid;
-            int32 BitDepth = PngImageWrapper->GetBitDepth();
-            ERGBFormat Format = PngImageWrapper->GetFormat();
+        QUICK_SCOPE_CYCLE_COUNTER(STAT_RuntimeImageUtils_CropImage);
 
-            if (Format == ERGBFormat::Gray)
-            {
-                if (BitDepth <= 8)
-                {
-                    TextureFormat = TSF_G8;
-                    Format = ERGBFormat::Gray;
-                    BitDepth = 8;
-                }
-                else if (BitDepth == 16)
-                {
-                    // TODO: TSF_G16?
-                    TextureFormat = TSF_RGBA16;
-                    Format = ERGBFormat::RGBA;
-                    BitDepth = 16;
-                }
-            }
-            else if (Format == ERGBFormat::RGBA || Format == ERGBFormat::BGRA)
-            {
-                if (BitDepth <= 8)
-                {
-                    TextureFormat = TSF_BGRA8;
-                    Format = ERGBFormat::BGRA;
-                    BitDepth = 8;
-                }
-                else if (BitDepth == 16)
-                {
-                    TextureFormat = TSF_RGBA16;
-                    Format = ERGBFormat::RGBA;
-                    BitDepth = 16;
-                }
-            }
+        const int64 BytesPerPixel = Image.GetBytesPerPixel();
+        const int64 SourcePitch = Image.SizeX * BytesPerPixel;
+        const int64 DestPitch = Rect.Width() * BytesPerPixel;
+        const uint8* Source = Image.RawData.GetData() + Rect.Min.Y * SourcePitch + Rect.Min.X * BytesPerPixel;
+        uint8* Dest = Image.RawData.GetData();
 
-            if (BitDepth > 16)
-            {
-                OutError = TEXT("Only 8 and 16 bit depth PNG images are currently supported.");
-                return false;
-            }
+        // rows only move towards the start of the buffer, so they are compacted in place
+        for (int32 Y = 0; Y < Rect.Height(); ++Y)
+        {
+            FMemory::Memmove(Dest + Y * DestPitch, Source + Y * SourcePitch, DestPitch);
+        }
 
-            TArray<uint8> RawPNG;
-            if (PngImageWrapper->GetRaw(Format, BitDepth, RawPNG))
-            {
-                OutImage.Init2D(
-                    PngImageWrapper->GetWidth(),
-                    PngImageWrapper->GetHeight(),
-                    TextureFormat,
-                    RawPNG.GetData()
-                );
-                OutImage.SRGB = BitDepth < 16;
-                OutImage.GammaSpace = OutImage.SRGB ? EGammaSpace::sRGB : EGammaSpace::Linear; 
-
-                FPNGHelpers::FillZeroAlphaPNGData(OutImage.SizeX, OutImage.SizeY, OutImage.TextureSourceFormat, OutImage.RawData.GetData());
-            }
-            else
-            {
-                OutError = FString::Printf(TEXT("Failed to decode PNG. Bit depth: %d"), BitDepth);
-                return false;
-            }
+        Image.SizeX = Rect.Width();
+        Image.SizeY = Rect.Height();
+        Image.RawData.SetNum(Image.SizeY * DestPitch);
+        Image.InvalidateAlphaUsage();
+    }
 
-            return true;
+    /** Crops the rest of the region out of the decoded image, which may cover more than the region and be downscaled */
+    static bool CropToRegion(FRuntimeImageData& Image, const FIntRect& Region, FString& OutError)
+    {
+        const FIntRect Covered = (Image.DecodedRegion.Area() > 0)
+            ? Image.DecodedRegion
+            : FIntRect(0, 0, (Image.SourceSizeX > 0) ? Image.SourceSizeX : Image.SizeX, (Image.SourceSizeY > 0) ? Image.SourceSizeY : Image.SizeY);
+
+        const FIntRect Wanted(
+            FMath::Max(Region.Min.X, Covered.Min.X), FMath::Max(Region.Min.Y, Covered.Min.Y),
+            FMath::Min(Region.Max.X, Covered.Max.X), FMath::Min(Region.Max.Y, Covered.Max.Y));
+        if (Wanted.Width() <= 0 || Wanted.Height() <= 0)
+        {
+            OutError = FString::Printf(TEXT("Region %s is outside of the image"), *Region.ToString());
+            return false;
         }
-        //
-        // JPEG
-        //
-        // JPEG can only be 8-bit depth
 
-        TSharedPtr<IImageWrapper> JpegImageWrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::JPEG);
-        if (JpegImageWrapper.IsValid() && JpegImageWrapper->SetCompressed(Buffer, Length))
-        {
-            if (!IsImportResolutionValid(JpegImageWrapper->GetWidth(), JpegImageWrapper->GetHeight(), true))
-            {
-                OutError = FString::Printf(TEXT("Texture resolution is not supported: %d x %d"), JpegImageWrapper->GetWidth(), JpegImageWrapper->GetHeight());
-                return false;
-            }
+        const double ScaleX = (double)Image.SizeX / Covered.Width();
+        const double ScaleY = (double)Image.SizeY / Covered.Height();
 
-            // Select the texture's source format
-            ETextureSourceFormat TextureFormat = TSF_Invalid;
-            int32 BitDepth = JpegImageWrapper->GetBitDepth();
-            ERGBFormat Format = JpegImageWrapper->GetFormat();
+        FIntRect Pixels;
+        Pixels.Min.X = FMath::Clamp(FMath::FloorToInt((Wanted.Min.X - Covered.Min.X) * ScaleX), 0, Image.SizeX - 1);
+        Pixels.Min.Y = FMath::Clamp(FMath::FloorToInt((Wanted.Min.Y - Covered.Min.Y) * ScaleY), 0, Image.SizeY - 1);
+        Pixels.Max.X = FMath::Clamp(FMath::CeilToInt((Wanted.Max.X - Covered.Min.X) * ScaleX), Pixels.Min.X + 1, Image.SizeX);
+        Pixels.Max.Y = FMath::Clamp(FMath::CeilToInt((Wanted.Max.Y - Covered.Min.Y) * ScaleY), Pixels.Min.Y + 1, Image.SizeY);
 
-            if (Format == ERGBFormat::Gray)
-            {
-                if (BitDepth <= 8)
-                {
-                    TextureFormat = TSF_G8;
-                    Format = ERGBFormat::Gray;
-                    BitDepth = 8;
-                }
-            }
-            else if (Format == ERGBFormat::RGBA || Format == ERGBFormat::BGRA)
-            {
-                if (BitDepth <= 8)
-                {
-                    TextureFormat = TSF_BGRA8;
-                    Format = ERGBFormat::BGRA;
-                    BitDepth = 8;
-                }
-            }
+        CropImage(Image, Pixels);
 
-            if (TextureFormat == TSF_Invalid)
-            {
-                OutError = FString::Printf(TEXT("JPEG file contains data in an unsupported format. Bit depth: %d"), BitDepth);
-                return false;
-            }
+        // transforms are relative to the region from here on
+        const bool bDownscaled = Image.SizeX != Wanted.Width() || Image.SizeY != Wanted.Height();
+        Image.SourceSizeX = bDownscaled ? Wanted.Width() : 0;
+        Image.SourceSizeY = bDownscaled ? Wanted.Height() : 0;
+        Image.DecodedRegion = Wanted;
 
-            TArray<uint8> RawJPEG;
-            if (JpegImageWrapper->GetRaw(Format, BitDepth, RawJPEG))
-            {
-                OutImage.Init2D(
-                    JpegImageWrapper->GetWidth(),
-                    JpegImageWrapper->GetHeight(),
-                    TextureFormat,
-                    RawJPEG.GetData()
-                );
-                OutImage.SRGB = true;
-                OutImage.GammaSpace = OutImage.SRGB ? EGammaSpace::sRGB : EGammaSpace::Linear;
-            }
-            else
-            {
-                OutError = TEXT("Failed to decode JPEG. Please contact devs");
-                return false;
-            }
+        return true;
+    }
 
-            return true;
-        }
+    bool ImportBufferAsImage(const uint8* Buffer, int32 Length, FRuntimeImageData& OutImage, FString& OutError, const FImageDecodeParams& Params)
+    {
+        QUICK_SCOPE_CYCLE_COUNTER(STAT_EvoImageUtils_ImportFileAsTexture_ImportBufferAsImage);
 
-        //
-        // BMP
-        //
-        TSharedPtr<IImageWrapper> BmpImageWrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::BMP);
-        if (BmpImageWrapper.IsValid() && BmpImageWrapper->SetCompressed(Buffer, Length))
+        FImageDecoderPtr Decoder = FImageDecoderRegistry::Get().FindDecoder(Buffer, Length);
+        if (!Decoder.IsValid())
         {
-            // Check the resolution of the imported texture to ensure validity
-            if (!IsImportResolutionValid(BmpImageWrapper->GetWidth(), BmpImageWrapper->GetHeight(), true))
-            {
-                OutError = FString::Printf(TEXT("Texture resolution is not supported: %d x %d"), BmpImageWrapper->GetWidth(), BmpImageWrapper->GetHeight());
-                return false;
-            }
-
-            TArray<uint8> RawBMP;
-            if (BmpImageWrapper->GetRaw(BmpImageWrapper->GetFormat(), BmpImageWrapper->GetBitDepth(), RawBMP))
-            {
-                // Set texture properties.
-                OutImage.Init2D(
-                    BmpImageWrapper->GetWidth(),
-                    BmpImageWrapper->GetHeight(),
-                    TSF_BGRA8,
-                    RawBMP.GetData()
-                );
-                
-                OutImage.SRGB = true;
-                OutImage.GammaSpace = OutImage.SRGB ? EGammaSpace::sRGB : EGammaSpace::Linear;
-            }
-            else
-            {
-                OutError = FString::Printf(TEXT("Failed to decode BMP. Bit depth: %d"), BmpImageWrapper->GetBitDepth());
-                return false;
-            }
-
-            return true;
+            OutError = FString::Printf(TEXT("Failed to decode image. The format is not supported!"));
+            return false;
         }
-       
-        //
-        // TGA
-        //
-        // Support for alpha stored as pseudo-color 8-bit TGA
-        const FTGAHelpers::FTGAFileHeader* TGA = (FTGAHelpers::FTGAFileHeader*)Buffer;
-        if (Length >= sizeof(FTGAHelpers::FTGAFileHeader) &&
-            ((TGA->ColorMapType == 0 && TGA->ImageTypeCode == 2) ||
-            // ImageTypeCode 3 is greyscale
-            (TGA->ColorMapType == 0 && TGA->ImageTypeCode == 3) ||
-            (TGA->ColorMapType == 0 && TGA->ImageTypeCode == 10) ||
-            (TGA->ColorMapType == 1 && TGA->ImageTypeCode == 1 && TGA->BitsPerPixel == 8))
-            )
+
+        if (!Decoder->Decode(Buffer, Length, Params, OutImage, OutError))
         {
-            // Check the resolution of the imported texture to ensure validity
-            if (!IsImportResolutionValid(TGA->Width, TGA->Height, true))
-            {
-                OutError = FString::Printf(TEXT("Texture resolution is not supported: %d x %d"), TGA->Width, TGA->Height);
-                return false;
-            }
+            return false;
+        }
 
-            const bool bResult = FTGAHelpers::DecompressTGA(TGA, OutImage, OutError);
-            if (bResult)
-            {
-                if (OutImage.CompressionSettings == TC_Grayscale && TGA->ImageTypeCode == 3)
-                {
-                    // default grayscales to linear as they wont get compression otherwise and are commonly used as masks
-                    OutImage.SRGB = false;
-                    
-                }
+        // blocks of pre-compressed images are uploaded as they are
+        return !Params.HasRegion() || OutImage.bPrecompressed || CropToRegion(OutImage, Params.Region, OutError);
+    }
 
-                OutImage.GammaSpace = OutImage.SRGB ? EGammaSpace::sRGB : EGammaSpace::Linear;
-            }
-            else
-            {
-                OutError = TEXT("Failed to decompress TGA. Please contact devs");
-                return false;
-            }
+    bool GetImageSize(const uint8* Buffer, int32 Length, int32& OutWidth, int32& OutHeight)
+    {
+        FImageDecoderPtr Decoder = FImageDecoderRegistry::Get().FindDecoder(Buffer, Length);
+        return Decoder.IsValid() && Decoder->GetImageSize(Buffer, Length, OutWidth, OutHeight);
+    }
 
-            return true;
-        }
+    bool ImportBufferAsPreviewImage(const uint8* Buffer, int32 Length, FRuntimeImageData& OutImage, FString& OutError)
+    {
+        QUICK_SCOPE_CYCLE_COUNTER(STAT_RuntimeImageUtils_ImportBufferAsPreviewImage);
 
+        if (FPNGHelpers::IsInterlacedPNG(Buffer, Length))
+        {
+            return FPNGHelpers::DecodeInterlacedPreview(Buffer, Length, OutImage, OutError);
+        }
 
-        //
-        // OpenEXR
-        //
-        TSharedPtr<IImageWrapper> ExrImageWrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::EXR);
-        if (ExrImageWrapper.IsValid() && ExrImageWrapper->SetCompressed(Buffer, Length))
+        if (FJPEGHelpers::IsProgressiveJPEG(Buffer, Length))
         {
-            int32 Width = ExrImageWrapper->GetWidth();
-            int32 Height = ExrImageWrapper->GetHeight();
+            return FJPEGHelpers::DecodeProgressivePreview(Buffer, Length, OutImage, OutError);
+        }
 
-            if (!IsImportResolutionValid(Width, Height, true))
-            {
-                return false;
-            }
+        return false;
+    }
 
-            // Select the texture's source format
-            ETextureSourceFormat TextureFormat = TSF_Invalid;
-            int32 BitDepth = ExrImageWrapper->GetBitDepth();
-            ERGBFormat Format = ExrImageWrapper->GetFormat();
+    bool SaveImageAsQOI(const FRuntimeImageData& Image, const FString& Filename, FString& OutError)
+    {
+        QUICK_SCOPE_CYCLE_COUNTER(STAT_RuntimeImageUtils_SaveImageAsQOI);
 
-            if (Format == ERGBFormat::RGBA && BitDepth == 16)
-            {
-                TextureFormat = TSF_RGBA16F;
-                Format = ERGBFormat::BGRA;
-            }
+        if (Image.TextureSourceFormat != TSF_BGRA8 && Image.TextureSourceFormat != TSF_G8)
+        {
+            OutError = TEXT("Only BGRA8 and G8 images can be saved as QOI");
+            return false;
+        }
 
-            if (TextureFormat == TSF_Invalid)
-            {
-                OutError = TEXT("EXR file contains data in an unsupported format.");
-                return false;
-            }
+        TUniquePtr<FArchive> FileWriter(IFileManager::Get().CreateFileWriter(*Filename));
+        if (!FileWriter)
+        {
+            OutError = FString::Printf(TEXT("Failed to open %s for writing"), *Filename);
+            return false;
+        }
 
-            TArray<uint8> RawExr;
-            if (ExrImageWrapper->GetRaw(Format, BitDepth, RawExr))
-            {
-                OutImage.Init2D(
-                    Width,
-                    Height,
-                    TextureFormat,
-                    RawExr.GetData()
-                );
-
-                OutImage.SRGB = false;
-                OutImage.GammaSpace = OutImage.SRGB ? EGammaSpace::sRGB : EGammaSpace::Linear;
-                OutImage.CompressionSettings = TC_HDR;
-            }
-            else
-            {
-                OutError = FString::Printf(TEXT("Failed to decode EXR. Bit depth: %d"), BitDepth);
-                return false;
-            }
+        const bool bHasAlpha = Image.TextureSourceFormat == TSF_BGRA8;
+        FQOIWriter QOIWriter(*FileWriter, Image.SizeX, Image.SizeY, bHasAlpha, Image.SRGB);
 
-            return true;
+        if (Image.TextureSourceFormat == TSF_BGRA8)
+        {
+            QOIWriter.WritePixels(Image.RawData.GetData(), (int64)Image.SizeX * Image.SizeY);
         }
-
-        //
-        // TIFF
-        //
-#if WITH_FREEIMAGE_LIB
-        static FRuntimeTiffLoadHelper TiffLoaderHelper;
-        if (TiffLoaderHelper.IsValid())
+        else
         {
-            TiffLoaderHelper.Reset();
+            // grayscale is expanded one row at a time
+            TArray<uint8> RowPixels;
+            RowPixels.SetNumUninitialized(Image.SizeX * 4);
 
-            if (TiffLoaderHelper.Load(Buffer, Length))
+            for (int32 Y = 0; Y < Image.SizeY; ++Y)
             {
-                OutImage.Init2D(
-                    TiffLoaderHelper.Width,
-                    TiffLoaderHelper.Height,
-                    TiffLoaderHelper.TextureSourceFormat,
-                    TiffLoaderHelper.RawData.GetData()
-                );
-
-                OutImage.SRGB = TiffLoaderHelper.bSRGB;
-                OutImage.GammaSpace = OutImage.SRGB ? EGammaSpace::sRGB : EGammaSpace::Linear;
-                OutImage.CompressionSettings = TiffLoaderHelper.CompressionSettings;
-
-                return true;
+                const uint8* GrayRow = Image.RawData.GetData() + (int64)Y * Image.SizeX;
+                for (int32 X = 0; X < Image.SizeX; ++X)
+                {
+                    RowPixels[X * 4 + 0] = GrayRow[X];
+                    RowPixels[X * 4 + 1] = GrayRow[X];
+                    RowPixels[X * 4 + 2] = GrayRow[X];
+                    RowPixels[X * 4 + 3] = 255;
+                }
+                QOIWriter.WritePixels(RowPixels.GetData(), Image.SizeX);
             }
         }
-#endif // WITH_FREEIMAGE_LIB
 
-        //
-        // QOI
-        //
-        FQOILoader QOILoader;
-        if (QOILoader.IsValidImage(Buffer, Length))
+        const bool bWritten = QOIWriter.Finish() && FileWriter->Close();
+        if (!bWritten)
         {
-            if (QOILoader.Load(Buffer, Length))
-            {
-                OutImage.Init2D(
-                    QOILoader.Width,
-                    QOILoader.Height,
-                    QOILoader.TextureSourceFormat,
-                    QOILoader.RawData.GetData()
-                );
-                
-                OutImage.SRGB = QOILoader.bSRGB;
-                OutImage.GammaSpace = OutImage.SRGB ? EGammaSpace::sRGB : EGammaSpace::Linear;
-                OutImage.CompressionSettings = QOILoader.CompressionSettings;
-
-                return true;
-            }
-
-            OutError = QOILoader.GetLastError();
-            return false;
+            OutError = FString::Printf(TEXT("Failed to write %s"), *Filename);
         }
+        return bWritten;
+    }
 
-        //
-        // HDR File
-        //
-        TSharedPtr<IImageWrapper> HdrImageWrapper = ImageWrapperModule.CreateImageWrapper(EImageFormat::HDR);
-        if (HdrImageWrapper.IsValid() && HdrImageWrapper->SetCompressed(Buffer, Length))
+    /** Mip sizes only, the data is uploaded by the RHI factory */
+    static void SetPlatformMips(FTexturePlatformData* PlatformData, const FRuntimeImageData& ImageData)
+    {
+        PlatformData->Mips.Empty(ImageData.NumMips);
+        for (int32 MipIndex = 0; MipIndex < ImageData.NumMips; ++MipIndex)
         {
-            if (!IsImportResolutionValid(HdrImageWrapper->GetWidth(), HdrImageWrapper->GetHeight(), true))
-            {
-                OutError = FString::Printf(TEXT("HDR Texture resolution is not supported: %d x %d"), HdrImageWrapper->GetWidth(), HdrImageWrapper->GetHeight());
-                return false;
-            }
-
-            // Select the texture's source format
-            ETextureSourceFormat TextureFormat = TSF_BGRE8;
-            int32 BitDepth = HdrImageWrapper->GetBitDepth();
-            ERGBFormat Format = HdrImageWrapper->GetFormat();
-
-            TArray64<uint8> RawHDR;
-            if (HdrImageWrapper->GetRaw(ERGBFormat::BGRE, BitDepth, RawHDR))
-            {
-                OutImage.Init2D(
-                    HdrImageWrapper->GetWidth(),
-                    HdrImageWrapper->GetHeight(),
-                    TextureFormat,
-                    RawHDR.GetData()
-                );
-
-                OutImage.SRGB = false;
-                OutImage.GammaSpace = EGammaSpace::Linear;
-                OutImage.CompressionSettings = TC_HDR;
-            }
-            else
-            {
-                OutError = TEXT("Failed to load .HDR image. Input image is not valid cubemap texture!");
-                return false;
-            }
-
-            return true;
+            FTexture2DMipMap* Mip = new FTexture2DMipMap();
+            PlatformData->Mips.Add(Mip);
+            Mip->SizeX = ImageData.GetMipSizeX(MipIndex);
+            Mip->SizeY = ImageData.GetMipSizeY(MipIndex);
         }
-
-        OutError = FString::Printf(TEXT("Failed to decode image. The format is not supported!"));
-        return false;
     }
 
     UTexture2D* CreateTexture(const FString& ImageFilename, const FRuntimeImageData& ImageData)
     {
         check(IsInGameThread());
 
-        const FString& BaseFilename = FPaths::GetBaseFilename(ImageFilename);
+        const FString BaseFilename = FImageReaderFactory::IsDataURI(ImageFilename) ? TEXT("DataURI") : FPaths::GetBaseFilename(ImageFilename);
 
         UTexture2D* NewTexture = NewObject<UTexture2D>(
             (UObject*)GetTransientPackage(),
@@ -471,20 +268,39 @@ namespace FRuntimeImageUtils
             PlatformData->SizeY = ImageData.SizeY;
             PlatformData->PixelFormat = ImageData.PixelFormat;
 
-            FTexture2DMipMap* Mip = new FTexture2DMipMap();
-            PlatformData->Mips.Add(Mip);
-            Mip->SizeX = ImageData.SizeX;
-            Mip->SizeY = ImageData.SizeY;
+            SetPlatformMips(PlatformData, ImageData);
         }
 
         return NewTexture;
     }
 
+    void UpdateTexture(UTexture2D* Texture, const FRuntimeImageData& ImageData)
+    {
+        check(IsInGameThread());
+        check(IsValid(Texture));
+
+        Texture->SRGB = ImageData.SRGB;
+        Texture->Filter = ImageData.FilterMode;
+
+#if ENGINE_MAJOR_VERSION < 5
+        FTexturePlatformData* PlatformData = Texture->PlatformData;
+#else
+        FTexturePlatformData* PlatformData = Texture->GetPlatformData();
+#endif
+        check(PlatformData != nullptr && PlatformData->Mips.Num() > 0);
+
+        PlatformData->SizeX = ImageData.SizeX;
+        PlatformData->SizeY = ImageData.SizeY;
+        PlatformData->PixelFormat = ImageData.PixelFormat;
+
+        SetPlatformMips(PlatformData, ImageData);
+    }
+
     UTextureCube* CreateTextureCube(const FString& ImageFilename, const FRuntimeImageData& ImageData)
     {
         check(IsInGameThread());
 
-        const FString& BaseFilename = FPaths::GetBaseFilename(ImageFilename);
+        const FString BaseFilename = FImageReaderFactory::IsDataURI(ImageFilename) ? TEXT("DataURI") : FPaths::GetBaseFilename(ImageFilename);
 
         UTextureCube* NewTexture = NewObject<UTextureCube>(
             (UObject*)GetTransientPackage(),
@@ -513,10 +329,7 @@ namespace FRuntimeImageUtils
             PlatformData->SizeY = ImageData.SizeY;
             PlatformData->PixelFormat = ImageData.PixelFormat;
 
-            FTexture2DMipMap* Mip = new FTexture2DMipMap();
-            PlatformData->Mips.Add(Mip);
-            Mip->SizeX = ImageData.SizeX;
-            Mip->SizeY = ImageData.SizeY;
+            SetPlatformMips(PlatformData, ImageData);
         }
 
         return NewTexture;
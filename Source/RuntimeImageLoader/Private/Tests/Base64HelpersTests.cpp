@@ -0,0 +1,89 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "RuntimeImageLoaderTests.h"
+#include "Misc/Base64.h"
+#include "Helpers/Base64Helpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    bool DecodeAnsi(const FString& Encoded, TArray<uint8>& OutBytes)
+    {
+        const FTCHARToUTF8 Source(*Encoded);
+        OutBytes.SetNumUninitialized(FBase64Helpers::GetMaxDecodedSize(Source.Length()));
+
+        const int64 NumBytes = FBase64Helpers::Decode(Source.Get(), Source.Length(), OutBytes.GetData());
+        if (NumBytes == INDEX_NONE)
+        {
+            return false;
+        }
+
+        OutBytes.SetNum(NumBytes);
+        return true;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBase64HelpersRoundTripTest, "RuntimeImageLoader.Base64.RoundTrip", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FBase64HelpersRoundTripTest::RunTest(const FString& Parameters)
+{
+    // short lengths go through the scalar tail only, the long ones through the vector blocks as well
+    TArray<int32> Lengths;
+    for (int32 Length = 0; Length <= 200; ++Length)
+    {
+        Lengths.Add(Length);
+    }
+    Lengths.Add(64 * 1024 + 1);
+
+    for (int32 Length : Lengths)
+    {
+        TArray<uint8> Source;
+        Source.SetNumUninitialized(Length);
+        FRuntimeImageLoaderTests::FillRandom(Source.GetData(), Length, Length);
+
+        const FString Encoded = FBase64::Encode(Source);
+
+        TArray<uint8> Expected;
+        TestTrue(FString::Printf(TEXT("FBase64 decodes %d bytes"), Length), FBase64::Decode(Encoded, Expected));
+
+        TArray<uint8> Decoded;
+        if (!TestTrue(FString::Printf(TEXT("Decode %d bytes"), Length), DecodeAnsi(Encoded, Decoded)))
+        {
+            continue;
+        }
+        TestTrue(FString::Printf(TEXT("%d bytes match FBase64"), Length), Decoded == Expected && Decoded == Source);
+
+        // URL-safe alphabet without padding
+        FString UrlSafe = Encoded.Replace(TEXT("+"), TEXT("-")).Replace(TEXT("/"), TEXT("_"));
+        UrlSafe.RemoveFromEnd(TEXT("="));
+        UrlSafe.RemoveFromEnd(TEXT("="));
+
+        TArray<uint8> DecodedUrlSafe;
+        TestTrue(FString::Printf(TEXT("%d bytes of URL-safe base64 match"), Length), DecodeAnsi(UrlSafe, DecodedUrlSafe) && DecodedUrlSafe == Source);
+    }
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBase64HelpersInvalidTest, "RuntimeImageLoader.Base64.Invalid", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FBase64HelpersInvalidTest::RunTest(const FString& Parameters)
+{
+    TArray<uint8> Decoded;
+    TestFalse(TEXT("Single character tail"), DecodeAnsi(TEXT("QUJDR"), Decoded));
+    TestFalse(TEXT("Character outside of the alphabet"), DecodeAnsi(TEXT("QU*D"), Decoded));
+
+    // invalid character inside of a block the vector decoders handle
+    TArray<uint8> Source;
+    Source.SetNumUninitialized(96);
+    FRuntimeImageLoaderTests::FillRandom(Source.GetData(), Source.Num(), 0);
+
+    FString Long = FBase64::Encode(Source);
+    Long[40] = TEXT('!');
+    TestFalse(TEXT("Character outside of the alphabet in a vector block"), DecodeAnsi(Long, Decoded));
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,201 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "RuntimeImageLoaderTests.h"
+#include "Helpers/BlockCompression.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    using namespace FBlockCompression;
+
+    /** BGRA8 image of smooth gradients in every channel, alpha included */
+    void MakeGradient(int32 SizeX, int32 SizeY, FRuntimeImageData& OutImage)
+    {
+        OutImage.Init(SizeX, SizeY, ERawImageFormat::BGRA8, EGammaSpace::sRGB);
+
+        for (int32 Y = 0; Y < SizeY; ++Y)
+        {
+            for (int32 X = 0; X < SizeX; ++X)
+            {
+                uint8* Pixel = OutImage.RawData.GetData() + ((int64)Y * SizeX + X) * 4;
+                Pixel[0] = (uint8)(X * 255 / (SizeX - 1));
+                Pixel[1] = (uint8)(Y * 255 / (SizeY - 1));
+                Pixel[2] = (uint8)((X + Y) * 255 / (SizeX + SizeY - 2));
+                Pixel[3] = (uint8)(255 - X * 255 / (SizeX - 1));
+            }
+        }
+    }
+
+    /** RGBA16F image of a gradient from black to 4 in every color channel */
+    void MakeHalfGradient(int32 SizeX, int32 SizeY, FRuntimeImageData& OutImage)
+    {
+        OutImage.Init(SizeX, SizeY, ERawImageFormat::RGBA16F, EGammaSpace::Linear);
+
+        FFloat16* Values = reinterpret_cast<FFloat16*>(OutImage.RawData.GetData());
+        for (int32 Y = 0; Y < SizeY; ++Y)
+        {
+            for (int32 X = 0; X < SizeX; ++X)
+            {
+                FFloat16* Pixel = Values + ((int64)Y * SizeX + X) * 4;
+                Pixel[0] = FFloat16(4.0f * X / (SizeX - 1));
+                Pixel[1] = FFloat16(4.0f * Y / (SizeY - 1));
+                Pixel[2] = FFloat16(2.0f * (X + Y) / (SizeX + SizeY - 2));
+                Pixel[3] = FFloat16(1.0f);
+            }
+        }
+    }
+
+    /** Reference BC1 decoder in four color mode, returns PSNR of the RGB channels of mip 0 over whole blocks, as the encoder sums it */
+    double GetDecodedBC1PSNR(const FRuntimeImageData& Image, const TArray64<uint8>& Blocks)
+    {
+        auto DecodeRGB565 = [](uint16 Color, int32 (&OutColor)[3])
+        {
+            const int32 R = (Color >> 11) & 31;
+            const int32 G = (Color >> 5) & 63;
+            const int32 B = Color & 31;
+            OutColor[0] = (R << 3) | (R >> 2);
+            OutColor[1] = (G << 2) | (G >> 4);
+            OutColor[2] = (B << 3) | (B >> 2);
+        };
+
+        const int32 BlocksX = FMath::DivideAndRoundUp(Image.SizeX, 4);
+        const int32 BlocksY = FMath::DivideAndRoundUp(Image.SizeY, 4);
+        double SquaredError = 0.0;
+
+        for (int32 Y = 0; Y < BlocksY * 4; ++Y)
+        {
+            for (int32 X = 0; X < BlocksX * 4; ++X)
+            {
+                const uint8* Block = Blocks.GetData() + ((int64)(Y / 4) * BlocksX + X / 4) * 8;
+                const uint16 Color0 = Block[0] | (Block[1] << 8);
+                const uint16 Color1 = Block[2] | (Block[3] << 8);
+                const uint32 Indices = Block[4] | (Block[5] << 8) | (Block[6] << 16) | ((uint32)Block[7] << 24);
+                const int32 Index = (Indices >> (((Y & 3) * 4 + (X & 3)) * 2)) & 3;
+
+                int32 Endpoints[2][3];
+                DecodeRGB565(Color0, Endpoints[0]);
+                DecodeRGB565(Color1, Endpoints[1]);
+
+                // RGB order, the source pixels are BGRA. Pixels past the edge repeat the edge ones
+                const int32 SourceX = FMath::Min(X, Image.SizeX - 1);
+                const int32 SourceY = FMath::Min(Y, Image.SizeY - 1);
+                const uint8* Source = Image.RawData.GetData() + ((int64)SourceY * Image.SizeX + SourceX) * 4;
+                const int32 SourceColor[3] = { Source[2], Source[1], Source[0] };
+
+                for (int32 C = 0; C < 3; ++C)
+                {
+                    const double Palette[4] =
+                    {
+                        (double)Endpoints[0][C],
+                        (double)Endpoints[1][C],
+                        (2.0 * Endpoints[0][C] + Endpoints[1][C]) / 3.0,
+                        (Endpoints[0][C] + 2.0 * Endpoints[1][C]) / 3.0
+                    };
+                    const double Diff = Palette[Index] - SourceColor[C];
+                    SquaredError += Diff * Diff;
+                }
+            }
+        }
+
+        return 10.0 * FMath::LogX(10.0, 255.0 * 255.0 * BlocksX * BlocksY * 16 * 3 / FMath::Max(SquaredError, 1e-6));
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBlockCompressionPSNRTest, "RuntimeImageLoader.BlockCompression.PSNR", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FBlockCompressionPSNRTest::RunTest(const FString& Parameters)
+{
+    struct FExpectation
+    {
+        EFormat Format;
+        double MinPSNR;
+    };
+
+    // single channel formats store the gradients nearly exactly, the color formats lose a few bits of the endpoints
+    const FExpectation Expectations[] =
+    {
+        { EFormat::BC1, 35.0 },
+        { EFormat::BC3, 35.0 },
+        { EFormat::BC4, 45.0 },
+        { EFormat::BC5, 45.0 },
+        { EFormat::BC7, 35.0 },
+        { EFormat::ETC2_RGB, 35.0 },
+        { EFormat::ETC2_RGBA, 35.0 }
+    };
+
+    FRuntimeImageData Image;
+    MakeGradient(64, 48, Image);
+
+    for (const FExpectation& Expectation : Expectations)
+    {
+        TArray64<uint8> Blocks;
+        FStats Stats;
+        Compress(Image, Expectation.Format, Blocks, Stats);
+
+        const FPixelFormatInfo& FormatInfo = GPixelFormats[GetPixelFormat(Expectation.Format)];
+        TestEqual(FString::Printf(TEXT("%s size"), GetName(Expectation.Format)), Blocks.Num(), (int64)(64 / 4) * (48 / 4) * FormatInfo.BlockBytes);
+        TestTrue(FString::Printf(TEXT("%s PSNR %.2f is at least %.0f"), GetName(Expectation.Format), Stats.PSNR, Expectation.MinPSNR), Stats.PSNR >= Expectation.MinPSNR);
+    }
+
+    // the reported PSNR must be the one of the blocks as a decoder reads them, on a size with partial edge blocks too
+    FRuntimeImageData EdgeImage;
+    MakeGradient(37, 21, EdgeImage);
+
+    for (const FRuntimeImageData* Source : { &Image, &EdgeImage })
+    {
+        TArray64<uint8> Blocks;
+        FStats Stats;
+        Compress(*Source, EFormat::BC1, Blocks, Stats);
+
+        if (!TestEqual(FString::Printf(TEXT("BC1 size of %dx%d"), Source->SizeX, Source->SizeY), Blocks.Num(), (int64)FMath::DivideAndRoundUp(Source->SizeX, 4) * FMath::DivideAndRoundUp(Source->SizeY, 4) * 8))
+        {
+            continue;
+        }
+
+        // the encoder rounds the interpolated colors, decoders may not
+        const double DecodedPSNR = GetDecodedBC1PSNR(*Source, Blocks);
+        TestTrue(FString::Printf(TEXT("Decoded BC1 PSNR %.2f of %dx%d matches the reported %.2f"), DecodedPSNR, Source->SizeX, Source->SizeY, Stats.PSNR), FMath::Abs(DecodedPSNR - Stats.PSNR) < 0.5);
+    }
+
+    // equal endpoints decode exactly
+    FRuntimeImageData Constant;
+    Constant.Init(13, 7, ERawImageFormat::G8, EGammaSpace::Linear);
+    FMemory::Memset(Constant.RawData.GetData(), 77, Constant.RawData.Num());
+
+    TArray64<uint8> Blocks;
+    FStats Stats;
+    Compress(Constant, EFormat::BC4, Blocks, Stats);
+    TestEqual(TEXT("BC4 PSNR of a constant image"), Stats.PSNR, 100.0);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBlockCompressionBC6HPSNRTest, "RuntimeImageLoader.BlockCompression.BC6HPSNR", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FBlockCompressionBC6HPSNRTest::RunTest(const FString& Parameters)
+{
+    // HDR values past 1 with partial edge blocks, the error is measured on the decoded floats
+    FRuntimeImageData Image;
+    MakeHalfGradient(37, 21, Image);
+
+    TArray64<uint8> Blocks;
+    FStats Stats;
+    Compress(Image, EFormat::BC6H, Blocks, Stats);
+
+    TestEqual(TEXT("BC6H size"), Blocks.Num(), (int64)FMath::DivideAndRoundUp(37, 4) * FMath::DivideAndRoundUp(21, 4) * 16);
+    TestTrue(FString::Printf(TEXT("BC6H PSNR %.2f is at least 30"), Stats.PSNR), Stats.PSNR >= 30.0);
+    TestTrue(FString::Printf(TEXT("BC6H PSNR %.2f of a gradient is not lossless"), Stats.PSNR), Stats.PSNR < 100.0);
+
+    // black is the 0 endpoint, the peak of a black image must not divide by 0
+    FRuntimeImageData Black;
+    Black.Init(8, 8, ERawImageFormat::RGBA16F, EGammaSpace::Linear);
+    FMemory::Memzero(Black.RawData.GetData(), Black.RawData.Num());
+
+    Compress(Black, EFormat::BC6H, Blocks, Stats);
+    TestEqual(TEXT("BC6H PSNR of a black image"), Stats.PSNR, 100.0);
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
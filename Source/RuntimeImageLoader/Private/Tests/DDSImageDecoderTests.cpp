@@ -0,0 +1,166 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "RuntimeImageLoaderTests.h"
+#include "ImageDecoders/DDSImageDecoder.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    struct FTestDDS
+    {
+        TArray<uint8> File;
+        // blocks the decoder must return, faces one after another with all of their mips
+        TArray<uint8> Expected;
+    };
+
+    void WriteUInt32(TArray<uint8>& Out, int64 Offset, uint32 Value)
+    {
+        for (int32 Byte = 0; Byte < 4; ++Byte)
+        {
+            Out[Offset + Byte] = (uint8)(Value >> (Byte * 8));
+        }
+    }
+
+    int64 GetBlocksSize(int32 Width, int32 Height, int32 NumMips, int32 BlockBytes)
+    {
+        int64 Size = 0;
+        for (int32 Mip = 0; Mip < NumMips; ++Mip)
+        {
+            Size += (int64)FMath::DivideAndRoundUp(FMath::Max(Width >> Mip, 1), 4) * FMath::DivideAndRoundUp(FMath::Max(Height >> Mip, 1), 4) * BlockBytes;
+        }
+        return Size;
+    }
+
+    /** DDS of random 4x4 blocks with a legacy FourCC header, or a DX10 header if the DXGI format is set */
+    FTestDDS MakeDDS(int32 Width, int32 Height, int32 NumMips, uint32 FourCC, uint32 DXGIFormat, int32 BlockBytes, bool bCubemap = false, uint32 ArraySize = 1)
+    {
+        const int64 HeaderSize = DXGIFormat ? 148 : 128;
+        const int64 DataSize = GetBlocksSize(Width, Height, NumMips, BlockBytes) * (bCubemap ? 6 : 1);
+
+        FTestDDS DDS;
+        DDS.File.SetNumZeroed(HeaderSize + DataSize);
+
+        WriteUInt32(DDS.File, 0, 0x20534444); // "DDS "
+        WriteUInt32(DDS.File, 4, 124);
+        WriteUInt32(DDS.File, 8, 0x00021007); // caps, height, width, pixel format and mip count
+        WriteUInt32(DDS.File, 12, Height);
+        WriteUInt32(DDS.File, 16, Width);
+        WriteUInt32(DDS.File, 28, NumMips);
+        WriteUInt32(DDS.File, 76, 32);
+        WriteUInt32(DDS.File, 80, 0x4); // FourCC
+        WriteUInt32(DDS.File, 84, DXGIFormat ? 0x30315844 : FourCC); // "DX10"
+        WriteUInt32(DDS.File, 112, bCubemap ? 0x0000FE00 : 0);
+
+        if (DXGIFormat)
+        {
+            WriteUInt32(DDS.File, 128, DXGIFormat);
+            WriteUInt32(DDS.File, 132, 3);
+            WriteUInt32(DDS.File, 136, bCubemap ? 0x4 : 0);
+            WriteUInt32(DDS.File, 140, ArraySize);
+        }
+
+        FRuntimeImageLoaderTests::FillRandom(DDS.File.GetData() + HeaderSize, DataSize, Width * 31 + Height + NumMips);
+        DDS.Expected.Append(DDS.File.GetData() + HeaderSize, (int32)DataSize);
+        return DDS;
+    }
+
+    bool Decode(const TArray<uint8>& File, FRuntimeImageData& OutImage, FString& OutError)
+    {
+        return FDDSImageDecoder().Decode(File.GetData(), File.Num(), FImageDecodeParams(), OutImage, OutError);
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDDSImageDecoderMipsTest, "RuntimeImageLoader.DDS.Mips", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FDDSImageDecoderMipsTest::RunTest(const FString& Parameters)
+{
+    // the mips smaller than a block take a whole block each
+    const FTestDDS DDS = MakeDDS(16, 8, 5, 0x31545844, 0, 8); // "DXT1"
+
+    FRuntimeImageData Image;
+    FString Error;
+    if (!TestTrue(TEXT("DXT1 mip chain"), Decode(DDS.File, Image, Error)))
+    {
+        AddError(Error);
+        return false;
+    }
+
+    TestEqual(TEXT("Pixel format"), (int32)Image.PixelFormat, (int32)PF_DXT1);
+    TestEqual(TEXT("Mips"), Image.NumMips, 5);
+    TestEqual(TEXT("Slices"), Image.NumSlices, 1);
+    TestTrue(TEXT("DXT1 is sRGB"), Image.SRGB);
+    TestTrue(TEXT("Blocks are read as they are"), Image.RawData.Num() == DDS.Expected.Num() && FMemory::Memcmp(Image.RawData.GetData(), DDS.Expected.GetData(), DDS.Expected.Num()) == 0);
+
+    // a mip count past the 1x1 mip is clamped to the full chain
+    FTestDDS Clamped = MakeDDS(16, 8, 5, 0x31545844, 0, 8);
+    WriteUInt32(Clamped.File, 28, 12);
+    if (TestTrue(TEXT("Mip count past the chain"), Decode(Clamped.File, Image, Error)))
+    {
+        TestEqual(TEXT("Clamped mips"), Image.NumMips, 5);
+    }
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDDSImageDecoderCubemapTest, "RuntimeImageLoader.DDS.Cubemap", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FDDSImageDecoderCubemapTest::RunTest(const FString& Parameters)
+{
+    // DDS stores the faces one after another with all of their mips, as the RHIs take them
+    for (const bool bDX10 : { false, true })
+    {
+        const FTestDDS DDS = bDX10 ? MakeDDS(8, 8, 2, 0, 98, 16, true) : MakeDDS(8, 8, 2, 0x35545844, 0, 16, true); // BC7 or "DXT5"
+        const TCHAR* What = bDX10 ? TEXT("DX10 BC7 cubemap") : TEXT("DXT5 cubemap");
+
+        FRuntimeImageData Image;
+        FString Error;
+        if (!TestTrue(What, Decode(DDS.File, Image, Error)))
+        {
+            AddError(Error);
+            continue;
+        }
+
+        TestEqual(FString(What) + TEXT(" slices"), Image.NumSlices, 6);
+        TestEqual(FString(What) + TEXT(" mips"), Image.NumMips, 2);
+        TestTrue(FString(What) + TEXT(" faces"), Image.RawData.Num() == DDS.Expected.Num() && FMemory::Memcmp(Image.RawData.GetData(), DDS.Expected.GetData(), DDS.Expected.Num()) == 0);
+    }
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDDSImageDecoderRejectTest, "RuntimeImageLoader.DDS.Reject", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FDDSImageDecoderRejectTest::RunTest(const FString& Parameters)
+{
+    auto TestRejected = [this](const TCHAR* What, const TArray<uint8>& File)
+    {
+        FRuntimeImageData Image;
+        FString Error;
+        TestFalse(What, Decode(File, Image, Error));
+        TestFalse(FString(What) + TEXT(" reports an error"), Error.IsEmpty());
+    };
+
+    FTestDDS Truncated = MakeDDS(16, 16, 3, 0x31545844, 0, 8);
+    Truncated.File.Pop();
+    TestRejected(TEXT("Last block truncated"), Truncated.File);
+
+    TestRejected(TEXT("Header truncated"), TArray<uint8>(MakeDDS(16, 16, 1, 0x31545844, 0, 8).File.GetData(), 100));
+    TestRejected(TEXT("DX10 header truncated"), TArray<uint8>(MakeDDS(16, 16, 1, 0, 71, 8).File.GetData(), 140));
+
+    FTestDDS TruncatedCube = MakeDDS(8, 8, 1, 0, 71, 8, true);
+    TruncatedCube.File.SetNum(TruncatedCube.File.Num() - 8);
+    TestRejected(TEXT("Last face truncated"), TruncatedCube.File);
+
+    TestRejected(TEXT("Partial blocks"), MakeDDS(6, 6, 1, 0x31545844, 0, 8).File);
+    TestRejected(TEXT("Texture array"), MakeDDS(8, 8, 1, 0, 71, 8, false, 2).File);
+    TestRejected(TEXT("Signed BC4"), MakeDDS(8, 8, 1, 0, 81, 8).File);
+    TestRejected(TEXT("Signed BC5"), MakeDDS(8, 8, 1, 0, 84, 16).File);
+    TestRejected(TEXT("Signed BC6H"), MakeDDS(8, 8, 1, 0, 96, 16).File);
+    TestRejected(TEXT("Signed BC4S"), MakeDDS(8, 8, 1, 0x53344342, 0, 8).File); // "BC4S"
+    TestRejected(TEXT("Signed BC5S"), MakeDDS(8, 8, 1, 0x53354342, 0, 16).File); // "BC5S"
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,654 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "RuntimeImageLoaderTests.h"
+#include "ImageReaders/ImageDownloadManager.h"
+#include "Async/Async.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "PlatformHttp.h"
+#include "Misc/Guid.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    class FTestImageServer;
+
+    class FTestImageDownloadResponse : public IImageDownloadResponse
+    {
+    public:
+        virtual int32 GetResponseCode() const override { return ResponseCode; }
+        virtual FString GetHeader(const FString& HeaderName) const override
+        {
+            const FString* Value = Headers.Find(HeaderName);
+            return Value ? *Value : FString();
+        }
+        virtual const TArray<uint8>& GetContent() const override { return Content; }
+        virtual FString GetContentAsString() const override { return FString::Printf(TEXT("%d bytes"), Content.Num()); }
+
+    public:
+        int32 ResponseCode = 0;
+        TMap<FString, FString> Headers;
+        TArray<uint8> Content;
+    };
+
+    /** Request received by the test server */
+    struct FTestRequestRecord
+    {
+        FString Verb;
+        FString URL;
+        FString Range;
+        FString IfRange;
+    };
+
+    /**
+     * Local stand-in for an image server. Each request is answered on its own thread after the injected latency,
+     * completions are delivered one at a time like the HTTP module does on the game thread
+     */
+    class FTestImageServer : public TSharedFromThis<FTestImageServer, ESPMode::ThreadSafe>
+    {
+    public:
+        explicit FTestImageServer(float InLatency)
+            : Latency(InLatency)
+        {}
+
+        /** Serves the body with ranges and the ETag validator, replaces the file of the URL if there is one */
+        void AddFile(const FString& URL, const TArray<uint8>& Body, const FString& ETag = TEXT("\"v1\""))
+        {
+            FScopeLock Lock(&Mutex);
+
+            FFile& File = Files.FindOrAdd(URL);
+            File.Body = Body;
+            File.ETag = ETag;
+        }
+
+        /** Next GET of the URL sends this many bytes of the response and drops the connection */
+        void DropNextResponse(const FString& URL, int64 NumBytesSent)
+        {
+            FScopeLock Lock(&Mutex);
+
+            Files.FindChecked(URL).Drops.Add(NumBytesSent);
+        }
+
+        FCreateImageDownloadRequestFunc GetRequestFactory();
+
+        TArray<FTestRequestRecord> GetRequests() const
+        {
+            FScopeLock Lock(&Mutex);
+            return Requests;
+        }
+
+        int32 GetNumRequests(const FString& URL) const
+        {
+            FScopeLock Lock(&Mutex);
+            return Requests.FilterByPredicate([&URL](const FTestRequestRecord& Request) { return Request.URL == URL; }).Num();
+        }
+
+        int32 GetMaxRequestsInFlight() const
+        {
+            FScopeLock Lock(&Mutex);
+            return MaxRequestsInFlight;
+        }
+
+        int32 GetMaxRequestsInFlightPerHost() const
+        {
+            FScopeLock Lock(&Mutex);
+            return MaxRequestsInFlightPerHost;
+        }
+
+        /** Blocks till every request has been answered and its completion has returned */
+        void WaitForIdle() const
+        {
+            while (NumOutstandingRequests.GetValue() > 0)
+            {
+                FPlatformProcess::Sleep(0.001f);
+            }
+        }
+
+    private:
+        friend class FTestImageDownloadRequest;
+
+        struct FFile
+        {
+            TArray<uint8> Body;
+            FString ETag;
+            // bytes sent by the next GET responses before the connection drops
+            TArray<int64> Drops;
+        };
+
+        void BeginRequest(const FString& Verb, const FString& URL, const TMap<FString, FString>& Headers)
+        {
+            FScopeLock Lock(&Mutex);
+
+            FTestRequestRecord& Request = Requests.AddDefaulted_GetRef();
+            Request.Verb = Verb;
+            Request.URL = URL;
+            Request.Range = Headers.FindRef(TEXT("Range"));
+            Request.IfRange = Headers.FindRef(TEXT("If-Range"));
+
+            NumOutstandingRequests.Increment();
+
+            ++NumRequestsInFlight;
+            MaxRequestsInFlight = FMath::Max(MaxRequestsInFlight, NumRequestsInFlight);
+
+            const int32 NumHostRequests = ++RequestsInFlightPerHost.FindOrAdd(FPlatformHttp::GetUrlDomain(URL));
+            MaxRequestsInFlightPerHost = FMath::Max(MaxRequestsInFlightPerHost, NumHostRequests);
+        }
+
+        FImageDownloadResponsePtr Serve(const FString& Verb, const FString& URL, const TMap<FString, FString>& Headers, bool bCancelled, bool& bOutSucceeded)
+        {
+            FScopeLock Lock(&Mutex);
+
+            // the request is answered, the completion may start the next one
+            --NumRequestsInFlight;
+            --RequestsInFlightPerHost.FindChecked(FPlatformHttp::GetUrlDomain(URL));
+
+            TSharedRef<FTestImageDownloadResponse, ESPMode::ThreadSafe> Response = MakeShared<FTestImageDownloadResponse, ESPMode::ThreadSafe>();
+            bOutSucceeded = !bCancelled;
+
+            FFile* File = Files.Find(URL);
+            if (!File)
+            {
+                Response->ResponseCode = 404;
+                return Response;
+            }
+
+            const int64 TotalSize = File->Body.Num();
+            Response->Headers.Add(TEXT("ETag"), File->ETag);
+            Response->Headers.Add(TEXT("Accept-Ranges"), TEXT("bytes"));
+
+            if (Verb == TEXT("HEAD"))
+            {
+                Response->ResponseCode = 200;
+                Response->Headers.Add(TEXT("Content-Length"), LexToString(TotalSize));
+                return Response;
+            }
+
+            // range is ignored if the file has changed since the validator was received
+            int64 RangeStart = 0;
+            int64 RangeEnd = TotalSize - 1;
+            const FString* Range = Headers.Find(TEXT("Range"));
+            const FString* IfRange = Headers.Find(TEXT("If-Range"));
+            const bool bPartial = Range && (!IfRange || *IfRange == File->ETag);
+            if (bPartial)
+            {
+                FString RangeStartString;
+                FString RangeEndString;
+                Range->Mid(6).Split(TEXT("-"), &RangeStartString, &RangeEndString);
+
+                RangeStart = FCString::Atoi64(*RangeStartString);
+                if (!RangeEndString.IsEmpty())
+                {
+                    RangeEnd = FMath::Min(FCString::Atoi64(*RangeEndString), TotalSize - 1);
+                }
+
+                if (RangeStart > RangeEnd)
+                {
+                    Response->ResponseCode = 416;
+                    Response->Headers.Add(TEXT("Content-Range"), FString::Printf(TEXT("bytes */%lld"), TotalSize));
+                    return Response;
+                }
+
+                Response->Headers.Add(TEXT("Content-Range"), FString::Printf(TEXT("bytes %lld-%lld/%lld"), RangeStart, RangeEnd, TotalSize));
+            }
+
+            Response->ResponseCode = bPartial ? 206 : 200;
+            Response->Headers.Add(TEXT("Content-Length"), LexToString(RangeEnd - RangeStart + 1));
+
+            int64 NumBytesSent = RangeEnd - RangeStart + 1;
+            if (File->Drops.Num() > 0)
+            {
+                NumBytesSent = FMath::Min(NumBytesSent, File->Drops[0]);
+                File->Drops.RemoveAt(0);
+                bOutSucceeded = false;
+            }
+            Response->Content.Append(File->Body.GetData() + RangeStart, (int32)NumBytesSent);
+
+            return Response;
+        }
+
+        void EndRequest()
+        {
+            NumOutstandingRequests.Decrement();
+        }
+
+    private:
+        float Latency;
+
+        mutable FCriticalSection Mutex;
+        TMap<FString, FFile> Files;
+        TArray<FTestRequestRecord> Requests;
+
+        int32 NumRequestsInFlight = 0;
+        int32 MaxRequestsInFlight = 0;
+        TMap<FString, int32> RequestsInFlightPerHost;
+        int32 MaxRequestsInFlightPerHost = 0;
+
+        FThreadSafeCounter NumOutstandingRequests;
+        FCriticalSection CompletionMutex;
+    };
+
+    class FTestImageDownloadRequest : public IImageDownloadRequest, public TSharedFromThis<FTestImageDownloadRequest, ESPMode::ThreadSafe>
+    {
+    public:
+        explicit FTestImageDownloadRequest(const TSharedRef<FTestImageServer, ESPMode::ThreadSafe>& InServer)
+            : Server(InServer)
+        {}
+
+        virtual void SetURL(const FString& InURL) override { URL = InURL; }
+        virtual void SetVerb(const FString& InVerb) override { Verb = InVerb; }
+        virtual void SetHeader(const FString& HeaderName, const FString& HeaderValue) override { Headers.Add(HeaderName, HeaderValue); }
+        virtual void SetTimeout(float InTimeoutSecs) override {}
+
+        virtual bool ProcessRequest() override
+        {
+            Server->BeginRequest(Verb, URL, Headers);
+
+            Async(EAsyncExecution::Thread, [This = AsShared()]()
+            {
+                FPlatformProcess::Sleep(This->Server->Latency);
+
+                bool bSucceeded = false;
+                FImageDownloadResponsePtr Response = This->Server->Serve(This->Verb, This->URL, This->Headers, This->bCancelled, bSucceeded);
+                {
+                    FScopeLock CompletionLock(&This->Server->CompletionMutex);
+                    This->OnComplete.ExecuteIfBound(Response, bSucceeded);
+                }
+                This->Server->EndRequest();
+            });
+            return true;
+        }
+
+        virtual void CancelRequest() override { bCancelled = true; }
+
+        virtual FOnImageDownloadRequestComplete& OnProcessRequestComplete() override { return OnComplete; }
+
+    private:
+        TSharedRef<FTestImageServer, ESPMode::ThreadSafe> Server;
+        FString URL;
+        FString Verb = TEXT("GET");
+        TMap<FString, FString> Headers;
+        FThreadSafeBool bCancelled = false;
+        FOnImageDownloadRequestComplete OnComplete;
+    };
+
+    FCreateImageDownloadRequestFunc FTestImageServer::GetRequestFactory()
+    {
+        TSharedRef<FTestImageServer, ESPMode::ThreadSafe> This = AsShared();
+        return [This]() -> FImageDownloadRequestPtr
+        {
+            return MakeShared<FTestImageDownloadRequest, ESPMode::ThreadSafe>(This);
+        };
+    }
+
+    /** URL no other run has downloaded, so there is no resume state of it */
+    FString MakeTestURL(const TCHAR* Host)
+    {
+        return FString::Printf(TEXT("http://%s/%s.png"), Host, *FGuid::NewGuid().ToString());
+    }
+
+    TArray<uint8> MakeTestBody(int32 Size, int32 Seed)
+    {
+        TArray<uint8> Body;
+        Body.SetNumUninitialized(Size);
+        FRuntimeImageLoaderTests::FillRandom(Body.GetData(), Body.Num(), Seed);
+        return Body;
+    }
+
+    /** Download that fails on every attempt after receiving a part of the body, leaving its resume state behind */
+    bool InterruptDownload(FAutomationTestBase& Test, const TSharedRef<FTestImageServer, ESPMode::ThreadSafe>& Server, const FString& URL)
+    {
+        // initial request and two retries, each of them resumes from where the previous one dropped
+        Server->DropNextResponse(URL, 100000);
+        Server->DropNextResponse(URL, 50000);
+        Server->DropNextResponse(URL, 50000);
+
+        FImageDownloadManager Manager;
+        Manager.SetRequestFactory(Server->GetRequestFactory());
+
+        FImageDownloadRef Download = Manager.Acquire(URL);
+        const bool bFailed = Test.TestFalse(TEXT("Interrupted download failed"), Download->WaitForResult());
+
+        const TArray<FTestRequestRecord> Requests = Server->GetRequests();
+        const bool bResumed = Test.TestEqual(TEXT("Requests of the interrupted download"), Requests.Num(), 3)
+            && Test.TestEqual(TEXT("Retry resumes from the received bytes"), Requests[1].Range, FString(TEXT("bytes=100000-")))
+            && Test.TestEqual(TEXT("Retry is conditional on the validator"), Requests[1].IfRange, FString(TEXT("\"v1\"")))
+            && Test.TestEqual(TEXT("Second retry resumes from the received bytes"), Requests[2].Range, FString(TEXT("bytes=150000-")));
+
+        // the manager waits for the partial body to be written
+        Server->WaitForIdle();
+        return bFailed && bResumed;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FImageDownloadManagerContentRangeTest, "RuntimeImageLoader.Download.ContentRange", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FImageDownloadManagerContentRangeTest::RunTest(const FString& Parameters)
+{
+    struct FCase
+    {
+        const TCHAR* ContentRange;
+        int64 Start;
+        int64 Total;
+    };
+
+    const FCase Cases[] =
+    {
+        { TEXT("bytes 100-199/1000"), 100, 1000 },
+        { TEXT("  bytes 0-0/1 "), 0, 1 },
+        { TEXT("bytes 4294967296-4294967395/8589934592"), 4294967296LL, 8589934592LL },
+        // unknown total size
+        { TEXT("bytes 5-9/*"), 5, INDEX_NONE },
+        // unsatisfiable range
+        { TEXT("bytes */1000"), INDEX_NONE, 1000 },
+        { TEXT("items 0-9/10"), INDEX_NONE, 10 },
+        { TEXT(""), INDEX_NONE, INDEX_NONE }
+    };
+
+    for (const FCase& Case : Cases)
+    {
+        TestEqual(FString::Printf(TEXT("Start of '%s'"), Case.ContentRange), FImageDownloadManager::ParseContentRangeStart(Case.ContentRange), Case.Start);
+        TestEqual(FString::Printf(TEXT("Total of '%s'"), Case.ContentRange), FImageDownloadManager::ParseContentRangeTotal(Case.ContentRange), Case.Total);
+    }
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FImageDownloadManagerLatencyTest, "RuntimeImageLoader.Download.Latency", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FImageDownloadManagerLatencyTest::RunTest(const FString& Parameters)
+{
+    const float Latency = 0.2f;
+    const int32 NumFiles = 8;
+
+    TSharedRef<FTestImageServer, ESPMode::ThreadSafe> Server = MakeShared<FTestImageServer, ESPMode::ThreadSafe>(Latency);
+    FImageDownloadManager Manager;
+    Manager.SetRequestFactory(Server->GetRequestFactory());
+    Manager.SetConcurrencyLimits(4, 2);
+
+    TArray<FString> URLs;
+    for (int32 Index = 0; Index < NumFiles; ++Index)
+    {
+        URLs.Add(MakeTestURL((Index % 2) ? TEXT("a.test") : TEXT("b.test")));
+        Server->AddFile(URLs.Last(), MakeTestBody(1000 + Index, Index));
+    }
+
+    const double StartTime = FPlatformTime::Seconds();
+
+    for (const FString& URL : URLs)
+    {
+        Manager.Prefetch(URL);
+    }
+
+    for (int32 Index = 0; Index < NumFiles; ++Index)
+    {
+        FImageDownloadRef Download = Manager.Acquire(URLs[Index]);
+        TestTrue(FString::Printf(TEXT("Download %d succeeded"), Index), Download->WaitForResult());
+        TestTrue(FString::Printf(TEXT("Body %d matches"), Index), Download->TakeContent() == MakeTestBody(1000 + Index, Index));
+    }
+
+    // two rounds of four downloads
+    const double Elapsed = FPlatformTime::Seconds() - StartTime;
+    TestTrue(FString::Printf(TEXT("%d downloads took %.2fs, well below %.2fs of downloading them one by one"), NumFiles, Elapsed, NumFiles * Latency), Elapsed < NumFiles * Latency / 2);
+
+    TestEqual(TEXT("Downloads in flight"), Server->GetMaxRequestsInFlight(), 4);
+    TestEqual(TEXT("Downloads in flight per host"), Server->GetMaxRequestsInFlightPerHost(), 2);
+
+    Server->WaitForIdle();
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FImageDownloadManagerSharedURLTest, "RuntimeImageLoader.Download.SharedURL", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FImageDownloadManagerSharedURLTest::RunTest(const FString& Parameters)
+{
+    TSharedRef<FTestImageServer, ESPMode::ThreadSafe> Server = MakeShared<FTestImageServer, ESPMode::ThreadSafe>(0.1f);
+    FImageDownloadManager Manager;
+    Manager.SetRequestFactory(Server->GetRequestFactory());
+
+    const TArray<uint8> Body = MakeTestBody(4096, 1);
+
+    // image queued several times
+    const FString PrefetchedURL = MakeTestURL(TEXT("a.test"));
+    Server->AddFile(PrefetchedURL, Body);
+
+    for (int32 Index = 0; Index < 3; ++Index)
+    {
+        Manager.Prefetch(PrefetchedURL);
+    }
+    for (int32 Index = 0; Index < 3; ++Index)
+    {
+        FImageDownloadRef Download = Manager.Acquire(PrefetchedURL);
+        TestTrue(TEXT("Prefetched download succeeded"), Download->WaitForResult());
+        TestTrue(TEXT("Every reader of the prefetched download gets the body"), Download->TakeContent() == Body);
+    }
+    TestEqual(TEXT("Requests of the prefetched URL"), Server->GetNumRequests(PrefetchedURL), 1);
+
+    // readers of an image that is being downloaded, one of them gives up
+    const FString AcquiredURL = MakeTestURL(TEXT("a.test"));
+    Server->AddFile(AcquiredURL, Body);
+
+    FImageDownloadRef FirstDownload = Manager.Acquire(AcquiredURL);
+    FImageDownloadRef SecondDownload = Manager.Acquire(AcquiredURL);
+    Manager.Prefetch(AcquiredURL);
+    FImageDownloadRef ThirdDownload = Manager.Acquire(AcquiredURL);
+    TestTrue(TEXT("Readers share the download in flight"), FirstDownload == SecondDownload && SecondDownload == ThirdDownload);
+
+    Manager.Cancel(FirstDownload);
+    TestTrue(TEXT("Shared download survives cancellation by one reader"), SecondDownload->WaitForResult());
+    TestTrue(TEXT("Second reader gets the body"), SecondDownload->TakeContent() == Body);
+    TestTrue(TEXT("Third reader gets the body"), ThirdDownload->TakeContent() == Body);
+    TestEqual(TEXT("Requests of the acquired URL"), Server->GetNumRequests(AcquiredURL), 1);
+
+    Server->WaitForIdle();
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FImageDownloadManagerPrefetchLimitsTest, "RuntimeImageLoader.Download.PrefetchLimits", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FImageDownloadManagerPrefetchLimitsTest::RunTest(const FString& Parameters)
+{
+    TSharedRef<FTestImageServer, ESPMode::ThreadSafe> Server = MakeShared<FTestImageServer, ESPMode::ThreadSafe>(0.05f);
+    FImageDownloadManager Manager;
+    Manager.SetRequestFactory(Server->GetRequestFactory());
+
+    auto AddFiles = [&Server](int32 NumFiles)
+    {
+        TArray<FString> URLs;
+        for (int32 Index = 0; Index < NumFiles; ++Index)
+        {
+            URLs.Add(MakeTestURL(TEXT("a.test")));
+            Server->AddFile(URLs.Last(), MakeTestBody(100, Index));
+        }
+        return URLs;
+    };
+
+    auto ReadAll = [this, &Manager](const TArray<FString>& URLs)
+    {
+        for (int32 Index = 0; Index < URLs.Num(); ++Index)
+        {
+            FImageDownloadRef Download = Manager.Acquire(URLs[Index]);
+            TestTrue(TEXT("Download succeeded"), Download->WaitForResult());
+            TestTrue(TEXT("Body matches"), Download->TakeContent() == MakeTestBody(100, Index));
+        }
+    };
+
+    // prefetches beyond the count are left to the reader
+    {
+        Manager.SetPrefetchLimits(2, MAX_int64);
+
+        const TArray<FString> URLs = AddFiles(4);
+        for (const FString& URL : URLs)
+        {
+            Manager.Prefetch(URL);
+        }
+        TestEqual(TEXT("Prefetched downloads within the count limit"), Server->GetRequests().Num(), 2);
+
+        ReadAll(URLs);
+        TestEqual(TEXT("Downloads of the readers"), Server->GetRequests().Num(), 4);
+        Server->WaitForIdle();
+    }
+
+    // completed bodies nobody has read hold the next prefetches back, acquired images are downloaded anyway
+    {
+        Manager.SetPrefetchLimits(32, 1);
+        Manager.SetConcurrencyLimits(1, 1);
+
+        const int32 NumRequests = Server->GetRequests().Num();
+        const TArray<FString> URLs = AddFiles(3);
+        for (const FString& URL : URLs)
+        {
+            Manager.Prefetch(URL);
+        }
+
+        Server->WaitForIdle();
+        TestEqual(TEXT("Prefetched downloads within the memory limit"), Server->GetRequests().Num() - NumRequests, 1);
+
+        FImageDownloadRef Acquired = Manager.Acquire(URLs[2]);
+        TestTrue(TEXT("Acquired download beyond the memory limit succeeded"), Acquired->WaitForResult());
+        Server->WaitForIdle();
+        TestEqual(TEXT("Requests after acquiring beyond the memory limit"), Server->GetRequests().Num() - NumRequests, 2);
+
+        ReadAll({ URLs[0], URLs[1] });
+        TestEqual(TEXT("Requests after reading the held bodies"), Server->GetRequests().Num() - NumRequests, 3);
+        Server->WaitForIdle();
+    }
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FImageDownloadManagerResumeTest, "RuntimeImageLoader.Download.Resume", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FImageDownloadManagerResumeTest::RunTest(const FString& Parameters)
+{
+    TSharedRef<FTestImageServer, ESPMode::ThreadSafe> Server = MakeShared<FTestImageServer, ESPMode::ThreadSafe>(0.01f);
+
+    const FString URL = MakeTestURL(TEXT("a.test"));
+    const TArray<uint8> Body = MakeTestBody(300000, 1);
+    Server->AddFile(URL, Body);
+
+    if (!InterruptDownload(*this, Server, URL))
+    {
+        return true;
+    }
+
+    // next run of the application picks up the persisted partial body
+    FImageDownloadManager Manager;
+    Manager.SetRequestFactory(Server->GetRequestFactory());
+
+    FImageDownloadRef Download = Manager.Acquire(URL);
+    TestTrue(TEXT("Resumed download succeeded"), Download->WaitForResult());
+    TestTrue(TEXT("Resumed body matches"), Download->TakeContent() == Body);
+
+    const TArray<FTestRequestRecord> Requests = Server->GetRequests();
+    if (TestEqual(TEXT("Requests of the resumed download"), Requests.Num(), 4))
+    {
+        TestEqual(TEXT("Resumed from the persisted bytes"), Requests[3].Range, FString(TEXT("bytes=200000-")));
+        TestEqual(TEXT("Resumed conditionally on the persisted validator"), Requests[3].IfRange, FString(TEXT("\"v1\"")));
+    }
+
+    Server->WaitForIdle();
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FImageDownloadManagerChangedFileTest, "RuntimeImageLoader.Download.ChangedFile", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FImageDownloadManagerChangedFileTest::RunTest(const FString& Parameters)
+{
+    TSharedRef<FTestImageServer, ESPMode::ThreadSafe> Server = MakeShared<FTestImageServer, ESPMode::ThreadSafe>(0.01f);
+
+    const FString URL = MakeTestURL(TEXT("a.test"));
+    Server->AddFile(URL, MakeTestBody(300000, 1));
+
+    if (!InterruptDownload(*this, Server, URL))
+    {
+        return true;
+    }
+
+    // file has changed on the server, If-Range doesn't match and the whole new file is sent
+    const TArray<uint8> ChangedBody = MakeTestBody(250000, 2);
+    Server->AddFile(URL, ChangedBody, TEXT("\"v2\""));
+
+    {
+        FImageDownloadManager Manager;
+        Manager.SetRequestFactory(Server->GetRequestFactory());
+
+        FImageDownloadRef Download = Manager.Acquire(URL);
+        TestTrue(TEXT("Download of the changed file succeeded"), Download->WaitForResult());
+        TestTrue(TEXT("Body is the changed file, not the stale partial body with the rest of the new one"), Download->TakeContent() == ChangedBody);
+
+        const TArray<FTestRequestRecord> Requests = Server->GetRequests();
+        TestEqual(TEXT("Requests of the changed file"), Requests.Num(), 4);
+        Server->WaitForIdle();
+    }
+
+    // stale resume state has been deleted
+    {
+        FImageDownloadManager Manager;
+        Manager.SetRequestFactory(Server->GetRequestFactory());
+
+        FImageDownloadRef Download = Manager.Acquire(URL);
+        TestTrue(TEXT("Download after the changed file succeeded"), Download->WaitForResult());
+
+        const TArray<FTestRequestRecord> Requests = Server->GetRequests();
+        TestTrue(TEXT("Download after the changed file starts from scratch"), Requests.Last().Range.IsEmpty());
+        Server->WaitForIdle();
+    }
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FImageDownloadManagerChunksTest, "RuntimeImageLoader.Download.Chunks", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FImageDownloadManagerChunksTest::RunTest(const FString& Parameters)
+{
+    TSharedRef<FTestImageServer, ESPMode::ThreadSafe> Server = MakeShared<FTestImageServer, ESPMode::ThreadSafe>(0.01f);
+    FImageDownloadManager Manager;
+    Manager.SetRequestFactory(Server->GetRequestFactory());
+
+    // large file is split into ranged chunks, one of them drops and is resumed
+    {
+        const FString URL = MakeTestURL(TEXT("a.test"));
+        const TArray<uint8> Body = MakeTestBody(40 * 1024 * 1024, 1);
+        Server->AddFile(URL, Body);
+        Server->DropNextResponse(URL, 1024 * 1024);
+
+        Manager.Prefetch(URL, true);
+        FImageDownloadRef Download = Manager.Acquire(URL);
+        TestTrue(TEXT("Chunked download succeeded"), Download->WaitForResult());
+        TestTrue(TEXT("Chunks are reassembled in order"), Download->TakeContent() == Body);
+
+        const TArray<FTestRequestRecord> Requests = Server->GetRequests().FilterByPredicate([&URL](const FTestRequestRecord& Request) { return Request.URL == URL; });
+        if (TestEqual(TEXT("Probe, two chunks and the resumed one"), Requests.Num(), 4))
+        {
+            TestEqual(TEXT("Size is probed first"), Requests[0].Verb, FString(TEXT("HEAD")));
+            TestEqual(TEXT("Resumed chunk is conditional on the validator"), Requests[3].IfRange, FString(TEXT("\"v1\"")));
+
+            for (int32 Index = 1; Index < Requests.Num(); ++Index)
+            {
+                TestTrue(TEXT("Chunks are ranged"), Requests[Index].Range.StartsWith(TEXT("bytes=")));
+            }
+        }
+        Server->WaitForIdle();
+    }
+
+    // previewed file gets its leading range ahead of the rest
+    {
+        const FString URL = MakeTestURL(TEXT("a.test"));
+        const TArray<uint8> Body = MakeTestBody(256 * 1024, 2);
+        Server->AddFile(URL, Body);
+
+        FImageDownloadRef Download = Manager.Acquire(URL, true);
+        if (TestTrue(TEXT("Prefix is ready"), Download->WaitForPrefix()))
+        {
+            TestTrue(TEXT("Prefix is the leading range of the file"), Download->Prefix.Num() >= 64 * 1024 && FMemory::Memcmp(Download->Prefix.GetData(), Body.GetData(), Download->Prefix.Num()) == 0);
+        }
+        TestTrue(TEXT("Previewed download succeeded"), Download->WaitForResult());
+        TestTrue(TEXT("Prefix and the rest are reassembled"), Download->TakeContent() == Body);
+        Server->WaitForIdle();
+    }
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
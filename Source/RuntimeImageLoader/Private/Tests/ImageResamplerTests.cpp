@@ -0,0 +1,510 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "RuntimeImageLoaderTests.h"
+#include "Helpers/ImageResampler.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    const FImageResampler::EFilter AllFilters[] =
+    {
+        FImageResampler::EFilter::Box,
+        FImageResampler::EFilter::Bilinear,
+        FImageResampler::EFilter::Bicubic,
+        FImageResampler::EFilter::Lanczos3,
+        FImageResampler::EFilter::Kaiser
+    };
+
+    /** Largest difference of the channels from the color over the pixels */
+    float GetMaxError(const FLinearColor* Pixels, int64 NumPixels, const FLinearColor& Color)
+    {
+        float MaxError = 0.0f;
+        for (int64 Index = 0; Index < NumPixels; ++Index)
+        {
+            const FLinearColor& Pixel = Pixels[Index];
+            MaxError = FMath::Max(MaxError, FMath::Abs(Pixel.R - Color.R));
+            MaxError = FMath::Max(MaxError, FMath::Abs(Pixel.G - Color.G));
+            MaxError = FMath::Max(MaxError, FMath::Abs(Pixel.B - Color.B));
+            MaxError = FMath::Max(MaxError, FMath::Abs(Pixel.A - Color.A));
+        }
+        return MaxError;
+    }
+
+    /** Channels may be off by one, the filter weights only sum to one within float precision */
+    bool IsNearlyEqual(const FColor& A, const FColor& B)
+    {
+        return FMath::Abs(A.R - B.R) <= 1 && FMath::Abs(A.G - B.G) <= 1 && FMath::Abs(A.B - B.B) <= 1 && FMath::Abs(A.A - B.A) <= 1;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FImageResamplerConstantTest, "RuntimeImageLoader.Resampler.Constant", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FImageResamplerConstantTest::RunTest(const FString& Parameters)
+{
+    const FLinearColor Color(0.25f, 0.5f, 0.75f, 0.125f);
+    const FIntPoint DestSizes[] = { { 13, 51 }, { 1, 1 }, { 37, 23 }, { 100, 7 } };
+
+    FImage Source(37, 23, ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+    for (FLinearColor& Pixel : Source.AsRGBA32F())
+    {
+        Pixel = Color;
+    }
+
+    // normalized weights keep a constant image constant, whatever the filter and scale
+    for (FImageResampler::EFilter Filter : AllFilters)
+    {
+        for (const FIntPoint& DestSize : DestSizes)
+        {
+            FImage Dest(DestSize.X, DestSize.Y, ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+            FImageResampler::Resize(Source, Dest, Filter);
+
+            TestTrue(FString::Printf(TEXT("Filter %d to %dx%d stays constant"), (int32)Filter, DestSize.X, DestSize.Y), GetMaxError(Dest.AsRGBA32F().GetData(), Dest.AsRGBA32F().Num(), Color) < 1e-5f);
+        }
+    }
+
+    // sRGB pixels are filtered in linear space and must round trip to the same 8-bit values
+    FImage Source8(37, 23, ERawImageFormat::BGRA8, EGammaSpace::sRGB);
+    for (FColor& Pixel : Source8.AsBGRA8())
+    {
+        Pixel = FColor(10, 128, 250, 77);
+    }
+
+    for (FImageResampler::EFilter Filter : AllFilters)
+    {
+        FImage Dest8(16, 40, ERawImageFormat::BGRA8, EGammaSpace::sRGB);
+        FImageResampler::Resize(Source8, Dest8, Filter);
+
+        bool bConstant = true;
+        for (const FColor& Pixel : Dest8.AsBGRA8())
+        {
+            bConstant &= IsNearlyEqual(Pixel, FColor(10, 128, 250, 77));
+        }
+        TestTrue(FString::Printf(TEXT("Filter %d keeps sRGB pixels"), (int32)Filter), bConstant);
+    }
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FImageResamplerDownscaleTest, "RuntimeImageLoader.Resampler.Downscale", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FImageResamplerDownscaleTest::RunTest(const FString& Parameters)
+{
+    const int32 SizeX = 64;
+    const int32 SizeY = 38;
+
+    FImage Source(SizeX, SizeY, ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+    TArrayView64<FLinearColor> SourcePixels = Source.AsRGBA32F();
+
+    // box filter at half size is the plain 2x2 average
+    {
+        TArray<uint8> Random;
+        Random.SetNumUninitialized(SourcePixels.Num() * 4);
+        FRuntimeImageLoaderTests::FillRandom(Random.GetData(), Random.Num(), 43);
+        for (int64 Index = 0; Index < SourcePixels.Num(); ++Index)
+        {
+            SourcePixels[Index] = FLinearColor(Random[Index * 4] / 255.0f, Random[Index * 4 + 1] / 255.0f, Random[Index * 4 + 2] / 255.0f, Random[Index * 4 + 3] / 255.0f);
+        }
+
+        FImage Dest(SizeX / 2, SizeY / 2, ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+        FImageResampler::Resize(Source, Dest, FImageResampler::EFilter::Box);
+        TArrayView64<FLinearColor> DestPixels = Dest.AsRGBA32F();
+
+        float MaxError = 0.0f;
+        for (int32 Y = 0; Y < Dest.SizeY; ++Y)
+        {
+            for (int32 X = 0; X < Dest.SizeX; ++X)
+            {
+                const FLinearColor Average = (SourcePixels[(Y * 2) * SizeX + X * 2] + SourcePixels[(Y * 2) * SizeX + X * 2 + 1]
+                    + SourcePixels[(Y * 2 + 1) * SizeX + X * 2] + SourcePixels[(Y * 2 + 1) * SizeX + X * 2 + 1]) * 0.25f;
+                MaxError = FMath::Max(MaxError, GetMaxError(&DestPixels[Y * Dest.SizeX + X], 1, Average));
+            }
+        }
+        TestTrue(FString::Printf(TEXT("Box downscale matches the 2x2 average (max error %f)"), MaxError), MaxError < 1e-5f);
+    }
+
+    // symmetric taps reproduce a linear ramp exactly, away from the edges where the taps are clamped
+    {
+        for (int32 Y = 0; Y < SizeY; ++Y)
+        {
+            for (int32 X = 0; X < SizeX; ++X)
+            {
+                const float Value = (X + 0.5f) / SizeX;
+                SourcePixels[Y * SizeX + X] = FLinearColor(Value, 1.0f - Value, Value * 0.5f, 1.0f);
+            }
+        }
+
+        for (FImageResampler::EFilter Filter : AllFilters)
+        {
+            FImage Dest(SizeX / 2, SizeY / 2, ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+            FImageResampler::Resize(Source, Dest, Filter);
+            TArrayView64<FLinearColor> DestPixels = Dest.AsRGBA32F();
+
+            // widest kernel is Lanczos3, 3 destination pixels at half size
+            const int32 Margin = 3;
+            float MaxError = 0.0f;
+            for (int32 Y = 0; Y < Dest.SizeY; ++Y)
+            {
+                for (int32 X = Margin; X < Dest.SizeX - Margin; ++X)
+                {
+                    const float Value = (X + 0.5f) / Dest.SizeX;
+                    MaxError = FMath::Max(MaxError, GetMaxError(&DestPixels[Y * Dest.SizeX + X], 1, FLinearColor(Value, 1.0f - Value, Value * 0.5f, 1.0f)));
+                }
+            }
+            TestTrue(FString::Printf(TEXT("Filter %d keeps the ramp (max error %f)"), (int32)Filter, MaxError), MaxError < 1e-4f);
+        }
+    }
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FImageResamplerGray16Test, "RuntimeImageLoader.Resampler.Gray16", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FImageResamplerGray16Test::RunTest(const FString& Parameters)
+{
+    // 16-bit grayscale is filtered with its full precision and stays one channel
+    FImage Source(40, 40, ERawImageFormat::G16, EGammaSpace::Linear);
+    TArrayView64<uint16> Values = Source.AsG16();
+    for (int32 Y = 0; Y < Source.SizeY; ++Y)
+    {
+        for (int32 X = 0; X < Source.SizeX; ++X)
+        {
+            Values[Y * Source.SizeX + X] = (uint16)(X * 1000 + Y * 37);
+        }
+    }
+
+    // a 2x box average of a ramp is the ramp at the centers of the 2x2 blocks
+    FImage Dest(20, 20, ERawImageFormat::G16, EGammaSpace::Linear);
+    FImageResampler::Resize(Source, Dest, FImageResampler::EFilter::Box);
+
+    bool bAveraged = true;
+    for (int32 Y = 0; Y < Dest.SizeY; ++Y)
+    {
+        for (int32 X = 0; X < Dest.SizeX; ++X)
+        {
+            const float Expected = X * 2000 + 500 + Y * 74 + 18.5f;
+            bAveraged &= FMath::Abs(Dest.AsG16()[Y * Dest.SizeX + X] - Expected) <= 1.0f;
+        }
+    }
+    TestTrue(TEXT("G16 box average"), bAveraged);
+
+    // grayscale is expanded to color when it's encoded, linear values become sRGB
+    FImage Constant(9, 9, ERawImageFormat::G16, EGammaSpace::Linear);
+    for (uint16& Value : Constant.AsG16())
+    {
+        Value = 12345;
+    }
+
+    FImage Color(4, 4, ERawImageFormat::BGRA8, EGammaSpace::sRGB);
+    FImageResampler::Resize(Constant, Color, FImageResampler::EFilter::Bilinear);
+
+    const FColor Expected = FLinearColor(12345 / 65535.0f, 12345 / 65535.0f, 12345 / 65535.0f, 1.0f).ToFColor(true);
+    bool bExpanded = true;
+    for (const FColor& Pixel : Color.AsBGRA8())
+    {
+        bExpanded &= IsNearlyEqual(Pixel, Expected);
+    }
+    TestTrue(TEXT("G16 expanded to sRGB BGRA8"), bExpanded);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FImageResamplerFusedConversionTest, "RuntimeImageLoader.Resampler.FusedConversion", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FImageResamplerFusedConversionTest::RunTest(const FString& Parameters)
+{
+    // rows are resized and encoded to the UI format in one pass, the result is the same as converting the resized image
+    const FLinearColor Color(0.2f, 0.4f, 0.6f, 0.8f);
+    const FColor Expected = Color.ToFColor(true);
+
+    FImage Source32F(33, 27, ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+    for (FLinearColor& Pixel : Source32F.AsRGBA32F())
+    {
+        Pixel = Color;
+    }
+
+    FImage Source16F(33, 27, ERawImageFormat::RGBA16F, EGammaSpace::Linear);
+    for (FFloat16Color& Pixel : Source16F.AsRGBA16F())
+    {
+        Pixel = FFloat16Color(Color);
+    }
+
+    FImage Source16(33, 27, ERawImageFormat::RGBA16, EGammaSpace::Linear);
+    TArrayView64<uint16> Values16 = Source16.AsRGBA16();
+    for (int64 Index = 0; Index < Values16.Num(); Index += 4)
+    {
+        Values16[Index + 0] = (uint16)FMath::RoundToInt(Color.R * 65535.0f);
+        Values16[Index + 1] = (uint16)FMath::RoundToInt(Color.G * 65535.0f);
+        Values16[Index + 2] = (uint16)FMath::RoundToInt(Color.B * 65535.0f);
+        Values16[Index + 3] = (uint16)FMath::RoundToInt(Color.A * 65535.0f);
+    }
+
+    const FImage* Sources[] = { &Source32F, &Source16F, &Source16 };
+    for (const FImage* Source : Sources)
+    {
+        FImage Dest(12, 40, ERawImageFormat::BGRA8, EGammaSpace::sRGB);
+        FImageResampler::Resize(*Source, Dest, FImageResampler::EFilter::Bilinear);
+
+        bool bEncoded = true;
+        for (const FColor& Pixel : Dest.AsBGRA8())
+        {
+            bEncoded &= IsNearlyEqual(Pixel, Expected);
+        }
+        TestTrue(FString::Printf(TEXT("Format %d resized to sRGB BGRA8"), (int32)Source->Format), bEncoded);
+    }
+
+    // destination rows span several bands, each row is the box average of its source rows
+    FImage Ramp(64, 2048, ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+    TArrayView64<FLinearColor> RampPixels = Ramp.AsRGBA32F();
+    for (int32 Y = 0; Y < Ramp.SizeY; ++Y)
+    {
+        const float Value = Y / 2047.0f;
+        for (int32 X = 0; X < Ramp.SizeX; ++X)
+        {
+            RampPixels[(int64)Y * Ramp.SizeX + X] = FLinearColor(Value, Value, Value, 1.0f);
+        }
+    }
+
+    FImage Banded(16, 256, ERawImageFormat::BGRA8, EGammaSpace::sRGB);
+    FImageResampler::Resize(Ramp, Banded, FImageResampler::EFilter::Box);
+
+    bool bBanded = true;
+    for (int32 Y = 0; Y < Banded.SizeY; ++Y)
+    {
+        const float Value = (Y * 8 + 3.5f) / 2047.0f;
+        const FColor RowColor = FLinearColor(Value, Value, Value, 1.0f).ToFColor(true);
+        for (int32 X = 0; X < Banded.SizeX; ++X)
+        {
+            bBanded &= IsNearlyEqual(Banded.AsBGRA8()[(int64)Y * Banded.SizeX + X], RowColor);
+        }
+    }
+    TestTrue(TEXT("Rows across bands"), bBanded);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FImageResamplerPremultipliedTest, "RuntimeImageLoader.Resampler.PremultipliedAlpha", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FImageResamplerPremultipliedTest::RunTest(const FString& Parameters)
+{
+    // opaque white next to transparent red, the red must not bleed into the white
+    FImage Source(2, 2, ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+    TArrayView64<FLinearColor> SourcePixels = Source.AsRGBA32F();
+    SourcePixels[0] = SourcePixels[2] = FLinearColor(1.0f, 1.0f, 1.0f, 1.0f);
+    SourcePixels[1] = SourcePixels[3] = FLinearColor(1.0f, 0.0f, 0.0f, 0.0f);
+
+    for (FImageResampler::EFilter Filter : AllFilters)
+    {
+        FImage Dest(1, 1, ERawImageFormat::RGBA32F, EGammaSpace::Linear);
+        FImageResampler::Resize(Source, Dest, Filter);
+
+        const FLinearColor Pixel = Dest.AsRGBA32F()[0];
+        TestTrue(FString::Printf(TEXT("Filter %d keeps the opaque color (%s)"), (int32)Filter, *Pixel.ToString()), GetMaxError(&Pixel, 1, FLinearColor(1.0f, 1.0f, 1.0f, Pixel.A)) < 1e-5f);
+        TestTrue(FString::Printf(TEXT("Filter %d blends alpha (%f)"), (int32)Filter, Pixel.A), Pixel.A > 0.0f && Pixel.A < 1.0f);
+    }
+
+    // transparent pixels come out transparent black instead of dividing by zero
+    FImage Transparent(8, 8, ERawImageFormat::BGRA8, EGammaSpace::sRGB);
+    for (FColor& Pixel : Transparent.AsBGRA8())
+    {
+        Pixel = FColor(255, 0, 0, 0);
+    }
+
+    FImage TransparentDest(3, 3, ERawImageFormat::BGRA8, EGammaSpace::sRGB);
+    FImageResampler::Resize(Transparent, TransparentDest, FImageResampler::EFilter::Lanczos3);
+
+    bool bTransparent = true;
+    for (const FColor& Pixel : TransparentDest.AsBGRA8())
+    {
+        bTransparent &= Pixel == FColor(0, 0, 0, 0);
+    }
+    TestTrue(TEXT("Transparent image stays transparent black"), bTransparent);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FImageResamplerBenchmarkTest, "RuntimeImageLoader.Resampler.Benchmark", RUNTIMEIMAGELOADER_PERF_TEST_FLAGS)
+
+bool FImageResamplerBenchmarkTest::RunTest(const FString& Parameters)
+{
+    struct FCase
+    {
+        ERawImageFormat::Type Format;
+        EGammaSpace GammaSpace;
+        FIntPoint DestSize;
+    };
+
+    // a large photo down to screen size and an upscale, in the formats the loader produces most
+    const FCase Cases[] =
+    {
+        { ERawImageFormat::BGRA8, EGammaSpace::sRGB, { 1280, 720 } },
+        { ERawImageFormat::BGRA8, EGammaSpace::sRGB, { 4500, 3000 } },
+        { ERawImageFormat::G8, EGammaSpace::Linear, { 1280, 720 } },
+        { ERawImageFormat::RGBA16F, EGammaSpace::Linear, { 1280, 720 } }
+    };
+    const int32 NumRuns = 3;
+
+    // best of the runs, the first one pays for the task graph warming up
+    auto Measure = [NumRuns](TFunctionRef<void()> Run)
+    {
+        double Best = MAX_dbl;
+        for (int32 RunIndex = 0; RunIndex < NumRuns; ++RunIndex)
+        {
+            const double StartTime = FPlatformTime::Seconds();
+            Run();
+            Best = FMath::Min(Best, FPlatformTime::Seconds() - StartTime);
+        }
+        return Best * 1000.0;
+    };
+
+    for (const FCase& Case : Cases)
+    {
+        FImage Source(3000, 2000, Case.Format, Case.GammaSpace);
+        if (Case.Format == ERawImageFormat::RGBA16F)
+        {
+            for (FFloat16Color& Pixel : Source.AsRGBA16F())
+            {
+                Pixel = FFloat16Color(FLinearColor::MakeRandomColor());
+            }
+        }
+        else
+        {
+            FRuntimeImageLoaderTests::FillRandom(Source.RawData.GetData(), Source.RawData.Num(), 7);
+        }
+
+        FImage Dest(Case.DestSize.X, Case.DestSize.Y, Case.Format, Case.GammaSpace);
+        const double EngineMs = Measure([&]() { Source.ResizeTo(Dest, Dest.SizeX, Dest.SizeY, Dest.Format, Dest.GammaSpace); });
+
+        for (FImageResampler::EFilter Filter : { FImageResampler::EFilter::Bilinear, FImageResampler::EFilter::Lanczos3 })
+        {
+            const double ResamplerMs = Measure([&]() { FImageResampler::Resize(Source, Dest, Filter); });
+            AddInfo(FString::Printf(TEXT("Format %d 3000x2000 to %dx%d: FImage::ResizeTo %.1f ms, resampler filter %d %.1f ms (%.1fx)"),
+                (int32)Case.Format, Case.DestSize.X, Case.DestSize.Y, EngineMs, (int32)Filter, ResamplerMs, EngineMs / FMath::Max(ResamplerMs, 1e-3)));
+        }
+    }
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FImageResamplerMipsTest, "RuntimeImageLoader.Resampler.GenerateMips", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FImageResamplerMipsTest::RunTest(const FString& Parameters)
+{
+    const FColor Color(200, 100, 50, 255);
+
+    FRuntimeImageData Image;
+    Image.Init(37, 20, ERawImageFormat::BGRA8, EGammaSpace::sRGB);
+    for (FColor& Pixel : Image.AsBGRA8())
+    {
+        Pixel = Color;
+    }
+
+    FImageResampler::GenerateMips(Image, FImageResampler::EFilter::Kaiser);
+
+    // 37x20, 18x10, 9x5, 4x2, 2x1, 1x1
+    if (!TestEqual(TEXT("Number of mips"), Image.NumMips, 6))
+    {
+        return true;
+    }
+
+    int64 ChainSize = 0;
+    for (int32 MipIndex = 0; MipIndex < Image.NumMips; ++MipIndex)
+    {
+        TestEqual(FString::Printf(TEXT("Mip %d offset"), MipIndex), Image.GetMipOffset(MipIndex), ChainSize);
+        ChainSize += (int64)Image.GetMipSizeX(MipIndex) * Image.GetMipSizeY(MipIndex) * sizeof(FColor);
+    }
+    TestEqual(TEXT("Chain size"), Image.RawData.Num(), ChainSize);
+    TestEqual(TEXT("Last mip width"), Image.GetMipSizeX(Image.NumMips - 1), 1);
+    TestEqual(TEXT("Last mip height"), Image.GetMipSizeY(Image.NumMips - 1), 1);
+
+    const FColor* Pixels = (const FColor*)Image.RawData.GetData();
+    bool bConstant = true;
+    for (int64 Index = 0; Index < ChainSize / (int64)sizeof(FColor); ++Index)
+    {
+        bConstant &= IsNearlyEqual(Pixels[Index], Color);
+    }
+    TestTrue(TEXT("Mips of a constant image are constant"), bConstant);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FImageResamplerMipsFilterTest, "RuntimeImageLoader.Resampler.GenerateMipsFilter", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FImageResamplerMipsFilterTest::RunTest(const FString& Parameters)
+{
+    // sRGB mips average light, a black and white checker is 50% linear gray and not 50% sRGB gray
+    FRuntimeImageData Checker;
+    Checker.Init(8, 8, ERawImageFormat::BGRA8, EGammaSpace::sRGB);
+    TArrayView64<FColor> CheckerPixels = Checker.AsBGRA8();
+    for (int32 Index = 0; Index < CheckerPixels.Num(); ++Index)
+    {
+        CheckerPixels[Index] = ((Index % 8 + Index / 8) % 2) ? FColor::White : FColor::Black;
+    }
+
+    FImageResampler::GenerateMips(Checker, FImageResampler::EFilter::Box);
+    if (TestEqual(TEXT("sRGB mips"), Checker.NumMips, 4))
+    {
+        const FColor LinearGray = FLinearColor(0.5f, 0.5f, 0.5f, 1.0f).ToFColor(true);
+        const FColor* Pixels = (const FColor*)Checker.RawData.GetData();
+
+        bool bLinearAverage = true;
+        for (int64 Index = Checker.GetMipOffset(1) / (int64)sizeof(FColor); Index < Checker.RawData.Num() / (int64)sizeof(FColor); ++Index)
+        {
+            bLinearAverage &= IsNearlyEqual(Pixels[Index], LinearGray);
+        }
+        TestTrue(TEXT("sRGB mips are averaged in linear space"), bLinearAverage);
+    }
+
+    // linear grayscale is averaged as it is, mips of a non-square image go down to 1x1
+    FRuntimeImageData Gray;
+    Gray.Init(16, 4, ERawImageFormat::G8, EGammaSpace::Linear);
+    Gray.PixelFormat = PF_G8;
+    TArrayView64<uint8> GrayValues = Gray.AsG8();
+    for (int32 Index = 0; Index < GrayValues.Num(); ++Index)
+    {
+        GrayValues[Index] = ((Index % 16 + Index / 16) % 2) ? 255 : 0;
+    }
+
+    FImageResampler::GenerateMips(Gray, FImageResampler::EFilter::Box);
+
+    // 16x4, 8x2, 4x1, 2x1, 1x1
+    if (TestEqual(TEXT("G8 mips"), Gray.NumMips, 5))
+    {
+        TestEqual(TEXT("G8 chain size"), Gray.RawData.Num(), (int64)(64 + 16 + 4 + 2 + 1));
+        TestEqual(TEXT("G8 last mip offset"), Gray.GetMipOffset(4), (int64)(64 + 16 + 4 + 2));
+
+        bool bAveraged = true;
+        for (int64 Index = Gray.GetMipOffset(1); Index < Gray.RawData.Num(); ++Index)
+        {
+            bAveraged &= FMath::Abs(Gray.RawData[Index] - 128) <= 1;
+        }
+        TestTrue(TEXT("G8 mips are averaged"), bAveraged);
+    }
+
+    // an image of one pixel has no mips to generate
+    FRuntimeImageData Single;
+    Single.Init(1, 1, ERawImageFormat::BGRA8, EGammaSpace::sRGB);
+    FImageResampler::GenerateMips(Single, FImageResampler::EFilter::Kaiser);
+    TestEqual(TEXT("1x1 mips"), Single.NumMips, 1);
+    TestEqual(TEXT("1x1 size"), Single.RawData.Num(), (int64)sizeof(FColor));
+
+    // block compressed chains take whole blocks for the mips smaller than a block
+    FRuntimeImageData Blocks;
+    Blocks.SizeX = 16;
+    Blocks.SizeY = 8;
+    Blocks.NumMips = 5;
+    Blocks.PixelFormat = PF_DXT1;
+    const int64 MipSizes[] = { 64, 16, 8, 8, 8 };
+
+    int64 Offset = 0;
+    for (int32 MipIndex = 0; MipIndex < Blocks.NumMips; ++MipIndex)
+    {
+        TestEqual(FString::Printf(TEXT("DXT1 mip %d size"), MipIndex), Blocks.GetMipDataSize(MipIndex), MipSizes[MipIndex]);
+        TestEqual(FString::Printf(TEXT("DXT1 mip %d offset"), MipIndex), Blocks.GetMipOffset(MipIndex), Offset);
+        Offset += MipSizes[MipIndex];
+    }
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,183 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "RuntimeImageLoaderTests.h"
+#include "IImageWrapperModule.h"
+#include "IImageWrapper.h"
+#include "Modules/ModuleManager.h"
+#include "Helpers/JPEGHelpers.h"
+#include "ImageDecoders/JPEGImageDecoder.h"
+
+#if WITH_DEV_AUTOMATION_TESTS && WITH_LIBJPEGTURBO
+
+namespace
+{
+    struct FTestJPEG
+    {
+        TArray64<uint8> File;
+        // full size pixels as ImageWrapper decodes them, BGRA8 or G8
+        TArray64<uint8> Decoded;
+    };
+
+    /** Smooth gradient encoded at high quality, so DCT scaled pixels stay close to the box filtered full size ones */
+    FTestJPEG MakeJPEG(int32 Width, int32 Height, bool bGrayscale)
+    {
+        const int32 NumChannels = bGrayscale ? 1 : 4;
+        const ERGBFormat Format = bGrayscale ? ERGBFormat::Gray : ERGBFormat::BGRA;
+
+        TArray<uint8> Raw;
+        Raw.SetNumUninitialized(Width * Height * NumChannels);
+        for (int32 Y = 0; Y < Height; ++Y)
+        {
+            for (int32 X = 0; X < Width; ++X)
+            {
+                uint8* Pixel = Raw.GetData() + (Y * Width + X) * NumChannels;
+                Pixel[0] = (uint8)(X * 255 / Width);
+                if (!bGrayscale)
+                {
+                    Pixel[1] = (uint8)(Y * 255 / Height);
+                    Pixel[2] = (uint8)((X + Y) * 255 / (Width + Height));
+                    Pixel[3] = 255;
+                }
+            }
+        }
+
+        IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+
+        FTestJPEG JPEG;
+        TSharedPtr<IImageWrapper> Encoder = ImageWrapperModule.CreateImageWrapper(EImageFormat::JPEG);
+        if (Encoder.IsValid() && Encoder->SetRaw(Raw.GetData(), Raw.Num(), Width, Height, Format, 8))
+        {
+            JPEG.File = Encoder->GetCompressed(95);
+        }
+
+        TSharedPtr<IImageWrapper> Decoder = ImageWrapperModule.CreateImageWrapper(EImageFormat::JPEG);
+        if (Decoder.IsValid() && Decoder->SetCompressed(JPEG.File.GetData(), JPEG.File.Num()))
+        {
+            Decoder->GetRaw(Format, 8, JPEG.Decoded);
+        }
+        return JPEG;
+    }
+
+    /** Largest difference between the scaled image and the full size one averaged over the same pixels */
+    int32 GetMaxErrorToBoxFiltered(const FTestJPEG& JPEG, int32 Width, int32 Height, int32 NumChannels, const FRuntimeImageData& Scaled, int32 ScaleDenom)
+    {
+        int32 MaxError = 0;
+        for (int32 Y = 0; Y < Scaled.SizeY; ++Y)
+        {
+            for (int32 X = 0; X < Scaled.SizeX; ++X)
+            {
+                for (int32 Channel = 0; Channel < FMath::Min(NumChannels, 3); ++Channel)
+                {
+                    int32 Sum = 0;
+                    int32 Count = 0;
+                    for (int32 SourceY = Y * ScaleDenom; SourceY < FMath::Min((Y + 1) * ScaleDenom, Height); ++SourceY)
+                    {
+                        for (int32 SourceX = X * ScaleDenom; SourceX < FMath::Min((X + 1) * ScaleDenom, Width); ++SourceX)
+                        {
+                            Sum += JPEG.Decoded[((int64)SourceY * Width + SourceX) * NumChannels + Channel];
+                            ++Count;
+                        }
+                    }
+
+                    const int32 Value = Scaled.RawData[((int64)Y * Scaled.SizeX + X) * NumChannels + Channel];
+                    MaxError = FMath::Max(MaxError, FMath::Abs(Value - Sum / Count));
+                }
+            }
+        }
+        return MaxError;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJPEGHelpersScaleDenominatorTest, "RuntimeImageLoader.JPEG.ScaleDenominator", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FJPEGHelpersScaleDenominatorTest::RunTest(const FString& Parameters)
+{
+    // the smallest scale that is still at or above the target, the resampler does the rest
+    TestEqual(TEXT("Full size"), FJPEGHelpers::GetScaleDenominator(1.0f), 1);
+    TestEqual(TEXT("Just above a half"), FJPEGHelpers::GetScaleDenominator(0.51f), 1);
+    TestEqual(TEXT("Half"), FJPEGHelpers::GetScaleDenominator(0.5f), 2);
+    TestEqual(TEXT("Just below a half"), FJPEGHelpers::GetScaleDenominator(0.49f), 2);
+    TestEqual(TEXT("Quarter"), FJPEGHelpers::GetScaleDenominator(0.25f), 4);
+    TestEqual(TEXT("Fifth"), FJPEGHelpers::GetScaleDenominator(0.2f), 4);
+    TestEqual(TEXT("Eighth"), FJPEGHelpers::GetScaleDenominator(0.125f), 8);
+    TestEqual(TEXT("Below an eighth"), FJPEGHelpers::GetScaleDenominator(0.01f), 8);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJPEGHelpersDecodeScaledTest, "RuntimeImageLoader.JPEG.DecodeScaled", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FJPEGHelpersDecodeScaledTest::RunTest(const FString& Parameters)
+{
+    const int32 Width = 250;
+    const int32 Height = 131;
+
+    for (const bool bGrayscale : { false, true })
+    {
+        const FTestJPEG JPEG = MakeJPEG(Width, Height, bGrayscale);
+        const int32 NumChannels = bGrayscale ? 1 : 4;
+        if (!TestTrue(TEXT("Test JPEG is encoded"), JPEG.File.Num() > 0 && JPEG.Decoded.Num() == (int64)Width * Height * NumChannels))
+        {
+            return false;
+        }
+
+        for (const int32 ScaleDenom : { 2, 4, 8 })
+        {
+            const FString What = FString::Printf(TEXT("%s 1/%d"), bGrayscale ? TEXT("Grayscale") : TEXT("Color"), ScaleDenom);
+
+            FRuntimeImageData Image;
+            FString Error;
+            if (!TestTrue(What, FJPEGHelpers::DecodeScaled(JPEG.File.GetData(), JPEG.File.Num(), ScaleDenom, FIntRect(), Image, Error)))
+            {
+                AddError(Error);
+                continue;
+            }
+
+            // partial blocks at the edges round up
+            TestEqual(What + TEXT(" size"), FIntPoint(Image.SizeX, Image.SizeY), FIntPoint(FMath::DivideAndRoundUp(Width, ScaleDenom), FMath::DivideAndRoundUp(Height, ScaleDenom)));
+            TestEqual(What + TEXT(" source size"), FIntPoint(Image.SourceSizeX, Image.SourceSizeY), FIntPoint(Width, Height));
+            TestEqual(What + TEXT(" format"), (int32)Image.TextureSourceFormat, (int32)(bGrayscale ? TSF_G8 : TSF_BGRA8));
+            TestTrue(What + TEXT(" is close to the box filtered full size image"), GetMaxErrorToBoxFiltered(JPEG, Width, Height, NumChannels, Image, ScaleDenom) <= 12);
+        }
+    }
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FJPEGImageDecoderMinScaleTest, "RuntimeImageLoader.JPEG.MinScale", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FJPEGImageDecoderMinScaleTest::RunTest(const FString& Parameters)
+{
+    const FTestJPEG JPEG = MakeJPEG(256, 128, false);
+
+    struct FCase
+    {
+        float MinScale;
+        FIntPoint Size;
+    };
+
+    // the decoder never goes below the minimum scale, full size images come from ImageWrapper
+    const FCase Cases[] = { { 1.0f, FIntPoint(256, 128) }, { 0.6f, FIntPoint(256, 128) }, { 0.3f, FIntPoint(128, 64) }, { 0.25f, FIntPoint(64, 32) }, { 0.05f, FIntPoint(32, 16) } };
+    for (const FCase& Case : Cases)
+    {
+        const FString What = FString::Printf(TEXT("Minimum scale %.2f"), Case.MinScale);
+
+        FImageDecodeParams Params;
+        Params.MinScale = Case.MinScale;
+
+        FRuntimeImageData Image;
+        FString Error;
+        if (!TestTrue(What, FJPEGImageDecoder().Decode(JPEG.File.GetData(), JPEG.File.Num(), Params, Image, Error)))
+        {
+            AddError(Error);
+            continue;
+        }
+
+        TestEqual(What + TEXT(" size"), FIntPoint(Image.SizeX, Image.SizeY), Case.Size);
+        TestEqual(What + TEXT(" source size"), Image.SourceSizeX, Case.Size.X == 256 ? 0 : 256);
+    }
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS && WITH_LIBJPEGTURBO
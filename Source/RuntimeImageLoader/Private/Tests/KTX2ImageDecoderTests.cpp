@@ -0,0 +1,187 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "RuntimeImageLoaderTests.h"
+#include "ImageDecoders/KTX2ImageDecoder.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    constexpr uint32 VkFormatBC1 = 131;
+    constexpr uint32 VkFormatBC4Signed = 140;
+    constexpr uint32 VkFormatBC5Signed = 142;
+    constexpr uint32 VkFormatBC6HSigned = 144;
+    constexpr uint32 VkFormatBC7 = 145;
+
+    struct FTestKTX2
+    {
+        TArray<uint8> File;
+        // blocks the decoder must return, faces one after another with all of their mips
+        TArray<uint8> Expected;
+    };
+
+    void WriteUInt32(TArray<uint8>& Out, int64 Offset, uint32 Value)
+    {
+        for (int32 Byte = 0; Byte < 4; ++Byte)
+        {
+            Out[Offset + Byte] = (uint8)(Value >> (Byte * 8));
+        }
+    }
+
+    void WriteUInt64(TArray<uint8>& Out, int64 Offset, uint64 Value)
+    {
+        WriteUInt32(Out, Offset, (uint32)Value);
+        WriteUInt32(Out, Offset + 4, (uint32)(Value >> 32));
+    }
+
+    /**
+     * KTX2 of random 4x4 blocks. Levels are stored smallest first as the specification recommends, the faces of a cubemap inside each level.
+     * Level lengths are of the first layer even when the header says there are more, the decoder must reject arrays before reading them
+     */
+    FTestKTX2 MakeKTX2(int32 Width, int32 Height, int32 NumLevels, uint32 VkFormat, int32 BlockBytes, int32 NumFaces = 1, uint32 LayerCount = 0)
+    {
+        const int64 IndexSize = NumLevels * 24;
+
+        TArray<int64> MipSizes;
+        int64 DataSize = 0;
+        for (int32 Level = 0; Level < NumLevels; ++Level)
+        {
+            MipSizes.Add((int64)FMath::DivideAndRoundUp(FMath::Max(Width >> Level, 1), 4) * FMath::DivideAndRoundUp(FMath::Max(Height >> Level, 1), 4) * BlockBytes);
+            DataSize += MipSizes.Last() * NumFaces;
+        }
+
+        FTestKTX2 KTX2;
+        KTX2.File.SetNumZeroed(80 + IndexSize + DataSize);
+
+        const uint8 Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+        FMemory::Memcpy(KTX2.File.GetData(), Identifier, sizeof(Identifier));
+        WriteUInt32(KTX2.File, 12, VkFormat);
+        WriteUInt32(KTX2.File, 16, 1);
+        WriteUInt32(KTX2.File, 20, Width);
+        WriteUInt32(KTX2.File, 24, Height);
+        WriteUInt32(KTX2.File, 32, LayerCount);
+        WriteUInt32(KTX2.File, 36, NumFaces);
+        WriteUInt32(KTX2.File, 40, NumLevels);
+
+        TArray<int64> LevelOffsets;
+        LevelOffsets.SetNum(NumLevels);
+
+        int64 LevelOffset = 80 + IndexSize;
+        for (int32 Level = NumLevels - 1; Level >= 0; --Level)
+        {
+            LevelOffsets[Level] = LevelOffset;
+            WriteUInt64(KTX2.File, 80 + Level * 24, LevelOffset);
+            WriteUInt64(KTX2.File, 80 + Level * 24 + 8, MipSizes[Level] * NumFaces);
+            WriteUInt64(KTX2.File, 80 + Level * 24 + 16, MipSizes[Level] * NumFaces);
+            LevelOffset += MipSizes[Level] * NumFaces;
+        }
+
+        FRuntimeImageLoaderTests::FillRandom(KTX2.File.GetData() + 80 + IndexSize, DataSize, Width * 17 + Height + NumLevels * 3 + NumFaces);
+
+        for (int32 Face = 0; Face < NumFaces; ++Face)
+        {
+            for (int32 Level = 0; Level < NumLevels; ++Level)
+            {
+                KTX2.Expected.Append(KTX2.File.GetData() + LevelOffsets[Level] + Face * MipSizes[Level], (int32)MipSizes[Level]);
+            }
+        }
+        return KTX2;
+    }
+
+    bool Decode(const TArray<uint8>& File, FRuntimeImageData& OutImage, FString& OutError)
+    {
+        return FKTX2ImageDecoder().Decode(File.GetData(), File.Num(), FImageDecodeParams(), OutImage, OutError);
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FKTX2ImageDecoderMipsTest, "RuntimeImageLoader.KTX2.Mips", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FKTX2ImageDecoderMipsTest::RunTest(const FString& Parameters)
+{
+    // levels are found through the index whatever order they are stored in, mips smaller than a block take a whole block
+    const FTestKTX2 KTX2 = MakeKTX2(16, 8, 5, VkFormatBC1, 8);
+
+    FRuntimeImageData Image;
+    FString Error;
+    if (!TestTrue(TEXT("BC1 mip chain"), Decode(KTX2.File, Image, Error)))
+    {
+        AddError(Error);
+        return false;
+    }
+
+    TestEqual(TEXT("Pixel format"), (int32)Image.PixelFormat, (int32)PF_DXT1);
+    TestEqual(TEXT("Mips"), Image.NumMips, 5);
+    TestEqual(TEXT("Slices"), Image.NumSlices, 1);
+    TestTrue(TEXT("Levels are read in mip order"), Image.RawData.Num() == KTX2.Expected.Num() && FMemory::Memcmp(Image.RawData.GetData(), KTX2.Expected.GetData(), KTX2.Expected.Num()) == 0);
+
+    // level count 0 asks for generated mips, only the first level is read
+    FTestKTX2 NoMips = MakeKTX2(8, 8, 1, VkFormatBC1, 8);
+    WriteUInt32(NoMips.File, 40, 0);
+    if (TestTrue(TEXT("Level count 0"), Decode(NoMips.File, Image, Error)))
+    {
+        TestEqual(TEXT("Level count 0 mips"), Image.NumMips, 1);
+    }
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FKTX2ImageDecoderCubemapTest, "RuntimeImageLoader.KTX2.Cubemap", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FKTX2ImageDecoderCubemapTest::RunTest(const FString& Parameters)
+{
+    // the faces inside each level are regrouped into faces with all of their mips
+    const FTestKTX2 KTX2 = MakeKTX2(8, 8, 3, VkFormatBC7, 16, 6);
+
+    FRuntimeImageData Image;
+    FString Error;
+    if (!TestTrue(TEXT("BC7 cubemap"), Decode(KTX2.File, Image, Error)))
+    {
+        AddError(Error);
+        return false;
+    }
+
+    TestEqual(TEXT("Slices"), Image.NumSlices, 6);
+    TestEqual(TEXT("Mips"), Image.NumMips, 3);
+    TestTrue(TEXT("Faces with all of their mips"), Image.RawData.Num() == KTX2.Expected.Num() && FMemory::Memcmp(Image.RawData.GetData(), KTX2.Expected.GetData(), KTX2.Expected.Num()) == 0);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FKTX2ImageDecoderRejectTest, "RuntimeImageLoader.KTX2.Reject", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FKTX2ImageDecoderRejectTest::RunTest(const FString& Parameters)
+{
+    auto TestRejected = [this](const TCHAR* What, const TArray<uint8>& File)
+    {
+        FRuntimeImageData Image;
+        FString Error;
+        TestFalse(What, Decode(File, Image, Error));
+        TestFalse(FString(What) + TEXT(" reports an error"), Error.IsEmpty());
+    };
+
+    // the largest level is stored last
+    FTestKTX2 Truncated = MakeKTX2(16, 16, 3, VkFormatBC1, 8);
+    Truncated.File.Pop();
+    TestRejected(TEXT("Last level truncated"), Truncated.File);
+
+    FTestKTX2 ShortLevel = MakeKTX2(16, 16, 3, VkFormatBC1, 8);
+    WriteUInt64(ShortLevel.File, 80 + 8, 8);
+    TestRejected(TEXT("Level shorter than its blocks"), ShortLevel.File);
+
+    FTestKTX2 OffsetPastEnd = MakeKTX2(16, 16, 1, VkFormatBC1, 8);
+    WriteUInt64(OffsetPastEnd.File, 80, MAX_uint64 - 4);
+    TestRejected(TEXT("Level offset wraps around"), OffsetPastEnd.File);
+
+    TestRejected(TEXT("Level index truncated"), TArray<uint8>(MakeKTX2(16, 16, 3, VkFormatBC1, 8).File.GetData(), 100));
+    TestRejected(TEXT("Header truncated"), TArray<uint8>(MakeKTX2(16, 16, 1, VkFormatBC1, 8).File.GetData(), 60));
+
+    TestRejected(TEXT("Partial blocks"), MakeKTX2(6, 6, 1, VkFormatBC1, 8).File);
+    TestRejected(TEXT("Texture array"), MakeKTX2(8, 8, 1, VkFormatBC1, 8, 1, 2).File);
+    TestRejected(TEXT("Signed BC4"), MakeKTX2(8, 8, 1, VkFormatBC4Signed, 8).File);
+    TestRejected(TEXT("Signed BC5"), MakeKTX2(8, 8, 1, VkFormatBC5Signed, 16).File);
+    TestRejected(TEXT("Signed BC6H"), MakeKTX2(8, 8, 1, VkFormatBC6HSigned, 16).File);
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,83 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "RuntimeImageLoaderTests.h"
+#include "IImageWrapperModule.h"
+#include "IImageWrapper.h"
+#include "Modules/ModuleManager.h"
+#include "Helpers/PNGHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS && WITH_FASTPNG
+
+namespace
+{
+    bool CompareWithImageWrapper(FAutomationTestBase& Test, const FString& What, const TArray<uint8>& Raw, int32 Width, int32 Height, ERGBFormat Format)
+    {
+        IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+
+        TSharedPtr<IImageWrapper> Encoder = ImageWrapperModule.CreateImageWrapper(EImageFormat::PNG);
+        if (!Test.TestTrue(What + TEXT(" is encoded"), Encoder.IsValid() && Encoder->SetRaw(Raw.GetData(), Raw.Num(), Width, Height, Format, 8)))
+        {
+            return false;
+        }
+        const TArray64<uint8> Compressed = Encoder->GetCompressed();
+
+        TArray64<uint8> Expected;
+        TSharedPtr<IImageWrapper> Decoder = ImageWrapperModule.CreateImageWrapper(EImageFormat::PNG);
+        if (!Test.TestTrue(What + TEXT(" is decoded by ImageWrapper"), Decoder->SetCompressed(Compressed.GetData(), Compressed.Num()) && Decoder->GetRaw(Format, 8, Expected)))
+        {
+            return false;
+        }
+
+        FRuntimeImageData Image;
+        FString Error;
+        if (!Test.TestTrue(What + TEXT(" is decoded by fastpng"), FPNGHelpers::DecodeFast(Compressed.GetData(), Compressed.Num(), Image, Error)))
+        {
+            Test.AddError(Error);
+            return false;
+        }
+
+        Test.TestEqual(What + TEXT(" width"), Image.SizeX, Width);
+        Test.TestEqual(What + TEXT(" height"), Image.SizeY, Height);
+        return Test.TestTrue(What + TEXT(" pixels match ImageWrapper"), Image.RawData == Expected);
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPNGHelpersDecodeFastTest, "RuntimeImageLoader.PNG.DecodeFast", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FPNGHelpersDecodeFastTest::RunTest(const FString& Parameters)
+{
+    const FIntPoint Sizes[] = { { 1, 1 }, { 3, 5 }, { 17, 9 }, { 64, 64 }, { 257, 31 } };
+
+    for (const FIntPoint& Size : Sizes)
+    {
+        const int32 NumPixels = Size.X * Size.Y;
+
+        TArray<uint8> Gray;
+        Gray.SetNumUninitialized(NumPixels);
+        FRuntimeImageLoaderTests::FillRandom(Gray.GetData(), Gray.Num(), NumPixels);
+        CompareWithImageWrapper(*this, FString::Printf(TEXT("Gray %dx%d"), Size.X, Size.Y), Gray, Size.X, Size.Y, ERGBFormat::Gray);
+
+        TArray<uint8> Opaque;
+        Opaque.SetNumUninitialized(NumPixels * 4);
+        FRuntimeImageLoaderTests::FillRandom(Opaque.GetData(), Opaque.Num(), NumPixels + 1);
+        for (int32 Index = 0; Index < NumPixels; ++Index)
+        {
+            Opaque[Index * 4 + 3] = 255;
+        }
+        CompareWithImageWrapper(*this, FString::Printf(TEXT("Opaque %dx%d"), Size.X, Size.Y), Opaque, Size.X, Size.Y, ERGBFormat::BGRA);
+
+        // no zero alpha, so the fill leaves the pixels as ImageWrapper returns them
+        TArray<uint8> Translucent;
+        Translucent.SetNumUninitialized(NumPixels * 4);
+        FRuntimeImageLoaderTests::FillRandom(Translucent.GetData(), Translucent.Num(), NumPixels + 2);
+        for (int32 Index = 0; Index < NumPixels; ++Index)
+        {
+            Translucent[Index * 4 + 3] = (uint8)(1 + Index % 255);
+        }
+        CompareWithImageWrapper(*this, FString::Printf(TEXT("Translucent %dx%d"), Size.X, Size.Y), Translucent, Size.X, Size.Y, ERGBFormat::BGRA);
+    }
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS && WITH_FASTPNG
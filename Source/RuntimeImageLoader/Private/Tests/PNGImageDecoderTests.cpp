@@ -0,0 +1,66 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "RuntimeImageLoaderTests.h"
+#include "IImageWrapperModule.h"
+#include "IImageWrapper.h"
+#include "Modules/ModuleManager.h"
+#include "ImageDecoders/PNGImageDecoder.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    /** 16-bit PNG of a ramp over the whole range, samples in the native byte order as ImageWrapper takes them */
+    TArray64<uint8> MakePNG16(int32 Width, int32 Height, int32 NumChannels, TArray<uint16>& OutSamples)
+    {
+        OutSamples.SetNumUninitialized(Width * Height * NumChannels);
+        for (int32 Index = 0; Index < OutSamples.Num(); ++Index)
+        {
+            OutSamples[Index] = (uint16)((int64)Index * 65535 / (OutSamples.Num() - 1));
+        }
+
+        IImageWrapperModule& ImageWrapperModule = FModuleManager::LoadModuleChecked<IImageWrapperModule>(FName("ImageWrapper"));
+
+        TSharedPtr<IImageWrapper> Encoder = ImageWrapperModule.CreateImageWrapper(EImageFormat::PNG);
+        if (!Encoder.IsValid() || !Encoder->SetRaw(OutSamples.GetData(), OutSamples.Num() * sizeof(uint16), Width, Height, NumChannels == 1 ? ERGBFormat::Gray : ERGBFormat::RGBA, 16))
+        {
+            return TArray64<uint8>();
+        }
+        return Encoder->GetCompressed();
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPNGImageDecoderGray16Test, "RuntimeImageLoader.PNG.Gray16", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FPNGImageDecoderGray16Test::RunTest(const FString& Parameters)
+{
+    // 16-bit grayscale stays one channel instead of being expanded to RGBA16
+    TArray<uint16> Samples;
+    const TArray64<uint8> Gray = MakePNG16(61, 17, 1, Samples);
+
+    FRuntimeImageData Image;
+    FString Error;
+    if (!TestTrue(TEXT("Gray16 decoded"), Gray.Num() > 0 && FPNGImageDecoder().Decode(Gray.GetData(), Gray.Num(), FImageDecodeParams(), Image, Error)))
+    {
+        AddError(Error);
+        return false;
+    }
+
+    TestEqual(TEXT("Gray16 source format"), (int32)Image.TextureSourceFormat, (int32)TSF_G16);
+    TestEqual(TEXT("Gray16 raw format"), (int32)Image.Format, (int32)ERawImageFormat::G16);
+    TestEqual(TEXT("Gray16 size"), Image.RawData.Num(), (int64)61 * 17 * sizeof(uint16));
+    TestFalse(TEXT("Gray16 is linear"), Image.SRGB);
+    TestTrue(TEXT("Gray16 samples"), Image.RawData.Num() == Samples.Num() * sizeof(uint16) && FMemory::Memcmp(Image.RawData.GetData(), Samples.GetData(), Image.RawData.Num()) == 0);
+
+    // color keeps all four channels
+    const TArray64<uint8> Color = MakePNG16(13, 9, 4, Samples);
+    if (TestTrue(TEXT("RGBA16 decoded"), Color.Num() > 0 && FPNGImageDecoder().Decode(Color.GetData(), Color.Num(), FImageDecodeParams(), Image, Error)))
+    {
+        TestEqual(TEXT("RGBA16 source format"), (int32)Image.TextureSourceFormat, (int32)TSF_RGBA16);
+        TestTrue(TEXT("RGBA16 samples"), Image.RawData.Num() == Samples.Num() * sizeof(uint16) && FMemory::Memcmp(Image.RawData.GetData(), Samples.GetData(), Image.RawData.Num()) == 0);
+    }
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,183 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "RuntimeImageLoaderTests.h"
+#include "Helpers/PixelPackingHelpers.h"
+#include "Helpers/ImageResampler.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    FString GetAlphaUsageName(ERuntimeImageAlphaUsage AlphaUsage)
+    {
+        return StaticEnum<ERuntimeImageAlphaUsage>()->GetNameStringByValue((int64)AlphaUsage);
+    }
+
+    /** Classifies an opaque image with the given alpha values written over its first pixels */
+    template<typename ChannelType, typename ClassifyFunc>
+    ERuntimeImageAlphaUsage ClassifyWithAlpha(int32 NumPixels, ChannelType Opaque, std::initializer_list<ChannelType> Alphas, int32 Position, ClassifyFunc Classify)
+    {
+        TArray<ChannelType> Pixels;
+        Pixels.Init(Opaque, NumPixels * 4);
+
+        int32 Index = Position;
+        for (ChannelType Alpha : Alphas)
+        {
+            Pixels[(Index++ % NumPixels) * 4 + 3] = Alpha;
+        }
+        return Classify(Pixels.GetData(), NumPixels);
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPixelPackingClassifyAlphaTest, "RuntimeImageLoader.PixelPacking.ClassifyAlpha", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FPixelPackingClassifyAlphaTest::RunTest(const FString& Parameters)
+{
+    auto Expect = [this](const TCHAR* What, int32 NumPixels, int32 Position, ERuntimeImageAlphaUsage Actual, ERuntimeImageAlphaUsage Expected)
+    {
+        TestEqual(FString::Printf(TEXT("%s of %d pixels at %d"), What, NumPixels, Position), GetAlphaUsageName(Actual), GetAlphaUsageName(Expected));
+    };
+
+    // odd sizes leave pixels after the last full vector
+    for (int32 NumPixels : { 1, 3, 4, 7, 16, 37 })
+    {
+        for (int32 Position = 0; Position < NumPixels; ++Position)
+        {
+            auto Classify8 = [](const uint8* Pixels, int64 Num) { return FPixelPackingHelpers::ClassifyAlpha(Pixels, Num); };
+            Expect(TEXT("Opaque BGRA8"), NumPixels, Position, ClassifyWithAlpha<uint8>(NumPixels, 255, {}, Position, Classify8), ERuntimeImageAlphaUsage::Opaque);
+            Expect(TEXT("Binary BGRA8"), NumPixels, Position, ClassifyWithAlpha<uint8>(NumPixels, 255, { 0 }, Position, Classify8), ERuntimeImageAlphaUsage::Binary);
+            Expect(TEXT("Translucent BGRA8"), NumPixels, Position, ClassifyWithAlpha<uint8>(NumPixels, 255, { 254 }, Position, Classify8), ERuntimeImageAlphaUsage::Translucent);
+            Expect(TEXT("Translucent BGRA8 after a transparent pixel"), NumPixels, Position, ClassifyWithAlpha<uint8>(NumPixels, 255, { 0, 1 }, Position, Classify8), ERuntimeImageAlphaUsage::Translucent);
+        }
+    }
+
+    const int32 NumPixels = 5;
+    const int32 Position = 3;
+
+    auto Classify16 = [](const uint16* Pixels, int64 Num) { return FPixelPackingHelpers::ClassifyAlpha16(Pixels, Num); };
+    Expect(TEXT("Opaque RGBA16"), NumPixels, Position, ClassifyWithAlpha<uint16>(NumPixels, 0xFFFF, {}, Position, Classify16), ERuntimeImageAlphaUsage::Opaque);
+    Expect(TEXT("Binary RGBA16"), NumPixels, Position, ClassifyWithAlpha<uint16>(NumPixels, 0xFFFF, { 0 }, Position, Classify16), ERuntimeImageAlphaUsage::Binary);
+    Expect(TEXT("Translucent RGBA16"), NumPixels, Position, ClassifyWithAlpha<uint16>(NumPixels, 0xFFFF, { 0xFF00 }, Position, Classify16), ERuntimeImageAlphaUsage::Translucent);
+
+    // 1.0 and above is opaque, 0 and below transparent
+    auto Classify16F = [](const uint16* Pixels, int64 Num) { return FPixelPackingHelpers::ClassifyAlpha16F(Pixels, Num); };
+    Expect(TEXT("Opaque RGBA16F"), NumPixels, Position, ClassifyWithAlpha<uint16>(NumPixels, 0x3C00, { 0x4000 }, Position, Classify16F), ERuntimeImageAlphaUsage::Opaque);
+    Expect(TEXT("Binary RGBA16F"), NumPixels, Position, ClassifyWithAlpha<uint16>(NumPixels, 0x3C00, { 0, 0x8000, 0xBC00 }, Position, Classify16F), ERuntimeImageAlphaUsage::Binary);
+    Expect(TEXT("Translucent RGBA16F"), NumPixels, Position, ClassifyWithAlpha<uint16>(NumPixels, 0x3C00, { 0x3800 }, Position, Classify16F), ERuntimeImageAlphaUsage::Translucent);
+
+    auto Classify32F = [](const float* Pixels, int64 Num) { return FPixelPackingHelpers::ClassifyAlpha32F(Pixels, Num); };
+    Expect(TEXT("Opaque RGBA32F"), NumPixels, Position, ClassifyWithAlpha<float>(NumPixels, 1.0f, { 2.0f }, Position, Classify32F), ERuntimeImageAlphaUsage::Opaque);
+    Expect(TEXT("Binary RGBA32F"), NumPixels, Position, ClassifyWithAlpha<float>(NumPixels, 1.0f, { 0.0f, -1.0f }, Position, Classify32F), ERuntimeImageAlphaUsage::Binary);
+    Expect(TEXT("Translucent RGBA32F"), NumPixels, Position, ClassifyWithAlpha<float>(NumPixels, 1.0f, { 0.999f }, Position, Classify32F), ERuntimeImageAlphaUsage::Translucent);
+
+    // the image keeps its class till its pixels are filtered, opaque images stay opaque
+    FRuntimeImageData Image;
+    Image.Init(3, 2, ERawImageFormat::BGRA8, EGammaSpace::sRGB);
+    FMemory::Memset(Image.RawData.GetData(), 255, Image.RawData.Num());
+    Image.RawData[7] = 0;
+
+    Expect(TEXT("Binary image"), 6, 1, Image.ClassifyAlpha(), ERuntimeImageAlphaUsage::Binary);
+    Image.RawData[7] = 128;
+    Expect(TEXT("Classified image"), 6, 1, Image.ClassifyAlpha(), ERuntimeImageAlphaUsage::Binary);
+    Image.InvalidateAlphaUsage();
+    Expect(TEXT("Filtered image"), 6, 1, Image.ClassifyAlpha(), ERuntimeImageAlphaUsage::Translucent);
+
+    FRuntimeImageData Gray;
+    Gray.Init(3, 2, ERawImageFormat::G8, EGammaSpace::sRGB);
+    Expect(TEXT("Grayscale image"), 6, 0, Gray.ClassifyAlpha(), ERuntimeImageAlphaUsage::Opaque);
+    Gray.InvalidateAlphaUsage();
+    TestTrue(TEXT("Grayscale image stays opaque after filtering"), Gray.AlphaUsage == ERuntimeImageAlphaUsage::Opaque);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FPixelPackingPack16Test, "RuntimeImageLoader.PixelPacking.Pack16", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FPixelPackingPack16Test::RunTest(const FString& Parameters)
+{
+    // flat 4x4 areas of every sRGB level average to its linear value, dark levels don't collapse to black
+    TArray<uint8> Pixels;
+    Pixels.SetNumUninitialized(16 * 4);
+    TArray<uint16> Texels;
+    Texels.SetNumUninitialized(16);
+
+    int32 NumMismatches = 0;
+    for (int32 Level = 0; Level < 256; ++Level)
+    {
+        for (int32 Index = 0; Index < 16; ++Index)
+        {
+            Pixels[Index * 4 + 0] = (uint8)Level;
+            Pixels[Index * 4 + 1] = (uint8)Level;
+            Pixels[Index * 4 + 2] = (uint8)Level;
+            Pixels[Index * 4 + 3] = (Index & 1) ? 255 : 127;
+        }
+
+        const double Linear = FLinearColor::sRGBToLinearTable[Level];
+
+        FPixelPackingHelpers::PackR5G6B5(Pixels.GetData(), Texels.GetData(), 4, 4);
+        double Blue = 0.0, Green = 0.0, Red = 0.0;
+        for (uint16 Texel : Texels)
+        {
+            Blue += (Texel & 31) / 31.0 / 16.0;
+            Green += ((Texel >> 5) & 63) / 63.0 / 16.0;
+            Red += (Texel >> 11) / 31.0 / 16.0;
+        }
+
+        const bool bR5G6B5Matches = FMath::Abs(Blue - Linear) <= 1.0 / (31 * 16) && FMath::Abs(Green - Linear) <= 1.0 / (63 * 16) && FMath::Abs(Red - Linear) <= 1.0 / (31 * 16);
+
+        FPixelPackingHelpers::PackB5G5R5A1(Pixels.GetData(), Texels.GetData(), 4, 4);
+        double Average = 0.0;
+        bool bAlphaMatches = true;
+        for (int32 Index = 0; Index < 16; ++Index)
+        {
+            Average += ((Texels[Index] >> 10) & 31) / 31.0 / 16.0;
+            bAlphaMatches &= (Texels[Index] >> 15) == (Index & 1);
+        }
+
+        const bool bB5G5R5A1Matches = FMath::Abs(Average - Linear) <= 1.0 / (31 * 16) && bAlphaMatches;
+
+        if (!bR5G6B5Matches || !bB5G5R5A1Matches)
+        {
+            AddError(FString::Printf(TEXT("Packed level %d averages to R %.4f G %.4f B %.4f, B5G5R5A1 R %.4f, instead of %.4f"), Level, Red, Green, Blue, Average, Linear));
+            ++NumMismatches;
+        }
+    }
+    TestEqual(TEXT("Levels whose packed average differs from the linear value"), NumMismatches, 0);
+
+    // white and black are exact, without dither noise
+    FMemory::Memset(Pixels.GetData(), 255, Pixels.Num());
+    FPixelPackingHelpers::PackR5G6B5(Pixels.GetData(), Texels.GetData(), 4, 4);
+    TestTrue(TEXT("White is exact"), Texels.FilterByPredicate([](uint16 Texel) { return Texel != 0xFFFF; }).Num() == 0);
+
+    FMemory::Memset(Pixels.GetData(), 0, Pixels.Num());
+    FPixelPackingHelpers::PackR5G6B5(Pixels.GetData(), Texels.GetData(), 4, 4);
+    TestTrue(TEXT("Black is exact"), Texels.FilterByPredicate([](uint16 Texel) { return Texel != 0; }).Num() == 0);
+
+    // the format is chosen by the whole mip chain, alpha of a pixel checkerboard blends to a half in the mips
+    FRuntimeImageData Image;
+    Image.Init(8, 8, ERawImageFormat::BGRA8, EGammaSpace::sRGB);
+    for (int32 Index = 0; Index < 64; ++Index)
+    {
+        const bool bTransparent = ((Index % 8) + (Index / 8)) % 2 == 0;
+        FMemory::Memset(Image.RawData.GetData() + Index * 4, 200, 3);
+        Image.RawData[Index * 4 + 3] = bTransparent ? 0 : 255;
+    }
+    Image.ClassifyAlpha();
+    TestEqual(TEXT("Binary image packs to B5G5R5A1"), (int32)FPixelPackingHelpers::GetPackedFormat(Image), (int32)PF_B5G5R5A1_UNORM);
+
+    FRuntimeImageData MippedImage = Image;
+    FImageResampler::GenerateMips(MippedImage, FImageResampler::EFilter::Box);
+    TestTrue(TEXT("Mips are generated"), MippedImage.NumMips > 1);
+    TestEqual(TEXT("Binary image with translucent mips is not packed"), (int32)FPixelPackingHelpers::GetPackedFormat(MippedImage), (int32)PF_Unknown);
+
+    // opaque mips stay opaque
+    FMemory::Memset(Image.RawData.GetData(), 255, Image.RawData.Num());
+    Image.AlphaUsage = ERuntimeImageAlphaUsage::Unknown;
+    Image.ClassifyAlpha();
+    FImageResampler::GenerateMips(Image, FImageResampler::EFilter::Box);
+    TestEqual(TEXT("Opaque image with mips packs to R5G6B5"), (int32)FPixelPackingHelpers::GetPackedFormat(Image), (int32)PF_R5G6B5_UNORM);
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
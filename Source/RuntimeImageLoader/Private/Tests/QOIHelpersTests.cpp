@@ -0,0 +1,194 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "RuntimeImageLoaderTests.h"
+#include "Helpers/QOIHelpers.h"
+#include "Serialization/MemoryWriter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    /** Runs, small and large steps, alpha changes and repeats of earlier colors, so every QOI op is used */
+    TArray<uint8> MakePixels(int32 Width, int32 Height, int32 Seed)
+    {
+        TArray<uint8> Noise;
+        Noise.SetNumUninitialized(Width * Height * 4);
+        FRuntimeImageLoaderTests::FillRandom(Noise.GetData(), Noise.Num(), Seed);
+
+        TArray<uint8> Pixels;
+        Pixels.SetNumUninitialized(Width * Height * 4);
+        for (int32 Index = 0; Index < Width * Height; ++Index)
+        {
+            const uint8* Random = Noise.GetData() + Index * 4;
+            uint8* Pixel = Pixels.GetData() + Index * 4;
+            switch ((Index / 16) % 5)
+            {
+                case 0: // run
+                    FMemory::Memset(Pixel, 200, 4);
+                    break;
+                case 1: // steps that fit the diff and luma ops
+                    Pixel[0] = (uint8)(Index + (Random[0] & 1));
+                    Pixel[1] = (uint8)(Index * 2 + (Random[1] & 3));
+                    Pixel[2] = (uint8)(Index * 3);
+                    Pixel[3] = 255;
+                    break;
+                case 2: // a few colors picked from the index
+                    FMemory::Memset(Pixel, (Random[0] & 3) * 60, 3);
+                    Pixel[3] = 255;
+                    break;
+                default:
+                    FMemory::Memcpy(Pixel, Random, 4);
+                    Pixel[3] = (Random[3] & 1) ? 255 : Random[3];
+                    break;
+            }
+        }
+        return Pixels;
+    }
+
+    TArray<uint8> Encode(const TArray<uint8>& Pixels, int32 Width, int32 Height, bool bHasAlpha, int32 PixelsPerWrite)
+    {
+        TArray<uint8> File;
+        FMemoryWriter Writer(File);
+
+        FQOIWriter QOIWriter(Writer, Width, Height, bHasAlpha, true);
+        for (int32 First = 0; First < Width * Height; First += PixelsPerWrite)
+        {
+            QOIWriter.WritePixels(Pixels.GetData() + First * 4, FMath::Min(PixelsPerWrite, Width * Height - First));
+        }
+        QOIWriter.Finish();
+
+        return File;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FQOIHelpersOpsTest, "RuntimeImageLoader.QOI.Ops", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FQOIHelpersOpsTest::RunTest(const FString& Parameters)
+{
+    // 4x2 RGBA image of one op per pixel, as the specification encodes it
+    const TArray<uint8> File =
+    {
+        'q', 'o', 'i', 'f', 0, 0, 0, 4, 0, 0, 0, 2, 4, 0,
+        0xFE, 16, 32, 48,           // RGB
+        0x76,                       // DIFF, red +1, green -1, blue 0
+        0xAA, 0x5D,                 // LUMA, green +10, red -3 and blue +5 from it
+        0xFF, 1, 2, 3, 128,         // RGBA
+        0x15,                       // INDEX of the first pixel
+        0xC2,                       // RUN of 3
+        0, 0, 0, 0, 0, 0, 0, 1
+    };
+
+    // BGRA8
+    const TArray64<uint8> Expected =
+    {
+        48, 32, 16, 255,
+        48, 31, 17, 255,
+        63, 41, 24, 255,
+        3, 2, 1, 128,
+        48, 32, 16, 255,
+        48, 32, 16, 255,
+        48, 32, 16, 255,
+        48, 32, 16, 255
+    };
+
+    FQOILoader Loader;
+    if (!TestTrue(TEXT("Decoded"), Loader.Load(File.GetData(), File.Num())))
+    {
+        AddError(Loader.GetLastError());
+        return false;
+    }
+
+    TestEqual(TEXT("Format"), (int32)Loader.TextureSourceFormat, (int32)TSF_BGRA8);
+    TestTrue(TEXT("Decoded straight to BGRA8"), Loader.RawData == Expected);
+
+    // the writer picks the same ops
+    TArray<uint8> Pixels(Expected.GetData(), (int32)Expected.Num());
+    TestTrue(TEXT("Encoded with the same ops"), Encode(Pixels, 4, 2, true, 3) == File);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FQOIHelpersRoundTripTest, "RuntimeImageLoader.QOI.RoundTrip", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FQOIHelpersRoundTripTest::RunTest(const FString& Parameters)
+{
+    const int32 Width = 97;
+    const int32 Height = 53;
+    const TArray<uint8> Pixels = MakePixels(Width, Height, 5);
+
+    // the output doesn't depend on how the pixels are handed to the writer, runs and the index carry over
+    const TArray<uint8> File = Encode(Pixels, Width, Height, true, Width * Height);
+    TestTrue(TEXT("Pixel by pixel"), Encode(Pixels, Width, Height, true, 1) == File);
+    TestTrue(TEXT("Blocks across rows"), Encode(Pixels, Width, Height, true, 61) == File);
+
+    FQOILoader Loader;
+    if (TestTrue(TEXT("RGBA decoded"), Loader.Load(File.GetData(), File.Num())))
+    {
+        TestEqual(TEXT("RGBA size"), FIntPoint(Loader.Width, Loader.Height), FIntPoint(Width, Height));
+        TestTrue(TEXT("RGBA round trip"), Loader.RawData == TArray64<uint8>(Pixels.GetData(), Pixels.Num()));
+        TestTrue(TEXT("sRGB"), Loader.bSRGB);
+    }
+
+    // images without alpha come back opaque
+    TArray64<uint8> Opaque(Pixels.GetData(), Pixels.Num());
+    for (int64 Index = 3; Index < Opaque.Num(); Index += 4)
+    {
+        Opaque[Index] = 255;
+    }
+
+    const TArray<uint8> RGBFile = Encode(Pixels, Width, Height, false, 29);
+    if (TestTrue(TEXT("RGB decoded"), Loader.Load(RGBFile.GetData(), RGBFile.Num())))
+    {
+        TestTrue(TEXT("RGB round trip"), Loader.RawData == Opaque);
+    }
+
+    // the writer fails until every pixel is written
+    TArray<uint8> Partial;
+    FMemoryWriter Writer(Partial);
+    FQOIWriter QOIWriter(Writer, Width, Height, true, true);
+    QOIWriter.WritePixels(Pixels.GetData(), Width * Height - 1);
+    TestFalse(TEXT("Missing pixel"), QOIWriter.Finish());
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FQOIHelpersRegionTest, "RuntimeImageLoader.QOI.Region", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FQOIHelpersRegionTest::RunTest(const FString& Parameters)
+{
+    const int32 Width = 64;
+    const int32 Height = 40;
+    const TArray<uint8> Pixels = MakePixels(Width, Height, 9);
+    const TArray<uint8> File = Encode(Pixels, Width, Height, true, Width);
+
+    // full rows are decoded in place, narrower regions through a row buffer
+    const FIntRect Regions[] = { FIntRect(0, 7, Width, 31), FIntRect(5, 3, 45, 40), FIntRect(60, 30, 100, 100) };
+    for (const FIntRect& Region : Regions)
+    {
+        const FString What = FString::Printf(TEXT("Region %s"), *Region.ToString());
+
+        FQOILoader Loader;
+        if (!TestTrue(What, Loader.Load(File.GetData(), File.Num(), Region)))
+        {
+            AddError(Loader.GetLastError());
+            continue;
+        }
+
+        const FIntRect Clipped(Region.Min, FIntPoint(FMath::Min(Region.Max.X, Width), FMath::Min(Region.Max.Y, Height)));
+        TestEqual(What + TEXT(" is clipped"), Loader.Region, Clipped);
+
+        TArray64<uint8> Expected;
+        for (int32 Y = Clipped.Min.Y; Y < Clipped.Max.Y; ++Y)
+        {
+            Expected.Append(Pixels.GetData() + (Y * Width + Clipped.Min.X) * 4, Clipped.Width() * 4);
+        }
+        TestTrue(What + TEXT(" pixels"), Loader.RawData == Expected);
+    }
+
+    FQOILoader Loader;
+    TestFalse(TEXT("Region outside of the image"), Loader.Load(File.GetData(), File.Num(), FIntRect(70, 0, 80, 10)));
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,33 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "Runtime/Launch/Resources/Version.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// benchmarks only report their timings, they run with the performance tests
+#if (ENGINE_MAJOR_VERSION > 5) || ((ENGINE_MAJOR_VERSION == 5) && (ENGINE_MINOR_VERSION >= 5))
+#define RUNTIMEIMAGELOADER_TEST_FLAGS (EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+#define RUNTIMEIMAGELOADER_PERF_TEST_FLAGS (EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+#else
+#define RUNTIMEIMAGELOADER_TEST_FLAGS (EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+#define RUNTIMEIMAGELOADER_PERF_TEST_FLAGS (EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+#endif
+
+namespace FRuntimeImageLoaderTests
+{
+    /** Deterministic pseudo random bytes, tests are reproducible run to run */
+    inline void FillRandom(uint8* Data, int64 Num, int32 Seed)
+    {
+        FRandomStream Random(Seed);
+        for (int64 Index = 0; Index < Num; ++Index)
+        {
+            Data[Index] = (uint8)Random.RandRange(0, 255);
+        }
+    }
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,170 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "RuntimeImageLoaderTests.h"
+#include "Helpers/TGAHelpers.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    using namespace FTGAHelpers;
+
+    /** Uncompressed TGA of random pixels, 8bpp images are grayscale */
+    TArray<uint8> MakeTGA(int32 Width, int32 Height, int32 BitsPerPixel, uint8 ImageDescriptor)
+    {
+        const int32 PixelBytes = BitsPerPixel / 8;
+
+        TArray<uint8> File;
+        File.SetNumZeroed(sizeof(FTGAFileHeader) + Width * Height * PixelBytes);
+
+        FTGAFileHeader* Header = (FTGAFileHeader*)File.GetData();
+        Header->ImageTypeCode = BitsPerPixel == 8 ? 3 : 2;
+        Header->Width = Width;
+        Header->Height = Height;
+        Header->BitsPerPixel = BitsPerPixel;
+        Header->ImageDescriptor = ImageDescriptor;
+
+        FRuntimeImageLoaderTests::FillRandom(File.GetData() + sizeof(FTGAFileHeader), Width * Height * PixelBytes, Width * 131 + Height * 7 + BitsPerPixel + ImageDescriptor);
+        return File;
+    }
+
+    /** Pixel by pixel decode of MakeTGA output, the scalar path the row kernels must match */
+    TArray64<uint8> DecodeReference(const TArray<uint8>& File)
+    {
+        const FTGAFileHeader* Header = (const FTGAFileHeader*)File.GetData();
+        const uint8* Pixels = File.GetData() + sizeof(FTGAFileHeader);
+        const int32 Width = Header->Width;
+        const int32 Height = Header->Height;
+        const int32 PixelBytes = Header->BitsPerPixel / 8;
+        const bool bFlipX = (Header->ImageDescriptor & 0x10) != 0;
+        const bool bFlipY = (Header->ImageDescriptor & 0x20) != 0;
+
+        TArray64<uint8> Result;
+        Result.SetNumUninitialized((int64)Width * Height * (PixelBytes == 1 ? 1 : 4));
+
+        for (int32 Y = 0; Y < Height; ++Y)
+        {
+            for (int32 X = 0; X < Width; ++X)
+            {
+                // rows are stored bottom up unless the top to bottom bit is set
+                const int32 SourceX = bFlipX ? Width - 1 - X : X;
+                const int32 SourceY = bFlipY ? Y : Height - 1 - Y;
+                const uint8* Source = Pixels + (SourceY * Width + SourceX) * PixelBytes;
+
+                if (PixelBytes == 1)
+                {
+                    Result[Y * Width + X] = Source[0];
+                    continue;
+                }
+
+                uint8* Dest = &Result[(Y * Width + X) * 4];
+                if (PixelBytes == 2)
+                {
+                    // A1R5G5B5, the low bits of the channels stay zero and the alpha bit becomes 0x80 as in the engine importer
+                    const uint16 Pixel = Source[0] | (Source[1] << 8);
+                    Dest[0] = (Pixel & 0x1F) << 3;
+                    Dest[1] = ((Pixel >> 5) & 0x1F) << 3;
+                    Dest[2] = ((Pixel >> 10) & 0x1F) << 3;
+                    Dest[3] = (Pixel & 0x8000) ? 0x80 : 0;
+                }
+                else
+                {
+                    Dest[0] = Source[0];
+                    Dest[1] = Source[1];
+                    Dest[2] = Source[2];
+                    Dest[3] = PixelBytes == 4 ? Source[3] : 255;
+                }
+            }
+        }
+
+        return Result;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTGAHelpersDecompressTest, "RuntimeImageLoader.TGA.Decompress", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FTGAHelpersDecompressTest::RunTest(const FString& Parameters)
+{
+    const int32 BitDepths[] = { 8, 16, 24, 32 };
+    const uint8 Descriptors[] = { 0x00, 0x10, 0x20, 0x30 };
+    const int32 Heights[] = { 1, 2, 5 };
+
+    // widths around the vector widths of the row kernels, including rows shorter than one vector
+    for (int32 Width = 1; Width <= 37; ++Width)
+    {
+        for (int32 Height : Heights)
+        {
+            for (int32 BitsPerPixel : BitDepths)
+            {
+                for (uint8 Descriptor : Descriptors)
+                {
+                    const FString What = FString::Printf(TEXT("%dx%d %dbpp descriptor 0x%02x"), Width, Height, BitsPerPixel, Descriptor);
+                    const TArray<uint8> File = MakeTGA(Width, Height, BitsPerPixel, Descriptor);
+                    const TArray64<uint8> Expected = DecodeReference(File);
+
+                    FRuntimeImageData Image;
+                    FString Error;
+                    if (!TestTrue(What, DecompressTGA((const FTGAFileHeader*)File.GetData(), Image, Error)))
+                    {
+                        AddError(Error);
+                        continue;
+                    }
+                    TestTrue(What + TEXT(" matches the reference"), Image.RawData == Expected);
+
+                    // region reads share the row kernels, a region off the image corner covers the clipping as well
+                    const FIntRect Region(Width / 3, Height / 2, Width + 4, Height + 4);
+                    FRuntimeImageData RegionImage;
+                    if (!TestTrue(What + TEXT(" region"), DecompressTGARegion((const FTGAFileHeader*)File.GetData(), File.Num(), Region, RegionImage, Error)))
+                    {
+                        AddError(Error);
+                        continue;
+                    }
+
+                    const int32 PixelBytes = BitsPerPixel == 8 ? 1 : 4;
+                    const int32 RegionWidth = Width - Region.Min.X;
+                    bool bRegionMatches = RegionImage.SizeX == RegionWidth && RegionImage.SizeY == Height - Region.Min.Y;
+                    for (int32 Y = 0; bRegionMatches && Y < RegionImage.SizeY; ++Y)
+                    {
+                        const uint8* ExpectedRow = Expected.GetData() + ((int64)(Region.Min.Y + Y) * Width + Region.Min.X) * PixelBytes;
+                        bRegionMatches = FMemory::Memcmp(RegionImage.RawData.GetData() + (int64)Y * RegionWidth * PixelBytes, ExpectedRow, RegionWidth * PixelBytes) == 0;
+                    }
+                    TestTrue(What + TEXT(" region matches the reference"), bRegionMatches);
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTGAHelpersTruncatedRegionTest, "RuntimeImageLoader.TGA.TruncatedRegion", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FTGAHelpersTruncatedRegionTest::RunTest(const FString& Parameters)
+{
+    TArray<uint8> File = MakeTGA(16, 8, 32, 0x00);
+    const FIntRect Region(2, 2, 6, 6);
+
+    FRuntimeImageData Image;
+    FString Error;
+    TestTrue(TEXT("Whole file"), DecompressTGARegion((const FTGAFileHeader*)File.GetData(), File.Num(), Region, Image, Error));
+
+    // the region is at the top of a bottom up image, the rows it reads are the last ones of the file
+    Error.Empty();
+    TestFalse(TEXT("Last row missing"), DecompressTGARegion((const FTGAFileHeader*)File.GetData(), File.Num() - 16 * 4, Region, Image, Error));
+    TestFalse(TEXT("Last row missing reports an error"), Error.IsEmpty());
+
+    // id field and color map lengths move the rows past the end of the file
+    ((FTGAFileHeader*)File.GetData())->IdFieldLength = 200;
+    Error.Empty();
+    TestFalse(TEXT("Id field past the rows"), DecompressTGARegion((const FTGAFileHeader*)File.GetData(), File.Num(), Region, Image, Error));
+
+    ((FTGAFileHeader*)File.GetData())->IdFieldLength = 0;
+    ((FTGAFileHeader*)File.GetData())->ColorMapEntrySize = 24;
+    ((FTGAFileHeader*)File.GetData())->ColorMapLength = 4;
+    Error.Empty();
+    TestFalse(TEXT("Color map past the rows"), DecompressTGARegion((const FTGAFileHeader*)File.GetData(), File.Num(), Region, Image, Error));
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,494 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "RuntimeImageLoaderTests.h"
+#include "Helpers/TIFFHelpers.h"
+
+THIRD_PARTY_INCLUDES_START
+#include "zlib.h"
+THIRD_PARTY_INCLUDES_END
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    struct FTIFFOptions
+    {
+        int32 Width = 1;
+        int32 Height = 1;
+        int32 SamplesPerPixel = 3;
+        int32 BitsPerSample = 8;
+        uint32 Compression = 1;
+        uint32 Predictor = 1;
+        uint32 Photometric = 0;
+        bool bBigEndian = false;
+        // whole image in one strip if 0
+        int32 RowsPerStrip = 0;
+        // strips if 0
+        int32 TileSize = 0;
+        // added to the byte count of every chunk, for chunks that are cut or run past the end of the file
+        int32 ByteCountAdjustment = 0;
+    };
+
+    struct FTestTIFF
+    {
+        TArray<uint8> File;
+        // pixels the decoder must return, BGRA8, G8, G16 or RGBA16 top to bottom
+        TArray64<uint8> Expected;
+        ETextureSourceFormat Format = TSF_Invalid;
+    };
+
+    /** LZW as libtiff writes it: a clear code first, codes widen when the next free code needs another bit, cleared when the table is full */
+    TArray<uint8> EncodeLZW(const TArray<uint8>& Data)
+    {
+        const int32 ClearCode = 256;
+        const int32 EndCode = 257;
+        const int32 FirstCode = 258;
+
+        TArray<uint8> Out;
+        uint32 BitBuffer = 0;
+        int32 NumBits = 0;
+        int32 CodeWidth = 9;
+
+        auto Emit = [&](int32 Code)
+        {
+            BitBuffer = (BitBuffer << CodeWidth) | (uint32)Code;
+            NumBits += CodeWidth;
+            while (NumBits >= 8)
+            {
+                Out.Add((uint8)(BitBuffer >> (NumBits - 8)));
+                NumBits -= 8;
+            }
+        };
+
+        TMap<uint32, int32> Codes;
+        int32 NextCode = FirstCode;
+
+        auto AddCode = [&](uint32 Key)
+        {
+            if (NextCode == 4094)
+            {
+                Emit(ClearCode);
+                Codes.Reset();
+                NextCode = FirstCode;
+                CodeWidth = 9;
+                return;
+            }
+
+            Codes.Add(Key, NextCode++);
+            if (NextCode > (1 << CodeWidth) - 1)
+            {
+                ++CodeWidth;
+            }
+        };
+
+        Emit(ClearCode);
+        if (Data.Num() > 0)
+        {
+            int32 Current = Data[0];
+            for (int32 Index = 1; Index < Data.Num(); ++Index)
+            {
+                const uint32 Key = ((uint32)Current << 8) | Data[Index];
+                if (const int32* Code = Codes.Find(Key))
+                {
+                    Current = *Code;
+                    continue;
+                }
+
+                Emit(Current);
+                AddCode(Key);
+                Current = Data[Index];
+            }
+
+            Emit(Current);
+            AddCode(MAX_uint32);
+        }
+        Emit(EndCode);
+
+        if (NumBits > 0)
+        {
+            Out.Add((uint8)(BitBuffer << (8 - NumBits)));
+        }
+        return Out;
+    }
+
+    /** Strips or tiles of smooth noisy samples, so LZW finds runs to compress */
+    FTestTIFF MakeTIFF(const FTIFFOptions& Options, int32 Seed)
+    {
+        const int32 BytesPerSample = Options.BitsPerSample / 8;
+        const int32 NumSamples = Options.Width * Options.Height * Options.SamplesPerPixel;
+
+        TArray<uint8> Noise;
+        Noise.SetNumUninitialized(NumSamples);
+        FRuntimeImageLoaderTests::FillRandom(Noise.GetData(), NumSamples, Seed);
+
+        TArray<uint16> Samples;
+        Samples.SetNumUninitialized(NumSamples);
+        for (int32 Index = 0; Index < NumSamples; ++Index)
+        {
+            const int32 Pixel = Index / Options.SamplesPerPixel;
+            const uint32 Smooth = (Pixel % Options.Width) * 3 + (Pixel / Options.Width) * 2 + (Index % Options.SamplesPerPixel) * 40;
+            Samples[Index] = BytesPerSample == 1 ? (uint16)((Smooth + (Noise[Index] & 3)) & 0xFF) : (uint16)(Smooth * 97 + Noise[Index]);
+        }
+
+        FTestTIFF TIFF;
+        const bool bGray = Options.SamplesPerPixel == 1;
+        TIFF.Format = bGray ? (BytesPerSample == 1 ? TSF_G8 : TSF_G16) : (BytesPerSample == 1 ? TSF_BGRA8 : TSF_RGBA16);
+
+        for (int32 Pixel = 0; Pixel < Options.Width * Options.Height; ++Pixel)
+        {
+            const uint16* Sample = Samples.GetData() + Pixel * Options.SamplesPerPixel;
+            const bool bAlpha = Options.SamplesPerPixel == 4;
+            if (bGray && BytesPerSample == 1)
+            {
+                TIFF.Expected.Add((uint8)Sample[0]);
+            }
+            else if (bGray)
+            {
+                TIFF.Expected.Append((const uint8*)Sample, 2);
+            }
+            else if (BytesPerSample == 1)
+            {
+                TIFF.Expected.Append({ (uint8)Sample[2], (uint8)Sample[1], (uint8)Sample[0], bAlpha ? (uint8)Sample[3] : (uint8)255 });
+            }
+            else
+            {
+                const uint16 RGBA[4] = { Sample[0], Sample[1], Sample[2], bAlpha ? Sample[3] : (uint16)0xFFFF };
+                TIFF.Expected.Append((const uint8*)RGBA, sizeof(RGBA));
+            }
+        }
+
+        auto AppendValue = [&Options](TArray<uint8>& Out, uint32 Value, int32 Size)
+        {
+            for (int32 Byte = 0; Byte < Size; ++Byte)
+            {
+                Out.Add((uint8)(Value >> ((Options.bBigEndian ? Size - 1 - Byte : Byte) * 8)));
+            }
+        };
+
+        // chunks are the strips or the tiles, tiles over the image edges are padded with zeros
+        const bool bTiled = Options.TileSize > 0;
+        const int32 ChunkWidth = bTiled ? Options.TileSize : Options.Width;
+        const int32 ChunkHeight = bTiled ? Options.TileSize : (Options.RowsPerStrip > 0 ? Options.RowsPerStrip : Options.Height);
+        const int32 ChunksAcross = FMath::DivideAndRoundUp(Options.Width, ChunkWidth);
+        const int32 NumChunks = ChunksAcross * FMath::DivideAndRoundUp(Options.Height, ChunkHeight);
+
+        TArray<uint8>& File = TIFF.File;
+        File.Append(Options.bBigEndian ? TArray<uint8>({ 'M', 'M' }) : TArray<uint8>({ 'I', 'I' }));
+        AppendValue(File, 42, 2);
+        AppendValue(File, 0, 4);
+
+        TArray<uint32> Offsets;
+        TArray<uint32> ByteCounts;
+        for (int32 Chunk = 0; Chunk < NumChunks; ++Chunk)
+        {
+            const int32 X0 = (Chunk % ChunksAcross) * ChunkWidth;
+            const int32 Y0 = (Chunk / ChunksAcross) * ChunkHeight;
+            const int32 Rows = bTiled ? ChunkHeight : FMath::Min(ChunkHeight, Options.Height - Y0);
+
+            TArray<uint8> Raw;
+            for (int32 Row = 0; Row < Rows; ++Row)
+            {
+                TArray<uint32> RowSamples;
+                RowSamples.SetNumZeroed(ChunkWidth * Options.SamplesPerPixel);
+                for (int32 Index = 0; Index < RowSamples.Num(); ++Index)
+                {
+                    const int32 X = X0 + Index / Options.SamplesPerPixel;
+                    const int32 Y = Y0 + Row;
+                    if (X < Options.Width && Y < Options.Height)
+                    {
+                        RowSamples[Index] = Samples[(Y * Options.Width + X) * Options.SamplesPerPixel + Index % Options.SamplesPerPixel];
+                    }
+                }
+
+                // horizontal differencing wraps around the sample size
+                if (Options.Predictor == 2)
+                {
+                    for (int32 Index = RowSamples.Num() - 1; Index >= Options.SamplesPerPixel; --Index)
+                    {
+                        RowSamples[Index] = (RowSamples[Index] - RowSamples[Index - Options.SamplesPerPixel]) & (BytesPerSample == 1 ? 0xFF : 0xFFFF);
+                    }
+                }
+
+                for (uint32 Value : RowSamples)
+                {
+                    AppendValue(Raw, Value, BytesPerSample);
+                }
+            }
+
+            TArray<uint8> Compressed = Raw;
+            if (Options.Compression == 5)
+            {
+                Compressed = EncodeLZW(Raw);
+            }
+            else if (Options.Compression == 8 || Options.Compression == 32946)
+            {
+                uLongf CompressedSize = compressBound(Raw.Num());
+                Compressed.SetNumUninitialized(CompressedSize);
+                compress2(Compressed.GetData(), &CompressedSize, Raw.GetData(), Raw.Num(), Z_BEST_COMPRESSION);
+                Compressed.SetNum(CompressedSize);
+            }
+
+            Offsets.Add(File.Num());
+            ByteCounts.Add(Compressed.Num() + Options.ByteCountAdjustment);
+            File.Append(Compressed);
+        }
+
+        struct FEntry
+        {
+            uint16 Tag;
+            uint16 Type;
+            TArray<uint32> Values;
+        };
+
+        const uint16 Short = 3;
+        const uint16 Long = 4;
+        TArray<uint32> BitsPerSample;
+        BitsPerSample.Init(Options.BitsPerSample, Options.SamplesPerPixel);
+
+        // entries are sorted by tag
+        TArray<FEntry> Entries;
+        Entries.Add({ 256, Long, { (uint32)Options.Width } });                                       // ImageWidth
+        Entries.Add({ 257, Long, { (uint32)Options.Height } });                                      // ImageLength
+        Entries.Add({ 258, Short, BitsPerSample });                                                  // BitsPerSample
+        Entries.Add({ 259, Short, { Options.Compression } });                                        // Compression
+        Entries.Add({ 262, Short, { Options.Photometric ? Options.Photometric : (bGray ? 1u : 2u) } });  // PhotometricInterpretation
+        if (!bTiled)
+        {
+            Entries.Add({ 273, Long, Offsets });                                                     // StripOffsets
+        }
+        Entries.Add({ 277, Short, { (uint32)Options.SamplesPerPixel } });                            // SamplesPerPixel
+        if (!bTiled)
+        {
+            Entries.Add({ 278, Short, { (uint32)ChunkHeight } });                                    // RowsPerStrip
+            Entries.Add({ 279, Long, ByteCounts });                                                  // StripByteCounts
+        }
+        Entries.Add({ 284, Short, { 1 } });                                                          // PlanarConfiguration, chunky
+        Entries.Add({ 317, Short, { Options.Predictor } });                                          // Predictor
+        if (bTiled)
+        {
+            Entries.Add({ 322, Short, { (uint32)ChunkWidth } });                                     // TileWidth
+            Entries.Add({ 323, Short, { (uint32)ChunkHeight } });                                    // TileLength
+            Entries.Add({ 324, Long, Offsets });                                                     // TileOffsets
+            Entries.Add({ 325, Long, ByteCounts });                                                  // TileByteCounts
+        }
+
+        // values that don't fit in the entry are written before the directory
+        TArray<uint32> ValueOffsets;
+        for (const FEntry& Entry : Entries)
+        {
+            const int32 ValueSize = Entry.Type == Short ? 2 : 4;
+            ValueOffsets.Add(File.Num());
+            if (Entry.Values.Num() * ValueSize > 4)
+            {
+                for (uint32 Value : Entry.Values)
+                {
+                    AppendValue(File, Value, ValueSize);
+                }
+            }
+        }
+
+        if (File.Num() % 2)
+        {
+            File.Add(0);
+        }
+
+        const uint32 DirectoryOffset = File.Num();
+        AppendValue(File, Entries.Num(), 2);
+        for (int32 Index = 0; Index < Entries.Num(); ++Index)
+        {
+            const FEntry& Entry = Entries[Index];
+            const int32 ValueSize = Entry.Type == Short ? 2 : 4;
+            AppendValue(File, Entry.Tag, 2);
+            AppendValue(File, Entry.Type, 2);
+            AppendValue(File, Entry.Values.Num(), 4);
+
+            // values that fit are left aligned in the value field
+            if (Entry.Values.Num() * ValueSize > 4)
+            {
+                AppendValue(File, ValueOffsets[Index], 4);
+            }
+            else
+            {
+                for (uint32 Value : Entry.Values)
+                {
+                    AppendValue(File, Value, ValueSize);
+                }
+                File.AddZeroed(4 - Entry.Values.Num() * ValueSize);
+            }
+        }
+        AppendValue(File, 0, 4);
+
+        TArray<uint8> Header;
+        AppendValue(Header, DirectoryOffset, 4);
+        FMemory::Memcpy(File.GetData() + 4, Header.GetData(), 4);
+
+        return TIFF;
+    }
+
+    bool Decode(const TArray<uint8>& File, FRuntimeImageData& OutImage, FString& OutError)
+    {
+        return FTIFFHelpers::DecodeParallel(File.GetData(), File.Num(), OutImage, OutError);
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTIFFHelpersLayoutsTest, "RuntimeImageLoader.TIFF.ParallelLayouts", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FTIFFHelpersLayoutsTest::RunTest(const FString& Parameters)
+{
+    struct FCase
+    {
+        const TCHAR* Name;
+        FTIFFOptions Options;
+    };
+
+    auto Make = [](int32 Width, int32 Height, int32 Samples, int32 Bits, uint32 Compression, uint32 Predictor, bool bBigEndian, int32 RowsPerStrip, int32 TileSize)
+    {
+        FTIFFOptions Options;
+        Options.Width = Width;
+        Options.Height = Height;
+        Options.SamplesPerPixel = Samples;
+        Options.BitsPerSample = Bits;
+        Options.Compression = Compression;
+        Options.Predictor = Predictor;
+        Options.bBigEndian = bBigEndian;
+        Options.RowsPerStrip = RowsPerStrip;
+        Options.TileSize = TileSize;
+        return Options;
+    };
+
+    const FCase Cases[] =
+    {
+        { TEXT("Uncompressed RGB, one strip in bands"), Make(301, 157, 3, 8, 1, 1, false, 0, 0) },
+        { TEXT("Uncompressed gray, strips of 7 rows"), Make(45, 130, 1, 8, 1, 1, false, 7, 0) },
+        { TEXT("Uncompressed RGBA, big endian, predictor"), Make(33, 70, 4, 8, 1, 2, true, 16, 0) },
+        { TEXT("Uncompressed RGBA16, big endian, tiles"), Make(37, 21, 4, 16, 1, 1, true, 0, 16) },
+        { TEXT("LZW RGB"), Make(64, 48, 3, 8, 5, 1, false, 8, 0) },
+        { TEXT("LZW RGBA, predictor, one strip"), Make(200, 90, 4, 8, 5, 2, false, 0, 0) },
+        { TEXT("LZW RGB16, big endian, predictor"), Make(50, 41, 3, 16, 5, 2, true, 5, 0) },
+        { TEXT("LZW gray, tiles"), Make(37, 21, 1, 8, 5, 1, false, 0, 16) },
+        { TEXT("Deflate RGB, tiles, predictor"), Make(70, 35, 3, 8, 8, 2, false, 0, 32) },
+        { TEXT("Deflate gray16"), Make(29, 60, 1, 16, 8, 1, false, 9, 0) },
+        { TEXT("Adobe Deflate RGB16, big endian"), Make(31, 17, 3, 16, 32946, 1, true, 4, 0) },
+    };
+
+    int32 Seed = 0;
+    for (const FCase& Case : Cases)
+    {
+        const FTestTIFF TIFF = MakeTIFF(Case.Options, ++Seed);
+
+        FRuntimeImageData Image;
+        FString Error;
+        if (!TestTrue(Case.Name, Decode(TIFF.File, Image, Error)))
+        {
+            AddError(FString::Printf(TEXT("%s: %s"), Case.Name, Error.IsEmpty() ? TEXT("left to FreeImage") : *Error));
+            continue;
+        }
+
+        TestEqual(FString(Case.Name) + TEXT(" size"), FIntPoint(Image.SizeX, Image.SizeY), FIntPoint(Case.Options.Width, Case.Options.Height));
+        TestEqual(FString(Case.Name) + TEXT(" format"), (int32)Image.TextureSourceFormat, (int32)TIFF.Format);
+        TestEqual(FString(Case.Name) + TEXT(" sRGB"), Image.SRGB, TIFF.Format == TSF_BGRA8);
+        TestTrue(FString(Case.Name) + TEXT(" pixels"), Image.RawData == TIFF.Expected);
+    }
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTIFFHelpersFallbackTest, "RuntimeImageLoader.TIFF.ParallelFallback", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FTIFFHelpersFallbackTest::RunTest(const FString& Parameters)
+{
+    FTIFFOptions Options;
+    Options.Width = 24;
+    Options.Height = 16;
+    Options.RowsPerStrip = 4;
+
+    // layouts left to FreeImage return false without an error
+    auto TestFallback = [this](const TCHAR* What, const TArray<uint8>& File)
+    {
+        FRuntimeImageData Image;
+        FString Error;
+        TestFalse(What, Decode(File, Image, Error));
+        TestTrue(FString(What) + TEXT(" has no error"), Error.IsEmpty());
+    };
+
+    FTIFFOptions PackBits = Options;
+    PackBits.Compression = 32773;
+    TestFallback(TEXT("PackBits"), MakeTIFF(PackBits, 1).File);
+
+    FTIFFOptions Palette = Options;
+    Palette.SamplesPerPixel = 1;
+    Palette.Photometric = 3;
+    TestFallback(TEXT("Palette"), MakeTIFF(Palette, 2).File);
+
+    FTIFFOptions FloatPredictor = Options;
+    FloatPredictor.Predictor = 3;
+    TestFallback(TEXT("Floating point predictor"), MakeTIFF(FloatPredictor, 3).File);
+
+    FTestTIFF BigTIFF = MakeTIFF(Options, 4);
+    BigTIFF.File[2] = 43;
+    TestFallback(TEXT("BigTIFF"), BigTIFF.File);
+
+    // broken files fail with an error instead of going on to FreeImage
+    auto TestRejected = [this](const TCHAR* What, const TArray<uint8>& File)
+    {
+        FRuntimeImageData Image;
+        FString Error;
+        TestFalse(What, Decode(File, Image, Error));
+        TestFalse(FString(What) + TEXT(" reports an error"), Error.IsEmpty());
+    };
+
+    TestFallback(TEXT("Directory past the end"), TArray<uint8>(MakeTIFF(Options, 5).File.GetData(), 8));
+
+    FTIFFOptions ShortStrip = Options;
+    ShortStrip.ByteCountAdjustment = -1;
+    TestRejected(TEXT("Strip shorter than its rows"), MakeTIFF(ShortStrip, 6).File);
+
+    FTIFFOptions PastEnd = Options;
+    PastEnd.ByteCountAdjustment = 1 << 20;
+    TestRejected(TEXT("Strip past the end"), MakeTIFF(PastEnd, 7).File);
+
+    // the compressed data ends before the strip is full
+    FTIFFOptions CutLZW = Options;
+    CutLZW.Compression = 5;
+    CutLZW.ByteCountAdjustment = -16;
+    TestRejected(TEXT("LZW strip cut"), MakeTIFF(CutLZW, 8).File);
+
+    FTIFFOptions CutDeflate = Options;
+    CutDeflate.Compression = 8;
+    CutDeflate.ByteCountAdjustment = -16;
+    TestRejected(TEXT("Deflate strip cut"), MakeTIFF(CutDeflate, 9).File);
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTIFFHelpersLZWTest, "RuntimeImageLoader.TIFF.LZW", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FTIFFHelpersLZWTest::RunTest(const FString& Parameters)
+{
+    // long enough to fill the table a few times, with runs so strings grow past single bytes
+    TArray<uint8> Data;
+    Data.SetNumUninitialized(64 * 1024);
+    FRuntimeImageLoaderTests::FillRandom(Data.GetData(), Data.Num(), 7);
+    for (int32 Index = 0; Index < Data.Num(); ++Index)
+    {
+        Data[Index] = (Index / 512) % 2 ? (uint8)(Index / 3) : (Data[Index] & 7);
+    }
+
+    const TArray<uint8> Encoded = EncodeLZW(Data);
+
+    TArray<uint8> Decoded;
+    Decoded.SetNumZeroed(Data.Num());
+    TestTrue(TEXT("Decoded"), FTIFFHelpers::DecodeLZW(Encoded.GetData(), Encoded.Num(), Decoded.GetData(), Decoded.Num()));
+    TestTrue(TEXT("Round trip"), Decoded == Data);
+
+    // a strip must hold all of its rows
+    TestFalse(TEXT("Stream ends early"), FTIFFHelpers::DecodeLZW(Encoded.GetData(), Encoded.Num() / 2, Decoded.GetData(), Decoded.Num()));
+
+    TArray<uint8> Longer;
+    Longer.SetNumZeroed(Data.Num() + 1);
+    TestFalse(TEXT("End code before the strip is full"), FTIFFHelpers::DecodeLZW(Encoded.GetData(), Encoded.Num(), Longer.GetData(), Longer.Num()));
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,178 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "RuntimeImageLoaderTests.h"
+#include "ImageDecoders/TIFFImageDecoder.h"
+#include "Async/ParallelFor.h"
+
+#if WITH_DEV_AUTOMATION_TESTS && WITH_FREEIMAGE_LIB
+
+namespace
+{
+    struct FTestTIFF
+    {
+        TArray<uint8> File;
+        // pixels the decoder must return, BGRA8 top to bottom
+        TArray64<uint8> Expected;
+    };
+
+    void WriteUInt16(TArray<uint8>& Out, uint16 Value)
+    {
+        Out.Add((uint8)Value);
+        Out.Add((uint8)(Value >> 8));
+    }
+
+    void WriteUInt32(TArray<uint8>& Out, uint32 Value)
+    {
+        WriteUInt16(Out, (uint16)Value);
+        WriteUInt16(Out, (uint16)(Value >> 16));
+    }
+
+    /**
+     * Minimal little endian baseline TIFF, 8-bit RGB in a single PackBits strip of literal runs.
+     * PackBits is left to FreeImage by the parallel decoder, so these go through the FreeImage loader
+     */
+    FTestTIFF MakeTIFF(int32 Width, int32 Height, int32 Seed)
+    {
+        const int32 NumEntries = 10;
+        const int32 IFDOffset = 8;
+        const int32 BitsPerSampleOffset = IFDOffset + 2 + NumEntries * 12 + 4;
+        const int32 PixelsOffset = BitsPerSampleOffset + 3 * 2;
+        const int32 PixelsSize = Width * Height * 3;
+        const int32 PackedSize = PixelsSize + FMath::DivideAndRoundUp(PixelsSize, 128);
+
+        FTestTIFF TIFF;
+        TArray<uint8>& File = TIFF.File;
+
+        File.Append({ 'I', 'I', 42, 0 });
+        WriteUInt32(File, IFDOffset);
+
+        auto WriteEntry = [&File](uint16 Tag, uint16 Type, uint32 Count, uint32 Value)
+        {
+            WriteUInt16(File, Tag);
+            WriteUInt16(File, Type);
+            WriteUInt32(File, Count);
+            // SHORT values are left aligned in the value field
+            if (Type == 3 && Count == 1)
+            {
+                WriteUInt16(File, (uint16)Value);
+                WriteUInt16(File, 0);
+            }
+            else
+            {
+                WriteUInt32(File, Value);
+            }
+        };
+
+        const uint16 Short = 3;
+        const uint16 Long = 4;
+
+        // entries are sorted by tag
+        WriteUInt16(File, NumEntries);
+        WriteEntry(256, Long, 1, Width);                   // ImageWidth
+        WriteEntry(257, Long, 1, Height);                  // ImageLength
+        WriteEntry(258, Short, 3, BitsPerSampleOffset);    // BitsPerSample
+        WriteEntry(259, Short, 1, 32773);                  // Compression, PackBits
+        WriteEntry(262, Short, 1, 2);                      // PhotometricInterpretation, RGB
+        WriteEntry(273, Long, 1, PixelsOffset);            // StripOffsets
+        WriteEntry(277, Short, 1, 3);                      // SamplesPerPixel
+        WriteEntry(278, Long, 1, Height);                  // RowsPerStrip
+        WriteEntry(279, Long, 1, PackedSize);              // StripByteCounts
+        WriteEntry(284, Short, 1, 1);                      // PlanarConfiguration, chunky
+        WriteUInt32(File, 0);
+
+        WriteUInt16(File, 8);
+        WriteUInt16(File, 8);
+        WriteUInt16(File, 8);
+        check(File.Num() == PixelsOffset);
+
+        TArray<uint8> Pixels;
+        Pixels.AddUninitialized(PixelsSize);
+        FRuntimeImageLoaderTests::FillRandom(Pixels.GetData(), PixelsSize, Seed);
+
+        // a count byte of N is followed by N + 1 literal bytes
+        for (int32 RunStart = 0; RunStart < PixelsSize; RunStart += 128)
+        {
+            const int32 RunLength = FMath::Min(128, PixelsSize - RunStart);
+            File.Add((uint8)(RunLength - 1));
+            File.Append(Pixels.GetData() + RunStart, RunLength);
+        }
+
+        TIFF.Expected.SetNumUninitialized((int64)Width * Height * 4);
+        for (int64 Index = 0; Index < (int64)Width * Height; ++Index)
+        {
+            const uint8* RGB = Pixels.GetData() + Index * 3;
+            uint8* BGRA = TIFF.Expected.GetData() + Index * 4;
+            BGRA[0] = RGB[2];
+            BGRA[1] = RGB[1];
+            BGRA[2] = RGB[0];
+            BGRA[3] = 255;
+        }
+
+        return TIFF;
+    }
+
+    bool DecodeTIFF(const FTestTIFF& TIFF, FString& OutError)
+    {
+        FTIFFImageDecoder Decoder;
+        FRuntimeImageData Image;
+        if (!Decoder.Decode(TIFF.File.GetData(), TIFF.File.Num(), FImageDecodeParams(), Image, OutError))
+        {
+            return false;
+        }
+
+        if (Image.Format != ERawImageFormat::BGRA8 || Image.RawData != TIFF.Expected)
+        {
+            OutError = FString::Printf(TEXT("Decoded %dx%d image doesn't match the source pixels"), Image.SizeX, Image.SizeY);
+            return false;
+        }
+        return true;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTIFFImageDecoderConcurrentTest, "RuntimeImageLoader.TIFF.ConcurrentDecode", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FTIFFImageDecoderConcurrentTest::RunTest(const FString& Parameters)
+{
+    const FIntPoint Sizes[] = { { 1, 1 }, { 17, 5 }, { 64, 48 }, { 301, 123 } };
+
+    TArray<FTestTIFF> TIFFs;
+    for (const FIntPoint& Size : Sizes)
+    {
+        TIFFs.Add(MakeTIFF(Size.X, Size.Y, TIFFs.Num()));
+    }
+
+    for (const FTestTIFF& TIFF : TIFFs)
+    {
+        FString Error;
+        if (!TestTrue(TEXT("Serial decode"), DecodeTIFF(TIFF, Error)))
+        {
+            AddError(Error);
+            return true;
+        }
+    }
+
+    // decoders are shared between the reader threads, each decode keeps its own loader state
+    const int32 NumDecodes = 64;
+    TArray<FString> Errors;
+    Errors.SetNum(NumDecodes);
+
+    ParallelFor(NumDecodes, [&TIFFs, &Errors](int32 Index)
+    {
+        DecodeTIFF(TIFFs[Index % TIFFs.Num()], Errors[Index]);
+    });
+
+    int32 NumFailed = 0;
+    for (const FString& Error : Errors)
+    {
+        if (!Error.IsEmpty())
+        {
+            AddError(Error);
+            ++NumFailed;
+        }
+    }
+    TestEqual(TEXT("Failed concurrent decodes"), NumFailed, 0);
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS && WITH_FREEIMAGE_LIB
@@ -0,0 +1,63 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "RuntimeImageLoaderTests.h"
+#include "RuntimeImageReader.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTransformImageParamsTargetSizeTest, "RuntimeImageLoader.Transform.TargetSize", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FTransformImageParamsTargetSizeTest::RunTest(const FString& Parameters)
+{
+    struct FCase
+    {
+        const TCHAR* Name;
+        FIntPoint SourceSize;
+        FIntPoint PercentSize;
+        FIntPoint MaxSize;
+        ERuntimeImageFitMode FitMode;
+        FIntPoint TargetSize;
+    };
+
+    const FIntPoint NoPercent(100, 100);
+    const FIntPoint NoLimit(0, 0);
+
+    const FCase Cases[] =
+    {
+        { TEXT("No transform"), FIntPoint(640, 480), NoPercent, NoLimit, ERuntimeImageFitMode::Fit, FIntPoint(640, 480) },
+        { TEXT("Percent"), FIntPoint(1000, 800), FIntPoint(50, 25), NoLimit, ERuntimeImageFitMode::Fit, FIntPoint(500, 200) },
+        { TEXT("Percent of 0 is ignored"), FIntPoint(1000, 800), FIntPoint(0, 50), NoLimit, ERuntimeImageFitMode::Fit, FIntPoint(1000, 800) },
+        { TEXT("Fit width"), FIntPoint(2048, 1024), NoPercent, FIntPoint(512, 0), ERuntimeImageFitMode::Fit, FIntPoint(512, 256) },
+        { TEXT("Fit height"), FIntPoint(2048, 1024), NoPercent, FIntPoint(0, 128), ERuntimeImageFitMode::Fit, FIntPoint(256, 128) },
+        { TEXT("Fit both"), FIntPoint(2048, 1024), NoPercent, FIntPoint(512, 512), ERuntimeImageFitMode::Fit, FIntPoint(512, 256) },
+        { TEXT("Fit never upscales"), FIntPoint(300, 200), NoPercent, FIntPoint(512, 512), ERuntimeImageFitMode::Fit, FIntPoint(300, 200) },
+        { TEXT("Fit rounds to the nearest pixel"), FIntPoint(999, 1000), NoPercent, FIntPoint(500, 0), ERuntimeImageFitMode::Fit, FIntPoint(500, 501) },
+        { TEXT("Fit keeps a pixel"), FIntPoint(1000, 2), NoPercent, FIntPoint(10, 0), ERuntimeImageFitMode::Fit, FIntPoint(10, 1) },
+        { TEXT("Fill covers both"), FIntPoint(2048, 1024), NoPercent, FIntPoint(512, 512), ERuntimeImageFitMode::Fill, FIntPoint(1024, 512) },
+        { TEXT("Fill with one limit fits"), FIntPoint(2048, 1024), NoPercent, FIntPoint(512, 0), ERuntimeImageFitMode::Fill, FIntPoint(512, 256) },
+        { TEXT("Stretch"), FIntPoint(2048, 1024), NoPercent, FIntPoint(100, 300), ERuntimeImageFitMode::Stretch, FIntPoint(100, 300) },
+        { TEXT("Stretch upscales"), FIntPoint(30, 20), NoPercent, FIntPoint(100, 50), ERuntimeImageFitMode::Stretch, FIntPoint(100, 50) },
+        { TEXT("Stretch one axis"), FIntPoint(300, 200), NoPercent, FIntPoint(100, 0), ERuntimeImageFitMode::Stretch, FIntPoint(100, 200) },
+        { TEXT("Percent then limit"), FIntPoint(1000, 500), FIntPoint(50, 50), FIntPoint(200, 0), ERuntimeImageFitMode::Fit, FIntPoint(200, 100) },
+    };
+
+    for (const FCase& Case : Cases)
+    {
+        FTransformImageParams Params;
+        Params.PercentSizeX = Case.PercentSize.X;
+        Params.PercentSizeY = Case.PercentSize.Y;
+        Params.MaxWidth = Case.MaxSize.X;
+        Params.MaxHeight = Case.MaxSize.Y;
+        Params.FitMode = Case.FitMode;
+
+        FIntPoint TargetSize;
+        const bool bResized = Params.GetTargetSize(Case.SourceSize.X, Case.SourceSize.Y, TargetSize.X, TargetSize.Y);
+
+        TestEqual(FString(Case.Name) + TEXT(" size"), TargetSize, Case.TargetSize);
+        TestEqual(FString(Case.Name) + TEXT(" is resized"), bResized, TargetSize != Case.SourceSize);
+    }
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,224 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#include "RuntimeImageLoaderTests.h"
+#include "ImageDecoders/WebPImageDecoder.h"
+#include "RuntimeImageReader.h"
+
+#if WITH_DEV_AUTOMATION_TESTS && WITH_LIBWEBP
+
+namespace
+{
+    struct FTestWebP
+    {
+        TArray<uint8> File;
+        // pixels the decoder must return at full size, BGRA8 top to bottom
+        TArray64<uint8> Expected;
+    };
+
+    /** Bits of a lossless bitstream, packed from the least significant bit */
+    struct FBitWriter
+    {
+        TArray<uint8> Bytes;
+        int32 NumBits = 0;
+
+        void Write(uint32 Value, int32 Count)
+        {
+            for (int32 Bit = 0; Bit < Count; ++Bit, ++NumBits)
+            {
+                if (NumBits % 8 == 0)
+                {
+                    Bytes.Add(0);
+                }
+                Bytes.Last() |= ((Value >> Bit) & 1) << (NumBits % 8);
+            }
+        }
+    };
+
+    /**
+     * Lossless WebP of two colors picked at random per pixel. Every channel has a simple prefix code of the two values,
+     * so each pixel is a literal of four 1-bit codes and there is no encoder to link
+     */
+    FTestWebP MakeWebP(int32 Width, int32 Height, FColor ColorA, FColor ColorB, int32 Seed)
+    {
+        FBitWriter Bits;
+        Bits.Write(0x2F, 8);                // signature
+        Bits.Write(Width - 1, 14);
+        Bits.Write(Height - 1, 14);
+        Bits.Write(1, 1);                   // alpha is used
+        Bits.Write(0, 3);                   // version
+        Bits.Write(0, 1);                   // no transforms
+        Bits.Write(0, 1);                   // no color cache
+        Bits.Write(0, 1);                   // no meta prefix codes
+
+        // green, red, blue and alpha codes, the smaller value gets code 0
+        const uint8 ValuesA[4] = { ColorA.G, ColorA.R, ColorA.B, ColorA.A };
+        const uint8 ValuesB[4] = { ColorB.G, ColorB.R, ColorB.B, ColorB.A };
+        for (int32 Channel = 0; Channel < 4; ++Channel)
+        {
+            check(ValuesA[Channel] != ValuesB[Channel]);
+            Bits.Write(1, 1);               // simple code
+            Bits.Write(1, 1);               // two symbols
+            Bits.Write(1, 1);               // first symbol is 8 bits
+            Bits.Write(ValuesA[Channel], 8);
+            Bits.Write(ValuesB[Channel], 8);
+        }
+
+        // distance code of a single symbol is never read
+        Bits.Write(1, 1);
+        Bits.Write(0, 1);
+        Bits.Write(0, 1);
+        Bits.Write(0, 1);
+
+        FTestWebP WebP;
+        TArray<uint8> Picks;
+        Picks.SetNumUninitialized(Width * Height);
+        FRuntimeImageLoaderTests::FillRandom(Picks.GetData(), Picks.Num(), Seed);
+
+        for (uint8 Pick : Picks)
+        {
+            const bool bColorB = (Pick & 1) != 0;
+            const FColor& Color = bColorB ? ColorB : ColorA;
+            const uint8* Values = bColorB ? ValuesB : ValuesA;
+            const uint8* OtherValues = bColorB ? ValuesA : ValuesB;
+            for (int32 Channel = 0; Channel < 4; ++Channel)
+            {
+                Bits.Write(Values[Channel] > OtherValues[Channel] ? 1 : 0, 1);
+            }
+            WebP.Expected.Append({ Color.B, Color.G, Color.R, Color.A });
+        }
+
+        auto AppendUInt32 = [](TArray<uint8>& Out, uint32 Value)
+        {
+            Out.Append({ (uint8)Value, (uint8)(Value >> 8), (uint8)(Value >> 16), (uint8)(Value >> 24) });
+        };
+
+        const int32 ChunkSize = Bits.Bytes.Num();
+        const int32 PaddedChunkSize = ChunkSize + (ChunkSize & 1);
+
+        WebP.File.Append({ 'R', 'I', 'F', 'F' });
+        AppendUInt32(WebP.File, 4 + 8 + PaddedChunkSize);
+        WebP.File.Append({ 'W', 'E', 'B', 'P', 'V', 'P', '8', 'L' });
+        AppendUInt32(WebP.File, ChunkSize);
+        WebP.File.Append(Bits.Bytes);
+        WebP.File.AddZeroed(PaddedChunkSize - ChunkSize);
+
+        return WebP;
+    }
+
+    bool Decode(const FTestWebP& WebP, const FImageDecodeParams& Params, FRuntimeImageData& OutImage, FString& OutError)
+    {
+        return FWebPImageDecoder().Decode(WebP.File.GetData(), WebP.File.Num(), Params, OutImage, OutError);
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWebPImageDecoderDecodeTest, "RuntimeImageLoader.WebP.Decode", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FWebPImageDecoderDecodeTest::RunTest(const FString& Parameters)
+{
+    const FTestWebP WebP = MakeWebP(37, 21, FColor(200, 30, 90, 255), FColor(10, 180, 240, 128), 1);
+
+    FRuntimeImageData Image;
+    FString Error;
+    if (!TestTrue(TEXT("Decoded"), Decode(WebP, FImageDecodeParams(), Image, Error)))
+    {
+        AddError(Error);
+        return false;
+    }
+
+    TestEqual(TEXT("Size"), FIntPoint(Image.SizeX, Image.SizeY), FIntPoint(37, 21));
+    TestEqual(TEXT("Not downscaled"), Image.SourceSizeX, 0);
+    TestTrue(TEXT("Pixels"), Image.RawData == WebP.Expected);
+
+    // the size the reader would resize to is kept when it isn't a downscale on both axes
+    FImageDecodeParams Upscale;
+    Upscale.TargetSize = FIntPoint(74, 10);
+    if (TestTrue(TEXT("Upscale target"), Decode(WebP, Upscale, Image, Error)))
+    {
+        TestEqual(TEXT("Upscale target is left to the resize"), FIntPoint(Image.SizeX, Image.SizeY), FIntPoint(37, 21));
+    }
+
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FWebPImageDecoderTargetSizeTest, "RuntimeImageLoader.WebP.TargetSize", RUNTIMEIMAGELOADER_TEST_FLAGS)
+
+bool FWebPImageDecoderTargetSizeTest::RunTest(const FString& Parameters)
+{
+    // sizes of the reader's transforms where a float scale floors a pixel short of the target
+    struct FCase
+    {
+        const TCHAR* Name;
+        FIntPoint SourceSize;
+        int32 PercentSize;
+        int32 MaxWidth;
+        int32 MaxHeight;
+        ERuntimeImageFitMode FitMode;
+    };
+
+    const FCase Cases[] =
+    {
+        { TEXT("Fit width rounds the height up"), FIntPoint(999, 1000), 100, 500, 0, ERuntimeImageFitMode::Fit },
+        { TEXT("Fit both"), FIntPoint(301, 203), 100, 150, 150, ERuntimeImageFitMode::Fit },
+        { TEXT("Fill"), FIntPoint(301, 203), 100, 100, 100, ERuntimeImageFitMode::Fill },
+        { TEXT("Stretch"), FIntPoint(301, 203), 100, 120, 40, ERuntimeImageFitMode::Stretch },
+        { TEXT("Percent"), FIntPoint(1000, 750), 33, 0, 0, ERuntimeImageFitMode::Fit },
+    };
+
+    int32 Seed = 0;
+    for (const FCase& Case : Cases)
+    {
+        FTransformImageParams TransformParams;
+        TransformParams.PercentSizeX = TransformParams.PercentSizeY = Case.PercentSize;
+        TransformParams.MaxWidth = Case.MaxWidth;
+        TransformParams.MaxHeight = Case.MaxHeight;
+        TransformParams.FitMode = Case.FitMode;
+
+        FImageDecodeParams Params;
+        if (!TestTrue(FString(Case.Name) + TEXT(" is resized"), TransformParams.GetTargetSize(Case.SourceSize.X, Case.SourceSize.Y, Params.TargetSize.X, Params.TargetSize.Y)))
+        {
+            continue;
+        }
+
+        const FTestWebP WebP = MakeWebP(Case.SourceSize.X, Case.SourceSize.Y, FColor(255, 0, 0, 255), FColor(0, 255, 255, 254), ++Seed);
+
+        FRuntimeImageData Image;
+        FString Error;
+        if (!TestTrue(Case.Name, Decode(WebP, Params, Image, Error)))
+        {
+            AddError(Error);
+            continue;
+        }
+
+        // the reader skips its own resize when the decoder has produced the target size
+        TestEqual(FString(Case.Name) + TEXT(" size"), FIntPoint(Image.SizeX, Image.SizeY), Params.TargetSize);
+        TestEqual(FString(Case.Name) + TEXT(" source size"), FIntPoint(Image.SourceSizeX, Image.SourceSizeY), Case.SourceSize);
+    }
+
+    // the region is cropped before scaling, an odd crop start adds a column that is scaled along with it
+    const FTestWebP WebP = MakeWebP(64, 48, FColor(255, 0, 0, 255), FColor(0, 255, 255, 254), 100);
+
+    FImageDecodeParams EvenRegion;
+    EvenRegion.Region = FIntRect(8, 4, 40, 36);
+    EvenRegion.TargetSize = FIntPoint(16, 16);
+
+    FRuntimeImageData Image;
+    FString Error;
+    if (TestTrue(TEXT("Even region"), Decode(WebP, EvenRegion, Image, Error)))
+    {
+        TestEqual(TEXT("Even region size"), FIntPoint(Image.SizeX, Image.SizeY), FIntPoint(16, 16));
+        TestEqual(TEXT("Even region decoded"), Image.DecodedRegion, EvenRegion.Region);
+    }
+
+    FImageDecodeParams OddRegion = EvenRegion;
+    OddRegion.Region.Min.X = 9;
+    OddRegion.TargetSize = FIntPoint(31, 16);
+    if (TestTrue(TEXT("Odd region"), Decode(WebP, OddRegion, Image, Error)))
+    {
+        TestEqual(TEXT("Odd region size"), FIntPoint(Image.SizeX, Image.SizeY), FIntPoint(32, 16));
+        TestEqual(TEXT("Odd region decoded"), Image.DecodedRegion, FIntRect(8, 4, 40, 36));
+    }
+
+    return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS && WITH_LIBWEBP
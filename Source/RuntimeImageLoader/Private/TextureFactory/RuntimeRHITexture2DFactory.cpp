@@ -10,6 +10,8 @@
 #include "HAL/Platform.h"
 #include "TextureResource.h"
 #include "Async/TaskGraphInterfaces.h"
+#include "RenderingThread.h"
+#include "RenderResource.h"
 
 #include "RuntimeTexture2DResource.h"
 
@@ -53,9 +55,12 @@ private:
 
 FTexture2DRHIRef FRuntimeRHITexture2DFactory::CreateRHITexture2D_Windows()
 {
-    uint32 NumMips = 1;
-    uint32 NumSamples = 1;
-    void* Mip0Data = (void*)ImageData.RawData.GetData();
+    // the whole mip chain is uploaded, bulk data holds the mips tightly packed one after another like RHIs expect them
+    TArray<void*, TInlineAllocator<MAX_TEXTURE_MIP_COUNT>> MipData;
+    for (int32 MipIndex = 0; MipIndex < ImageData.NumMips; ++MipIndex)
+    {
+        MipData.Add((void*)(ImageData.RawData.GetData() + ImageData.GetMipOffset(MipIndex)));
+    }
 
     ETextureCreateFlags TextureFlags = TexCreate_ShaderResource;
     if (ImageData.SRGB)
@@ -77,8 +82,8 @@ FTexture2DRHIRef FRuntimeRHITexture2DFactory::CreateRHITexture2D_Windows()
             ImageData.PixelFormat,
             ImageData.NumMips,
             TextureFlags,
-            &Mip0Data,
-            1
+            MipData.GetData(),
+            MipData.Num()
 #if (ENGINE_MAJOR_VERSION >= 5) && (ENGINE_MINOR_VERSION > 2)
             ,CompletionEvent
 #endif
@@ -86,7 +91,7 @@ FTexture2DRHIRef FRuntimeRHITexture2DFactory::CreateRHITexture2D_Windows()
     }
     else
     {
-        FTextureDataResource TextureData(Mip0Data, ImageData.RawData.Num());
+        FTextureDataResource TextureData(MipData[0], ImageData.RawData.Num());
 
         FRHIResourceCreateInfo CreateInfo(TEXT("RuntimeImageReaderTextureData"));
         CreateInfo.BulkData = &TextureData;
@@ -128,10 +133,6 @@ FTexture2DRHIRef FRuntimeRHITexture2DFactory::CreateRHITexture2D_Windows()
 
 FTexture2DRHIRef FRuntimeRHITexture2DFactory::CreateRHITexture2D_Mobile()
 {
-    uint32 NumMips = 1;
-    uint32 NumSamples = 1;
-    void* Mip0Data = (void*)ImageData.RawData.GetData();
-
     ETextureCreateFlags TextureFlags = TexCreate_ShaderResource;
     if (ImageData.SRGB)
     {
@@ -169,21 +170,25 @@ FTexture2DRHIRef FRuntimeRHITexture2DFactory::CreateRHITexture2D_Mobile()
                 DummyCreateInfo);
 #endif
 
-            FUpdateTextureRegion2D TextureRegion2D;
+            const FPixelFormatInfo& FormatInfo = GPixelFormats[ImageData.PixelFormat];
+            for (int32 MipIndex = 0; MipIndex < ImageData.NumMips; ++MipIndex)
             {
-                TextureRegion2D.DestX = 0;
-                TextureRegion2D.DestY = 0;
-                TextureRegion2D.SrcX = 0;
-                TextureRegion2D.SrcY = 0;
-                TextureRegion2D.Width = ImageData.SizeX;
-                TextureRegion2D.Height = ImageData.SizeY;
-            }
+                FUpdateTextureRegion2D TextureRegion2D;
+                {
+                    TextureRegion2D.DestX = 0;
+                    TextureRegion2D.DestY = 0;
+                    TextureRegion2D.SrcX = 0;
+                    TextureRegion2D.SrcY = 0;
+                    TextureRegion2D.Width = ImageData.GetMipSizeX(MipIndex);
+                    TextureRegion2D.Height = ImageData.GetMipSizeY(MipIndex);
+                }
 
-            RHIUpdateTexture2D(
-                RHITexture2D, 0, TextureRegion2D,
-                TextureRegion2D.Width * GPixelFormats[ImageData.PixelFormat].BlockBytes,
-                ImageData.RawData.GetData()
-            );
+                RHIUpdateTexture2D(
+                    RHITexture2D, MipIndex, TextureRegion2D,
+                    FMath::DivideAndRoundUp<uint32>(TextureRegion2D.Width, FormatInfo.BlockSizeX) * FormatInfo.BlockBytes,
+                    ImageData.RawData.GetData() + ImageData.GetMipOffset(MipIndex)
+                );
+            }
         }, TStatId(), nullptr, ENamedThreads::ActualRenderingThread
     );
     CreateTextureTask->Wait();
@@ -199,6 +204,13 @@ FTexture2DRHIRef FRuntimeRHITexture2DFactory::CreateRHITexture2D_Other()
 
 void FRuntimeRHITexture2DFactory::FinalizeRHITexture2D()
 {
+    // Texture may already have a resource, e.g. preview one that is replaced with full resolution image
+    if (NewTexture->GetResource() != nullptr)
+    {
+        ReplaceTextureResource();
+        return;
+    }
+
     // Create texture resource that returns actual texture size so that UMG can display the texture
     FRuntimeTextureResource* NewTextureResource = new FRuntimeTexture2DResource(NewTexture, RHITexture2D, ImageData.FilterMode);
     NewTexture->SetResource(NewTextureResource);
@@ -214,3 +226,58 @@ void FRuntimeRHITexture2DFactory::FinalizeRHITexture2D()
     );
     UpdateResourceTask->Wait();
 }
+
+/** Deletes the replaced resource once the rendering thread has gone past the frame that could still draw it */
+class FDeferredTextureResourceDelete : public FDeferredCleanupInterface
+{
+public:
+    FDeferredTextureResourceDelete(FRuntimeTextureResource* InTextureResource)
+        : TextureResource(InTextureResource)
+    {}
+
+    virtual ~FDeferredTextureResourceDelete()
+    {
+        delete TextureResource;
+    }
+
+private:
+    FRuntimeTextureResource* TextureResource;
+};
+
+void FRuntimeRHITexture2DFactory::ReplaceTextureResource()
+{
+    // the texture has been handed out already, so the resource is swapped on the game thread as UTexture::UpdateResource does.
+    // Rendering commands and Slate elements queued before the swap may still reference the old resource,
+    // it is released after them and deleted by the deferred cleanup
+    auto SwapResource = [Texture = NewTexture, RHITexture = RHITexture2D, FilterMode = ImageData.FilterMode]()
+    {
+        FRuntimeTextureResource* OldTextureResource = static_cast<FRuntimeTextureResource*>(Texture->GetResource());
+
+        FRuntimeTextureResource* NewTextureResource = new FRuntimeTexture2DResource(Texture, RHITexture, FilterMode);
+        Texture->SetResource(NewTextureResource);
+
+        ENQUEUE_RENDER_COMMAND(RuntimeImageLoader_ReplaceTextureResource)(
+            [Texture, RHITexture, NewTextureResource, OldTextureResource](FRHICommandListImmediate& RHICmdList)
+            {
+                // the old resource must not reset the texture reference when it is released
+                OldTextureResource->DetachOwner();
+
+                NewTextureResource->InitResource();
+                RHIUpdateTextureReference(Texture->TextureReference.TextureReferenceRHI, RHITexture);
+                NewTextureResource->SetTextureReference(Texture->TextureReference.TextureReferenceRHI);
+            }
+        );
+
+        BeginReleaseResource(OldTextureResource);
+        BeginCleanup(new FDeferredTextureResourceDelete(OldTextureResource));
+    };
+
+    if (IsInGameThread())
+    {
+        SwapResource();
+        return;
+    }
+
+    FGraphEventRef SwapResourceTask = FFunctionGraphTask::CreateAndDispatchWhenReady(MoveTemp(SwapResource), TStatId(), nullptr, ENamedThreads::GameThread);
+    SwapResourceTask->Wait();
+}
@@ -30,6 +30,7 @@ private:
     FTexture2DRHIRef CreateRHITexture2D_Mobile();
     FTexture2DRHIRef CreateRHITexture2D_Other();
     void FinalizeRHITexture2D();
+    void ReplaceTextureResource();
 
 private:
     UTexture2D* NewTexture;
@@ -59,9 +59,6 @@ FTextureCubeRHIRef FRuntimeRHITextureCubeFactory::CreateTextureCubeRHI_Windows()
 {
     FTextureCubeRHIRef TextureCubeRHI = nullptr;
     
-    int32 NumMips = 1;
-    uint32 NumSamples = 1;
-
     ensureMsgf(ImageData.SizeX > 0, TEXT("ImageData.SizeX must be > 0"));
     ensureMsgf(ImageData.SizeY > 0, TEXT("ImageData.SizeY must be > 0"));
 
@@ -80,7 +77,7 @@ FTextureCubeRHIRef FRuntimeRHITextureCubeFactory::CreateTextureCubeRHI_Windows()
                 FRHITextureCreateDesc::CreateCube(CreateInfo.DebugName)
                 .SetExtent(ImageData.SizeX)
                 .SetFormat(ImageData.PixelFormat)
-                .SetNumMips(1)
+                .SetNumMips(ImageData.NumMips)
                 .SetFlags(TextureFlags)
                 .SetInitialState(ERHIAccess::Unknown)
                 .SetExtData(CreateInfo.ExtData)
@@ -90,7 +87,7 @@ FTextureCubeRHIRef FRuntimeRHITextureCubeFactory::CreateTextureCubeRHI_Windows()
             );
 #else
             TextureCubeRHI = RHICreateTextureCube(
-                ImageData.SizeX, ImageData.PixelFormat, 1, TextureFlags, CreateInfo);
+                ImageData.SizeX, ImageData.PixelFormat, ImageData.NumMips, TextureFlags, CreateInfo);
 #endif
         }, TStatId(), nullptr, ENamedThreads::ActualRenderingThread
     );
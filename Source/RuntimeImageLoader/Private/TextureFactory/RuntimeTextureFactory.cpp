@@ -35,6 +35,27 @@ UTexture2D* URuntimeTextureFactory::CreateTexture2D(const FConstructTextureTask&
     return OutResult;
 }
 
+void URuntimeTextureFactory::UpdateTexture2D(UTexture2D* Texture, const FConstructTextureTask& Task)
+{
+    if (IsInGameThread())
+    {
+        FRuntimeImageUtils::UpdateTexture(Texture, *Task.ImageData);
+        return;
+    }
+
+    CurrentTask = Async(
+        EAsyncExecution::TaskGraphMainThread,
+        [Texture, Task]()
+        {
+            FRuntimeImageUtils::UpdateTexture(Texture, *Task.ImageData);
+
+            return true;
+        }
+    );
+
+    CurrentTask.Get();
+}
+
 UTextureCube* URuntimeTextureFactory::CreateTextureCube(const FConstructTextureTask& Task)
 {
     UTextureCube* OutResult = nullptr;
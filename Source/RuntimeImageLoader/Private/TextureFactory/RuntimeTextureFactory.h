@@ -26,6 +26,7 @@ public:
 
 public:
     UTexture2D* CreateTexture2D(const FConstructTextureTask& Task);
+    void UpdateTexture2D(UTexture2D* Texture, const FConstructTextureTask& Task);
     UTextureCube* CreateTextureCube(const FConstructTextureTask& Task);
 
 private:
@@ -14,7 +14,7 @@ FRuntimeTextureResource::FRuntimeTextureResource(UTexture* InTexture, FTextureRH
     TextureRHI = InRHITexture;
     bSRGB = (TextureRHI->GetFlags() & TexCreate_SRGB) != TexCreate_None;
     bIgnoreGammaConversions = !bSRGB;
-    bGreyScaleFormat = (TextureRHI->GetFormat() == PF_G8) || (TextureRHI->GetFormat() == PF_BC4);
+    bGreyScaleFormat = (TextureRHI->GetFormat() == PF_G8) || (TextureRHI->GetFormat() == PF_G16) || (TextureRHI->GetFormat() == PF_BC4);
 
     UE_LOG(LogRuntimeTextureResource, Verbose, TEXT("RuntimeTextureResource has been created!"))
 }
@@ -28,6 +28,9 @@ public:
 #endif
     virtual void ReleaseRHI() override;
 
+    /** Resource that is being replaced must not touch the owner's texture reference anymore */
+    void DetachOwner() { Owner = nullptr; }
+
 protected:
     UTexture* Owner;
     uint32 SizeX;
@@ -0,0 +1,63 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "RuntimeImageData.h"
+
+/** Hints for the decoder, decoders that can't make use of them ignore them */
+struct FImageDecodeParams
+{
+    // decoded image may be downscaled as long as it stays at least this fraction of the source size in both dimensions
+    float MinScale = 1.0f;
+
+    // size the image is resized to after decoding, relative to the region like MinScale, zero if it keeps its size.
+    // Decoders that resample while decoding (WebP) produce exactly this size so the resize is skipped
+    FIntPoint TargetSize = FIntPoint::ZeroValue;
+
+    // part of the image to decode in pixels of the encoded image, empty for the whole image. MinScale is relative to the region.
+    // Decoders that can't decode a part of the image decode all of it and ImportBufferAsImage crops it
+    FIntRect Region;
+
+    bool HasRegion() const
+    {
+        return Region.Width() > 0 && Region.Height() > 0;
+    }
+
+    /** Region clipped to the image of the given size, empty if it's outside of the image */
+    FIntRect GetClippedRegion(int32 Width, int32 Height) const
+    {
+        const FIntRect Clipped(FMath::Max(Region.Min.X, 0), FMath::Max(Region.Min.Y, 0), FMath::Min(Region.Max.X, Width), FMath::Min(Region.Max.Y, Height));
+        return (Clipped.Width() > 0 && Clipped.Height() > 0) ? Clipped : FIntRect();
+    }
+};
+
+/**
+ * Decoder of a single image format. Decoders are registered in FImageDecoderRegistry and picked by the first bytes of the image,
+ * they are shared between the reader threads so Decode must be thread safe.
+ */
+class IImageDecoder
+{
+public:
+    virtual ~IImageDecoder() {}
+
+    /** Unique name of the decoder, e.g. the format name */
+    virtual FName GetName() const = 0;
+
+    /**
+     * First bytes of the signatures of the format, the decoder is sniffed only for the images starting with one of them.
+     * Formats without a signature leave it empty and are sniffed after all signature based decoders.
+     */
+    virtual void GetLeadBytes(TArray<uint8>& OutLeadBytes) const = 0;
+
+    /** Returns true if the buffer has the signature (or a plausible header) of the format */
+    virtual bool Sniff(const uint8* Buffer, int64 Length) const = 0;
+
+    /** Reads the image size from the header without decoding the image. Returns false if the decoder can't tell it cheaply */
+    virtual bool GetImageSize(const uint8* Buffer, int64 Length, int32& OutWidth, int32& OutHeight) const { return false; }
+
+    virtual bool Decode(const uint8* Buffer, int64 Length, const FImageDecodeParams& Params, FRuntimeImageData& OutImage, FString& OutError) const = 0;
+};
+
+typedef TSharedRef<IImageDecoder, ESPMode::ThreadSafe> FImageDecoderRef;
+typedef TSharedPtr<IImageDecoder, ESPMode::ThreadSafe> FImageDecoderPtr;
@@ -0,0 +1,36 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ImageDecoders/IImageDecoder.h"
+
+/**
+ * Picks the decoder of the image from its first byte instead of trying every format in turn.
+ * Built-in decoders are registered on first use, other modules can register theirs at startup.
+ */
+class RUNTIMEIMAGELOADER_API FImageDecoderRegistry
+{
+public:
+    static FImageDecoderRegistry& Get();
+
+    /** Decoders registered later take precedence over the earlier ones with the same lead bytes, decoder of the same name is replaced */
+    void RegisterDecoder(const FImageDecoderRef& Decoder);
+    void UnregisterDecoder(FName DecoderName);
+
+    /** Returns the decoder whose signature matches the buffer or null if the format is not supported */
+    FImageDecoderPtr FindDecoder(const uint8* Buffer, int64 Length) const;
+
+private:
+    FImageDecoderRegistry();
+
+    void RegisterBuiltInDecoders();
+
+private:
+    mutable FRWLock DecodersLock;
+
+    // decoders indexed by the first byte of their signatures, most recently registered first
+    TArray<FImageDecoderRef> DecodersByLeadByte[256];
+    // decoders of formats without a signature
+    TArray<FImageDecoderRef> FallbackDecoders;
+};
@@ -8,6 +8,21 @@ class IImageReader
 {
 public:
     virtual TArray<uint8> ReadImage(const FString& ImageURI) = 0;
+
+    /**
+     * Zero-copy alternative to ReadImage for readers that already hold the image in memory.
+     * The view must stay valid till the reader is destroyed, the reader is kept alive till the image is decoded.
+     * Returns false if the reader doesn't support views, ReadImage is used then.
+     */
+    virtual bool ReadImageView(const FString& ImageURI, TArrayView<const uint8>& OutImageView) { return false; }
+
+    /**
+     * Leading bytes of the image that are available before the whole image, e.g. the first range of a download.
+     * Called before ReadImage, blocks till the prefix or the whole image has arrived.
+     * Returns false if the reader has no prefix to offer, the image is read with ReadImage then.
+     */
+    virtual bool ReadImagePrefix(const FString& ImageURI, TArray<uint8>& OutPrefix) { return false; }
+
     virtual FString GetLastError() const { return TEXT(""); };
     virtual void Flush() = 0;
     virtual void Cancel() = 0;
@@ -0,0 +1,49 @@
+// Copyright 2023 Petr Leontev. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ImageReaders/IImageReader.h"
+
+typedef TFunction<TSharedPtr<IImageReader, ESPMode::ThreadSafe>()> FCreateImageReaderFunc;
+
+/** Reader registered for the URI scheme, e.g. "mem" for mem://... URIs */
+struct FImageReaderScheme
+{
+    FCreateImageReaderFunc CreateReader;
+
+    // how many images of the scheme can be read at the same time without contention
+    int32 MaxConcurrentReads = 1;
+};
+
+
+class RUNTIMEIMAGELOADER_API FImageReaderFactory
+{
+public:
+    /** Creates reader of the registered URI scheme, http(s) reader or local file reader for URIs without a known scheme */
+    static TSharedPtr<IImageReader, ESPMode::ThreadSafe> CreateReader(const FString& ImageURI);
+
+    /**
+     * Starts fetching remote images in the background before the reader gets to them.
+     * Large images are probed for their size first so they can be downloaded in parallel ranged chunks.
+     * Previewed images are probed too, their leading bytes are downloaded ahead of the rest for the preview.
+     */
+    static void PrefetchImage(const FString& ImageURI, bool bExpectLargeImage = false, bool bWantsPreview = false);
+
+    /**
+     * Installs the reader for URIs starting with <Scheme>://, replaces built-in and previously registered readers of the scheme.
+     * Scheme is case insensitive. CreateReaderFunc is called from the reader threads.
+     */
+    static void RegisterScheme(const FString& Scheme, FCreateImageReaderFunc CreateReaderFunc, int32 MaxConcurrentReads = 1);
+    static void UnregisterScheme(const FString& Scheme);
+
+    /** Concurrency hint of the scheme of the URI, 1 for local files */
+    static int32 GetMaxConcurrentReads(const FString& ImageURI);
+
+    /** data: URIs carry the whole encoded image, they must be shortened before getting into logs or object names */
+    static bool IsDataURI(const FString& ImageURI);
+    static FString SanitizeURI(const FString& ImageURI);
+
+private:
+    static FString GetScheme(const FString& ImageURI);
+};
@@ -12,14 +12,65 @@
 #include "Engine/TextureDefines.h"
 #endif
 
+#include "RuntimeImageData.generated.h"
+
+/** How the alpha channel of an image is used, UI can draw opaque images without blending and binary ones with alpha testing */
+UENUM(BlueprintType)
+enum class ERuntimeImageAlphaUsage : uint8
+{
+    /** Not classified yet, or the pixels can't be read (pre-compressed images) */
+    Unknown,
+
+    Opaque,
+
+    /** Every pixel is either fully transparent or fully opaque */
+    Binary,
+
+    Translucent
+};
+
 struct RUNTIMEIMAGELOADER_API FRuntimeImageData : public FImage
 {
     void Init2D(int32 InSizeX, int32 InSizeY, ETextureSourceFormat InFormat, const void* InData = nullptr);
 
+    /**
+     * Adopts already decoded pixels instead of copying them, the array must hold exactly one image of the given size and format.
+     * Returns false and leaves the image untouched if it doesn't
+     */
+    bool Init2D(int32 InSizeX, int32 InSizeY, ETextureSourceFormat InFormat, TArray64<uint8>&& InRawData, FString& OutError);
+
+    // mips follow mip 0 in RawData, tightly packed in the pixel format
     int32 NumMips = 1;
     bool SRGB = true;
     TextureFilter FilterMode = TextureFilter::TF_Default;
     ETextureSourceFormat TextureSourceFormat = TSF_Invalid;
     TextureCompressionSettings CompressionSettings;
     EPixelFormat PixelFormat = PF_B8G8R8A8;
+
+    // size of the encoded image if the decoder has already downscaled it, 0 otherwise
+    int32 SourceSizeX = 0;
+    int32 SourceSizeY = 0;
+
+    int32 GetMipSizeX(int32 MipIndex) const;
+    int32 GetMipSizeY(int32 MipIndex) const;
+
+    /** Offset and size of the mip in RawData, computed from the blocks of the pixel format */
+    int64 GetMipOffset(int32 MipIndex) const;
+    int64 GetMipDataSize(int32 MipIndex) const;
+
+    // part of the encoded image the pixels cover if only a part of it was decoded, empty otherwise
+    FIntRect DecodedRegion;
+
+    // RawData holds GPU blocks of PixelFormat read from a texture container (DDS, KTX2), there is no raw image format.
+    // Cubemaps have 6 slices, each slice is followed by the next one after all of its mips
+    bool bPrecompressed = false;
+
+    // alpha of mip 0, classified once and reused by the transforms that depend on it
+    ERuntimeImageAlphaUsage AlphaUsage = ERuntimeImageAlphaUsage::Unknown;
+
+    /** Classifies alpha of mip 0 unless it is known already, RawData must still hold pixels of the raw image format */
+    ERuntimeImageAlphaUsage ClassifyAlpha();
+
+    /** Called after the pixels have been filtered or cropped, opaque images stay opaque but the other classes may change */
+    void InvalidateAlphaUsage();
 };
\ No newline at end of file
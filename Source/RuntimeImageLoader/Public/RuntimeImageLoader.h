@@ -18,6 +18,7 @@ class UAnimatedTexture2D;
 class URuntimeGifReader;
 
 DECLARE_DELEGATE_OneParam(FOnRequestCompleted, const FImageReadResult&);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnImagePreviewReady, const FString&, ImageFilename, UTexture2D*, PreviewTexture, ERuntimeImageAlphaUsage, AlphaUsage);
 
 struct RUNTIMEIMAGELOADER_API FLoadImageRequest
 {
@@ -47,28 +48,47 @@ class RUNTIMEIMAGELOADER_API URuntimeImageLoader : public UWorldSubsystem, publi
 
 public:
     //------------------ Images --------------------
+    /**
+     * OutAlphaUsage of the image loads tells how the image uses its alpha, opaque images can be drawn without blending. Unknown for pre-compressed images.
+     * OutTextureStats tells the GPU memory of the texture and, if it was block compressed, the ratio, quality and time of the compression
+     */
     UFUNCTION(BlueprintCallable, Category = "Runtime Image Loader", meta = (AutoCreateRefTerm = "TransformParams", Latent, LatentInfo = "LatentInfo", HidePin = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
-    void LoadImageAsync(const FString& ImageFilename, const FTransformImageParams& TransformParams, UTexture2D*& OutTexture, bool& bSuccess, FString& OutError, FLatentActionInfo LatentInfo, UObject* WorldContextObject = nullptr);
+    void LoadImageAsync(const FString& ImageFilename, const FTransformImageParams& TransformParams, UTexture2D*& OutTexture, ERuntimeImageAlphaUsage& OutAlphaUsage, FRuntimeTextureStats& OutTextureStats, bool& bSuccess, FString& OutError, FLatentActionInfo LatentInfo, UObject* WorldContextObject = nullptr);
 
     UFUNCTION(BlueprintCallable, Category = "Runtime Image Loader | Bytes", meta = (AutoCreateRefTerm = "TransformParams", Latent, LatentInfo = "LatentInfo", HidePin = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
-    void LoadImageFromBytesAsync(UPARAM(ref) TArray<uint8>& ImageBytes, const FTransformImageParams& TransformParams, UTexture2D*& OutTexture, bool& bSuccess, FString& OutError, FLatentActionInfo LatentInfo, UObject* WorldContextObject = nullptr);
+    void LoadImageFromBytesAsync(UPARAM(ref) TArray<uint8>& ImageBytes, const FTransformImageParams& TransformParams, UTexture2D*& OutTexture, ERuntimeImageAlphaUsage& OutAlphaUsage, FRuntimeTextureStats& OutTextureStats, bool& bSuccess, FString& OutError, FLatentActionInfo LatentInfo, UObject* WorldContextObject = nullptr);
     
     UFUNCTION(BlueprintCallable, Category = "Runtime Image Loader | Cubemap", meta = (AutoCreateRefTerm = "TransformParams", Latent, LatentInfo = "LatentInfo", HidePin = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
     void LoadHDRIAsCubemapAsync(const FString& ImageFilename, const FTransformImageParams& TransformParams, UTextureCube*& OutTextureCube, bool& bSuccess, FString& OutError, FLatentActionInfo LatentInfo, UObject* WorldContextObject = nullptr);
 
     UFUNCTION(BlueprintCallable, Category = "Runtime Image Loader", meta = (AutoCreateRefTerm = "TransformParams"))
-    void LoadImageSync(const FString& ImageFilename, const FTransformImageParams& TransformParams, UTexture2D*& OutTexture, bool& bSuccess, FString& OutError);
+    void LoadImageSync(const FString& ImageFilename, const FTransformImageParams& TransformParams, UTexture2D*& OutTexture, ERuntimeImageAlphaUsage& OutAlphaUsage, FRuntimeTextureStats& OutTextureStats, bool& bSuccess, FString& OutError);
 
     UFUNCTION(BlueprintCallable, Category = "Runtime Image Loader | Bytes", meta = (AutoCreateRefTerm = "TransformParams"))
-    void LoadImageFromBytesSync(UPARAM(ref) TArray<uint8>& ImageBytes, const FTransformImageParams& TransformParams, UTexture2D*& OutTexture, bool& bSuccess, FString& OutError);
+    void LoadImageFromBytesSync(UPARAM(ref) TArray<uint8>& ImageBytes, const FTransformImageParams& TransformParams, UTexture2D*& OutTexture, ERuntimeImageAlphaUsage& OutAlphaUsage, FRuntimeTextureStats& OutTextureStats, bool& bSuccess, FString& OutError);
 
     UFUNCTION(BlueprintCallable, Category = "Runtime Image Loader", meta = (Latent, LatentInfo = "LatentInfo", HidePin = "WorldContextObject", DefaultToSelf = "WorldContextObject"))
-    void LoadImagePixels(const FInputImageDescription& InputImage, const FTransformImageParams& TransformParams, TArray<FColor>& OutImagePixels, bool& bSuccess, FString& OutError, FLatentActionInfo LatentInfo, UObject* WorldContextObject = nullptr);
+    void LoadImagePixels(const FInputImageDescription& InputImage, const FTransformImageParams& TransformParams, TArray<FColor>& OutImagePixels, ERuntimeImageAlphaUsage& OutAlphaUsage, bool& bSuccess, FString& OutError, FLatentActionInfo LatentInfo, UObject* WorldContextObject = nullptr);
+
+    /**
+     * Low resolution texture of an async request with bProgressivePreview, broadcast before the request completes.
+     * The request completes with the same texture object once the full image has replaced the preview in it.
+     */
+    UPROPERTY(BlueprintAssignable, Category = "Runtime Image Loader")
+    FOnImagePreviewReady OnImagePreviewReady;
 
     /** Utilities */
     UFUNCTION(BlueprintCallable, Category = "Runtime Image Loader | Utilities")
     void CancelAll();
 
+    /** Limits how many images are downloaded at once. Remote images start downloading as soon as they are queued */
+    UFUNCTION(BlueprintCallable, Category = "Runtime Image Loader | Utilities")
+    void SetHttpConcurrencyLimits(int32 MaxConcurrentDownloads = 8, int32 MaxConcurrentDownloadsPerHost = 4);
+
+    /** Limits how many queued remote images are downloaded ahead of the reader, by their number and by the size of the downloaded bodies */
+    UFUNCTION(BlueprintCallable, Category = "Runtime Image Loader | Utilities")
+    void SetHttpPrefetchLimits(int32 MaxPrefetchedImages = 32, int32 MaxPrefetchedMegabytes = 256);
+
     UFUNCTION(BlueprintCallable, Category = "Runtime Image Loader | Utilities")
     TArray<uint8> LoadFileToByteArray(const FString& ImageFilename);
 
@@ -22,6 +22,68 @@ class UTextureCube;
 class IImageReader;
 
 
+/** Pixel format of textures created for UI */
+UENUM(BlueprintType)
+enum class ERuntimeUITextureFormat : uint8
+{
+    /** Every image is expanded to BGRA8 */
+    BGRA8,
+
+    /** Grayscale images stay single channel (G8), sample them with a Grayscale sampler. Color images are BGRA8 */
+    Compact,
+
+    /**
+     * Like Compact, opaque color images are packed to R5G6B5 and images with 1-bit alpha to B5G5R5A1 where the RHI supports them.
+     * Packed texels are linear and dithered, so dark gradients don't band. Images whose mips need partial alpha stay BGRA8.
+     */
+    Packed16
+};
+
+/** Filter of the percent size resize */
+UENUM(BlueprintType)
+enum class ERuntimeImageResizeFilter : uint8
+{
+    Box,
+    Bilinear,
+    Bicubic,
+    Lanczos3
+};
+
+/** How the image is scaled into MaxWidth x MaxHeight */
+UENUM(BlueprintType)
+enum class ERuntimeImageFitMode : uint8
+{
+    /** Whole image fits into the box, aspect ratio is kept */
+    Fit,
+
+    /** Image covers the box keeping the aspect ratio, the overflow is cropped evenly from both sides */
+    Fill,
+
+    /** Image is scaled to the box exactly */
+    Stretch
+};
+
+/** Filter of the generated mips */
+UENUM(BlueprintType)
+enum class ERuntimeImageMipFilter : uint8
+{
+    Box,
+    Kaiser
+};
+
+/** GPU block compression of 2D textures, the format is chosen by the compression settings of the image, its alpha and the formats the RHI supports */
+UENUM(BlueprintType)
+enum class ERuntimeTextureCompression : uint8
+{
+    None,
+
+    /** BC1 for opaque and BC3 for translucent images, BC4 for linear grayscale, BC5 for normal maps and BC6H for HDR. ETC2 where BC is not supported */
+    Fast,
+
+    /** Like Fast, color images are BC7 where the RHI supports it */
+    Quality
+};
+
 USTRUCT(BlueprintType)
 struct RUNTIMEIMAGELOADER_API FTransformImageParams
 {
@@ -30,15 +92,69 @@ struct RUNTIMEIMAGELOADER_API FTransformImageParams
     UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (Category = "Runtime Image Reader"))
     bool bForUI = true;
 
+    /** Format of the textures created with bForUI */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (Category = "Runtime Image Reader", EditCondition = "bForUI"))
+    ERuntimeUITextureFormat UIFormat = ERuntimeUITextureFormat::BGRA8;
+
     UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (Category = "Runtime Image Reader"))
     TEnumAsByte<TextureFilter> FilterMode = TextureFilter::TF_Default;
 
+    /**
+     * Top left corner of the part of the image to load, in pixels of the image. The region is cut out before any other transform,
+     * formats that allow it (JPEG, WebP, uncompressed TGA and BMP, QOI) decode only the rows it needs.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (Category = "Runtime Image Reader"))
+    FIntPoint RegionOffset = FIntPoint::ZeroValue;
+
+    /** Size of the part of the image to load, the whole image is loaded if it's 0 */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (Category = "Runtime Image Reader"))
+    FIntPoint RegionSize = FIntPoint::ZeroValue;
+
     UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (Category = "Runtime Image Reader", UIMin = 0, UIMax = 100, ClampMin = 0, ClampMax = 100))
     int32 PercentSizeX = 100;
 
     UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (Category = "Runtime Image Reader", UIMin = 0, UIMax = 100, ClampMin = 0, ClampMax = 100))
     int32 PercentSizeY = 100;
 
+    /** Largest width of the texture, 0 for no limit. Applied after the percent size, images are never upscaled to it except by Stretch */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (Category = "Runtime Image Reader", ClampMin = 0))
+    int32 MaxWidth = 0;
+
+    /** Largest height of the texture, 0 for no limit */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (Category = "Runtime Image Reader", ClampMin = 0))
+    int32 MaxHeight = 0;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (Category = "Runtime Image Reader"))
+    ERuntimeImageFitMode FitMode = ERuntimeImageFitMode::Fit;
+
+    /** sRGB images are resized in linear space */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (Category = "Runtime Image Reader"))
+    ERuntimeImageResizeFilter ResizeFilter = ERuntimeImageResizeFilter::Bilinear;
+
+    /** Generate the full mip chain on the reader thread, for textures that are minified in the world. HDR cubemaps get no mips */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (Category = "Runtime Image Reader"))
+    bool bGenerateMips = false;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (Category = "Runtime Image Reader", EditCondition = "bGenerateMips"))
+    ERuntimeImageMipFilter MipFilter = ERuntimeImageMipFilter::Box;
+
+    /**
+     * Compress 2D textures on the reader thread after the resize and the mips, it takes the place of the Packed16 UI format.
+     * Textures whose size is not a multiple of 4 stay uncompressed.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (Category = "Runtime Image Reader"))
+    ERuntimeTextureCompression Compression = ERuntimeTextureCompression::None;
+
+    /** 
+     * Publish a low resolution texture decoded from the first passes of interlaced PNG or the first scan of progressive JPEG
+     * through URuntimeImageLoader::OnImagePreviewReady. The request completes with the same texture once the full image is decoded
+     * and the texture is updated in place. Other images are loaded as usual.
+     * Remote images that support range requests are previewed from their leading bytes while the rest is downloading,
+     * others are previewed from the complete file and save the decode time of the full image only.
+     */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (Category = "Runtime Image Reader"))
+    bool bProgressivePreview = false;
+
     // Hidden as there is method in RuntimeImageLoader that sets this flag
     bool bOnlyPixels = false;
 
@@ -46,6 +162,33 @@ struct RUNTIMEIMAGELOADER_API FTransformImageParams
     {
         return PercentSizeX > 0 && PercentSizeX < 100 && PercentSizeY > 0 && PercentSizeY < 100;
     }
+
+    bool HasRegion() const
+    {
+        return RegionSize.X > 0 && RegionSize.Y > 0;
+    }
+
+    FIntRect GetRegion() const
+    {
+        return HasRegion() ? FIntRect(RegionOffset, RegionOffset + RegionSize) : FIntRect();
+    }
+
+    bool WantsPreview() const
+    {
+        // preview of the whole image would be replaced by the region
+        return bProgressivePreview && !bOnlyPixels && !HasRegion();
+    }
+
+    bool HasSizeLimit() const
+    {
+        return MaxWidth > 0 || MaxHeight > 0;
+    }
+
+    /**
+     * Size the image of the source size is resized to by the percent size and the size limit, before the Fill crop.
+     * Returns false if the image keeps its size.
+     */
+    bool GetTargetSize(int32 SourceSizeX, int32 SourceSizeY, int32& OutSizeX, int32& OutSizeY) const;
 };
 
 struct RUNTIMEIMAGELOADER_API FImageReadRequest
@@ -55,6 +198,32 @@ struct RUNTIMEIMAGELOADER_API FImageReadRequest
     bool bPixelsOnly;
 };
 
+/** GPU side of a loaded texture */
+USTRUCT(BlueprintType)
+struct RUNTIMEIMAGELOADER_API FRuntimeTextureStats
+{
+    GENERATED_BODY()
+
+    /** Size of the texture data uploaded to the GPU in bytes, mips included */
+    UPROPERTY(BlueprintReadOnly, meta = (Category = "Runtime Image Reader"))
+    int64 TextureMemorySize = 0;
+
+    /** Uncompressed size over the block compressed size, 0 if the texture was not compressed */
+    UPROPERTY(BlueprintReadOnly, meta = (Category = "Runtime Image Reader"))
+    float CompressionRatio = 0.0f;
+
+    /**
+     * PSNR of the first mip in dB, 100 for lossless blocks and 0 if the texture was not compressed.
+     * BC6H error is measured on the float values against the brightest channel of the image.
+     */
+    UPROPERTY(BlueprintReadOnly, meta = (Category = "Runtime Image Reader"))
+    float CompressionPSNR = 0.0f;
+
+    /** Time spent encoding the blocks of all mips */
+    UPROPERTY(BlueprintReadOnly, meta = (Category = "Runtime Image Reader"))
+    float CompressionTimeMs = 0.0f;
+};
+
 USTRUCT()
 struct RUNTIMEIMAGELOADER_API FImageReadResult
 {
@@ -71,6 +240,13 @@ struct RUNTIMEIMAGELOADER_API FImageReadResult
     UPROPERTY()
     UTextureCube* OutTextureCube = nullptr;
 
+    UPROPERTY()
+    FRuntimeTextureStats TextureStats;
+
+    // alpha of the loaded image, UI can batch opaque images without blending. Unknown for pre-compressed images
+    UPROPERTY()
+    ERuntimeImageAlphaUsage AlphaUsage = ERuntimeImageAlphaUsage::Unknown;
+
     FString OutError = TEXT("");
 };
 
@@ -87,6 +263,7 @@ public:
 public:
     void AddRequest(const FImageReadRequest& Request);
     bool GetResult(FImageReadResult& OutResult);
+    bool GetPreview(FImageReadResult& OutPreview);
     void Clear();
     void Stop();
     bool IsWorkCompleted() const;
@@ -103,8 +280,13 @@ protected:
     /* ~FRunnable interface */
 
 private:
+    bool PublishPreview(const uint8* Buffer, int32 Length, FImageReadRequest& Request);
     EPixelFormat DeterminePixelFormat(ERawImageFormat::Type ImageFormat, const FTransformImageParams& Params) const;
     void ApplySizeFormatTransformations(FRuntimeImageData& ImageData, FTransformImageParams TransformParams);
+    void CropCentered(FRuntimeImageData& ImageData, int32 SizeX, int32 SizeY);
+    void ConvertForUI(FRuntimeImageData& ImageData, ERawImageFormat::Type Format, ETextureSourceFormat TextureSourceFormat);
+    void PackForUI(FRuntimeImageData& ImageData);
+    void CompressForGPU(FRuntimeImageData& ImageData, ERuntimeTextureCompression Compression);
 
 private:
     TQueue<FImageReadRequest, EQueueMode::Mpsc> Requests;
@@ -112,11 +294,18 @@ private:
     UPROPERTY()
     TArray<FImageReadResult> Results;
 
+    // previews of the requests, their results follow in Results
+    UPROPERTY()
+    TArray<FImageReadResult> Previews;
+
     UPROPERTY()
     FImageReadResult PendingReadResult;
 
     FCriticalSection ResultsMutex;
 
+    // preview of the pending request has already been handed out
+    bool bPendingPreviewPublished = false;
+
 private:
     UPROPERTY()
     URuntimeTextureFactory* TextureFactory;
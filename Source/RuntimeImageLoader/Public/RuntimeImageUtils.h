@@ -4,15 +4,35 @@
 
 #include "CoreMinimal.h"
 #include "RuntimeImageData.h"
+#include "ImageDecoders/IImageDecoder.h"
 
 class UTexture2D;
 class UTextureCube;
 
 namespace FRuntimeImageUtils
 {
-    bool ImportBufferAsImage(const uint8* Buffer, int32 Length, FRuntimeImageData& OutImage, FString& OutError);
+    bool IsImportResolutionValid(int32 Width, int32 Height, bool bAllowNonPowerOfTwo);
+
+    /** D3D rejects block compressed textures whose first mip is not made of whole blocks */
+    bool IsWholeBlockSize(EPixelFormat PixelFormat, int32 Width, int32 Height);
+
+    /** Decodes the image with the decoder registered for its signature in FImageDecoderRegistry */
+    bool ImportBufferAsImage(const uint8* Buffer, int32 Length, FRuntimeImageData& OutImage, FString& OutError, const FImageDecodeParams& Params = FImageDecodeParams());
+
+    /** Cuts the rectangle given in pixels of the image out of the image in place */
+    void CropImage(FRuntimeImageData& Image, const FIntRect& Rect);
+
+    /** Reads the image size from the header without decoding the image, false if the format's decoder can't tell it cheaply */
+    bool GetImageSize(const uint8* Buffer, int32 Length, int32& OutWidth, int32& OutHeight);
+
+    /** Decodes low resolution BGRA8 preview from the leading passes/scans of interlaced PNG or progressive JPEG */
+    bool ImportBufferAsPreviewImage(const uint8* Buffer, int32 Length, FRuntimeImageData& OutImage, FString& OutError);
+
+    /** Writes BGRA8 or G8 image as QOI file, the image is encoded while it's written so there is no intermediate buffer */
+    bool SaveImageAsQOI(const FRuntimeImageData& Image, const FString& Filename, FString& OutError);
 
     UTexture2D* CreateTexture(const FString& ImageFilename, const FRuntimeImageData& ImageData);
+    void UpdateTexture(UTexture2D* Texture, const FRuntimeImageData& ImageData);
     UTextureCube* CreateTextureCube(const FString& ImageFilename, const FRuntimeImageData& ImageData);
 
     static TArray<FString> SupportedImageFormats{
@@ -20,6 +40,6 @@ namespace FRuntimeImageUtils
         TEXT(".bmp"), TEXT(".tga"), TEXT(".exr"), 
         TEXT(".tif"), TEXT(".tiff"), TEXT(".qoi"),
         TEXT(".hdr"), TEXT(".tiff"), TEXT(".qoi"),
-        TEXT(".jfif")
+        TEXT(".jfif"), TEXT(".webp")
     };
 }
\ No newline at end of file
@@ -9,7 +9,7 @@ public class RuntimeImageLoader : ModuleRules
 	{
 		var EngineDir = Path.GetFullPath(Target.RelativeEnginePath);
 
-		{
+		{
             bUseUnity = false;
 
             PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
@@ -65,6 +65,25 @@ public class RuntimeImageLoader : ModuleRules
 			Path.Combine(EngineDir, @"Source/Runtime/Renderer/Private")
         });
 
+        // zlib is used to inflate the leading Adam7 passes of interlaced PNGs for preview textures and Deflate compressed TIFF strips
+        AddEngineThirdPartyPrivateStaticDependencies(Target, "zlib");
+
+        // bundled fastpng decoder handles 8-bit non-interlaced PNGs, the rest goes through ImageWrapper. Set to 0 to always use ImageWrapper
+        PrivateDefinitions.Add("WITH_FASTPNG=1");
+
+        // libjpeg-turbo is used directly for progressive JPEG previews (same platforms as in ImageWrapper)
+        if (Target.Platform.IsInGroup(UnrealPlatformGroup.Windows) || 
+            Target.Platform == UnrealTargetPlatform.Mac || 
+            Target.IsInPlatformGroup(UnrealPlatformGroup.Linux))
+        {
+            PrivateDefinitions.Add("WITH_LIBJPEGTURBO=1");
+            AddEngineThirdPartyPrivateStaticDependencies(Target, "LibJpegTurbo");
+        }
+        else
+        {
+            PrivateDefinitions.Add("WITH_LIBJPEGTURBO=0");
+        }
+
         DynamicallyLoadedModuleNames.AddRange(
 			new string[]
 			{